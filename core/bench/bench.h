@@ -0,0 +1,127 @@
+/*
+ * bench.h - Microbenchmark Harness
+ *
+ * Purpose: Timing, percentile and reporting helpers shared by bench_*.c.
+ *
+ * Method:
+ *   Each benchmark runs its kernel in samples of 'batch' operations timed
+ *   with clock_gettime(CLOCK_MONOTONIC). Per-op cost is sample time divided
+ *   by batch, so operations far below the clock resolution are still
+ *   measured; percentiles are taken over the samples.
+ *
+ * Output:
+ *   One JSON object per line on stdout:
+ *     {"bench":"append","params":"cap=65536","batch":64,"samples":20000,
+ *      "ns_per_op":2.1,"p50_ns":2.0,"p99_ns":2.6,"p999_ns":9.8,"mops":476.2}
+ *   The first line carries run metadata ("meta"). Lines can be joined on
+ *   (bench, params) to compare two runs.
+ *
+ * Including files must define _POSIX_C_SOURCE >= 199309L (clock_gettime).
+ *
+ * Copyright (c) 2025 AlgorithmicGrid
+ */
+
+#ifndef AG_BENCH_H
+#define AG_BENCH_H
+
+#include "ag_timeseries.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Samples per benchmark (AG_BENCH_SAMPLES overrides) */
+#define BENCH_DEFAULT_SAMPLES 20000
+
+/* Sample buffer and configuration */
+typedef struct {
+    size_t samples;         /* Samples per benchmark */
+    const char* filter;     /* Only run benches whose name contains this */
+    double* ns;             /* Per-op nanoseconds, one per sample */
+} bench_ctx_t;
+
+/* Helper: Monotonic clock in nanoseconds */
+static inline uint64_t bench_now_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000ull + (uint64_t)t.tv_nsec;
+}
+
+/* Results sink; volatile so the compiler cannot drop the work */
+static volatile double bench_sink_slot;
+
+/* Helper: Keep a result alive */
+static inline void bench_sink(double x) {
+    bench_sink_slot = x;
+}
+
+/* Helper: qsort comparator for doubles */
+static int bench_cmp_double(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/* Helper: Nearest-rank percentile of sorted samples */
+static inline double bench_percentile(const double* sorted, size_t n, double p) {
+    size_t rank = (size_t)(p * (double)n);
+    return sorted[rank >= n ? n - 1 : rank];
+}
+
+/* Initialize context from argv[1] (filter) and AG_BENCH_SAMPLES */
+static inline int bench_init(bench_ctx_t* ctx, int argc, char** argv) {
+    const char* env = getenv("AG_BENCH_SAMPLES");
+    ctx->samples = BENCH_DEFAULT_SAMPLES;
+    if (env != NULL && atol(env) > 0) {
+        ctx->samples = (size_t)atol(env);
+    }
+    ctx->filter = argc > 1 ? argv[1] : NULL;
+    ctx->ns = (double*)malloc(ctx->samples * sizeof(double));
+    if (ctx->ns == NULL) {
+        return -1;
+    }
+
+    printf("{\"meta\":{\"suite\":\"%s\",\"simd\":\"%s\",\"samples\":%zu}}\n",
+           argv[0], ag_timeseries_simd_name(), ctx->samples);
+    return 0;
+}
+
+/* Release context */
+static inline void bench_free(bench_ctx_t* ctx) {
+    free(ctx->ns);
+}
+
+/* Returns nonzero if 'name' passes the filter */
+static inline int bench_enabled(const bench_ctx_t* ctx, const char* name) {
+    return ctx->filter == NULL || strstr(name, ctx->filter) != NULL;
+}
+
+/*
+ * Sort collected samples and print one result line.
+ *
+ * ctx->ns[i] must hold per-op nanoseconds for sample i; batch is the number
+ * of operations per sample.
+ */
+static inline void bench_report(bench_ctx_t* ctx, const char* name,
+                                const char* params, size_t batch) {
+    size_t n = ctx->samples;
+    double total = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        total += ctx->ns[i];
+    }
+    qsort(ctx->ns, n, sizeof(double), bench_cmp_double);
+
+    double mean = total / (double)n;
+    printf("{\"bench\":\"%s\",\"params\":\"%s\",\"batch\":%zu,\"samples\":%zu,"
+           "\"ns_per_op\":%.3f,\"p50_ns\":%.3f,\"p99_ns\":%.3f,\"p999_ns\":%.3f,"
+           "\"mops\":%.3f}\n",
+           name, params, batch, n, mean,
+           bench_percentile(ctx->ns, n, 0.50),
+           bench_percentile(ctx->ns, n, 0.99),
+           bench_percentile(ctx->ns, n, 0.999),
+           mean > 0.0 ? 1000.0 / mean : 0.0);
+    fflush(stdout);
+}
+
+#endif /* AG_BENCH_H */
@@ -0,0 +1,870 @@
+/*
+ * bench_core.c - Core Ring Buffer Microbenchmarks
+ *
+ * Benchmarks:
+ *   - append        Single-point append at several capacities (plain, SPMC,
+ *                   with compressed cold tier, through a reorder buffer,
+ *                   with a TTL expiring one point per append, and through
+ *                   the header-only inline path)
+ *   - append_batch  Batch append throughput per point at several batch sizes
+ *   - append_row    One 5-column row into a multi-column series vs five
+ *                   appends into separate series
+ *   - query_last    Copy newest N points at several capacities and windows
+ *   - query_range   Range copy of N points from a full, ordered buffer
+ *   - aggregate_sum SIMD range sum over N points
+ *   - asof          N consecutive as-of lookups, one binary search each
+ *   - align         The same N lookups as one merge-join (one series)
+ *   - query_last_layout
+ *                   query_last on split vs interleaved buffers, for one hot
+ *                   series and for many series cycled to miss the cache
+ *   - typed         Native batch append, native range copy and range sum of
+ *                   1000 points per value column type (1M-point buffers)
+ *   - aggregate_many
+ *                   Sum and max over a 1000-point window of 16 / 64 / 256
+ *                   series, on the calling thread vs an auto-sized pool
+ *   - resize        Doubling a full ring in place vs copying it out and
+ *                   replaying it into a new buffer, per stored point
+ *   - serialize     Snapshot of a full ring (raw and delta timestamps) and
+ *                   deserialize back into a new buffer, per point
+ *   - tsdb_flush    Flush pass over 64 series with 256 new points each,
+ *                   zero-copy chunks to a sink vs cursor_read into a
+ *                   staging buffer, per flushed point
+ *   - ingress       256 records round-robin over 1 / 64 series: direct
+ *                   appends vs queue push, and drain into the rings
+ *   - quantiles     p50/p95/p99 of a full ring from its window sketch vs
+ *                   copying and sorting the window, and append cost with
+ *                   the sketch attached
+ *
+ * Usage:
+ *   build/bench_core [filter]     e.g. build/bench_core query_
+ *   AG_BENCH_SAMPLES=N            samples per benchmark (default 20000)
+ *
+ * Copyright (c) 2025 AlgorithmicGrid
+ */
+
+#define _POSIX_C_SOURCE 200809L     /* clock_gettime */
+
+#include "bench.h"
+#include "ag_mseries.h"
+#include "ag_ingress.h"
+#include "ag_tsdb.h"
+#include "ag_timeseries_inline.h"
+
+static const size_t CAPACITIES[] = { 1024, 65536, 1048576 };
+static const size_t WINDOWS[] = { 10, 100, 1000 };
+static const size_t CHUNKS[] = { 16, 256, 4096 };
+static const size_t LAYOUT_WINDOWS[] = { 1, 10, 1000 };
+static const size_t LAYOUT_SERIES[] = { 1, 4096 };
+static const size_t MANY_SERIES[] = { 16, 64, 256 };
+static const size_t INGRESS_SERIES[] = { 1, 64 };
+
+/* Samples for whole-ring benchmarks (a 1M-point copy takes milliseconds) */
+#define WHOLE_RING_SAMPLES 200
+
+/* Columns per order-book row (bid, ask, bid size, ask size, mid) */
+#define ROW_COLUMNS 5
+
+/* Samples for the copy-and-sort baseline (a 1M-point sort takes ~100 ms) */
+#define SORT_SAMPLES 20
+
+/* Series and new points per series in a tsdb_flush pass */
+#define FLUSH_SERIES 64
+#define FLUSH_POINTS 256
+
+#define NELEMS(a) (sizeof(a) / sizeof((a)[0]))
+
+/* Helper: Buffer filled past capacity (wrapped) with ordered timestamps */
+static ag_timeseries_t* filled(size_t capacity, int spmc) {
+    ag_timeseries_t* ts = spmc ? ag_timeseries_create_spmc(capacity)
+                               : ag_timeseries_create(capacity);
+    if (ts == NULL) {
+        fprintf(stderr, "bench: allocation failed (capacity %zu)\n", capacity);
+        exit(1);
+    }
+    size_t n = capacity + capacity / 3;
+    for (size_t i = 0; i < n; i++) {
+        ag_timeseries_append(ts, (int64_t)i, (double)(i % 997));
+    }
+    return ts;
+}
+
+/* Helper: Cheap deterministic PRNG for query positions */
+static inline uint64_t xorshift(uint64_t* s) {
+    *s ^= *s << 13;
+    *s ^= *s >> 7;
+    *s ^= *s << 17;
+    return *s;
+}
+
+static void bench_append(bench_ctx_t* ctx, const char* name, int spmc, int cold,
+                         int reorder, int ttl, int inl) {
+    const size_t batch = 256;
+    char params[64];
+
+    for (size_t c = 0; c < NELEMS(CAPACITIES); c++) {
+        ag_timeseries_t* ts = filled(CAPACITIES[c], spmc);
+        if (cold && ag_timeseries_enable_cold(ts, 4u << 20) != AG_OK) {
+            fprintf(stderr, "bench: cold tier unavailable\n");
+            exit(1);
+        }
+        if (reorder && ag_timeseries_enable_reorder(ts, 64, 256) != AG_OK) {
+            fprintf(stderr, "bench: reorder buffer unavailable\n");
+            exit(1);
+        }
+        int64_t t = (int64_t)ag_timeseries_sequence(ts);
+        /* TTL: keep half the ring; the bulk expiry happens here, not in a sample */
+        if (ttl && (ag_timeseries_set_ttl(ts, (int64_t)CAPACITIES[c] / 2) != AG_OK ||
+                    ag_timeseries_expire(ts, t) == 0)) {
+            fprintf(stderr, "bench: TTL unavailable\n");
+            exit(1);
+        }
+
+        for (size_t s = 0; s < ctx->samples; s++) {
+            uint64_t start = bench_now_ns();
+            for (size_t i = 0; i < batch; i++, t++) {
+                /* Reorder: swap neighbours so half the points arrive late */
+                int64_t at = (reorder && (t & 1)) ? t - 1 : t + (reorder ? 1 : 0);
+                if (inl) {
+                    ag_timeseries_append_inline(ts, at, (double)t);
+                } else {
+                    ag_timeseries_append(ts, at, (double)t);
+                }
+            }
+            ctx->ns[s] = (double)(bench_now_ns() - start) / (double)batch;
+        }
+
+        snprintf(params, sizeof(params), "cap=%zu", CAPACITIES[c]);
+        bench_report(ctx, name, params, batch);
+        ag_timeseries_destroy(ts);
+    }
+}
+
+static void bench_append_row(bench_ctx_t* ctx) {
+    const size_t batch = 256;
+    char params[64];
+
+    for (size_t c = 0; c < NELEMS(CAPACITIES); c++) {
+        size_t capacity = CAPACITIES[c];
+        for (int columnar = 0; columnar < 2; columnar++) {
+            ag_mseries_t* ms = NULL;
+            ag_timeseries_t* series[ROW_COLUMNS] = { NULL };
+            if (columnar) {
+                ms = ag_mseries_create(capacity, ROW_COLUMNS, 0);
+            } else {
+                for (size_t k = 0; k < ROW_COLUMNS; k++) {
+                    series[k] = ag_timeseries_create(capacity);
+                }
+            }
+            if ((columnar && ms == NULL) || (!columnar && series[ROW_COLUMNS - 1] == NULL)) {
+                fprintf(stderr, "bench: allocation failed (capacity %zu)\n", capacity);
+                exit(1);
+            }
+
+            double row[ROW_COLUMNS] = { 100.0, 100.5, 3.0, 4.0, 100.25 };
+            int64_t t = 0;
+            for (size_t s = 0; s < ctx->samples; s++) {
+                uint64_t start = bench_now_ns();
+                for (size_t i = 0; i < batch; i++, t++) {
+                    row[0] = (double)t;
+                    if (columnar) {
+                        ag_mseries_append_row(ms, t, row);
+                    } else {
+                        for (size_t k = 0; k < ROW_COLUMNS; k++) {
+                            ag_timeseries_append(series[k], t, row[k]);
+                        }
+                    }
+                }
+                ctx->ns[s] = (double)(bench_now_ns() - start) / (double)batch;
+            }
+
+            snprintf(params, sizeof(params), "cap=%zu,layout=%s,columns=%d", capacity,
+                     columnar ? "mseries" : "separate", ROW_COLUMNS);
+            bench_report(ctx, "append_row", params, batch);
+
+            ag_mseries_destroy(ms);
+            for (size_t k = 0; k < ROW_COLUMNS; k++) {
+                ag_timeseries_destroy(series[k]);
+            }
+        }
+    }
+}
+
+static void bench_append_batch(bench_ctx_t* ctx) {
+    const size_t capacity = 65536;
+    const size_t max_chunk = CHUNKS[NELEMS(CHUNKS) - 1];
+    char params[64];
+
+    int64_t* timestamps = (int64_t*)malloc(max_chunk * sizeof(int64_t));
+    double* values = (double*)malloc(max_chunk * sizeof(double));
+    if (timestamps == NULL || values == NULL) {
+        fprintf(stderr, "bench: allocation failed\n");
+        exit(1);
+    }
+
+    for (size_t c = 0; c < NELEMS(CHUNKS); c++) {
+        size_t chunk = CHUNKS[c];
+        size_t calls = chunk >= 4096 ? 1 : 4096 / chunk;
+        ag_timeseries_t* ts = filled(capacity, 0);
+
+        for (size_t i = 0; i < chunk; i++) {
+            timestamps[i] = (int64_t)i;
+            values[i] = (double)i;
+        }
+
+        for (size_t s = 0; s < ctx->samples; s++) {
+            uint64_t start = bench_now_ns();
+            for (size_t k = 0; k < calls; k++) {
+                ag_timeseries_append_batch(ts, timestamps, values, chunk);
+            }
+            ctx->ns[s] = (double)(bench_now_ns() - start) / (double)(calls * chunk);
+        }
+
+        snprintf(params, sizeof(params), "cap=%zu,chunk=%zu", capacity, chunk);
+        bench_report(ctx, "append_batch", params, calls * chunk);
+        ag_timeseries_destroy(ts);
+    }
+
+    free(timestamps);
+    free(values);
+}
+
+/*
+ * Window benchmarks share one driver: 'op' runs one query of 'window'
+ * points starting near 'start' and returns a value to sink.
+ */
+typedef double (*window_op_t)(const ag_timeseries_t* ts, int64_t start, size_t window,
+                              int64_t* out_ts, double* out_vals);
+
+static double op_query_last(const ag_timeseries_t* ts, int64_t start, size_t window,
+                            int64_t* out_ts, double* out_vals) {
+    (void)start;
+    size_t n = ag_timeseries_query_last(ts, window, out_ts, out_vals);
+    return out_vals[n - 1];
+}
+
+static double op_query_range(const ag_timeseries_t* ts, int64_t start, size_t window,
+                             int64_t* out_ts, double* out_vals) {
+    size_t n = ag_timeseries_query_range(ts, start, start + (int64_t)window - 1,
+                                         window, out_ts, out_vals);
+    return n > 0 ? out_vals[n - 1] : 0.0;
+}
+
+static double op_aggregate_sum(const ag_timeseries_t* ts, int64_t start, size_t window,
+                               int64_t* out_ts, double* out_vals) {
+    (void)out_ts;
+    (void)out_vals;
+    double sum = 0.0;
+    ag_timeseries_aggregate_range(ts, start, start + (int64_t)window - 1,
+                                  AG_AGG_SUM, &sum);
+    return sum;
+}
+
+static double op_asof(const ag_timeseries_t* ts, int64_t start, size_t window,
+                      int64_t* out_ts, double* out_vals) {
+    int64_t t = 0;
+    for (size_t i = 0; i < window; i++) {
+        ag_timeseries_asof(ts, start + (int64_t)i, &t, &out_vals[i]);
+    }
+    (void)out_ts;
+    return out_vals[window - 1];
+}
+
+static double op_align(const ag_timeseries_t* ts, int64_t start, size_t window,
+                       int64_t* out_ts, double* out_vals) {
+    for (size_t i = 0; i < window; i++) {
+        out_ts[i] = start + (int64_t)i;
+    }
+    ag_timeseries_align(&ts, 1, out_ts, window, out_vals);
+    return out_vals[window - 1];
+}
+
+static void bench_window(bench_ctx_t* ctx, const char* name, window_op_t op) {
+    const size_t max_window = WINDOWS[NELEMS(WINDOWS) - 1];
+    char params[64];
+
+    int64_t* out_ts = (int64_t*)malloc(max_window * sizeof(int64_t));
+    double* out_vals = (double*)malloc(max_window * sizeof(double));
+    if (out_ts == NULL || out_vals == NULL) {
+        fprintf(stderr, "bench: allocation failed\n");
+        exit(1);
+    }
+
+    for (size_t c = 0; c < NELEMS(CAPACITIES); c++) {
+        size_t capacity = CAPACITIES[c];
+        ag_timeseries_t* ts = filled(capacity, 0);
+        int64_t oldest = (int64_t)(ag_timeseries_sequence(ts) - capacity);
+
+        for (size_t w = 0; w < NELEMS(WINDOWS); w++) {
+            size_t window = WINDOWS[w];
+            size_t batch = window >= 1000 ? 1 : 1000 / window;
+            uint64_t rng = 0x9e3779b97f4a7c15ull;
+            double acc = 0.0;
+
+            for (size_t s = 0; s < ctx->samples; s++) {
+                /* Random start so searches and copies miss the cache realistically */
+                int64_t start = oldest + (int64_t)(xorshift(&rng) % (capacity - window + 1));
+                uint64_t t0 = bench_now_ns();
+                for (size_t i = 0; i < batch; i++) {
+                    acc += op(ts, start, window, out_ts, out_vals);
+                }
+                ctx->ns[s] = (double)(bench_now_ns() - t0) / (double)batch;
+            }
+            bench_sink(acc);
+
+            snprintf(params, sizeof(params), "cap=%zu,window=%zu", capacity, window);
+            bench_report(ctx, name, params, batch);
+        }
+        ag_timeseries_destroy(ts);
+    }
+
+    free(out_ts);
+    free(out_vals);
+}
+
+static void bench_query_last_layout(bench_ctx_t* ctx) {
+    const size_t capacity = 1024;
+    const size_t max_series = LAYOUT_SERIES[NELEMS(LAYOUT_SERIES) - 1];
+    char params[96];
+
+    int64_t* out_ts = (int64_t*)malloc(capacity * sizeof(int64_t));
+    double* out_vals = (double*)malloc(capacity * sizeof(double));
+    ag_timeseries_t** series = (ag_timeseries_t**)malloc(max_series * sizeof(*series));
+    if (out_ts == NULL || out_vals == NULL || series == NULL) {
+        fprintf(stderr, "bench: allocation failed\n");
+        exit(1);
+    }
+
+    for (int interleaved = 0; interleaved < 2; interleaved++) {
+        for (size_t c = 0; c < NELEMS(LAYOUT_SERIES); c++) {
+            size_t count = LAYOUT_SERIES[c];
+            for (size_t k = 0; k < count; k++) {
+                series[k] = interleaved ? ag_timeseries_create_interleaved(capacity)
+                                        : ag_timeseries_create(capacity);
+                if (series[k] == NULL) {
+                    fprintf(stderr, "bench: allocation failed\n");
+                    exit(1);
+                }
+                for (size_t i = 0; i < capacity + capacity / 3; i++) {
+                    ag_timeseries_append(series[k], (int64_t)i, (double)(i % 997));
+                }
+            }
+
+            for (size_t w = 0; w < NELEMS(LAYOUT_WINDOWS); w++) {
+                size_t window = LAYOUT_WINDOWS[w];
+                size_t batch = window >= 100 ? 4 : 256;
+                uint64_t rng = 0x9e3779b97f4a7c15ull;
+                double acc = 0.0;
+
+                for (size_t s = 0; s < ctx->samples; s++) {
+                    uint64_t t0 = bench_now_ns();
+                    for (size_t i = 0; i < batch; i++) {
+                        /* Random series: with many, each read starts cold */
+                        const ag_timeseries_t* ts = series[xorshift(&rng) % count];
+                        size_t n = ag_timeseries_query_last(ts, window, out_ts, out_vals);
+                        acc += out_vals[n - 1];
+                    }
+                    ctx->ns[s] = (double)(bench_now_ns() - t0) / (double)batch;
+                }
+                bench_sink(acc);
+
+                snprintf(params, sizeof(params), "layout=%s,series=%zu,window=%zu",
+                         interleaved ? "interleaved" : "split", count, window);
+                bench_report(ctx, "query_last_layout", params, batch);
+            }
+
+            for (size_t k = 0; k < count; k++) {
+                ag_timeseries_destroy(series[k]);
+            }
+        }
+    }
+
+    free(series);
+    free(out_ts);
+    free(out_vals);
+}
+
+static void bench_typed(bench_ctx_t* ctx) {
+    static const int types[] = { AG_VALUE_F64, AG_VALUE_F32, AG_VALUE_I64, AG_VALUE_I32 };
+    static const char* names[] = { "f64", "f32", "i64", "i32" };
+    const size_t capacity = 1048576;
+    const size_t window = 1000;
+    char params[64];
+
+    int64_t* out_ts = (int64_t*)malloc(window * sizeof(int64_t));
+    int64_t* in_ts = (int64_t*)malloc(window * sizeof(int64_t));
+    int64_t* cells = (int64_t*)calloc(window, sizeof(int64_t));    /* Widest type */
+    if (out_ts == NULL || in_ts == NULL || cells == NULL) {
+        fprintf(stderr, "bench: allocation failed\n");
+        exit(1);
+    }
+
+    for (size_t k = 0; k < NELEMS(types); k++) {
+        ag_timeseries_t* ts = ag_timeseries_create_typed(capacity, types[k]);
+        if (ts == NULL) {
+            fprintf(stderr, "bench: allocation failed (capacity %zu)\n", capacity);
+            exit(1);
+        }
+
+        /* Fill with ordered points, values 0..capacity-1 */
+        int64_t t = 0;
+        for (; t < (int64_t)capacity; t++) {
+            ag_timeseries_append(ts, t, (double)(t & 0xffff));
+        }
+
+        for (int op = 0; op < 3; op++) {
+            uint64_t rng = 0x9e3779b97f4a7c15ull;
+            volatile double sink = 0.0;
+            for (size_t s = 0; s < ctx->samples; s++) {
+                int64_t from = (int64_t)(xorshift(&rng) % (capacity - window)) + t - (int64_t)capacity;
+                uint64_t start = bench_now_ns();
+                if (op == 0) {
+                    for (size_t i = 0; i < window; i++) {
+                        in_ts[i] = t + (int64_t)i;
+                    }
+                    start = bench_now_ns();
+                    ag_timeseries_append_batch_native(ts, in_ts, cells, window);
+                    t += (int64_t)window;
+                } else if (op == 1) {
+                    sink = (double)ag_timeseries_query_range_native(
+                        ts, from, from + (int64_t)window - 1, window, out_ts, cells);
+                } else {
+                    double sum = 0.0;
+                    ag_timeseries_aggregate_range(ts, from, from + (int64_t)window - 1,
+                                                  AG_AGG_SUM, &sum);
+                    sink = sum;
+                }
+                ctx->ns[s] = (double)(bench_now_ns() - start) / (double)window;
+            }
+            (void)sink;
+
+            static const char* ops[] = { "append_batch_native", "query_range_native",
+                                         "aggregate_sum" };
+            snprintf(params, sizeof(params), "type=%s,op=%s,window=%zu", names[k], ops[op],
+                     window);
+            bench_report(ctx, "typed", params, window);
+        }
+        ag_timeseries_destroy(ts);
+    }
+
+    free(out_ts);
+    free(in_ts);
+    free(cells);
+}
+
+static void bench_aggregate_many(bench_ctx_t* ctx) {
+    const size_t capacity = 4096;
+    const size_t window = 1000;
+    const size_t max_series = MANY_SERIES[NELEMS(MANY_SERIES) - 1];
+    const int aggs[] = { AG_AGG_SUM, AG_AGG_MAX };
+    char params[64];
+
+    ag_timeseries_t** series = (ag_timeseries_t**)malloc(max_series * sizeof(*series));
+    double* out = (double*)malloc(max_series * NELEMS(aggs) * sizeof(double));
+    ag_timeseries_pool_t* pool = ag_timeseries_pool_create(0);
+    if (series == NULL || out == NULL || pool == NULL) {
+        fprintf(stderr, "bench: allocation failed\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < max_series; i++) {
+        series[i] = filled(capacity, 0);
+    }
+    const ag_timeseries_t* const* view = (const ag_timeseries_t* const*)series;
+    int64_t oldest = (int64_t)(ag_timeseries_sequence(series[0]) - capacity);
+
+    for (size_t n = 0; n < NELEMS(MANY_SERIES); n++) {
+        size_t k = MANY_SERIES[n];
+        for (int pooled = 0; pooled <= 1; pooled++) {
+            uint64_t rng = 0x9e3779b97f4a7c15ull;
+            double acc = 0.0;
+
+            for (size_t s = 0; s < ctx->samples; s++) {
+                int64_t start = oldest + (int64_t)(xorshift(&rng) % (capacity - window + 1));
+                uint64_t t0 = bench_now_ns();
+                ag_timeseries_aggregate_many(view, k, start, start + (int64_t)window - 1,
+                                             aggs, NELEMS(aggs), out, pooled ? pool : NULL);
+                ctx->ns[s] = (double)(bench_now_ns() - t0);
+                acc += out[0];
+            }
+            bench_sink(acc);
+
+            snprintf(params, sizeof(params), "series=%zu,pool=%s,threads=%zu", k,
+                     pooled ? "auto" : "none",
+                     pooled ? ag_timeseries_pool_threads(pool) + 1 : 1);
+            bench_report(ctx, "aggregate_many", params, 1);
+        }
+    }
+
+    for (size_t i = 0; i < max_series; i++) {
+        ag_timeseries_destroy(series[i]);
+    }
+    ag_timeseries_pool_destroy(pool);
+    free(series);
+    free(out);
+}
+
+static void bench_resize(bench_ctx_t* ctx) {
+    char params[64];
+    size_t samples = ctx->samples;
+    if (ctx->samples > WHOLE_RING_SAMPLES) {
+        ctx->samples = WHOLE_RING_SAMPLES;
+    }
+
+    for (size_t c = 0; c < NELEMS(CAPACITIES); c++) {
+        size_t capacity = CAPACITIES[c];
+        ag_timeseries_t* ts = filled(capacity, 0);
+        int64_t* tmp_ts = (int64_t*)malloc(capacity * sizeof(int64_t));
+        double* tmp_vals = (double*)malloc(capacity * sizeof(double));
+        if (tmp_ts == NULL || tmp_vals == NULL) {
+            fprintf(stderr, "bench: allocation failed (capacity %zu)\n", capacity);
+            exit(1);
+        }
+
+        for (int replay = 0; replay < 2; replay++) {
+            for (size_t s = 0; s < ctx->samples; s++) {
+                uint64_t start = bench_now_ns();
+                if (!replay) {
+                    ag_timeseries_resize(ts, 2 * capacity);
+                    ctx->ns[s] = (double)(bench_now_ns() - start) / (double)capacity;
+                    ag_timeseries_resize(ts, capacity);
+                } else {
+                    /* The alternative: a bigger buffer and per-point appends */
+                    ag_timeseries_t* big = ag_timeseries_create(2 * capacity);
+                    size_t n = ag_timeseries_query_range(ts, INT64_MIN, INT64_MAX, capacity,
+                                                         tmp_ts, tmp_vals);
+                    for (size_t i = 0; i < n; i++) {
+                        ag_timeseries_append(big, tmp_ts[i], tmp_vals[i]);
+                    }
+                    ctx->ns[s] = (double)(bench_now_ns() - start) / (double)capacity;
+                    ag_timeseries_destroy(big);
+                }
+            }
+
+            snprintf(params, sizeof(params), "cap=%zu,op=%s", capacity,
+                     replay ? "replay" : "resize");
+            bench_report(ctx, "resize", params, capacity);
+        }
+        free(tmp_ts);
+        free(tmp_vals);
+        ag_timeseries_destroy(ts);
+    }
+    ctx->samples = samples;
+}
+
+static void bench_quantiles(bench_ctx_t* ctx) {
+    static const double qs[] = { 0.5, 0.95, 0.99 };
+    const size_t batch = 256;
+    char params[64];
+    size_t samples = ctx->samples;
+
+    for (size_t c = 0; c < NELEMS(CAPACITIES); c++) {
+        size_t capacity = CAPACITIES[c];
+        ag_timeseries_t* ts = filled(capacity, 0);
+        int64_t* tmp_ts = (int64_t*)malloc(capacity * sizeof(int64_t));
+        double* tmp_vals = (double*)malloc(capacity * sizeof(double));
+        if (tmp_ts == NULL || tmp_vals == NULL ||
+            ag_timeseries_enable_quantiles(ts, 0.01, 1e-3, 1e6) != AG_OK) {
+            fprintf(stderr, "bench: allocation failed (capacity %zu)\n", capacity);
+            exit(1);
+        }
+
+        /* Three quantiles from the sketch */
+        double out[3];
+        ctx->samples = samples;
+        for (size_t s = 0; s < ctx->samples; s++) {
+            uint64_t start = bench_now_ns();
+            ag_timeseries_quantiles(ts, qs, 3, out);
+            ctx->ns[s] = (double)(bench_now_ns() - start);
+            bench_sink(out[2]);
+        }
+        snprintf(params, sizeof(params), "cap=%zu,op=sketch", capacity);
+        bench_report(ctx, "quantiles", params, 1);
+
+        /* The alternative: copy the window out and sort it */
+        ctx->samples = (samples > SORT_SAMPLES) ? SORT_SAMPLES : samples;
+        for (size_t s = 0; s < ctx->samples; s++) {
+            uint64_t start = bench_now_ns();
+            size_t n = ag_timeseries_query_last(ts, capacity, tmp_ts, tmp_vals);
+            qsort(tmp_vals, n, sizeof(double), bench_cmp_double);
+            for (size_t i = 0; i < 3; i++) {
+                out[i] = tmp_vals[(size_t)(qs[i] * (double)(n - 1))];
+            }
+            ctx->ns[s] = (double)(bench_now_ns() - start);
+            bench_sink(out[2]);
+        }
+        snprintf(params, sizeof(params), "cap=%zu,op=sort", capacity);
+        bench_report(ctx, "quantiles", params, 1);
+
+        /* Append cost with the sketch counting and evicting */
+        ctx->samples = samples;
+        int64_t t = (int64_t)ag_timeseries_sequence(ts);
+        for (size_t s = 0; s < ctx->samples; s++) {
+            uint64_t start = bench_now_ns();
+            for (size_t i = 0; i < batch; i++, t++) {
+                ag_timeseries_append(ts, t, (double)(t % 997));
+            }
+            ctx->ns[s] = (double)(bench_now_ns() - start) / (double)batch;
+        }
+        snprintf(params, sizeof(params), "cap=%zu,op=append", capacity);
+        bench_report(ctx, "quantiles", params, batch);
+
+        free(tmp_ts);
+        free(tmp_vals);
+        ag_timeseries_destroy(ts);
+    }
+    ctx->samples = samples;
+}
+
+static void bench_serialize(bench_ctx_t* ctx) {
+    char params[64];
+    size_t samples = ctx->samples;
+    if (ctx->samples > WHOLE_RING_SAMPLES) {
+        ctx->samples = WHOLE_RING_SAMPLES;
+    }
+
+    for (size_t c = 0; c < NELEMS(CAPACITIES); c++) {
+        size_t capacity = CAPACITIES[c];
+        ag_timeseries_t* ts = filled(capacity, 0);
+        size_t cap_bytes;
+        ag_timeseries_serialize(ts, NULL, 0, AG_SERIAL_DELTA, &cap_bytes);
+        void* buf = malloc(cap_bytes);
+        if (buf == NULL) {
+            fprintf(stderr, "bench: allocation failed (capacity %zu)\n", capacity);
+            exit(1);
+        }
+
+        for (unsigned flags = 0; flags <= AG_SERIAL_DELTA; flags += AG_SERIAL_DELTA) {
+            size_t len = 0;
+            for (int load = 0; load < 2; load++) {
+                for (size_t s = 0; s < ctx->samples; s++) {
+                    uint64_t start = bench_now_ns();
+                    if (!load) {
+                        ag_timeseries_serialize(ts, buf, cap_bytes, flags, &len);
+                        ctx->ns[s] = (double)(bench_now_ns() - start) / (double)capacity;
+                    } else {
+                        ag_timeseries_t* copy = ag_timeseries_deserialize(buf, len, 0);
+                        ctx->ns[s] = (double)(bench_now_ns() - start) / (double)capacity;
+                        ag_timeseries_destroy(copy);
+                    }
+                }
+
+                snprintf(params, sizeof(params), "cap=%zu,ts=%s,op=%s,bytes=%zu", capacity,
+                         flags ? "delta" : "raw", load ? "deserialize" : "serialize", len);
+                bench_report(ctx, "serialize", params, capacity);
+            }
+        }
+        free(buf);
+        ag_timeseries_destroy(ts);
+    }
+    ctx->samples = samples;
+}
+
+/* Helper: Flush sink that reads every value, as a COPY out would */
+static int sum_sink(void* ctx, const ag_tsdb_chunk_t* chunk) {
+    double* sum = (double*)ctx;
+    const ag_timeseries_span_t* span = &chunk->view.spans[0];
+    for (size_t i = 0; i < span->length; i++) {
+        *sum += span->values[i] + (double)span->timestamps[i];
+    }
+    return AG_OK;
+}
+
+static void bench_tsdb_flush(bench_ctx_t* ctx) {
+    char params[64];
+    size_t samples = ctx->samples;
+    if (ctx->samples > WHOLE_RING_SAMPLES) {
+        ctx->samples = WHOLE_RING_SAMPLES;
+    }
+
+    const size_t points = FLUSH_SERIES * FLUSH_POINTS;
+    int64_t* stage_ts = (int64_t*)malloc(FLUSH_POINTS * sizeof(int64_t));
+    double* stage_vals = (double*)malloc(FLUSH_POINTS * sizeof(double));
+    ag_ts_cursor_t* cursors = (ag_ts_cursor_t*)calloc(FLUSH_SERIES, sizeof(ag_ts_cursor_t));
+    if (stage_ts == NULL || stage_vals == NULL || cursors == NULL) {
+        fprintf(stderr, "bench: allocation failed\n");
+        exit(1);
+    }
+
+    for (int staged = 0; staged < 2; staged++) {
+        ag_tsdb_t* db = ag_tsdb_create(FLUSH_SERIES, 4 * FLUSH_POINTS, 0);
+        double sum = 0.0;
+        if (db == NULL || ag_tsdb_flush_attach(db, sum_sink, &sum, 0) != AG_OK) {
+            fprintf(stderr, "bench: allocation failed\n");
+            exit(1);
+        }
+        for (size_t id = 0; id < FLUSH_SERIES; id++) {
+            ag_tsdb_add(db, NULL, NULL);
+            cursors[id].next_seq = 0;
+        }
+
+        int64_t t = 0;
+        for (size_t s = 0; s < ctx->samples; s++) {
+            for (size_t id = 0; id < FLUSH_SERIES; id++) {
+                ag_timeseries_t* ts = ag_tsdb_get(db, id);
+                for (size_t i = 0; i < FLUSH_POINTS; i++) {
+                    ag_timeseries_append(ts, t + (int64_t)i, (double)(i % 997));
+                }
+            }
+            t += FLUSH_POINTS;
+
+            uint64_t start = bench_now_ns();
+            if (!staged) {
+                ag_tsdb_flush(db, NULL);
+            } else {
+                /* The alternative: copy out to a buffer, then consume that */
+                for (size_t id = 0; id < FLUSH_SERIES; id++) {
+                    size_t n = 0;
+                    ag_timeseries_cursor_read(ag_tsdb_get(db, id), &cursors[id], FLUSH_POINTS,
+                                              stage_ts, stage_vals, &n, NULL);
+                    for (size_t i = 0; i < n; i++) {
+                        sum += stage_vals[i] + (double)stage_ts[i];
+                    }
+                }
+            }
+            ctx->ns[s] = (double)(bench_now_ns() - start) / (double)points;
+        }
+        bench_sink(sum);
+
+        snprintf(params, sizeof(params), "series=%d,points=%d,op=%s", FLUSH_SERIES,
+                 FLUSH_POINTS, staged ? "staged" : "zero_copy");
+        bench_report(ctx, "tsdb_flush", params, points);
+        ag_tsdb_destroy(db);
+    }
+    free(stage_ts);
+    free(stage_vals);
+    free(cursors);
+    ctx->samples = samples;
+}
+
+static void bench_ingress(bench_ctx_t* ctx) {
+    const size_t batch = 256;
+    char params[64];
+
+    for (size_t c = 0; c < NELEMS(INGRESS_SERIES); c++) {
+        size_t nseries = INGRESS_SERIES[c];
+        ag_tsdb_t* db = ag_tsdb_create(nseries, 65536, 0);
+        ag_ingress_t* q = (db != NULL) ? ag_ingress_create(db, 4096, 0) : NULL;
+        if (q == NULL) {
+            fprintf(stderr, "bench: allocation failed (series %zu)\n", nseries);
+            exit(1);
+        }
+        for (size_t id = 0; id < nseries; id++) {
+            ag_tsdb_add(db, NULL, NULL);
+        }
+
+        /* op 0: direct appends, 1: push, 2: drain of the pushed records */
+        double* drain_ns = (double*)malloc(ctx->samples * sizeof(double));
+        if (drain_ns == NULL) {
+            fprintf(stderr, "bench: allocation failed\n");
+            exit(1);
+        }
+        int64_t t = 0;
+        for (int op = 0; op < 2; op++) {
+            for (size_t s = 0; s < ctx->samples; s++) {
+                uint64_t start = bench_now_ns();
+                for (size_t i = 0; i < batch; i++) {
+                    size_t id = i % nseries;
+                    if (op == 0) {
+                        ag_timeseries_append(ag_tsdb_get(db, id), t + (int64_t)i, (double)i);
+                    } else {
+                        ag_ingress_push(q, id, t + (int64_t)i, (double)i);
+                    }
+                }
+                ctx->ns[s] = (double)(bench_now_ns() - start) / (double)batch;
+                t += (int64_t)batch;
+
+                if (op == 1) {
+                    start = bench_now_ns();
+                    ag_ingress_drain(q, 0, NULL);
+                    drain_ns[s] = (double)(bench_now_ns() - start) / (double)batch;
+                }
+            }
+
+            snprintf(params, sizeof(params), "series=%zu,op=%s", nseries,
+                     op ? "push" : "direct");
+            bench_report(ctx, "ingress", params, batch);
+        }
+
+        memcpy(ctx->ns, drain_ns, ctx->samples * sizeof(double));
+        snprintf(params, sizeof(params), "series=%zu,op=drain", nseries);
+        bench_report(ctx, "ingress", params, batch);
+
+        free(drain_ns);
+        ag_ingress_destroy(q);
+        ag_tsdb_destroy(db);
+    }
+}
+
+int main(int argc, char** argv) {
+    bench_ctx_t ctx;
+    if (bench_init(&ctx, argc, argv) != 0) {
+        fprintf(stderr, "bench: allocation failed\n");
+        return 1;
+    }
+
+    if (bench_enabled(&ctx, "append")) {
+        bench_append(&ctx, "append", 0, 0, 0, 0, 0);
+    }
+    if (bench_enabled(&ctx, "append_spmc")) {
+        bench_append(&ctx, "append_spmc", 1, 0, 0, 0, 0);
+    }
+    if (bench_enabled(&ctx, "append_cold")) {
+        bench_append(&ctx, "append_cold", 0, 1, 0, 0, 0);
+    }
+    if (bench_enabled(&ctx, "append_reorder")) {
+        bench_append(&ctx, "append_reorder", 0, 0, 1, 0, 0);
+    }
+    if (bench_enabled(&ctx, "append_ttl")) {
+        bench_append(&ctx, "append_ttl", 0, 0, 0, 1, 0);
+    }
+    if (bench_enabled(&ctx, "append_inline")) {
+        bench_append(&ctx, "append_inline", 0, 0, 0, 0, 1);
+    }
+    if (bench_enabled(&ctx, "append_batch")) {
+        bench_append_batch(&ctx);
+    }
+    if (bench_enabled(&ctx, "append_row")) {
+        bench_append_row(&ctx);
+    }
+    if (bench_enabled(&ctx, "query_last")) {
+        bench_window(&ctx, "query_last", op_query_last);
+    }
+    if (bench_enabled(&ctx, "query_last_layout")) {
+        bench_query_last_layout(&ctx);
+    }
+    if (bench_enabled(&ctx, "query_range")) {
+        bench_window(&ctx, "query_range", op_query_range);
+    }
+    if (bench_enabled(&ctx, "aggregate_sum")) {
+        bench_window(&ctx, "aggregate_sum", op_aggregate_sum);
+    }
+    if (bench_enabled(&ctx, "asof")) {
+        bench_window(&ctx, "asof", op_asof);
+    }
+    if (bench_enabled(&ctx, "align")) {
+        bench_window(&ctx, "align", op_align);
+    }
+    if (bench_enabled(&ctx, "typed")) {
+        bench_typed(&ctx);
+    }
+    if (bench_enabled(&ctx, "aggregate_many")) {
+        bench_aggregate_many(&ctx);
+    }
+    if (bench_enabled(&ctx, "resize")) {
+        bench_resize(&ctx);
+    }
+    if (bench_enabled(&ctx, "serialize")) {
+        bench_serialize(&ctx);
+    }
+    if (bench_enabled(&ctx, "tsdb_flush")) {
+        bench_tsdb_flush(&ctx);
+    }
+    if (bench_enabled(&ctx, "ingress")) {
+        bench_ingress(&ctx);
+    }
+    if (bench_enabled(&ctx, "quantiles")) {
+        bench_quantiles(&ctx);
+    }
+
+    bench_free(&ctx);
+    return 0;
+}
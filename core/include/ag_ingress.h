@@ -0,0 +1,152 @@
+/*
+ * ag_ingress.h - Registry Ingress Queue API
+ *
+ * Purpose: Decouples feed threads from the thread that owns a registry's
+ *          series. Any thread pushes (series ID, timestamp, value) records
+ *          into a bounded lock-free queue; the owning thread drains them
+ *          into the target rings with ag_timeseries_append_batch().
+ *
+ * Thread Safety: ag_ingress_push() is lock-free and safe from any number
+ *   of threads (one thread with AG_INGRESS_SPSC). Draining and stats belong
+ *   to one thread: the series' writer.
+ * Memory Model: One 64-byte-aligned array of 32-byte cells sized at
+ *   creation; pushes and drains never allocate.
+ *
+ * Copyright (c) 2025 AlgorithmicGrid
+ */
+
+#ifndef AG_INGRESS_H
+#define AG_INGRESS_H
+
+#include "ag_tsdb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Opaque handle - internal structure hidden from users */
+typedef struct ag_ingress_t ag_ingress_t;
+
+/* Creation flags for ag_ingress_create */
+#define AG_INGRESS_SPSC     0x1u    /* One producer thread: pushes skip the CAS */
+
+/*
+ * Ingress counters.
+ */
+typedef struct {
+    uint64_t drained;   /* Records appended to their series */
+    uint64_t batches;   /* ag_timeseries_append_batch() calls made */
+    uint64_t dropped;   /* Records for series IDs not registered at drain time */
+    uint64_t rejected;  /* Pushes refused because the queue was full */
+    size_t depth;       /* Records queued now */
+} ag_ingress_stats_t;
+
+/*
+ * Create an ingress queue feeding the series of a registry.
+ *
+ * Parameters:
+ *   db       - Registry whose series IDs the records address
+ *   capacity - Queued records (rounded up to a power of two, must be > 0)
+ *   flags    - Bitwise OR of AG_INGRESS_* flags, or 0
+ *
+ * Returns:
+ *   Queue handle, or NULL on invalid arguments / allocation failure.
+ *
+ * Memory:
+ *   32 bytes per record. Call ag_ingress_destroy() to free; the registry
+ *   must outlive the queue.
+ */
+ag_ingress_t* ag_ingress_create(ag_tsdb_t* db, size_t capacity, unsigned flags);
+
+/*
+ * Destroy a queue. Records still queued are discarded.
+ *
+ * Parameters:
+ *   q - Queue handle (NULL safe - no-op if NULL)
+ *
+ * Thread Safety:
+ *   NOT safe. No thread may push or drain.
+ */
+void ag_ingress_destroy(ag_ingress_t* q);
+
+/*
+ * Queue one point for a series.
+ *
+ * Parameters:
+ *   q            - Queue handle
+ *   series       - Registry series ID (checked when drained)
+ *   timestamp_ms - Point timestamp
+ *   value        - Point value
+ *
+ * Returns:
+ *   AG_OK on success, AG_ERR_FULL if the queue is full (the record is not
+ *   queued and counts as rejected), AG_ERR_INVALID_ARG if q is NULL.
+ *
+ * Behavior:
+ *   Never blocks or allocates. Records of one producer are drained in push
+ *   order; records of different producers in the order they claimed cells.
+ *
+ * Performance:
+ *   O(1): one CAS on the shared tail (none with AG_INGRESS_SPSC) plus one
+ *   32-byte cell write.
+ *
+ * Thread Safety:
+ *   Safe from any number of threads concurrently with ag_ingress_drain().
+ *   With AG_INGRESS_SPSC, at most one thread may push.
+ */
+int ag_ingress_push(ag_ingress_t* q, size_t series, int64_t timestamp_ms, double value);
+
+/*
+ * Append queued records to their series.
+ *
+ * Parameters:
+ *   q           - Queue handle
+ *   max_records - Most records to drain (0 = up to the queue's capacity)
+ *   out_records - Output: records taken off the queue (may be NULL)
+ *
+ * Returns:
+ *   AG_OK on success (also when the queue is empty), AG_ERR_INVALID_ARG if
+ *   q is NULL.
+ *
+ * Behavior:
+ *   Takes records in chunks of up to 256. Each run of one series in a
+ *   chunk goes to that series with a single ag_timeseries_append_batch();
+ *   a chunk of short, interleaved runs is first grouped by series, keeping
+ *   each series' records in queue order. Records for IDs not registered in
+ *   the registry are dropped and counted. Stops early at a cell a producer
+ *   has claimed but not yet written.
+ *
+ * Performance:
+ *   O(records), grouping included (hash lookup plus counting scatter).
+ *   Zero allocations.
+ *
+ * Thread Safety:
+ *   Call from the thread that appends to the registry's series; one
+ *   drainer at a time. Producers may push concurrently.
+ */
+int ag_ingress_drain(ag_ingress_t* q, size_t max_records, size_t* out_records);
+
+/*
+ * Read the queue counters.
+ *
+ * Returns:
+ *   AG_OK on success, AG_ERR_INVALID_ARG if q or out is NULL.
+ *
+ * Thread Safety:
+ *   Call from the draining thread.
+ */
+int ag_ingress_stats(const ag_ingress_t* q, ag_ingress_stats_t* out);
+
+/*
+ * Get the queue capacity.
+ *
+ * Returns:
+ *   Records the queue holds (the rounded-up capacity), 0 if q is NULL.
+ */
+size_t ag_ingress_capacity(const ag_ingress_t* q);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AG_INGRESS_H */
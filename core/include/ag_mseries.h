@@ -0,0 +1,197 @@
+/*
+ * ag_mseries.h - Multi-Column Series API
+ *
+ * Purpose: Fixed-width rows (e.g. bid, ask, bid size, ask size, mid) stored
+ *          in one ring: K value columns share a single timestamp column
+ *          and a single set of ring counters.
+ *
+ * Thread Safety: NOT thread-safe for appends; one writer at a time. Column
+ *   handles from ag_mseries_column() follow the read rules of
+ *   ag_timeseries.h (lock-free readers when created with AG_MSERIES_SPMC).
+ * Memory Model: One zero-filled mapping holds the timestamp column and the
+ *   K value columns, each a contiguous, 64-byte-aligned array. A row costs
+ *   8 + 8K bytes instead of 16K for K separate series.
+ *
+ * Copyright (c) 2025 AlgorithmicGrid
+ */
+
+#ifndef AG_MSERIES_H
+#define AG_MSERIES_H
+
+#include "ag_timeseries.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Opaque handle - internal structure hidden from users */
+typedef struct ag_mseries_t ag_mseries_t;
+
+/* Creation flags for ag_mseries_create */
+#define AG_MSERIES_SPMC     0x1u    /* One writer, lock-free readers (as create_spmc) */
+
+/*
+ * Create a multi-column series.
+ *
+ * Parameters:
+ *   capacity - Maximum number of rows to store (must be > 0)
+ *   columns  - Number of value columns K (must be > 0)
+ *   flags    - Bitwise OR of AG_MSERIES_* flags, or 0
+ *
+ * Returns:
+ *   Handle, or NULL on invalid arguments / allocation failure.
+ *
+ * Memory:
+ *   Call ag_mseries_destroy() to free.
+ *
+ * Thread Safety:
+ *   Safe to call concurrently from multiple threads.
+ */
+ag_mseries_t* ag_mseries_create(size_t capacity, size_t columns, unsigned flags);
+
+/*
+ * Destroy a multi-column series and its column handles.
+ *
+ * Parameters:
+ *   ms - Handle (NULL safe - no-op if NULL)
+ *
+ * Thread Safety:
+ *   NOT safe. No column handle may be in use.
+ */
+void ag_mseries_destroy(ag_mseries_t* ms);
+
+/*
+ * Append one row.
+ *
+ * Parameters:
+ *   ms           - Handle
+ *   timestamp_ms - Row timestamp
+ *   row          - K values, column 0 first
+ *
+ * Returns:
+ *   AG_OK on success, AG_ERR_INVALID_ARG if ms or row is NULL
+ *
+ * Behavior:
+ *   Overwrites the oldest row when full. Ordering is tracked as for
+ *   ag_timeseries_append(); in SPMC mode the whole row becomes visible
+ *   at once.
+ *
+ * Performance:
+ *   O(K), zero allocations; one counter update per row instead of per value.
+ *
+ * Thread Safety:
+ *   NOT safe. Appends from one thread at a time.
+ */
+int ag_mseries_append_row(ag_mseries_t* ms, int64_t timestamp_ms, const double* row);
+
+/*
+ * Get a read-only series handle for one column.
+ *
+ * Parameters:
+ *   ms     - Handle
+ *   column - Column index (0 to K-1)
+ *
+ * Returns:
+ *   Series handle, or NULL if ms is NULL or column >= K. Owned by ms
+ *   (ag_timeseries_destroy() is a no-op).
+ *
+ * Behavior:
+ *   The handle sees the shared timestamps with this column's values, so
+ *   every ag_timeseries.h read function works on it: query_last/range,
+ *   view_last/range (spans point straight into the column), aggregate_range,
+ *   query_buckets, asof/align, cursors. Functions that modify the buffer or
+ *   attach state (append, enable_stats/cold/rollups/reorder) return
+ *   AG_ERR_INVALID_ARG.
+ *
+ * Thread Safety:
+ *   Safe to call (handles are fixed at creation).
+ */
+const ag_timeseries_t* ag_mseries_column(const ag_mseries_t* ms, size_t column);
+
+/*
+ * Query newest rows for several columns at once.
+ *
+ * Parameters:
+ *   ms             - Handle
+ *   columns        - Indices of the ncols columns to return
+ *   ncols          - Number of requested columns
+ *   max_points     - Maximum number of rows to retrieve
+ *   out_timestamps - Output timestamps (space for max_points)
+ *   out_columns    - ncols output arrays (each with space for max_points),
+ *                    filled in the order of 'columns'
+ *
+ * Returns:
+ *   Number of rows written. Returns 0 on NULL arguments, ncols == 0 or a
+ *   column index >= K.
+ *
+ * Behavior:
+ *   Rows ordered newest to oldest, as ag_timeseries_query_last().
+ *
+ * Thread Safety:
+ *   NOT safe. Caller must serialize access with append operations.
+ *   SPMC: safe concurrently with the writer (lock-free snapshot).
+ */
+size_t ag_mseries_query_last(
+    const ag_mseries_t* ms,
+    const size_t* columns,
+    size_t ncols,
+    size_t max_points,
+    int64_t* out_timestamps,
+    double* const* out_columns
+);
+
+/*
+ * Query rows in time range [start_ms, end_ms] inclusive for several columns.
+ *
+ * Parameters:
+ *   ms             - Handle
+ *   start_ms       - Start timestamp (inclusive)
+ *   end_ms         - End timestamp (inclusive)
+ *   columns        - Indices of the ncols columns to return
+ *   ncols          - Number of requested columns
+ *   max_points     - Maximum number of rows to retrieve
+ *   out_timestamps - Output timestamps (space for max_points)
+ *   out_columns    - ncols output arrays (each with space for max_points),
+ *                    filled in the order of 'columns'
+ *
+ * Returns:
+ *   Number of rows written. Returns 0 on NULL arguments, ncols == 0, a
+ *   column index >= K, or start_ms > end_ms.
+ *
+ * Behavior:
+ *   Rows ordered oldest to newest, as ag_timeseries_query_range(). The
+ *   timestamp column is searched once; each requested column is then
+ *   copied with at most two memcpy calls.
+ *
+ * Performance:
+ *   O(log n + k * ncols) when timestamps are non-decreasing, O(n) scan
+ *   otherwise.
+ *
+ * Thread Safety:
+ *   NOT safe. Caller must serialize access with append operations.
+ *   SPMC: safe concurrently with the writer (lock-free snapshot).
+ */
+size_t ag_mseries_query_range(
+    const ag_mseries_t* ms,
+    int64_t start_ms,
+    int64_t end_ms,
+    const size_t* columns,
+    size_t ncols,
+    size_t max_points,
+    int64_t* out_timestamps,
+    double* const* out_columns
+);
+
+/*
+ * Get number of value columns.
+ *
+ * Returns:
+ *   K given at creation (0 if ms is NULL).
+ */
+size_t ag_mseries_columns(const ag_mseries_t* ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AG_MSERIES_H */
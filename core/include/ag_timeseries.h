@@ -3,7 +3,9 @@
  *
  * Purpose: Lock-free, zero-allocation ring buffer for storing time-series metrics.
  *
- * Thread Safety: NOT thread-safe. Caller must provide external synchronization.
+ * Thread Safety: NOT thread-safe. Caller must provide external synchronization,
+ *   except for buffers created with ag_timeseries_create_spmc(), which allow
+ *   one writer and any number of concurrent readers without locks.
  * Memory Model: Fixed capacity allocated at creation time, no allocations in hot paths.
  * ABI Stability: Opaque handle design allows internal changes without breaking API.
  *
@@ -23,12 +25,201 @@ extern "C" {
 /* Opaque handle - internal structure hidden from users */
 typedef struct ag_timeseries_t ag_timeseries_t;
 
+/* Opaque worker pool for multi-series calls (ag_timeseries_aggregate_many) */
+typedef struct ag_timeseries_pool_t ag_timeseries_pool_t;
+
+/* Opaque mergeable quantile sketch (ag_timeseries_sketch_create) */
+typedef struct ag_timeseries_sketch_t ag_timeseries_sketch_t;
+
+/* Most bins a quantile sketch may have (16 bytes each: one count per sign) */
+#define AG_SKETCH_MAX_BINS  (1u << 20)
+
 /* Error codes - consistent with MULTI_AGENT_PLAN.md Section 3.1 */
 #define AG_OK               0   /* Success */
 #define AG_ERR_INVALID_ARG -1   /* Invalid argument (NULL pointer, invalid capacity, etc.) */
 #define AG_ERR_NOMEM       -2   /* Memory allocation failed */
-#define AG_ERR_FULL        -3   /* Buffer is full (not used in ring buffer, kept for compatibility) */
+#define AG_ERR_FULL        -3   /* No room: registry full, or snapshot output buffer too small */
 #define AG_ERR_EMPTY       -4   /* Buffer is empty */
+#define AG_ERR_UNORDERED   -5   /* Operation needs non-decreasing timestamps */
+#define AG_ERR_IO          -6   /* File or mapping operation failed */
+#define AG_ERR_LAPPED      -7   /* Cursor was overrun; some points were lost */
+#define AG_ERR_UNSUPPORTED -8   /* Feature not compiled into this build */
+
+/* Aggregates for ag_timeseries_aggregate_range */
+#define AG_AGG_COUNT        0   /* Number of points in range */
+#define AG_AGG_SUM          1   /* Sum of values */
+#define AG_AGG_MEAN         2   /* Arithmetic mean of values */
+#define AG_AGG_MIN          3   /* Smallest value (NaN ignored) */
+#define AG_AGG_MAX          4   /* Largest value (NaN ignored) */
+
+/* Value column types for ag_timeseries_create_typed */
+#define AG_VALUE_F64        0   /* double (default) */
+#define AG_VALUE_F32        1   /* float */
+#define AG_VALUE_I64        2   /* int64_t */
+#define AG_VALUE_I32        3   /* int32_t */
+
+/*
+ * Zero-copy span: 'length' consecutive points stored contiguously in the ring.
+ */
+typedef struct {
+    const int64_t* timestamps;  /* First timestamp of the span */
+    const double* values;       /* First value of the span */
+    size_t length;              /* Number of points in the span */
+} ag_timeseries_span_t;
+
+/*
+ * Zero-copy view: up to two spans pointing straight into the ring, oldest
+ * first. Points are identified by append sequence [begin_seq, end_seq); see
+ * ag_timeseries_sequence(). The pointers stay valid for the buffer's
+ * lifetime, but the data they point to is overwritten once the writer laps
+ * the view - check with ag_timeseries_view_valid().
+ */
+typedef struct {
+    ag_timeseries_span_t spans[2];  /* Spans in chronological order */
+    size_t span_count;              /* Number of valid spans (0 to 2) */
+    size_t length;                  /* Total points across all spans */
+    uint64_t begin_seq;             /* Sequence of the oldest point in view */
+    uint64_t end_seq;               /* Sequence one past the newest point */
+} ag_timeseries_view_t;
+
+/* Placement flags for ag_timeseries_create_ex */
+#define AG_CREATE_SPMC          0x01u   /* As ag_timeseries_create_spmc */
+#define AG_CREATE_INTERLEAVED   0x02u   /* As ag_timeseries_create_interleaved */
+#define AG_CREATE_HUGEPAGES     0x04u   /* Huge pages (MAP_HUGETLB, else THP advice) */
+#define AG_CREATE_LAZY          0x08u   /* Skip prefaulting; pages fault on first write */
+#define AG_CREATE_MLOCK         0x10u   /* Lock the data pages in RAM */
+#define AG_CREATE_NUMA          0x20u   /* Bind the data pages to numa_node */
+
+/* Highest NUMA node number accepted by ag_timeseries_create_ex, plus one */
+#define AG_CREATE_MAX_NUMA_NODES 1024
+
+/*
+ * Options for ag_timeseries_create_ex. A zeroed struct gives the defaults:
+ * plain pages on the creating thread's node, prefaulted at create time.
+ */
+typedef struct {
+    unsigned flags;     /* Bitwise OR of AG_CREATE_* flags */
+    int numa_node;      /* Node for AG_CREATE_NUMA, else ignored */
+    int value_type;     /* AG_VALUE_* column type (0 = double) */
+} ag_timeseries_options_t;
+
+/* Snapshot flags for ag_timeseries_serialize */
+#define AG_SERIAL_DELTA     0x01u   /* Timestamps as zigzag varint deltas (~1-2 bytes each) */
+
+/* Starting points for ag_timeseries_cursor_init */
+#define AG_CURSOR_OLDEST    0   /* Replay the points stored now, then new ones */
+#define AG_CURSOR_LATEST    1   /* Only points appended after init */
+
+/*
+ * Incremental reader position: the append sequence of the next point to
+ * deliver. Caller-allocated and freely copyable; one per consumer.
+ */
+typedef struct {
+    uint64_t next_seq;  /* Sequence of the next point to read */
+    uint64_t lost;      /* Total points overwritten before they were read */
+} ag_ts_cursor_t;
+
+/*
+ * Rolling window statistics over all stored points.
+ */
+typedef struct {
+    size_t count;       /* Number of points in window */
+    double sum;         /* Sum of values (compensated) */
+    double sum_sq;      /* Sum of squared values (compensated) */
+    double mean;        /* sum / count */
+    double variance;    /* Population variance (>= 0), from sums shifted by a window value */
+    double min;         /* Smallest value in window */
+    double max;         /* Largest value in window */
+} ag_timeseries_stats_t;
+
+/*
+ * Rollup level: one downsampled child ring (see ag_timeseries_enable_rollups).
+ */
+typedef struct {
+    int64_t bucket_ms;  /* Bucket width (> 0, multiple of the previous level's) */
+    size_t capacity;    /* Closed buckets retained (> 0) */
+} ag_rollup_level_t;
+
+/* Maximum levels in a rollup chain */
+#define AG_ROLLUP_MAX_LEVELS 8
+
+/*
+ * Rollup point: aggregate of the points in [start_ms, start_ms + bucket_ms).
+ * Raw points returned by ag_timeseries_query_rollup have count 1 and
+ * last == mean == min == max == value.
+ */
+typedef struct {
+    int64_t start_ms;   /* Bucket start, epoch-aligned (raw: timestamp) */
+    double last;        /* Value of the newest point */
+    double mean;        /* Arithmetic mean */
+    double min;         /* Smallest value */
+    double max;         /* Largest value */
+    size_t count;       /* Number of raw points (always > 0) */
+} ag_timeseries_rollup_t;
+
+/*
+ * Compressed cold tier occupancy (see ag_timeseries_enable_cold).
+ */
+typedef struct {
+    size_t points;          /* Points held in compressed blocks */
+    size_t blocks;          /* Sealed blocks (plus one open block being filled) */
+    size_t bytes;           /* Compressed bytes in use */
+    size_t budget_bytes;    /* Byte budget given at enable time */
+} ag_timeseries_cold_stats_t;
+
+/*
+ * Reorder buffer counters (see ag_timeseries_enable_reorder).
+ */
+typedef struct {
+    size_t pending;         /* Points staged, not yet visible */
+    uint64_t rejected;      /* Points dropped as later than the window */
+    uint64_t reordered;     /* Points placed before an already staged point */
+    int64_t window_ms;      /* Hold time given at enable time */
+    size_t max_points;      /* Staging depth given at enable time */
+} ag_timeseries_reorder_stats_t;
+
+/*
+ * Downsampled bucket: open/high/low/close/count of the points in
+ * [start_ms, start_ms + bucket_ms).
+ */
+typedef struct {
+    int64_t start_ms;   /* Bucket start, a multiple of bucket_ms (epoch-aligned) */
+    double open;        /* Value of the first point in the bucket */
+    double high;        /* Largest value */
+    double low;         /* Smallest value */
+    double close;       /* Value of the last point in the bucket */
+    size_t count;       /* Number of points (always > 0) */
+} ag_timeseries_bucket_t;
+
+/* Buckets per latency histogram (see ag_timeseries_histogram_bucket_ns) */
+#define AG_METRICS_BUCKETS  128
+
+/*
+ * Log-linear latency histogram (HDR-style). Four sub-buckets per power of
+ * two: bucket b covers [bucket_ns(b), bucket_ns(b + 1)), at most 25% wide
+ * relative to its lower bound. The last bucket also takes everything
+ * above ~8.6 s.
+ */
+typedef struct {
+    uint64_t count;                         /* Samples recorded */
+    uint64_t sum_ns;                        /* Sum of all samples */
+    uint64_t max_ns;                        /* Largest sample */
+    uint64_t buckets[AG_METRICS_BUCKETS];   /* Samples per bucket */
+} ag_timeseries_histogram_t;
+
+/*
+ * Instrumentation counters (see ag_timeseries_get_metrics). All counters
+ * are monotonic since creation (process start for the global set).
+ */
+typedef struct {
+    uint64_t appends;           /* Points handed to the ring (batch points included) */
+    uint64_t overwrites;        /* Points that left the window by wraparound */
+    uint64_t queries;           /* Read calls (query, view, aggregate, buckets, as-of, cursor) */
+    uint64_t points_scanned;    /* Stored points those calls examined */
+    uint64_t points_returned;   /* Points copied out, or matched by aggregates */
+    uint64_t retries;           /* Lock-free reads repeated after the writer lapped them */
+    ag_timeseries_histogram_t query_latency;    /* Wall time per read call */
+} ag_timeseries_metrics_t;
 
 /*
  * Create time-series buffer with fixed capacity.
@@ -48,6 +239,403 @@ typedef struct ag_timeseries_t ag_timeseries_t;
  */
 ag_timeseries_t* ag_timeseries_create(size_t capacity);
 
+/*
+ * Create single-producer/multi-consumer time-series buffer.
+ *
+ * Parameters:
+ *   capacity - Maximum number of data points to store (must be > 0)
+ *
+ * Returns:
+ *   Pointer to allocated time-series buffer, or NULL on failure.
+ *
+ * Behavior:
+ *   Same as ag_timeseries_create(), but append publishes each point with an
+ *   atomic sequence so one writer thread and any number of reader threads
+ *   can use the buffer without locks. Readers never block the writer:
+ *   ag_timeseries_query_last, ag_timeseries_query_range, ag_timeseries_size
+ *   and ag_timeseries_is_monotonic take a consistent snapshot and silently
+ *   retry if the writer overwrote slots they were copying. A retrying reader
+ *   skips the oldest points it keeps racing with, so a query that was lapped
+ *   may return fewer of the oldest points than were present when it began.
+ *
+ * Thread Safety:
+ *   Safe to call concurrently from multiple threads. Appends must come from
+ *   a single thread at a time.
+ */
+ag_timeseries_t* ag_timeseries_create_spmc(size_t capacity);
+
+/*
+ * Create time-series buffer with capacity rounded up to a power of two.
+ *
+ * Parameters:
+ *   capacity - Minimum number of data points to store (must be > 0)
+ *
+ * Returns:
+ *   Pointer to allocated time-series buffer, or NULL on failure.
+ *   ag_timeseries_capacity() reports the rounded capacity.
+ *
+ * Behavior:
+ *   Ring slots are addressed with a mask instead of a modulo. Buffers from
+ *   ag_timeseries_create() whose capacity is already a power of two get the
+ *   same fast path automatically.
+ *
+ * Thread Safety:
+ *   Safe to call concurrently from multiple threads.
+ */
+ag_timeseries_t* ag_timeseries_create_pow2(size_t capacity);
+
+/*
+ * Create time-series buffer storing each point as an interleaved pair.
+ *
+ * Parameters:
+ *   capacity - Maximum number of data points to store (must be > 0)
+ *
+ * Returns:
+ *   Pointer to allocated time-series buffer, or NULL on failure.
+ *
+ * Behavior:
+ *   Points are stored as {int64_t timestamp; double value;} pairs in one
+ *   64-byte-aligned block (four pairs per cache line) instead of two
+ *   separate arrays, so reading a point touches one cache line rather than
+ *   two. Favors ag_timeseries_query_last() on small N and cold caches.
+ *   Trade-offs:
+ *   - ag_timeseries_view_last/range return AG_ERR_INVALID_ARG, since spans
+ *     must be contiguous arrays.
+ *   - ag_timeseries_aggregate_range reduces with scalar code (SIMD kernels
+ *     need split arrays).
+ *   Every other function behaves as for ag_timeseries_create().
+ *
+ * Memory:
+ *   16 bytes per point, rounded up to a whole cache line.
+ *
+ * Thread Safety:
+ *   Safe to call concurrently from multiple threads.
+ */
+ag_timeseries_t* ag_timeseries_create_interleaved(size_t capacity);
+
+/*
+ * Create time-series buffer with explicit page placement.
+ *
+ * Parameters:
+ *   capacity - Maximum number of data points to store (must be > 0)
+ *   options  - Placement options, or NULL for the defaults
+ *
+ * Returns:
+ *   Pointer to allocated time-series buffer, or NULL on failure: unknown
+ *   flags or value_type, AG_CREATE_INTERLEAVED with a value_type other
+ *   than AG_VALUE_F64, numa_node outside [0, AG_CREATE_MAX_NUMA_NODES), a node the
+ *   system cannot bind to (or no mbind support), or mlock refused (see
+ *   RLIMIT_MEMLOCK).
+ *
+ * Behavior:
+ *   Data arrays come from an anonymous page mapping instead of malloc, so
+ *   they are zero-filled by the kernel rather than memset.
+ *   - AG_CREATE_HUGEPAGES: MAP_HUGETLB if the system has a reserved pool,
+ *     otherwise transparent huge page advice (advisory, never fails).
+ *   - AG_CREATE_NUMA: pages are bound (MPOL_BIND) to numa_node before any
+ *     is touched, so they are allocated there whichever thread creates.
+ *   - Without AG_CREATE_LAZY every page is faulted in during create, so
+ *     appends never take a page fault. With it create is O(1) and each
+ *     page is allocated on first write - on the appender's node under the
+ *     default first-touch policy, even without AG_CREATE_NUMA.
+ *   - AG_CREATE_MLOCK: pages are locked after placement (this faults them
+ *     in, so LAZY only skips the separate prefault pass).
+ *   The handle itself is small and stays on the heap. The buffer otherwise
+ *   behaves as one from ag_timeseries_create(), _spmc(), _interleaved() or
+ *   _typed() (value_type).
+ *
+ * Thread Safety:
+ *   Safe to call concurrently from multiple threads.
+ */
+ag_timeseries_t* ag_timeseries_create_ex(size_t capacity,
+                                         const ag_timeseries_options_t* options);
+
+/*
+ * Create time-series buffer with a narrower value column.
+ *
+ * Parameters:
+ *   capacity   - Maximum number of data points to store (must be > 0)
+ *   value_type - AG_VALUE_F64, AG_VALUE_F32, AG_VALUE_I64 or AG_VALUE_I32
+ *
+ * Returns:
+ *   Pointer to allocated time-series buffer, or NULL on failure or an
+ *   unknown value_type.
+ *
+ * Behavior:
+ *   Values are stored in the column type; timestamps stay int64_t.
+ *   - The double API converts: appends round to the column type (integers
+ *     to nearest, saturating, NaN stored as 0) and queries widen back.
+ *     float, int32_t and int64_t up to 2^53 round-trip exactly.
+ *   - The _native functions (ag_timeseries_append_batch_native,
+ *     ag_timeseries_query_last_native/query_range_native) move values in
+ *     the column type with memcpy; ag_timeseries_append_i64 stores
+ *     integers exactly.
+ *   - Aggregates, buckets, as-of, cursors and rolling stats run typed
+ *     kernels and report doubles.
+ *   - ag_timeseries_view_last/range return AG_ERR_INVALID_ARG (spans
+ *     are double arrays). The cold tier and rollups hold doubles, so
+ *     int64_t beyond 2^53 loses precision through them; the reorder
+ *     buffer stages int64 values exactly.
+ *   AG_VALUE_F64 gives the same buffer as ag_timeseries_create().
+ *
+ * Memory:
+ *   8 + sizeof(value type) bytes per point: 12 for F32/I32 instead of 16.
+ *
+ * Thread Safety:
+ *   Safe to call concurrently from multiple threads.
+ */
+ag_timeseries_t* ag_timeseries_create_typed(size_t capacity, int value_type);
+
+/*
+ * Open (or create) a time-series buffer persisted in a memory-mapped file.
+ *
+ * Parameters:
+ *   path     - File path. Created if missing or empty.
+ *   capacity - Maximum number of data points (must be > 0 and match the file)
+ *
+ * Returns:
+ *   Pointer to buffer holding the points stored in the file, or NULL if the
+ *   file cannot be opened/mapped, or exists but is not a ring file with this
+ *   capacity and format version (it is left untouched).
+ *
+ * Recovery:
+ *   The file has a versioned header with a checksum. Counters are mirrored
+ *   into the file on every append, so points survive a process crash
+ *   without replay:
+ *   - Closed cleanly (destroy or sync): data checksum verified; a mismatch
+ *     recovers an empty buffer.
+ *   - Killed between appends: the page cache holds every write; the last
+ *     points and the sequence counter are restored as they were.
+ *   - Killed inside an append: the oldest points that append was
+ *     overwriting are dropped and the survivors are renumbered from 0.
+ *   Durability against power loss requires ag_timeseries_sync().
+ *
+ * Memory:
+ *   Maps 4 KiB + 16 bytes per point. ag_timeseries_destroy() syncs and
+ *   unmaps. Only one process may append to a file at a time.
+ *
+ * Thread Safety:
+ *   Safe to call concurrently. The buffer follows ag_timeseries_create() rules.
+ */
+ag_timeseries_t* ag_timeseries_open_mmap(const char* path, size_t capacity);
+
+/*
+ * Flush a file-backed buffer to disk.
+ *
+ * Parameters:
+ *   ts - Buffer from ag_timeseries_open_mmap()
+ *
+ * Returns:
+ *   AG_OK on success, AG_ERR_INVALID_ARG if ts is NULL or not file-backed,
+ *   AG_ERR_IO if msync() fails.
+ *
+ * Behavior:
+ *   Records a checksum of the counters and arrays, marks the file clean,
+ *   and waits for msync(MS_SYNC). The next append marks it dirty again.
+ *
+ * Performance:
+ *   O(capacity) plus disk write-back.
+ *
+ * Thread Safety:
+ *   NOT safe. Call from the writer thread.
+ */
+int ag_timeseries_sync(ag_timeseries_t* ts);
+
+/*
+ * Write the stored points to a compact, versioned binary snapshot.
+ *
+ * Parameters:
+ *   ts       - Time-series buffer handle
+ *   buf      - Output buffer (NULL only with len 0)
+ *   len      - Size of buf in bytes
+ *   flags    - 0 or AG_SERIAL_DELTA
+ *   out_len  - Bytes written; with AG_ERR_FULL, the size buf must have
+ *
+ * Returns:
+ *   AG_OK on success
+ *   AG_ERR_FULL if len is below the size bound for the stored points
+ *     (call with len 0 to size the buffer; a concurrent writer can grow the
+ *     window between calls, so retry on AG_ERR_FULL)
+ *   AG_ERR_INVALID_ARG if ts or out_len is NULL, or flags are unknown
+ *   AG_ERR_UNSUPPORTED on big-endian hosts
+ *
+ * Behavior:
+ *   The bound is 64 + 8 * size + 8 * size (raw) or 64 + 10 * size +
+ *   8 * size (delta), each section rounded up to 8 bytes; *out_len is the
+ *   exact size, often far below the delta bound. Values keep the series'
+ *   column type. Only the ring window is written (not the cold tier,
+ *   rollups, stats or staged reorder points).
+ *
+ * Snapshot Layout (stable, little-endian, version 1):
+ *   offset  0  char[8]   magic "AGTSSER1"
+ *   offset  8  uint32    version (1)
+ *   offset 12  uint32    header size (64)
+ *   offset 16  uint32    flags (AG_SERIAL_*)
+ *   offset 20  uint32    value type (AG_VALUE_*)
+ *   offset 24  uint64    count - points, oldest first
+ *   offset 32  uint64    capacity of the source buffer
+ *   offset 40  uint64    payload size - bytes after the header
+ *   offset 48  uint64    reserved (0)
+ *   offset 56  uint64    checksum over offsets 0..55 and the payload,
+ *                        as 64-bit words: h = 0xcbf29ce484222325, then per
+ *                        word h ^= w; h *= 0x100000001b3; h ^= h >> 29
+ *   offset 64            timestamps: int64[count], or with AG_SERIAL_DELTA
+ *                        count LEB128 varints of zigzag(t[i] - t[i-1])
+ *                        (t[-1] = 0, differences wrap modulo 2^64);
+ *                        zero-padded to a multiple of 8 bytes
+ *   then                 values: count cells of the value type, zero-padded
+ *                        to a multiple of 8 bytes
+ *
+ * Performance:
+ *   O(size): two memcpy per column for raw split buffers, one varint per
+ *   point with AG_SERIAL_DELTA. Zero allocations.
+ *
+ * Thread Safety:
+ *   Same as ag_timeseries_query_last(); SPMC readers take a consistent
+ *   snapshot concurrently with the writer.
+ */
+int ag_timeseries_serialize(
+    const ag_timeseries_t* ts,
+    void* buf,
+    size_t len,
+    unsigned flags,
+    size_t* out_len
+);
+
+/*
+ * Append the points of a snapshot to an existing buffer.
+ *
+ * Parameters:
+ *   ts   - Time-series buffer handle (value type must match the snapshot)
+ *   buf  - Snapshot from ag_timeseries_serialize()
+ *   len  - Bytes available at buf (>= the snapshot size)
+ *
+ * Returns:
+ *   AG_OK on success
+ *   AG_ERR_INVALID_ARG if ts is NULL or read-only, the value type differs,
+ *     or buf is not a valid snapshot (bad magic, version, size or checksum)
+ *   AG_ERR_UNORDERED if a reorder buffer rejected points (as
+ *     ag_timeseries_append_batch_native)
+ *   AG_ERR_UNSUPPORTED on big-endian hosts
+ *
+ * Behavior:
+ *   The whole snapshot is validated before anything is appended. Points
+ *   are then appended oldest first with ag_timeseries_append_batch_native(),
+ *   so stats, cold tier, rollups, TTL and ordering treat them like any other
+ *   appends; more points than capacity keep the newest. A raw snapshot at
+ *   an 8-byte-aligned address is appended in place in one call.
+ *
+ * Performance:
+ *   O(count): checksum pass plus one copy pass (raw); decoding goes
+ *   through 256-point stack chunks. Zero allocations.
+ *
+ * Thread Safety:
+ *   NOT safe. Call from the writer thread.
+ */
+int ag_timeseries_load(ag_timeseries_t* ts, const void* buf, size_t len);
+
+/*
+ * Create a buffer holding the points of a snapshot.
+ *
+ * Parameters:
+ *   buf       - Snapshot from ag_timeseries_serialize()
+ *   len       - Bytes available at buf
+ *   capacity  - Capacity of the new buffer, 0 for the source's capacity
+ *
+ * Returns:
+ *   New buffer (ag_timeseries_create_typed with the snapshot's value type),
+ *   or NULL if the snapshot is invalid, allocation failed, or the host is
+ *   big-endian.
+ *
+ * Behavior:
+ *   Equivalent to create_typed() followed by ag_timeseries_load(). The
+ *   points get new sequence numbers starting at 0.
+ *
+ * Thread Safety:
+ *   Safe to call concurrently (the new buffer is not shared yet).
+ */
+ag_timeseries_t* ag_timeseries_deserialize(const void* buf, size_t len, size_t capacity);
+
+/*
+ * Create a buffer in a POSIX shared-memory segment for other processes.
+ *
+ * Parameters:
+ *   name     - Segment name for shm_open(), e.g. "/ag_btc_mid"
+ *   capacity - Maximum number of data points to store (must be > 0)
+ *
+ * Returns:
+ *   Writer handle (SPMC semantics, see ag_timeseries_create_spmc), or NULL
+ *   if the segment cannot be created or another live process owns 'name'.
+ *
+ * Behavior:
+ *   A segment left behind by a writer that exited or crashed is replaced.
+ *   Readers in any process attach with ag_timeseries_attach_shm() and use
+ *   the regular query, view and cursor functions, copying straight out of
+ *   the shared mapping. ag_timeseries_destroy() marks the segment closed
+ *   and unlinks the name; attached readers keep their mapping.
+ *   Rolling stats stay private to the writer; cold tiers and rollups are
+ *   unavailable (SPMC).
+ *
+ * Segment Layout (stable, little-endian host order, version 1):
+ *   offset  0  char[8]   magic "AGTSSHM1"
+ *   offset  8  uint32    version (1)
+ *   offset 12  uint32    header size (4096)
+ *   offset 16  uint64    capacity
+ *   offset 24  uint64    state: 0 initializing, 1 live, 2 closed
+ *   offset 32  uint64    writer pid
+ *   offset 64  uint64    appended - points ever appended (release-published)
+ *   offset 72  uint64    claimed  - end sequence of the append in progress
+ *   offset 80  uint64    ordered_from - sequence of last out-of-order point
+ *   offset 88  uint64    expired  - sequences below it expired (TTL), else 0
+ *   offset 4096          int64  timestamps[capacity]
+ *   then                 double values[capacity]
+ *   Point s lives at slot s % capacity. Foreign readers: load expired
+ *   (acquire), then appended (acquire), copy slots, then discard slots of
+ *   sequences below claimed - capacity (loaded after an acquire fence) or
+ *   below expired.
+ *
+ * Thread Safety:
+ *   Same as ag_timeseries_create_spmc(): one writer thread, any number of
+ *   reader threads and processes.
+ */
+ag_timeseries_t* ag_timeseries_create_shm(const char* name, size_t capacity);
+
+/*
+ * Attach read-only to a shared-memory buffer created by another process.
+ *
+ * Parameters:
+ *   name - Segment name passed to ag_timeseries_create_shm()
+ *
+ * Returns:
+ *   Reader handle, or NULL if the segment does not exist, is not live yet,
+ *   or has a different layout version.
+ *
+ * Behavior:
+ *   Query, view and cursor functions read the writer's points lock-free.
+ *   Functions that modify the buffer return AG_ERR_INVALID_ARG.
+ *   ag_timeseries_destroy() unmaps the segment. The capacity is taken
+ *   from the segment header.
+ *
+ * Thread Safety:
+ *   Safe to call concurrently. Queries follow ag_timeseries_create_spmc().
+ */
+ag_timeseries_t* ag_timeseries_attach_shm(const char* name);
+
+/*
+ * Check whether a shared-memory buffer's writer is still attached.
+ *
+ * Parameters:
+ *   ts - Handle from ag_timeseries_create_shm/attach_shm
+ *
+ * Returns:
+ *   1 while the writer handle exists, 0 once it was destroyed or if ts is
+ *   not shared. A crashed writer leaves the segment marked live.
+ *
+ * Thread Safety:
+ *   Safe to call concurrently.
+ */
+int ag_timeseries_shm_live(const ag_timeseries_t* ts);
+
 /*
  * Destroy time-series buffer.
  *
@@ -55,7 +643,8 @@ ag_timeseries_t* ag_timeseries_create(size_t capacity);
  *   ts - Time-series buffer handle (NULL safe - no-op if NULL)
  *
  * Memory:
- *   Frees all memory associated with the buffer.
+ *   Frees all memory associated with the buffer. No-op for series owned by
+ *   an ag_tsdb_t registry (freed by ag_tsdb_destroy()).
  *
  * Thread Safety:
  *   NOT safe. Caller must ensure no other threads are accessing this buffer.
@@ -72,18 +661,108 @@ void ag_timeseries_destroy(ag_timeseries_t* ts);
  *
  * Returns:
  *   AG_OK on success
- *   AG_ERR_INVALID_ARG if ts is NULL
+ *   AG_ERR_INVALID_ARG if ts is NULL or read-only (shared-memory reader,
+ *     ag_mseries column)
+ *   AG_ERR_UNORDERED if a reorder buffer rejected the point as too late
  *
  * Behavior:
  *   Ring buffer implementation - oldest data is overwritten when full.
- *   No validation of timestamp ordering (caller's responsibility).
+ *   No validation of timestamp ordering (caller's responsibility) unless
+ *   ag_timeseries_enable_reorder() staged the buffer.
+ *   Ordering is tracked: an append older than the newest stored point marks
+ *   the window unordered until the points before it have been evicted.
  *   NO ALLOCATIONS - constant time O(1) operation.
  *
  * Thread Safety:
  *   NOT safe. Caller must serialize access.
+ *   SPMC buffers: one writer thread, concurrent with readers.
  */
 int ag_timeseries_append(ag_timeseries_t* ts, int64_t timestamp_ms, double value);
 
+/*
+ * Append multiple data points in one call.
+ *
+ * Parameters:
+ *   ts            - Time-series buffer handle
+ *   timestamps_ms - Array of count timestamps in milliseconds (Unix epoch)
+ *   values        - Array of count metric values
+ *   count         - Number of points to append (0 is a no-op)
+ *
+ * Returns:
+ *   AG_OK on success
+ *   AG_ERR_INVALID_ARG if ts is NULL or read-only (shared-memory reader,
+ *     ag_mseries column), or an array is NULL with count > 0
+ *   AG_ERR_UNORDERED if a reorder buffer rejected any point (the others
+ *     are still appended)
+ *
+ * Behavior:
+ *   Equivalent to calling ag_timeseries_append() for each point in order,
+ *   but writes with at most two memcpy calls split at the wrap point.
+ *   If count > capacity, only the last capacity points are written.
+ *   NO ALLOCATIONS - O(count) copy plus an O(count) ordering check.
+ *
+ * Thread Safety:
+ *   NOT safe. Caller must serialize access.
+ *   SPMC buffers: one writer thread; readers see the batch published at once.
+ */
+int ag_timeseries_append_batch(
+    ag_timeseries_t* ts,
+    const int64_t* timestamps_ms,
+    const double* values,
+    size_t count
+);
+
+/*
+ * Append one point with an integer value.
+ *
+ * Parameters:
+ *   ts           - Time-series buffer handle
+ *   timestamp_ms - Unix timestamp in milliseconds
+ *   value        - Integer value
+ *
+ * Returns:
+ *   As ag_timeseries_append().
+ *
+ * Behavior:
+ *   Stored exactly in AG_VALUE_I64 series (no round trip through double),
+ *   also when staged in a reorder buffer; the cold tier and rollups still
+ *   see it as a double. Converted as by ag_timeseries_append() for every
+ *   other value type.
+ *
+ * Thread Safety:
+ *   NOT safe. Caller must serialize access.
+ */
+int ag_timeseries_append_i64(ag_timeseries_t* ts, int64_t timestamp_ms, int64_t value);
+
+/*
+ * Append multiple points with values in the series' own column type.
+ *
+ * Parameters:
+ *   ts             - Time-series buffer handle
+ *   timestamps_ms  - Array of timestamps (oldest first)
+ *   values         - Array of count values of the series' value type
+ *                    (see ag_timeseries_value_type)
+ *   count          - Number of points
+ *
+ * Returns:
+ *   As ag_timeseries_append_batch().
+ *
+ * Behavior:
+ *   Values are copied with at most two memcpy calls, without conversion.
+ *   With a reorder buffer, cold tier or rollups attached, points go
+ *   through them one by one as doubles instead.
+ *
+ * Thread Safety:
+ *   NOT safe. Caller must serialize access. In SPMC mode the whole batch is
+ *   published at once.
+ */
+int ag_timeseries_append_batch_native(
+    ag_timeseries_t* ts,
+    const int64_t* timestamps_ms,
+    const void* values,
+    size_t count
+);
+
 /*
  * Query last N points (newest first).
  *
@@ -100,10 +779,12 @@ int ag_timeseries_append(ag_timeseries_t* ts, int64_t timestamp_ms, double value
  * Behavior:
  *   Returns up to max_points, ordered newest to oldest.
  *   If buffer has fewer than max_points, returns all available.
+ *   With a cold tier enabled, continues into the compressed points.
  *   NO ALLOCATIONS - output written to caller-provided buffers.
  *
  * Thread Safety:
  *   NOT safe. Caller must serialize access with append operations.
+ *   SPMC buffers: safe concurrently with the writer (lock-free snapshot).
  */
 size_t ag_timeseries_query_last(
     const ag_timeseries_t* ts,
@@ -131,10 +812,17 @@ size_t ag_timeseries_query_last(
  *   Returns points where start_ms <= timestamp <= end_ms, up to max_points.
  *   Results ordered oldest to newest (chronological).
  *   If more than max_points match, returns first max_points chronologically.
+ *   With a cold tier enabled, matching compressed points come first.
  *   NO ALLOCATIONS - output written to caller-provided buffers.
  *
+ * Performance:
+ *   O(log n + k) when stored timestamps are non-decreasing (see
+ *   ag_timeseries_is_monotonic), O(n) scan otherwise. Cold blocks are
+ *   skipped by timestamp bounds; each overlapping block decodes in O(1024).
+ *
  * Thread Safety:
  *   NOT safe. Caller must serialize access with append operations.
+ *   SPMC buffers: safe concurrently with the writer (lock-free snapshot).
  */
 size_t ag_timeseries_query_range(
     const ag_timeseries_t* ts,
@@ -146,13 +834,1000 @@ size_t ag_timeseries_query_range(
 );
 
 /*
- * Get current number of data points in buffer.
+ * Query last N points with values in the series' own column type.
  *
  * Parameters:
- *   ts - Time-series buffer handle
+ *   As ag_timeseries_query_last(), except out_values has space for
+ *   max_points values of the series' value type.
  *
  * Returns:
- *   Number of points currently stored (0 to capacity).
+ *   Number of points written (0 to max_points).
+ *
+ * Behavior:
+ *   As ag_timeseries_query_last() (newest first), without conversion.
+ *   Cold-tier points are not included.
+ *
+ * Thread Safety:
+ *   As ag_timeseries_query_last().
+ */
+size_t ag_timeseries_query_last_native(
+    const ag_timeseries_t* ts,
+    size_t max_points,
+    int64_t* out_timestamps,
+    void* out_values
+);
+
+/*
+ * Query points in [start_ms, end_ms] with values in the series' own type.
+ *
+ * Parameters:
+ *   As ag_timeseries_query_range(), except out_values has space for
+ *   max_points values of the series' value type.
+ *
+ * Returns:
+ *   Number of points written (0 to max_points).
+ *
+ * Behavior:
+ *   As ag_timeseries_query_range() (oldest first); matching spans of an
+ *   ordered window are copied with memcpy, without conversion.
+ *   Cold-tier points are not included.
+ *
+ * Thread Safety:
+ *   As ag_timeseries_query_range().
+ */
+size_t ag_timeseries_query_range_native(
+    const ag_timeseries_t* ts,
+    int64_t start_ms,
+    int64_t end_ms,
+    size_t max_points,
+    int64_t* out_timestamps,
+    void* out_values
+);
+
+/*
+ * Look up the point in effect at a timestamp (as-of lookup).
+ *
+ * Parameters:
+ *   ts             - Time-series buffer handle
+ *   timestamp_ms   - Query timestamp
+ *   out_timestamp  - Output: timestamp of the matching point
+ *   out_value      - Output: value of the matching point
+ *
+ * Returns:
+ *   AG_OK on success
+ *   AG_ERR_INVALID_ARG if ts or an output pointer is NULL
+ *   AG_ERR_EMPTY if no stored point has timestamp <= timestamp_ms
+ *
+ * Behavior:
+ *   Finds the point with the greatest timestamp <= timestamp_ms; among
+ *   equal timestamps the most recently appended one wins. Only the ring is
+ *   searched: points evicted to a cold tier are not consulted.
+ *
+ * Performance:
+ *   O(log n) when stored timestamps are non-decreasing (see
+ *   ag_timeseries_is_monotonic), O(n) scan otherwise.
+ *
+ * Thread Safety:
+ *   NOT safe. Caller must serialize access with append operations.
+ *   SPMC buffers: safe concurrently with the writer (lock-free snapshot).
+ */
+int ag_timeseries_asof(
+    const ag_timeseries_t* ts,
+    int64_t timestamp_ms,
+    int64_t* out_timestamp,
+    double* out_value
+);
+
+/*
+ * Align several series on common timestamps (as-of merge-join).
+ *
+ * Parameters:
+ *   series      - Array of k time-series buffer handles
+ *   k           - Number of series (matrix columns)
+ *   timestamps  - n query timestamps, non-decreasing
+ *   n           - Number of query timestamps (matrix rows)
+ *   out_matrix  - Output: n * k doubles, row-major
+ *
+ * Returns:
+ *   AG_OK on success
+ *   AG_ERR_INVALID_ARG if a pointer or series handle is NULL, or timestamps
+ *   decrease
+ *   AG_ERR_UNORDERED if a series' stored timestamps are not monotonic
+ *
+ * Behavior:
+ *   out_matrix[i * k + j] is the ag_timeseries_asof value of series[j] at
+ *   timestamps[i], or NAN if that series has no point at or before it.
+ *   Each series is walked once alongside the query timestamps. Cold tiers
+ *   are not consulted. On error the matrix contents are unspecified.
+ *   NO ALLOCATIONS - output written to caller-provided buffer.
+ *
+ * Performance:
+ *   O(log m + m + n) per series of m stored points, instead of n binary
+ *   searches.
+ *
+ * Thread Safety:
+ *   NOT safe. Caller must serialize access with append operations.
+ *   SPMC buffers: safe concurrently with the writer (lock-free snapshot).
+ */
+int ag_timeseries_align(
+    const ag_timeseries_t* const* series,
+    size_t k,
+    const int64_t* timestamps,
+    size_t n,
+    double* out_matrix
+);
+
+/*
+ * View last N points in place, without copying.
+ *
+ * Parameters:
+ *   ts          - Time-series buffer handle
+ *   max_points  - Maximum number of points to include
+ *   out_view    - Output view (spans ordered oldest to newest)
+ *
+ * Returns:
+ *   AG_OK on success (out_view->length may be 0 for an empty buffer)
+ *   AG_ERR_INVALID_ARG if ts or out_view is NULL, or ts is interleaved or
+ *   typed
+ *
+ * Behavior:
+ *   Unlike ag_timeseries_query_last(), spans are chronological (oldest
+ *   first). The view is valid until the writer overwrites its oldest point:
+ *   at least (capacity - length) further appends for a buffer that is full.
+ *   NO ALLOCATIONS, NO COPY - O(1).
+ *
+ * Thread Safety:
+ *   NOT safe. Caller must serialize access with append operations.
+ *   SPMC buffers: read the spans, then call ag_timeseries_view_valid() and
+ *   discard the result if it returns 0.
+ */
+int ag_timeseries_view_last(
+    const ag_timeseries_t* ts,
+    size_t max_points,
+    ag_timeseries_view_t* out_view
+);
+
+/*
+ * View points in time range [start_ms, end_ms] inclusive, without copying.
+ *
+ * Parameters:
+ *   ts          - Time-series buffer handle
+ *   start_ms    - Start timestamp (inclusive)
+ *   end_ms      - End timestamp (inclusive)
+ *   out_view    - Output view (spans ordered oldest to newest)
+ *
+ * Returns:
+ *   AG_OK on success (out_view->length is 0 if nothing matches or start > end)
+ *   AG_ERR_INVALID_ARG if ts or out_view is NULL, or ts is interleaved or
+ *   typed
+ *   AG_ERR_UNORDERED if stored timestamps are not monotonic, since matches
+ *   would not be contiguous (use ag_timeseries_query_range instead)
+ *
+ * Behavior:
+ *   Binary-searches both ring segments. O(log n), NO ALLOCATIONS, NO COPY.
+ *
+ * Thread Safety:
+ *   Same as ag_timeseries_view_last().
+ */
+int ag_timeseries_view_range(
+    const ag_timeseries_t* ts,
+    int64_t start_ms,
+    int64_t end_ms,
+    ag_timeseries_view_t* out_view
+);
+
+/*
+ * Check that a view still refers to the points it was created for.
+ *
+ * Parameters:
+ *   ts   - Time-series buffer handle the view came from
+ *   view - View returned by ag_timeseries_view_last/range
+ *
+ * Returns:
+ *   1 if no point of the view has been overwritten, 0 otherwise
+ *   (or if ts or view is NULL).
+ *
+ * Behavior:
+ *   Call after consuming the view. In SPMC mode this also accounts for an
+ *   append the writer has started but not yet published.
+ *
+ * Thread Safety:
+ *   Safe to call; SPMC buffers may call it concurrently with the writer.
+ */
+int ag_timeseries_view_valid(
+    const ag_timeseries_t* ts,
+    const ag_timeseries_view_t* view
+);
+
+/*
+ * Position a cursor for incremental reads.
+ *
+ * Parameters:
+ *   ts          - Time-series buffer handle
+ *   from        - AG_CURSOR_OLDEST or AG_CURSOR_LATEST
+ *   out_cursor  - Cursor to initialize
+ *
+ * Returns:
+ *   AG_OK on success
+ *   AG_ERR_INVALID_ARG if ts or out_cursor is NULL, or 'from' is unknown
+ *
+ * Thread Safety:
+ *   Same as ag_timeseries_query_last().
+ */
+int ag_timeseries_cursor_init(
+    const ag_timeseries_t* ts,
+    int from,
+    ag_ts_cursor_t* out_cursor
+);
+
+/*
+ * Copy points appended since the cursor's last read, oldest first.
+ *
+ * Parameters:
+ *   ts              - Time-series buffer handle
+ *   cursor          - Cursor from ag_timeseries_cursor_init() on this buffer
+ *   max_points      - Maximum number of points to copy
+ *   out_timestamps  - Output array for timestamps (size >= max_points)
+ *   out_values      - Output array for values (size >= max_points)
+ *   out_count       - Number of points written
+ *   out_lost        - Points lost since the previous read (NULL to ignore)
+ *
+ * Returns:
+ *   AG_OK when every point since the last read was still stored
+ *   AG_ERR_LAPPED if the ring overwrote unread points: *out_lost of them
+ *     were skipped (also added to cursor->lost) and reading continued at
+ *     the oldest stored point, so *out_count points are still delivered
+ *   AG_ERR_INVALID_ARG for NULL pointers, or a cursor ahead of the buffer
+ *
+ * Behavior:
+ *   Advances the cursor past the copied points. Points are delivered
+ *   exactly once and in append order; call again while *out_count ==
+ *   max_points to drain a backlog. Lost points are not looked up in the
+ *   cold tier (use ag_timeseries_query_range for those).
+ *   O(new points), zero allocations.
+ *
+ * Thread Safety:
+ *   Same as ag_timeseries_query_last(); SPMC readers may read concurrently
+ *   with the writer, each with its own cursor. A read lapped mid-copy
+ *   retries and reports the points it had to skip as lost.
+ */
+int ag_timeseries_cursor_read(
+    const ag_timeseries_t* ts,
+    ag_ts_cursor_t* cursor,
+    size_t max_points,
+    int64_t* out_timestamps,
+    double* out_values,
+    size_t* out_count,
+    uint64_t* out_lost
+);
+
+/*
+ * View points appended since the cursor's last read, without copying.
+ *
+ * Parameters:
+ *   ts          - Time-series buffer handle
+ *   cursor      - Cursor from ag_timeseries_cursor_init() on this buffer
+ *   max_points  - Maximum number of points to view
+ *   out_view    - Output view of the next unread points (oldest first)
+ *   out_lost    - Points lost since the previous read (NULL to ignore)
+ *
+ * Returns:
+ *   AG_OK when every point since the last read is still stored
+ *   AG_ERR_LAPPED if the ring overwrote unread points: *out_lost of them
+ *     were skipped (also added to cursor->lost) and the view starts at the
+ *     oldest stored point
+ *   AG_ERR_INVALID_ARG for NULL pointers, a cursor ahead of the buffer, or
+ *   an interleaved or typed buffer
+ *
+ * Behavior:
+ *   The zero-copy counterpart of ag_timeseries_cursor_read(). The cursor
+ *   only moves past lost points: once the view is consumed (and, for SPMC
+ *   buffers, ag_timeseries_view_valid() still holds) set
+ *   cursor->next_seq = out_view->end_seq to mark it read. Until then the
+ *   same points are viewed again, so a consumer can retry a view it could
+ *   not take. O(1), NO ALLOCATIONS, NO COPY.
+ *
+ * Thread Safety:
+ *   Same as ag_timeseries_view_last().
+ */
+int ag_timeseries_cursor_view(
+    const ag_timeseries_t* ts,
+    ag_ts_cursor_t* cursor,
+    size_t max_points,
+    ag_timeseries_view_t* out_view,
+    uint64_t* out_lost
+);
+
+/*
+ * Aggregate values in time range [start_ms, end_ms] inclusive, without copying.
+ *
+ * Parameters:
+ *   ts         - Time-series buffer handle
+ *   start_ms   - Start timestamp (inclusive)
+ *   end_ms     - End timestamp (inclusive)
+ *   agg        - One of AG_AGG_COUNT, AG_AGG_SUM, AG_AGG_MEAN, AG_AGG_MIN, AG_AGG_MAX
+ *   out_value  - Output aggregate (COUNT is returned as a double)
+ *
+ * Returns:
+ *   AG_OK on success (COUNT and SUM are 0 when nothing matches)
+ *   AG_ERR_INVALID_ARG if ts or out_value is NULL, or agg is unknown
+ *   AG_ERR_EMPTY if nothing matches for MEAN, MIN or MAX
+ *
+ * Behavior:
+ *   Reduces the two contiguous ring segments in place with AVX2 (x86-64) or
+ *   NEON (aarch64) kernels chosen at runtime, falling back to scalar code;
+ *   see ag_timeseries_simd_name(). Ordered windows binary-search the range
+ *   first, O(log n + k); unordered windows use masked kernels, O(n).
+ *   SIMD sums are reassociated and may differ from a sequential sum in the
+ *   last bits. NO ALLOCATIONS.
+ *
+ * Thread Safety:
+ *   NOT safe. Caller must serialize access with append operations.
+ *   SPMC buffers: safe concurrently with the writer (lock-free snapshot).
+ */
+int ag_timeseries_aggregate_range(
+    const ag_timeseries_t* ts,
+    int64_t start_ms,
+    int64_t end_ms,
+    int agg,
+    double* out_value
+);
+
+/*
+ * Create a worker pool for multi-series calls.
+ *
+ * Parameters:
+ *   threads - Worker threads to start, or 0 for one per online CPU minus
+ *             one (the calling thread always works too)
+ *
+ * Returns:
+ *   Pool handle, or NULL if threads > 1024 or allocation/thread creation
+ *   fails.
+ *
+ * Behavior:
+ *   Workers sleep on a condition variable between calls. One pool can
+ *   serve any number of series and calls; create it once at startup.
+ *
+ * Thread Safety:
+ *   Safe to call.
+ */
+ag_timeseries_pool_t* ag_timeseries_pool_create(size_t threads);
+
+/*
+ * Stop the workers and free the pool. Safe to call with NULL.
+ *
+ * Thread Safety:
+ *   NOT safe. No call may be using the pool.
+ */
+void ag_timeseries_pool_destroy(ag_timeseries_pool_t* pool);
+
+/*
+ * Get the number of worker threads (excluding the calling thread).
+ *
+ * Returns:
+ *   Worker count, 0 if pool is NULL.
+ */
+size_t ag_timeseries_pool_threads(const ag_timeseries_pool_t* pool);
+
+/*
+ * Aggregate one time range over many series in parallel.
+ *
+ * Parameters:
+ *   series      - Array of k time-series buffer handles
+ *   k           - Number of series (matrix rows)
+ *   start_ms    - Start timestamp (inclusive)
+ *   end_ms      - End timestamp (inclusive)
+ *   aggs        - naggs aggregates (AG_AGG_*), one matrix column each
+ *   naggs       - Number of aggregates (matrix columns)
+ *   out_matrix  - Output: k * naggs doubles, row-major
+ *   pool        - Worker pool, or NULL to run on the calling thread only
+ *
+ * Returns:
+ *   AG_OK on success
+ *   AG_ERR_INVALID_ARG if a pointer or series handle is NULL, naggs is 0,
+ *   or an aggregate is unknown
+ *
+ * Behavior:
+ *   out_matrix[i * naggs + j] is ag_timeseries_aggregate_range(series[i],
+ *   start_ms, end_ms, aggs[j]), or NAN where that returns AG_ERR_EMPTY.
+ *   Series are split into chunks dealt out evenly to the calling thread
+ *   and the workers. A participant that runs out steals single chunks from
+ *   the end of another's share, so a few long series do not leave cores
+ *   idle. The calling thread returns once every row is written.
+ *   NO ALLOCATIONS.
+ *
+ * Performance:
+ *   Serial cost divided by up to (threads + 1), plus one wake-up of the
+ *   workers (a few microseconds); small k runs on the caller alone.
+ *
+ * Thread Safety:
+ *   Each series must be safe to aggregate from another thread: not
+ *   appended to during the call, or SPMC. Concurrent calls on one pool
+ *   are serialized.
+ */
+int ag_timeseries_aggregate_many(
+    const ag_timeseries_t* const* series,
+    size_t k,
+    int64_t start_ms,
+    int64_t end_ms,
+    const int* aggs,
+    size_t naggs,
+    double* out_matrix,
+    ag_timeseries_pool_t* pool
+);
+
+/*
+ * Downsample time range [start_ms, end_ms] into OHLC buckets.
+ *
+ * Parameters:
+ *   ts           - Time-series buffer handle
+ *   start_ms     - Start timestamp (inclusive)
+ *   end_ms       - End timestamp (inclusive)
+ *   bucket_ms    - Bucket width in milliseconds (must be > 0)
+ *   out_buckets  - Output array (must have space for max_buckets)
+ *   max_buckets  - Maximum number of buckets to write
+ *   out_count    - Output number of buckets written
+ *
+ * Returns:
+ *   AG_OK on success (*out_count may be 0)
+ *   AG_ERR_INVALID_ARG if a pointer is NULL or bucket_ms <= 0
+ *   AG_ERR_UNORDERED if stored timestamps are not monotonic
+ *
+ * Behavior:
+ *   Buckets are aligned to multiples of bucket_ms since the epoch, written
+ *   oldest first, and only non-empty buckets are emitted. Buckets at the
+ *   edges only cover points inside [start_ms, end_ms]. If more than
+ *   max_buckets are non-empty, returns the first max_buckets.
+ *   Single pass over the binary-searched range, O(log n + k). NO ALLOCATIONS.
+ *
+ * Thread Safety:
+ *   NOT safe. Caller must serialize access with append operations.
+ *   SPMC buffers: safe concurrently with the writer (lock-free snapshot).
+ */
+int ag_timeseries_query_buckets(
+    const ag_timeseries_t* ts,
+    int64_t start_ms,
+    int64_t end_ms,
+    int64_t bucket_ms,
+    ag_timeseries_bucket_t* out_buckets,
+    size_t max_buckets,
+    size_t* out_count
+);
+
+/*
+ * Get name of the SIMD kernels selected for this CPU.
+ *
+ * Returns:
+ *   "avx2", "neon" or "scalar". Setting environment variable
+ *   AG_CORE_SIMD=scalar before first use forces the scalar fallback.
+ *
+ * Thread Safety:
+ *   Safe to call concurrently from multiple threads.
+ */
+const char* ag_timeseries_simd_name(void);
+
+/*
+ * Enable incrementally maintained rolling statistics.
+ *
+ * Parameters:
+ *   ts - Time-series buffer handle
+ *
+ * Returns:
+ *   AG_OK on success (also if already enabled)
+ *   AG_ERR_INVALID_ARG if ts is NULL or read-only (shared-memory reader,
+ *     ag_mseries column)
+ *   AG_ERR_NOMEM if allocation failed
+ *
+ * Behavior:
+ *   Allocates two monotonic deques of capacity entries (16 bytes per point)
+ *   and seeds them from the points already stored, O(n). From then on every
+ *   append updates a Kahan-compensated sum and sum of squares plus the
+ *   sliding min/max in O(1) amortized, including for points it evicts.
+ *   The sums are kept relative to the window's oldest value, re-based
+ *   (recomputed) once per capacity of appends, so the variance of a small
+ *   spread at a large, drifting price level stays accurate.
+ *   Values should be finite: a NaN or infinity poisons sum and variance
+ *   until the next append_batch that replaces the whole window.
+ *
+ * Thread Safety:
+ *   NOT safe. Call before sharing the buffer with other threads.
+ */
+int ag_timeseries_enable_stats(ag_timeseries_t* ts);
+
+/*
+ * Get rolling statistics over all stored points.
+ *
+ * Parameters:
+ *   ts         - Time-series buffer handle
+ *   out_stats  - Output statistics
+ *
+ * Returns:
+ *   AG_OK on success
+ *   AG_ERR_INVALID_ARG if ts or out_stats is NULL, or stats are not enabled
+ *   AG_ERR_EMPTY if the buffer holds no points
+ *
+ * Behavior:
+ *   O(1) - reads the maintained aggregates, no scan.
+ *
+ * Thread Safety:
+ *   NOT safe. Caller must serialize access with append operations.
+ *   SPMC buffers: safe concurrently with the writer (seqlock snapshot).
+ */
+int ag_timeseries_stats(const ag_timeseries_t* ts, ag_timeseries_stats_t* out_stats);
+
+/*
+ * Maintain a quantile sketch of the values in the ring window.
+ *
+ * Parameters:
+ *   ts                - Time-series buffer handle
+ *   relative_accuracy - Max relative error of a returned quantile, in
+ *                       (0, 0.5], e.g. 0.01 for 1%
+ *   min_value         - Smallest magnitude resolved (>= DBL_MIN); values
+ *                       with |v| < min_value count as 0
+ *   max_value         - Largest magnitude resolved (> min_value); larger
+ *                       magnitudes count as max_value
+ *
+ * Returns:
+ *   AG_OK on success (also if already enabled; the existing sketch is kept)
+ *   AG_ERR_INVALID_ARG if ts is NULL or read-only, or a parameter is out
+ *     of range (see ag_timeseries_sketch_create)
+ *   AG_ERR_NOMEM if allocation failed
+ *
+ * Behavior:
+ *   DDSketch-style log-scale histogram with a fixed key range. Seeds from
+ *   the points already stored, O(n). Every append counts its value, and
+ *   every point leaving the window (overwrite, TTL expiry, resize) is
+ *   subtracted again, so queries cover exactly the stored points.
+ *   O(1) per point, no allocations. NaN values are not counted.
+ *
+ * Memory:
+ *   16 bytes per bin, about log2(max_value / min_value) /
+ *   (2 * relative_accuracy) bins: 31 KiB for 1% over 1e-6..1e6.
+ *
+ * Thread Safety:
+ *   NOT safe. Call before sharing the buffer with other threads.
+ */
+int ag_timeseries_enable_quantiles(ag_timeseries_t* ts, double relative_accuracy,
+                                   double min_value, double max_value);
+
+/*
+ * Get quantiles of the values in the ring window.
+ *
+ * Parameters:
+ *   ts         - Buffer with a sketch (ag_timeseries_enable_quantiles)
+ *   qs         - n quantiles in [0, 1], e.g. {0.5, 0.95, 0.99}
+ *   n          - Number of quantiles
+ *   out_values - Output: n values, out_values[i] for qs[i]
+ *
+ * Returns:
+ *   AG_OK on success
+ *   AG_ERR_INVALID_ARG if a pointer is NULL, the sketch is not enabled or
+ *     a quantile is outside [0, 1]
+ *   AG_ERR_EMPTY if the window holds no counted value
+ *
+ * Behavior:
+ *   Each result is within relative_accuracy of the value of rank
+ *   q * (count - 1) in the window (0 for the zero bin, +-max_value for the
+ *   clamped top bins). Ascending qs share one pass over the bins.
+ *
+ * Performance:
+ *   O(bins), no copy or sort of the window: a few us for 2000 bins.
+ *
+ * Thread Safety:
+ *   NOT safe. Caller must serialize access with append operations.
+ *   SPMC buffers: safe concurrently with the writer. Counts are read one
+ *   by one, so appends during the call may shift a result by the ranks
+ *   they add or remove.
+ */
+int ag_timeseries_quantiles(const ag_timeseries_t* ts, const double* qs, size_t n,
+                            double* out_values);
+
+/*
+ * Create a standalone quantile sketch, e.g. to merge several series into
+ * a portfolio-level distribution.
+ *
+ * Parameters:
+ *   relative_accuracy - Max relative error, in (0, 0.5]
+ *   min_value         - Smallest magnitude resolved (>= DBL_MIN)
+ *   max_value         - Largest magnitude resolved (> min_value)
+ *
+ * Returns:
+ *   Sketch handle, or NULL if a parameter is out of range, the range needs
+ *   more than AG_SKETCH_MAX_BINS bins, or allocation failed.
+ *
+ * Memory:
+ *   One allocation, 16 bytes per bin. Call ag_timeseries_sketch_destroy().
+ */
+ag_timeseries_sketch_t* ag_timeseries_sketch_create(double relative_accuracy,
+                                                    double min_value, double max_value);
+
+/*
+ * Free a sketch. Safe to call with NULL.
+ */
+void ag_timeseries_sketch_destroy(ag_timeseries_sketch_t* sketch);
+
+/*
+ * Count one value.
+ *
+ * Returns:
+ *   AG_OK on success (NaN is ignored), AG_ERR_INVALID_ARG if sketch is NULL.
+ */
+int ag_timeseries_sketch_add(ag_timeseries_sketch_t* sketch, double value);
+
+/*
+ * Add the counts of src to dst.
+ *
+ * Returns:
+ *   AG_OK on success, AG_ERR_INVALID_ARG if a pointer is NULL or the
+ *   relative accuracies differ.
+ *
+ * Behavior:
+ *   Sketches with the same relative accuracy share one key mapping, so the
+ *   merge is exact, bin by bin; src values outside dst's range go to dst's
+ *   zero or top bins. O(bins of src).
+ */
+int ag_timeseries_sketch_merge(ag_timeseries_sketch_t* dst, const ag_timeseries_sketch_t* src);
+
+/*
+ * Add the window sketch of a series to dst (ag_timeseries_sketch_merge).
+ *
+ * Returns:
+ *   AG_OK on success, AG_ERR_INVALID_ARG if a pointer is NULL, the series
+ *   has no sketch or the relative accuracies differ.
+ *
+ * Thread Safety:
+ *   As ag_timeseries_quantiles() for the series.
+ */
+int ag_timeseries_sketch_merge_series(ag_timeseries_sketch_t* dst, const ag_timeseries_t* ts);
+
+/*
+ * Get quantiles of the counted values (see ag_timeseries_quantiles).
+ *
+ * Returns:
+ *   AG_OK on success, AG_ERR_INVALID_ARG on NULL pointers or a quantile
+ *   outside [0, 1], AG_ERR_EMPTY if nothing is counted.
+ */
+int ag_timeseries_sketch_quantiles(const ag_timeseries_sketch_t* sketch, const double* qs,
+                                   size_t n, double* out_values);
+
+/*
+ * Reset every count to zero, keeping the configuration.
+ */
+void ag_timeseries_sketch_clear(ag_timeseries_sketch_t* sketch);
+
+/*
+ * Get the number of counted values.
+ *
+ * Returns:
+ *   Values counted (NaN excluded), 0 if sketch is NULL.
+ */
+uint64_t ag_timeseries_sketch_count(const ag_timeseries_sketch_t* sketch);
+
+/*
+ * Maintain a chain of downsampled child rings on append.
+ *
+ * Parameters:
+ *   ts           - Time-series buffer handle (not SPMC)
+ *   levels       - Levels from finest to coarsest, e.g. {1000, 3600},
+ *                  {60000, 43200}, {3600000, 720}
+ *   level_count  - Number of levels (1 to AG_ROLLUP_MAX_LEVELS)
+ *
+ * Returns:
+ *   AG_OK on success
+ *   AG_ERR_INVALID_ARG if ts/levels is NULL, ts is SPMC or read-only,
+ *     rollups are already enabled, or widths are not positive multiples of
+ *     the previous level
+ *   AG_ERR_NOMEM if allocation failed
+ *
+ * Behavior:
+ *   Each append updates the open bucket of the finest level. When a point
+ *   lands past it, the bucket closes: its last/mean/min/max/count is stored
+ *   and merged into the next level, which may close in turn. Cost is O(1)
+ *   amortized per append, no allocations. Empty buckets are skipped.
+ *   Points older than the finest open bucket (late points) stay in the
+ *   raw ring but are not rolled up. Points already stored are not replayed.
+ *
+ * Memory:
+ *   48 bytes per retained bucket, allocated once.
+ *
+ * Thread Safety:
+ *   NOT safe. Call before sharing the buffer with other threads.
+ */
+int ag_timeseries_enable_rollups(
+    ag_timeseries_t* ts,
+    const ag_rollup_level_t* levels,
+    size_t level_count
+);
+
+/*
+ * Query [start_ms, end_ms] at the finest resolution that fits.
+ *
+ * Parameters:
+ *   ts             - Time-series buffer handle with rollups enabled
+ *   start_ms       - Start timestamp (inclusive)
+ *   end_ms         - End timestamp (inclusive)
+ *   max_points     - Point budget (capacity of out_points)
+ *   out_points     - Output points, oldest first
+ *   out_count      - Output: number of points written
+ *   out_bucket_ms  - Output: resolution used, 0 for raw points (may be NULL)
+ *
+ * Returns:
+ *   AG_OK on success (out_count may be 0)
+ *   AG_ERR_INVALID_ARG for NULL arguments, start_ms > end_ms, or rollups
+ *     not enabled
+ *
+ * Routing:
+ *   Candidates are the raw ring, then each level from finest to coarsest.
+ *   The first one that still holds data back to start_ms and has at most
+ *   max_points points in the range answers. If none fits, the coarsest
+ *   level returns its first max_points buckets. Buckets are reported once
+ *   closed, and a bucket is matched by its start_ms; the raw ring is only
+ *   used while its timestamps are non-decreasing.
+ *
+ * Performance:
+ *   O(levels * log n + k).
+ *
+ * Thread Safety:
+ *   NOT safe. Caller must serialize access with append operations.
+ */
+int ag_timeseries_query_rollup(
+    const ag_timeseries_t* ts,
+    int64_t start_ms,
+    int64_t end_ms,
+    size_t max_points,
+    ag_timeseries_rollup_t* out_points,
+    size_t* out_count,
+    int64_t* out_bucket_ms
+);
+
+/*
+ * Stage appends in a bounded reorder buffer so the ring stays monotonic.
+ *
+ * Parameters:
+ *   ts          - Time-series buffer handle
+ *   window_ms   - Hold time (>= 0): a point becomes visible once a point
+ *                 window_ms newer has been appended. INT64_MAX bounds the
+ *                 buffer by max_points only.
+ *   max_points  - Staging depth (> 0): beyond it the oldest staged point
+ *                 becomes visible early
+ *
+ * Returns:
+ *   AG_OK on success
+ *   AG_ERR_INVALID_ARG if ts is NULL, read-only, already has a
+ *     reorder buffer, or a parameter is out of range
+ *   AG_ERR_NOMEM if allocation failed
+ *
+ * Behavior:
+ *   Appends are insertion-sorted into the staged tail and released to the
+ *   ring (and to stats, cold tier and rollups) in timestamp order. A point
+ *   older than the last released one, or more than window_ms older than
+ *   the newest appended, cannot be placed: it is counted and dropped, and
+ *   append returns AG_ERR_UNORDERED. The binary-search range, view and
+ *   bucket paths therefore stay valid.
+ *   Staged points are not visible to queries and are discarded by
+ *   ag_timeseries_destroy(); call ag_timeseries_flush_reorder() first to
+ *   keep them. An in-order append costs one extra compare.
+ *
+ * Memory:
+ *   16 bytes per staged point, allocated once.
+ *
+ * Thread Safety:
+ *   NOT safe. Call before sharing the buffer; staging is writer-side, so
+ *   SPMC readers only ever see released points.
+ */
+int ag_timeseries_enable_reorder(ag_timeseries_t* ts, int64_t window_ms, size_t max_points);
+
+/*
+ * Release every staged point to the ring, oldest first.
+ *
+ * Parameters:
+ *   ts - Buffer with a reorder buffer
+ *
+ * Returns:
+ *   AG_OK on success, AG_ERR_INVALID_ARG if ts is NULL or has no reorder buffer
+ *
+ * Behavior:
+ *   Use at shutdown or when the feed goes idle. Points that arrive later
+ *   than the flushed ones are rejected as late.
+ *
+ * Thread Safety:
+ *   NOT safe. Call from the writer thread.
+ */
+int ag_timeseries_flush_reorder(ag_timeseries_t* ts);
+
+/*
+ * Read reorder buffer counters.
+ *
+ * Parameters:
+ *   ts        - Buffer with a reorder buffer
+ *   out_stats - Output counters
+ *
+ * Returns:
+ *   AG_OK on success
+ *   AG_ERR_INVALID_ARG if ts or out_stats is NULL, or ts has no reorder buffer
+ *
+ * Thread Safety:
+ *   NOT safe. Call from the writer thread.
+ */
+int ag_timeseries_reorder_stats(const ag_timeseries_t* ts,
+                                ag_timeseries_reorder_stats_t* out_stats);
+
+/*
+ * Drop points older than a retention period (time-based retention).
+ *
+ * Parameters:
+ *   ts      - Time-series buffer handle (writer, not read-only)
+ *   ttl_ms  - Retention in ms (>= 0); 0 disables expiry
+ *
+ * Returns:
+ *   AG_OK on success
+ *   AG_ERR_INVALID_ARG if ts is NULL, read-only, or ttl_ms < 0
+ *
+ * Behavior:
+ *   With a TTL set, every append expires the stored points whose
+ *   timestamp is older than the appended timestamp minus ttl_ms, so data
+ *   time is the clock. Call ag_timeseries_expire() to expire against a
+ *   wall clock while the feed is quiet. Expiry walks from the oldest point
+ *   and stops at the first one inside the period; with out-of-order
+ *   points (ag_timeseries_is_monotonic() is 0) a late point can shelter
+ *   older ones behind it until it expires itself.
+ *   Expired points leave size, queries, views, rolling stats and
+ *   buckets; they go to the cold tier when one is enabled, and cursors
+ *   count unread ones as lost (AG_ERR_LAPPED). Rollups keep the buckets
+ *   they already closed. File-backed buffers record expiry in the
+ *   file, so expired points stay gone after reopening; the TTL itself is
+ *   not stored, set it again.
+ *
+ * Performance:
+ *   One compare per append while nothing is due; O(1) per expired point.
+ *
+ * Thread Safety:
+ *   NOT safe against other writers. SPMC and shared-memory readers stay
+ *   safe and see expired points disappear atomically.
+ */
+int ag_timeseries_set_ttl(ag_timeseries_t* ts, int64_t ttl_ms);
+
+/*
+ * Expire points older than now_ms minus the TTL.
+ *
+ * Parameters:
+ *   ts      - Buffer with a TTL (ag_timeseries_set_ttl)
+ *   now_ms  - Current time, same clock as the timestamps
+ *
+ * Returns:
+ *   Number of points expired; 0 if ts is NULL, read-only or has no TTL.
+ *
+ * Behavior:
+ *   Same rule as expiry on append, with now_ms as the clock; now_ms older
+ *   than the newest point is allowed (expires less).
+ *
+ * Performance:
+ *   O(expired points).
+ *
+ * Thread Safety:
+ *   NOT safe against other writers. Call from the writer thread.
+ */
+size_t ag_timeseries_expire(ag_timeseries_t* ts, int64_t now_ms);
+
+/*
+ * Keep evicted points in a compressed cold tier.
+ *
+ * Parameters:
+ *   ts            - Time-series buffer handle (not SPMC)
+ *   budget_bytes  - Fixed size of compressed storage (>= ~19 KiB, one
+ *                   worst-case block)
+ *
+ * Returns:
+ *   AG_OK on success (also if already enabled)
+ *   AG_ERR_INVALID_ARG if ts is NULL, SPMC, read-only, or budget_bytes is too small
+ *   AG_ERR_NOMEM if allocation failed
+ *
+ * Behavior:
+ *   The ring stays the hot tail. Every point it evicts is encoded into
+ *   blocks of 1024 points (Gorilla: delta-of-delta timestamps, XOR-encoded
+ *   values; ~1-2 bytes per point on regular ticks vs 16 raw). When the
+ *   budget is full the oldest block is dropped. query_range() and
+ *   query_last() transparently continue into the cold tier, decoding only
+ *   blocks that overlap the request. Views, aggregates, buckets and stats
+ *   cover the hot ring only. Encoding is lossless.
+ *
+ * Memory:
+ *   Allocates budget_bytes plus ~19 KiB once; appends never allocate.
+ *
+ * Thread Safety:
+ *   NOT safe. Call before sharing the buffer with other threads.
+ */
+int ag_timeseries_enable_cold(ag_timeseries_t* ts, size_t budget_bytes);
+
+/*
+ * Get cold tier occupancy.
+ *
+ * Returns:
+ *   AG_OK on success
+ *   AG_ERR_INVALID_ARG if ts or out_stats is NULL, or the tier is not enabled
+ */
+int ag_timeseries_cold_stats(const ag_timeseries_t* ts, ag_timeseries_cold_stats_t* out_stats);
+
+/*
+ * Read instrumentation counters and the query latency histogram.
+ *
+ * Parameters:
+ *   ts          - Series handle, or NULL for the process-wide totals over
+ *                 every series
+ *   out_metrics - Output counters
+ *
+ * Returns:
+ *   AG_OK on success
+ *   AG_ERR_INVALID_ARG if out_metrics is NULL
+ *   AG_ERR_UNSUPPORTED if the library was built without AG_METRICS
+ *                      (out_metrics is zeroed)
+ *
+ * Behavior:
+ *   Instrumentation is compiled in with -DAG_METRICS (make METRICS=1);
+ *   without it the hot paths carry no counters at all. With it:
+ *   - Appends and evictions are counted, not timed: one clock read costs
+ *     more than an append.
+ *   - query_last/range (and _native), view_last/range, cursor_read,
+ *     aggregate_range, query_buckets, asof and the ag_mseries queries
+ *     count as queries and are timed. A range query that scans an
+ *     unordered window shows up as points_scanned >> points_returned.
+ *   - align() counts under each series' retries only.
+ *   - ag_mseries rows and queries are recorded on the column 0 handle
+ *     (ag_mseries_column(ms, 0)).
+ *   Counters are read one by one with relaxed loads, so a snapshot taken
+ *   during traffic is not atomic across fields.
+ *   Per-series counters are exact. The global totals lag: each series
+ *   folds its appends in every 1024 points and on destroy, each thread
+ *   its queries every 64 calls, at thread exit and when it reads the
+ *   totals itself.
+ *
+ * Performance:
+ *   Instrumented builds add about 1 ns per append (writer-local counts)
+ *   and about 100 ns per query: two clock_gettime() reads and five
+ *   relaxed atomic adds on the series. Uninstrumented builds pay nothing.
+ *
+ * Thread Safety:
+ *   Safe to call from any thread, concurrently with appends and queries.
+ */
+int ag_timeseries_get_metrics(const ag_timeseries_t* ts, ag_timeseries_metrics_t* out_metrics);
+
+/*
+ * Get the lower bound of a latency histogram bucket.
+ *
+ * Returns:
+ *   Smallest latency in ns recorded into 'bucket'. For
+ *   bucket == AG_METRICS_BUCKETS, the exclusive upper bound of the last
+ *   regular bucket. Returns UINT64_MAX for larger indices.
+ *
+ * Thread Safety:
+ *   Safe to call (pure function).
+ */
+uint64_t ag_timeseries_histogram_bucket_ns(size_t bucket);
+
+/*
+ * Estimate a latency quantile from a histogram.
+ *
+ * Parameters:
+ *   hist - Histogram from ag_timeseries_get_metrics
+ *   q    - Quantile in [0, 1] (0.99 for p99)
+ *
+ * Returns:
+ *   Upper bound in ns of the bucket holding the q-th sample, capped by
+ *   hist->max_ns. Returns 0 for an empty histogram, NULL or q outside [0, 1].
+ *
+ * Thread Safety:
+ *   Safe to call (reads only *hist).
+ */
+uint64_t ag_timeseries_histogram_quantile(const ag_timeseries_histogram_t* hist, double q);
+
+/*
+ * Get current number of data points in buffer.
+ *
+ * Parameters:
+ *   ts - Time-series buffer handle
+ *
+ * Returns:
+ *   Number of points currently stored (0 to capacity).
  *   Returns 0 if ts is NULL.
  *
  * Thread Safety:
@@ -160,6 +1835,27 @@ size_t ag_timeseries_query_range(
  */
 size_t ag_timeseries_size(const ag_timeseries_t* ts);
 
+/*
+ * Get total number of points ever appended.
+ *
+ * Parameters:
+ *   ts - Time-series buffer handle
+ *
+ * Returns:
+ *   Monotonically increasing 64-bit append sequence (never wraps).
+ *   Returns 0 if ts is NULL.
+ *
+ * Behavior:
+ *   The newest point has sequence (result - 1) and the oldest stored point
+ *   has sequence (result - size). Comparing two observations tells a reader
+ *   exactly how many points were appended, and how many were overwritten.
+ *
+ * Thread Safety:
+ *   Safe to call, but result may be stale if other threads are modifying buffer.
+ *   SPMC buffers: safe concurrently with the writer.
+ */
+uint64_t ag_timeseries_sequence(const ag_timeseries_t* ts);
+
 /*
  * Get buffer capacity.
  *
@@ -171,10 +1867,78 @@ size_t ag_timeseries_size(const ag_timeseries_t* ts);
  *   Returns 0 if ts is NULL.
  *
  * Thread Safety:
- *   Safe to call (capacity is immutable after creation).
+ *   Safe to call (capacity changes only with ag_timeseries_resize()).
  */
 size_t ag_timeseries_capacity(const ag_timeseries_t* ts);
 
+/*
+ * Change buffer capacity, keeping the newest points.
+ *
+ * Parameters:
+ *   ts            - Heap-allocated buffer (create, create_pow2,
+ *                   create_interleaved, create_typed)
+ *   new_capacity  - New maximum number of points (> 0)
+ *
+ * Returns:
+ *   AG_OK on success (also when new_capacity equals the capacity)
+ *   AG_ERR_INVALID_ARG if ts is NULL, new_capacity is 0 or too large, or
+ *     ts is SPMC, read-only, registry-owned, file-backed, shared-memory
+ *     or page-mapped (create_ex)
+ *   AG_ERR_NOMEM if allocation failed (the buffer is left unchanged)
+ *
+ * Behavior:
+ *   Copies the stored points into new arrays of the same layout and
+ *   column type and frees the old ones. Shrinking drops the oldest points
+ *   beyond new_capacity exactly as overwrites would: they go to the cold
+ *   tier if one is enabled, leave rolling stats and the quantile sketch,
+ *   and cursors count unread ones as lost. Growing keeps every point; the
+ *   extra room fills with new appends. Sequence numbers, cursors,
+ *   ordering, rolling stats, quantile sketch, TTL, cold tier, rollups and
+ *   reorder buffer carry over.
+ *   Views and spans into the buffer are invalidated.
+ *
+ * Performance:
+ *   O(size): at most three memcpy per column (the stored window wraps at
+ *   most once in each ring), plus O(new_capacity) to allocate and zero
+ *   the arrays (and the stats deques when enabled).
+ *
+ * Thread Safety:
+ *   NOT safe. No other thread may use the buffer during the call.
+ */
+int ag_timeseries_resize(ag_timeseries_t* ts, size_t new_capacity);
+
+/*
+ * Get value column type.
+ *
+ * Returns:
+ *   AG_VALUE_* type given at creation (AG_VALUE_F64 for every constructor
+ *   but ag_timeseries_create_typed/_ex), or -1 if ts is NULL.
+ *
+ * Thread Safety:
+ *   Safe to call (type is immutable after creation).
+ */
+int ag_timeseries_value_type(const ag_timeseries_t* ts);
+
+/*
+ * Check whether stored timestamps are non-decreasing (oldest to newest).
+ *
+ * Parameters:
+ *   ts - Time-series buffer handle
+ *
+ * Returns:
+ *   1 if every stored point is no older than its predecessor, 0 otherwise.
+ *   Returns 0 if ts is NULL. An empty buffer is monotonic.
+ *
+ * Behavior:
+ *   Tracked on append in O(1). A window made unordered by a late point
+ *   becomes monotonic again once the points before it are overwritten.
+ *   While monotonic, ag_timeseries_query_range uses binary search.
+ *
+ * Thread Safety:
+ *   Safe to call, but result may be stale if other threads are modifying buffer.
+ */
+int ag_timeseries_is_monotonic(const ag_timeseries_t* ts);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,271 @@
+/*
+ * ag_timeseries_inline.h - Header-Only Fast Path (Unstable ABI)
+ *
+ * Purpose: Inlinable append and newest-point reads for callers that build
+ *          against this exact library version, so the hot path compiles
+ *          into the caller instead of crossing a library call.
+ *
+ * ABI: NOT covered by the ABI guarantees of ag_timeseries.h. These
+ *   functions read the handle through a mirror of its internal layout, so
+ *   a caller must be rebuilt with every library update. Check
+ *   ag_timeseries_inline_abi() == AG_TIMESERIES_INLINE_ABI at startup; the
+ *   library build fails if the mirror and the real layout disagree.
+ *
+ * Coverage: Rings without attachments take the inline path: double values
+ *   (split or interleaved), no rolling stats, quantile sketch, cold tier,
+ *   rollups, reorder buffer, TTL or file backing. Everything else (typed
+ *   columns, read-only handles, ...) calls the regular library function,
+ *   with identical results. Inline appends are not counted by AG_METRICS
+ *   instrumentation.
+ *
+ * Validation: NULL handle checks are compiled in unless NDEBUG is defined;
+ *   override with -DAG_INLINE_CHECKS=0 or 1. Pointers to output arguments
+ *   are never checked.
+ *
+ * Thread Safety: Same rules as the library functions they replace.
+ *   Requires C11 atomics, so C only.
+ *
+ * Copyright (c) 2025 AlgorithmicGrid
+ */
+
+#ifndef AG_TIMESERIES_INLINE_H
+#define AG_TIMESERIES_INLINE_H
+
+#ifdef __cplusplus
+#error "ag_timeseries_inline.h needs C11 atomics; C++ callers use ag_timeseries.h"
+#endif
+
+#include "ag_timeseries.h"
+#include <stdatomic.h>
+#include <stddef.h>
+
+/* Layout revision of the mirror below */
+#define AG_TIMESERIES_INLINE_ABI 2
+
+/* NULL handle checks: on in debug builds, off with NDEBUG */
+#ifndef AG_INLINE_CHECKS
+#ifdef NDEBUG
+#define AG_INLINE_CHECKS 0
+#else
+#define AG_INLINE_CHECKS 1
+#endif
+#endif
+
+/* Mirror of the ring counters (internal ring_ctl_t) */
+typedef struct {
+    _Atomic uint64_t appended;      /* Published number of points ever appended */
+    _Atomic uint64_t claimed;       /* Sequence the writer may be writing (SPMC) */
+    _Atomic uint64_t ordered_from;  /* Sequence of the last out-of-order point */
+    _Atomic uint64_t expired;       /* Points below this sequence dropped early */
+} ag_ts_inline_ctl_t;
+
+/*
+ * Mirror of the leading fields of the internal handle. Used for offsetof()
+ * only: fields are read through pointers of their own type, never through
+ * this struct, so the handle is not accessed as a different struct type.
+ */
+typedef struct {
+    size_t capacity;
+    size_t mask;
+    size_t head;
+    int pow2;
+    int spmc;
+    int external;
+    int readonly;
+    ag_ts_inline_ctl_t* ctl;
+    size_t stride;
+    int64_t* timestamps;
+    double* values;
+    void* cells;
+    int vtype;
+    size_t vsize;
+    void* stats;
+    void* persist;
+    void* cold;
+    void* rollups;
+    void* reorder;
+    void* quantiles;
+    int64_t ttl_ms;
+} ag_ts_inline_layout_t;
+
+/*
+ * Get the inline layout revision the library was built with.
+ *
+ * Returns:
+ *   The library's AG_TIMESERIES_INLINE_ABI. A different value means this
+ *   header does not match the library and the inline functions must not
+ *   be used.
+ */
+int ag_timeseries_inline_abi(void);
+
+/* Helper: Field 'field' of type 'type' in handle 'ts' */
+#define AG_TS_INLINE_FIELD(ts, type, field) \
+    (*(type*)(void*)((char*)(ts) + offsetof(ag_ts_inline_layout_t, field)))
+
+/* Helper: Nonzero if rings like 'ts' must go through the library */
+static inline int ag_timeseries_inline_slow(const ag_timeseries_t* ts) {
+    return AG_TS_INLINE_FIELD(ts, const int, readonly) |
+           (AG_TS_INLINE_FIELD(ts, double* const, values) == NULL) |
+           (AG_TS_INLINE_FIELD(ts, void* const, stats) != NULL) |
+           (AG_TS_INLINE_FIELD(ts, void* const, persist) != NULL) |
+           (AG_TS_INLINE_FIELD(ts, void* const, cold) != NULL) |
+           (AG_TS_INLINE_FIELD(ts, void* const, rollups) != NULL) |
+           (AG_TS_INLINE_FIELD(ts, void* const, reorder) != NULL) |
+           (AG_TS_INLINE_FIELD(ts, void* const, quantiles) != NULL) |
+           (AG_TS_INLINE_FIELD(ts, const int64_t, ttl_ms) != 0);
+}
+
+/*
+ * Append a single point: inline equivalent of ag_timeseries_append().
+ *
+ * Returns:
+ *   Same as ag_timeseries_append().
+ *
+ * Behavior:
+ *   Same ordering tracking and SPMC claim/publish protocol as the library.
+ *   O(1), a few loads and stores, no call on the inline path.
+ */
+static inline int ag_timeseries_append_inline(ag_timeseries_t* ts, int64_t timestamp_ms,
+                                              double value) {
+#if AG_INLINE_CHECKS
+    if (ts == NULL) {
+        return AG_ERR_INVALID_ARG;
+    }
+#endif
+    if (ag_timeseries_inline_slow(ts)) {
+        return ag_timeseries_append(ts, timestamp_ms, value);
+    }
+
+    ag_ts_inline_ctl_t* ctl = AG_TS_INLINE_FIELD(ts, ag_ts_inline_ctl_t*, ctl);
+    size_t capacity = AG_TS_INLINE_FIELD(ts, size_t, capacity);
+    size_t head = AG_TS_INLINE_FIELD(ts, size_t, head);
+    size_t stride = AG_TS_INLINE_FIELD(ts, size_t, stride);
+    int64_t* timestamps = AG_TS_INLINE_FIELD(ts, int64_t*, timestamps);
+    double* values = AG_TS_INLINE_FIELD(ts, double*, values);
+    int spmc = AG_TS_INLINE_FIELD(ts, int, spmc);
+    uint64_t seq = atomic_load_explicit(&ctl->appended, memory_order_relaxed);
+
+    /* Track ordering against the newest stored point */
+    if (seq > 0) {
+        size_t newest = (head == 0) ? capacity - 1 : head - 1;
+        if (timestamp_ms < timestamps[newest * stride]) {
+            atomic_store_explicit(&ctl->ordered_from, seq, memory_order_relaxed);
+        }
+    }
+
+    /* SPMC: announce the slot before overwriting it */
+    if (spmc) {
+        atomic_store_explicit(&ctl->claimed, seq + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+    }
+
+    timestamps[head * stride] = timestamp_ms;
+    values[head * stride] = value;
+    AG_TS_INLINE_FIELD(ts, size_t, head) = (head + 1 == capacity) ? 0 : head + 1;
+
+    /* Publish (constant orders: a runtime order compiles to seq_cst) */
+    if (spmc) {
+        atomic_store_explicit(&ctl->appended, seq + 1, memory_order_release);
+    } else {
+        atomic_store_explicit(&ctl->appended, seq + 1, memory_order_relaxed);
+    }
+    return AG_OK;
+}
+
+/*
+ * Get the newest point: inline equivalent of ag_timeseries_query_last()
+ * with max_points = 1.
+ *
+ * Returns:
+ *   AG_OK, AG_ERR_EMPTY if no point is stored, AG_ERR_INVALID_ARG for a
+ *   NULL handle (when checks are compiled in).
+ *
+ * Behavior:
+ *   SPMC readers validate the copy against the writer's claim and retry,
+ *   like the library. Typed columns go through the library.
+ */
+static inline int ag_timeseries_last_inline(const ag_timeseries_t* ts, int64_t* out_timestamp,
+                                            double* out_value) {
+#if AG_INLINE_CHECKS
+    if (ts == NULL) {
+        return AG_ERR_INVALID_ARG;
+    }
+#endif
+    const double* values = AG_TS_INLINE_FIELD(ts, double* const, values);
+    if (values == NULL) {
+        return (ag_timeseries_query_last(ts, 1, out_timestamp, out_value) == 1) ? AG_OK
+                                                                              : AG_ERR_EMPTY;
+    }
+
+    ag_ts_inline_ctl_t* ctl = AG_TS_INLINE_FIELD(ts, ag_ts_inline_ctl_t* const, ctl);
+    size_t capacity = AG_TS_INLINE_FIELD(ts, const size_t, capacity);
+    size_t stride = AG_TS_INLINE_FIELD(ts, const size_t, stride);
+    const int64_t* timestamps = AG_TS_INLINE_FIELD(ts, int64_t* const, timestamps);
+    int pow2 = AG_TS_INLINE_FIELD(ts, const int, pow2);
+    int spmc = AG_TS_INLINE_FIELD(ts, const int, spmc);
+
+    for (;;) {
+        uint64_t expired = atomic_load_explicit(&ctl->expired, memory_order_acquire);
+        uint64_t end = atomic_load_explicit(&ctl->appended, memory_order_acquire);
+        if (end == 0 || end <= expired) {
+            return AG_ERR_EMPTY;
+        }
+
+        size_t slot = pow2 ? (size_t)(end - 1) & AG_TS_INLINE_FIELD(ts, const size_t, mask)
+                           : (size_t)((end - 1) % capacity);
+        int64_t t = timestamps[slot * stride];
+        double v = values[slot * stride];
+
+        /* SPMC: keep the copy only if the writer has not lapped the slot */
+        if (spmc) {
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&ctl->claimed, memory_order_relaxed) > end - 1 + capacity) {
+                continue;
+            }
+        }
+        *out_timestamp = t;
+        *out_value = v;
+        return AG_OK;
+    }
+}
+
+/*
+ * Get the number of stored points: inline ag_timeseries_size().
+ *
+ * Returns:
+ *   Points currently stored (0 for a NULL handle when checks are on).
+ */
+static inline size_t ag_timeseries_size_inline(const ag_timeseries_t* ts) {
+#if AG_INLINE_CHECKS
+    if (ts == NULL) {
+        return 0;
+    }
+#endif
+    ag_ts_inline_ctl_t* ctl = AG_TS_INLINE_FIELD(ts, ag_ts_inline_ctl_t* const, ctl);
+    size_t capacity = AG_TS_INLINE_FIELD(ts, const size_t, capacity);
+    uint64_t expired = atomic_load_explicit(&ctl->expired, memory_order_acquire);
+    uint64_t end = atomic_load_explicit(&ctl->appended, memory_order_acquire);
+    uint64_t begin = (end > capacity) ? end - capacity : 0;
+    if (begin < expired) {
+        begin = expired;
+    }
+    return (begin < end) ? (size_t)(end - begin) : 0;
+}
+
+/*
+ * Get the append sequence: inline ag_timeseries_sequence().
+ *
+ * Returns:
+ *   Points ever appended (0 for a NULL handle when checks are on).
+ */
+static inline uint64_t ag_timeseries_sequence_inline(const ag_timeseries_t* ts) {
+#if AG_INLINE_CHECKS
+    if (ts == NULL) {
+        return 0;
+    }
+#endif
+    ag_ts_inline_ctl_t* ctl = AG_TS_INLINE_FIELD(ts, ag_ts_inline_ctl_t* const, ctl);
+    return atomic_load_explicit(&ctl->appended, memory_order_acquire);
+}
+
+#endif /* AG_TIMESERIES_INLINE_H */
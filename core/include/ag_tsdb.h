@@ -0,0 +1,296 @@
+/*
+ * ag_tsdb.h - Multi-Series Registry API
+ *
+ * Purpose: Holds many fixed-capacity time-series carved out of one aligned
+ *          arena, addressed by dense integer ID or interned name.
+ *
+ * Thread Safety: NOT thread-safe for registration. Series handles returned by
+ *   ag_tsdb_get() follow the rules of ag_timeseries.h (SPMC when the registry
+ *   was created with AG_TSDB_SPMC). The background flush thread may run
+ *   while series are registered and appended to.
+ * Memory Model: One mapping sized for max_series at creation time; adding a
+ *   series only copies its name. Pages are zero-filled by the kernel, so no
+ *   up-front memset - untouched series cost no resident memory.
+ *
+ * Copyright (c) 2025 AlgorithmicGrid
+ */
+
+#ifndef AG_TSDB_H
+#define AG_TSDB_H
+
+#include "ag_timeseries.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Opaque handle - internal structure hidden from users */
+typedef struct ag_tsdb_t ag_tsdb_t;
+
+/* Creation flags for ag_tsdb_create */
+#define AG_TSDB_HUGEPAGES   0x1u    /* Back the arena with huge pages if available */
+#define AG_TSDB_SPMC        0x2u    /* Create every series in SPMC mode */
+
+/*
+ * One chunk of new points handed to a flush sink. The view is a single
+ * contiguous span straight into the series' ring (span_count is 1), so a
+ * sink can copy or COPY it out with no staging buffer.
+ */
+typedef struct {
+    size_t id;                  /* Series ID */
+    const char* name;           /* Series name (NULL for anonymous series) */
+    const ag_timeseries_t* ts;  /* Series handle, for ag_timeseries_view_valid() */
+    ag_timeseries_view_t view;  /* New points, oldest first */
+    uint64_t lost;              /* Points overwritten unflushed just before this chunk */
+} ag_tsdb_chunk_t;
+
+/*
+ * Flush sink: consume one chunk. Return AG_OK once the chunk is consumed;
+ * any other value refuses it (backpressure) and the same chunk is offered
+ * again on a later pass.
+ */
+typedef int (*ag_tsdb_sink_fn)(void* ctx, const ag_tsdb_chunk_t* chunk);
+
+/*
+ * Flush pipeline counters (totals since ag_tsdb_flush_attach()).
+ */
+typedef struct {
+    uint64_t flushed;   /* Points the sink accepted */
+    uint64_t chunks;    /* Chunks the sink accepted */
+    uint64_t lost;      /* Points overwritten before they could be flushed */
+    uint64_t deferred;  /* Chunks the sink refused (backpressure) */
+    uint64_t torn;      /* Accepted chunks overwritten while the sink read them */
+    uint64_t passes;    /* Completed passes over all series */
+    uint64_t backlog;   /* Points appended but not yet flushed, as of the last pass */
+} ag_tsdb_flush_stats_t;
+
+/*
+ * Create a registry for up to max_series series of 'capacity' points each.
+ *
+ * Parameters:
+ *   max_series - Maximum number of series (must be > 0)
+ *   capacity   - Points per series (must be > 0)
+ *   flags      - Bitwise OR of AG_TSDB_* flags, or 0
+ *
+ * Returns:
+ *   Registry handle, or NULL on invalid arguments / allocation failure.
+ *
+ * Layout:
+ *   All series handles are packed first (each padded to whole 64-byte
+ *   cache lines), followed by each series' timestamp and value arrays,
+ *   every array 64-byte aligned. Sweeping handles touches consecutive lines.
+ *
+ * Huge Pages:
+ *   With AG_TSDB_HUGEPAGES the arena is mapped with MAP_HUGETLB when the
+ *   system has a reserved pool, otherwise transparent huge pages are
+ *   requested with madvise(). Falls back to normal pages silently.
+ *
+ * Memory:
+ *   Call ag_tsdb_destroy() to free. Series are never freed individually.
+ */
+ag_tsdb_t* ag_tsdb_create(size_t max_series, size_t capacity, unsigned flags);
+
+/*
+ * Destroy registry and every series in it.
+ *
+ * Parameters:
+ *   db - Registry handle (NULL safe - no-op if NULL)
+ *
+ * Thread Safety:
+ *   NOT safe. No series of the registry may be in use.
+ */
+void ag_tsdb_destroy(ag_tsdb_t* db);
+
+/*
+ * Register a series.
+ *
+ * Parameters:
+ *   db     - Registry handle
+ *   name   - Series name (copied), or NULL for an anonymous series
+ *   out_id - Output: series ID (may be NULL)
+ *
+ * Returns:
+ *   AG_OK on success (also when 'name' is already registered - out_id then
+ *   receives the existing ID), AG_ERR_INVALID_ARG if db is NULL,
+ *   AG_ERR_FULL if max_series are registered, AG_ERR_NOMEM if the name
+ *   copy fails.
+ *
+ * Behavior:
+ *   IDs are dense and assigned in registration order: 0, 1, 2, ...
+ *
+ * Performance:
+ *   O(1) expected (hashed name lookup).
+ */
+int ag_tsdb_add(ag_tsdb_t* db, const char* name, size_t* out_id);
+
+/*
+ * Look up a series ID by name.
+ *
+ * Returns:
+ *   AG_OK and *out_id on success, AG_ERR_EMPTY if no series has that name,
+ *   AG_ERR_INVALID_ARG on NULL arguments.
+ *
+ * Performance:
+ *   O(1) expected.
+ */
+int ag_tsdb_find(const ag_tsdb_t* db, const char* name, size_t* out_id);
+
+/*
+ * Get series handle by ID.
+ *
+ * Returns:
+ *   Series handle, or NULL if db is NULL or id >= ag_tsdb_count().
+ *   The handle is owned by the registry (ag_timeseries_destroy() is a no-op).
+ */
+ag_timeseries_t* ag_tsdb_get(const ag_tsdb_t* db, size_t id);
+
+/*
+ * Get series handle by name (ag_tsdb_find() + ag_tsdb_get()).
+ *
+ * Returns:
+ *   Series handle, or NULL if not registered.
+ */
+ag_timeseries_t* ag_tsdb_lookup(const ag_tsdb_t* db, const char* name);
+
+/*
+ * Get series name by ID.
+ *
+ * Returns:
+ *   Interned name (valid until ag_tsdb_destroy()), or NULL for anonymous
+ *   series and invalid IDs.
+ */
+const char* ag_tsdb_name(const ag_tsdb_t* db, size_t id);
+
+/*
+ * Get number of registered series.
+ *
+ * Iteration:
+ *   for (size_t id = 0; id < ag_tsdb_count(db); id++) {
+ *       ag_timeseries_t* ts = ag_tsdb_get(db, id);
+ *       ...
+ *   }
+ *
+ * Returns:
+ *   Number of series (0 if db is NULL).
+ */
+size_t ag_tsdb_count(const ag_tsdb_t* db);
+
+/*
+ * Get per-series point capacity.
+ *
+ * Returns:
+ *   Capacity given at creation (0 if db is NULL).
+ */
+size_t ag_tsdb_capacity(const ag_tsdb_t* db);
+
+/*
+ * Attach a flush sink: every registered series gets a flush cursor.
+ *
+ * Parameters:
+ *   db        - Registry handle
+ *   sink      - Callback receiving chunks of new points
+ *   ctx       - Opaque pointer passed to every sink call
+ *   max_chunk - Most points per chunk (0 = per-series capacity)
+ *
+ * Returns:
+ *   AG_OK on success, AG_ERR_INVALID_ARG if db or sink is NULL or the
+ *   flush thread is running, AG_ERR_NOMEM if the cursors cannot be allocated.
+ *
+ * Behavior:
+ *   Cursors start at each series' oldest stored point; series registered
+ *   later are flushed from their first point. Attaching again replaces the
+ *   sink but keeps cursors and counters, so nothing is flushed twice.
+ *
+ * Thread Safety:
+ *   NOT safe. Same rules as ag_tsdb_add().
+ */
+int ag_tsdb_flush_attach(ag_tsdb_t* db, ag_tsdb_sink_fn sink, void* ctx,
+                         size_t max_chunk);
+
+/*
+ * Run one flush pass on the calling thread.
+ *
+ * Parameters:
+ *   db         - Registry handle with a sink attached
+ *   out_points - Output: points the sink accepted in this pass (may be NULL)
+ *
+ * Returns:
+ *   AG_OK on success, AG_ERR_INVALID_ARG if db is NULL, no sink is attached
+ *   or the flush thread is running.
+ *
+ * Behavior:
+ *   For each series in ID order, views its unflushed points through its
+ *   cursor (ag_timeseries_cursor_view) and offers them to the sink in
+ *   chunks of up to max_chunk points; a chunk never crosses the ring's
+ *   wrap point. A series stops at the sequence it had when the pass
+ *   reached it, or at the first refused chunk (counted as deferred).
+ *   Points overwritten before they were offered are counted as lost and
+ *   reported with the next chunk. If the writer laps a chunk while the sink
+ *   reads it, the chunk counts as torn and its surviving points are
+ *   offered again, so sinks on SPMC registries should check
+ *   ag_timeseries_view_valid() before committing a chunk.
+ *
+ * Performance:
+ *   O(series + new points) plus the sink's own work. NO COPY.
+ *
+ * Thread Safety:
+ *   Without AG_TSDB_SPMC, NOT safe against appends; with it, safe to run
+ *   concurrently with the series' writers. Never run two passes at once.
+ */
+int ag_tsdb_flush(ag_tsdb_t* db, size_t* out_points);
+
+/*
+ * Start a background thread that runs flush passes.
+ *
+ * Parameters:
+ *   db          - Registry handle with a sink attached
+ *   interval_ms - Sleep after a pass that flushed nothing (0 = 1 ms)
+ *
+ * Returns:
+ *   AG_OK on success, AG_ERR_INVALID_ARG if db is NULL, no sink is
+ *   attached, the registry was created without AG_TSDB_SPMC or the thread
+ *   is already running, AG_ERR_NOMEM if the thread cannot be created.
+ *
+ * Behavior:
+ *   Passes run back to back while they make progress. After a pass that
+ *   flushed nothing (idle, or every chunk refused) the thread sleeps for
+ *   interval_ms, which also paces retries of a backpressuring sink. The
+ *   sink is called on the flush thread only.
+ *
+ * Thread Safety:
+ *   NOT safe against other flush calls on the same registry. Series may be
+ *   registered and appended to while the thread runs.
+ */
+int ag_tsdb_flush_start(ag_tsdb_t* db, unsigned interval_ms);
+
+/*
+ * Stop the background flush thread and wait for it to exit.
+ *
+ * Returns:
+ *   AG_OK on success, AG_ERR_INVALID_ARG if db is NULL or no thread runs.
+ *
+ * Behavior:
+ *   The pass in progress completes first. Points appended after it are
+ *   not flushed; call ag_tsdb_flush() once writers are done to drain them.
+ *   ag_tsdb_destroy() stops a running thread itself.
+ */
+int ag_tsdb_flush_stop(ag_tsdb_t* db);
+
+/*
+ * Read the flush pipeline counters.
+ *
+ * Returns:
+ *   AG_OK on success, AG_ERR_INVALID_ARG if db or out is NULL.
+ *   Counters are zero until a sink is attached.
+ *
+ * Thread Safety:
+ *   Safe to call while the flush thread runs (each counter is read
+ *   atomically, the set is not one snapshot).
+ */
+int ag_tsdb_flush_stats(const ag_tsdb_t* db, ag_tsdb_flush_stats_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AG_TSDB_H */
@@ -0,0 +1,175 @@
+/*
+ * ag_alloc.c - Page-Level Buffer Placement
+ *
+ * Implementation Strategy:
+ *   - Data arrays in one anonymous mapping: kernel zero-fill, no memset
+ *   - Huge pages: MAP_HUGETLB when a pool is reserved, else THP advice
+ *   - NUMA binding through the raw mbind syscall (no libnuma dependency),
+ *     applied before the first touch so every page lands on the node
+ *   - Prefault with MADV_POPULATE_WRITE, or one store per page on kernels
+ *     without it; mlock last
+ *
+ * Copyright (c) 2025 AlgorithmicGrid
+ */
+
+#define _DEFAULT_SOURCE     /* MAP_ANONYMOUS, MAP_HUGETLB, madvise, syscall */
+
+#include "ag_timeseries_internal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#define PAGES_ALIGN         64u                 /* Cache line */
+#define PAGES_HUGE_PAGE     (2u * 1024u * 1024u) /* Default x86-64/aarch64 huge page */
+#define PAGES_MPOL_BIND     2                   /* <linux/mempolicy.h> MPOL_BIND */
+
+#define CREATE_FLAGS (AG_CREATE_SPMC | AG_CREATE_INTERLEAVED | AG_CREATE_HUGEPAGES | \
+                      AG_CREATE_LAZY | AG_CREATE_MLOCK | AG_CREATE_NUMA)
+
+/* Helper: Round up to multiple of 'align' (power of two), 0 on overflow */
+static size_t align_up(size_t n, size_t align) {
+    if (n > SIZE_MAX - (align - 1)) {
+        return 0;
+    }
+    return (n + align - 1) & ~(align - 1);
+}
+
+void* ag_map_pages(size_t* size, int huge) {
+    void* p = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    if (huge) {
+        /* Explicit huge pages need a length that is a huge page multiple */
+        size_t rounded = align_up(*size, PAGES_HUGE_PAGE);
+        if (rounded != 0) {
+            p = mmap(NULL, rounded, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p != MAP_FAILED) {
+                *size = rounded;
+                return p;
+            }
+        }
+    }
+#endif
+
+    p = mmap(NULL, *size, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        return NULL;
+    }
+
+#ifdef MADV_HUGEPAGE
+    if (huge) {
+        /* Transparent huge pages - advisory, failure is harmless */
+        (void)madvise(p, *size, MADV_HUGEPAGE);
+    }
+#endif
+
+    return p;
+}
+
+/* Helper: Bind an untouched mapping to one NUMA node; 0 on success */
+static int bind_node(void* p, size_t size, int node) {
+#if defined(__linux__) && defined(SYS_mbind)
+    unsigned long mask[AG_CREATE_MAX_NUMA_NODES / (8 * sizeof(unsigned long))];
+    const size_t bits = 8 * sizeof(unsigned long);
+    memset(mask, 0, sizeof(mask));
+    mask[(size_t)node / bits] = 1ul << ((size_t)node % bits);
+
+    /* maxnode counts one past the last bit the kernel reads */
+    return (int)syscall(SYS_mbind, p, size, PAGES_MPOL_BIND, mask,
+                        (unsigned long)AG_CREATE_MAX_NUMA_NODES + 1, 0ul);
+#else
+    (void)p;
+    (void)size;
+    (void)node;
+    return -1;
+#endif
+}
+
+/* Helper: Fault every page in now so appends never do */
+static void prefault(void* p, size_t size) {
+#ifdef MADV_POPULATE_WRITE
+    if (madvise(p, size, MADV_POPULATE_WRITE) == 0) {
+        return;
+    }
+#endif
+    /* Older kernels: one store per page (the pages are already zero) */
+    long page = sysconf(_SC_PAGESIZE);
+    size_t step = (page > 0) ? (size_t)page : 4096u;
+    volatile unsigned char* bytes = (volatile unsigned char*)p;
+    for (size_t off = 0; off < size; off += step) {
+        bytes[off] = 0;
+    }
+}
+
+ag_timeseries_t* ag_timeseries_create_ex(size_t capacity,
+                                         const ag_timeseries_options_t* options) {
+    ag_timeseries_options_t defaults = { 0, 0, AG_VALUE_F64 };
+    const ag_timeseries_options_t* opt = (options != NULL) ? options : &defaults;
+    unsigned flags = opt->flags;
+
+    /* Validate arguments */
+    if (capacity == 0 || capacity > SIZE_MAX / sizeof(int64_t) || (flags & ~CREATE_FLAGS)) {
+        return NULL;
+    }
+    if ((flags & AG_CREATE_NUMA) &&
+        (opt->numa_node < 0 || opt->numa_node >= AG_CREATE_MAX_NUMA_NODES)) {
+        return NULL;
+    }
+
+    /* Interleaved pairs hold doubles only */
+    int interleaved = (flags & AG_CREATE_INTERLEAVED) != 0;
+    size_t vsize = ag_typed_size(opt->value_type);
+    if (vsize == 0 || (interleaved && opt->value_type != AG_VALUE_F64)) {
+        return NULL;
+    }
+
+    /* Layout: interleaved pairs, or timestamps then a cache-line-aligned value array */
+    size_t array = align_up(capacity * sizeof(int64_t), PAGES_ALIGN);
+    size_t cells = align_up(capacity * vsize, PAGES_ALIGN);
+    if (array == 0 || cells == 0 || array > SIZE_MAX - cells) {
+        return NULL;
+    }
+    size_t size = array + (interleaved ? array : cells);
+
+    ag_timeseries_t* ts = (ag_timeseries_t*)malloc(sizeof(ag_timeseries_t));
+    if (ts == NULL) {
+        return NULL;
+    }
+    unsigned char* base = (unsigned char*)ag_map_pages(&size, (flags & AG_CREATE_HUGEPAGES) != 0);
+    if (base == NULL) {
+        free(ts);
+        return NULL;
+    }
+
+    /* Placement before first touch, then prefault, then lock */
+    if (((flags & AG_CREATE_NUMA) && bind_node(base, size, opt->numa_node) != 0) ||
+        ((flags & AG_CREATE_MLOCK) && mlock(base, size) != 0)) {
+        munmap(base, size);
+        free(ts);
+        return NULL;
+    }
+    if (!(flags & (AG_CREATE_LAZY | AG_CREATE_MLOCK))) {
+        prefault(base, size);
+    }
+
+    int64_t* timestamps = (int64_t*)base;
+    double* values = interleaved ? (double*)base + 1 : (double*)(base + array);
+    ag_timeseries_init(ts, capacity, (flags & AG_CREATE_SPMC) != 0, timestamps, values);
+    ts->stride = interleaved ? 2 : 1;
+    ts->mapped = size;
+    if (opt->value_type != AG_VALUE_F64) {
+        ag_typed_attach(ts, opt->value_type, base + array);
+    }
+    return ts;
+}
+
+void ag_pages_close(ag_timeseries_t* ts) {
+    munmap(ts->timestamps, ts->mapped);
+    ts->mapped = 0;
+}
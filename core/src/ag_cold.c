@@ -0,0 +1,481 @@
+/*
+ * ag_cold.c - Gorilla-Compressed Cold Tier
+ *
+ * Implementation Strategy:
+ *   - Evicted points are encoded into an open block as they arrive:
+ *     timestamps as delta-of-delta with variable-width buckets, values as
+ *     XOR against the previous value with a reused leading/trailing-zero
+ *     window (Pelkonen et al., "Gorilla", VLDB 2015)
+ *   - Full blocks are copied into a circular word arena; the oldest blocks
+ *     are dropped to make room, so the tier is always a contiguous suffix
+ *     of the evicted history
+ *   - Each block records its min/max timestamp, so range queries only
+ *     decode overlapping blocks
+ *   - All memory is allocated once at creation - no allocations on append
+ *
+ * Bit Layout (MSB first within 64-bit words):
+ *   First point: 64-bit timestamp, 64-bit value bits
+ *   Timestamp:   '0' (dod == 0) | '10'+7 | '110'+9 | '1110'+12 | '1111'+64
+ *   Value:       '0' (same) | '10'+bits in previous window |
+ *                '11'+5 leading zeros+6 length (0 = 64)+bits
+ *
+ * Copyright (c) 2025 AlgorithmicGrid
+ */
+
+#include "ag_cold.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Worst case per point: timestamp 4 + 64 bits, value 2 + 5 + 6 + 64 bits */
+#define MAX_BITS_PER_POINT  145
+#define BLOCK_WORDS         ((AG_COLD_BLOCK_POINTS * MAX_BITS_PER_POINT + 63) / 64 + 1)
+
+/* Best case per block: first point 128 bits, then 2 bits per point */
+#define MIN_BLOCK_WORDS     ((128 + (AG_COLD_BLOCK_POINTS - 1) * 2 + 63) / 64)
+
+/* Codec state shared by encoder and decoder */
+typedef struct {
+    int64_t prev_ts;        /* Previous timestamp */
+    int64_t prev_delta;     /* Previous timestamp delta */
+    uint64_t prev_bits;     /* Previous value bit pattern */
+    unsigned lead;          /* Current XOR window: leading zeros */
+    unsigned trail;         /* Current XOR window: trailing zeros */
+    int has_window;         /* lead/trail are valid */
+} codec_state_t;
+
+/* Sealed block: 'words' words at 'offset' in the arena */
+typedef struct {
+    size_t offset;          /* First word in arena */
+    size_t words;           /* Encoded length in words */
+    size_t count;           /* Number of points */
+    int64_t min_ts;         /* Smallest timestamp in block */
+    int64_t max_ts;         /* Largest timestamp in block */
+} cold_block_t;
+
+/*
+ * Internal structure
+ *
+ * Arena occupancy: live blocks run circularly from blocks[oldest].offset to
+ * 'arena_head'; a block that does not fit before the arena end starts over
+ * at word 0, leaving the tail unused until the blocks before it expire.
+ */
+struct cold_tier_t {
+    uint64_t* arena;            /* Sealed block storage */
+    size_t arena_words;         /* Arena size in words */
+    size_t arena_head;          /* Next free word */
+
+    cold_block_t* blocks;       /* Ring of sealed block descriptors */
+    size_t block_capacity;      /* Descriptor ring size */
+    size_t block_first;         /* Index of oldest block */
+    size_t block_count;         /* Number of sealed blocks */
+    size_t sealed_points;       /* Points in sealed blocks */
+    size_t sealed_words;        /* Words used by sealed blocks */
+
+    uint64_t* open;             /* Open block bits (BLOCK_WORDS words) */
+    size_t open_bits;           /* Bits written to open block */
+    size_t open_count;          /* Points in open block */
+    int64_t open_min_ts;        /* Smallest timestamp in open block */
+    int64_t open_max_ts;        /* Largest timestamp in open block */
+    codec_state_t enc;          /* Encoder state of open block */
+};
+
+/* Sequential reader over one encoded block */
+typedef struct {
+    const uint64_t* words;      /* Encoded block */
+    size_t pos;                 /* Next bit */
+    size_t remaining;           /* Points left to decode */
+    codec_state_t st;           /* Decoder state */
+} cold_reader_t;
+
+/* Helper: Low n bits set (1 <= n <= 64) */
+static inline uint64_t low_mask(unsigned n) {
+    return n >= 64 ? ~0ull : (1ull << n) - 1;
+}
+
+/* Helper: Append low n bits of v (1 <= n <= 64) to a zeroed bit buffer */
+static inline void bits_write(uint64_t* words, size_t* pos, uint64_t v, unsigned n) {
+    size_t idx = *pos >> 6;
+    unsigned room = 64 - (unsigned)(*pos & 63);
+    v &= low_mask(n);
+
+    if (n <= room) {
+        words[idx] |= v << (room - n);
+    } else {
+        unsigned spill = n - room;
+        words[idx] |= v >> spill;
+        words[idx + 1] |= v << (64 - spill);
+    }
+    *pos += n;
+}
+
+/* Helper: Read next n bits (1 <= n <= 64) */
+static inline uint64_t bits_read(cold_reader_t* r, unsigned n) {
+    size_t idx = r->pos >> 6;
+    unsigned room = 64 - (unsigned)(r->pos & 63);
+    uint64_t v;
+
+    if (n <= room) {
+        v = (r->words[idx] >> (room - n)) & low_mask(n);
+    } else {
+        unsigned spill = n - room;
+        v = ((r->words[idx] & low_mask(room)) << spill) | (r->words[idx + 1] >> (64 - spill));
+    }
+    r->pos += n;
+    return v;
+}
+
+/* Helper: Sign-extend the low n bits of v */
+static inline int64_t sign_extend(uint64_t v, unsigned n) {
+    if (n < 64 && ((v >> (n - 1)) & 1)) {
+        v |= ~low_mask(n);
+    }
+    return (int64_t)v;
+}
+
+/* Helper: Double to bit pattern and back */
+static inline uint64_t double_bits(double x) {
+    uint64_t b;
+    memcpy(&b, &x, sizeof(b));
+    return b;
+}
+
+static inline double bits_double(uint64_t b) {
+    double x;
+    memcpy(&x, &b, sizeof(x));
+    return x;
+}
+
+/* Helper: Encode one point into the open block */
+static void encode_point(cold_tier_t* c, int64_t timestamp_ms, double value) {
+    codec_state_t* st = &c->enc;
+    uint64_t bits = double_bits(value);
+
+    if (c->open_count == 0) {
+        bits_write(c->open, &c->open_bits, (uint64_t)timestamp_ms, 64);
+        bits_write(c->open, &c->open_bits, bits, 64);
+        st->prev_ts = timestamp_ms;
+        st->prev_delta = 0;
+        st->prev_bits = bits;
+        st->has_window = 0;
+        c->open_min_ts = timestamp_ms;
+        c->open_max_ts = timestamp_ms;
+        c->open_count = 1;
+        return;
+    }
+
+    /* Timestamp: delta-of-delta in wrapping arithmetic */
+    int64_t delta = (int64_t)((uint64_t)timestamp_ms - (uint64_t)st->prev_ts);
+    int64_t dod = (int64_t)((uint64_t)delta - (uint64_t)st->prev_delta);
+    if (dod == 0) {
+        bits_write(c->open, &c->open_bits, 0x0, 1);
+    } else if (dod >= -64 && dod <= 63) {
+        bits_write(c->open, &c->open_bits, 0x2, 2);
+        bits_write(c->open, &c->open_bits, (uint64_t)dod, 7);
+    } else if (dod >= -256 && dod <= 255) {
+        bits_write(c->open, &c->open_bits, 0x6, 3);
+        bits_write(c->open, &c->open_bits, (uint64_t)dod, 9);
+    } else if (dod >= -2048 && dod <= 2047) {
+        bits_write(c->open, &c->open_bits, 0xE, 4);
+        bits_write(c->open, &c->open_bits, (uint64_t)dod, 12);
+    } else {
+        bits_write(c->open, &c->open_bits, 0xF, 4);
+        bits_write(c->open, &c->open_bits, (uint64_t)dod, 64);
+    }
+    st->prev_ts = timestamp_ms;
+    st->prev_delta = delta;
+
+    /* Value: XOR against previous */
+    uint64_t x = bits ^ st->prev_bits;
+    if (x == 0) {
+        bits_write(c->open, &c->open_bits, 0x0, 1);
+    } else {
+        unsigned lead = (unsigned)__builtin_clzll(x);
+        unsigned trail = (unsigned)__builtin_ctzll(x);
+        if (lead > 31) {
+            lead = 31;  /* 5-bit field */
+        }
+
+        if (st->has_window && lead >= st->lead && trail >= st->trail) {
+            bits_write(c->open, &c->open_bits, 0x2, 2);
+            bits_write(c->open, &c->open_bits, x >> st->trail, 64 - st->lead - st->trail);
+        } else {
+            unsigned sig = 64 - lead - trail;
+            bits_write(c->open, &c->open_bits, 0x3, 2);
+            bits_write(c->open, &c->open_bits, lead, 5);
+            bits_write(c->open, &c->open_bits, sig & 63, 6);
+            bits_write(c->open, &c->open_bits, x >> trail, sig);
+            st->lead = lead;
+            st->trail = trail;
+            st->has_window = 1;
+        }
+    }
+    st->prev_bits = bits;
+
+    if (timestamp_ms < c->open_min_ts) {
+        c->open_min_ts = timestamp_ms;
+    }
+    if (timestamp_ms > c->open_max_ts) {
+        c->open_max_ts = timestamp_ms;
+    }
+    c->open_count++;
+}
+
+/* Helper: Start decoding an encoded block of 'count' points */
+static void reader_init(cold_reader_t* r, const uint64_t* words, size_t count) {
+    r->words = words;
+    r->pos = 0;
+    r->remaining = count;
+    memset(&r->st, 0, sizeof(r->st));
+}
+
+/* Helper: Decode next point (caller checks r->remaining > 0) */
+static void reader_next(cold_reader_t* r, int64_t* out_ts, double* out_value) {
+    codec_state_t* st = &r->st;
+    int first = r->pos == 0;
+    r->remaining--;
+
+    if (first) {
+        st->prev_ts = (int64_t)bits_read(r, 64);
+        st->prev_bits = bits_read(r, 64);
+        *out_ts = st->prev_ts;
+        *out_value = bits_double(st->prev_bits);
+        return;
+    }
+
+    /* Timestamp: count leading 1s of the prefix (up to 4) */
+    unsigned prefix = 0;
+    while (prefix < 4 && bits_read(r, 1) == 1) {
+        prefix++;
+    }
+    static const unsigned widths[5] = { 0, 7, 9, 12, 64 };
+    int64_t dod = 0;
+    if (prefix > 0) {
+        dod = sign_extend(bits_read(r, widths[prefix]), widths[prefix]);
+    }
+    st->prev_delta = (int64_t)((uint64_t)st->prev_delta + (uint64_t)dod);
+    st->prev_ts = (int64_t)((uint64_t)st->prev_ts + (uint64_t)st->prev_delta);
+
+    /* Value */
+    if (bits_read(r, 1) == 1) {
+        if (bits_read(r, 1) == 1) {
+            st->lead = (unsigned)bits_read(r, 5);
+            unsigned sig = (unsigned)bits_read(r, 6);
+            if (sig == 0) {
+                sig = 64;
+            }
+            st->trail = 64 - st->lead - sig;
+        }
+        unsigned sig = 64 - st->lead - st->trail;
+        st->prev_bits ^= bits_read(r, sig) << st->trail;
+    }
+
+    *out_ts = st->prev_ts;
+    *out_value = bits_double(st->prev_bits);
+}
+
+/* Helper: Drop the oldest sealed block */
+static void drop_oldest(cold_tier_t* c) {
+    cold_block_t* b = &c->blocks[c->block_first];
+    c->sealed_points -= b->count;
+    c->sealed_words -= b->words;
+    c->block_first = (c->block_first + 1 == c->block_capacity) ? 0 : c->block_first + 1;
+    c->block_count--;
+}
+
+/* Helper: Arena offset for a block of 'words', dropping old blocks as needed */
+static size_t arena_alloc(cold_tier_t* c, size_t words) {
+    for (;;) {
+        if (c->block_count == 0) {
+            c->arena_head = 0;
+            return 0;
+        }
+
+        size_t oldest = c->blocks[c->block_first].offset;
+        if (oldest < c->arena_head) {
+            /* Live region [oldest, head): free space after head, then before oldest */
+            if (c->arena_head + words <= c->arena_words) {
+                return c->arena_head;
+            }
+            if (words <= oldest) {
+                return 0;
+            }
+        } else if (oldest > c->arena_head && c->arena_head + words <= oldest) {
+            /* Live region wraps: free space is [head, oldest) */
+            return c->arena_head;
+        }
+
+        drop_oldest(c);
+    }
+}
+
+/* Helper: Move the full open block into the arena */
+static void seal_open(cold_tier_t* c) {
+    size_t words = (c->open_bits + 63) / 64;
+
+    if (c->block_count == c->block_capacity) {
+        drop_oldest(c);
+    }
+    size_t offset = arena_alloc(c, words);
+    memcpy(c->arena + offset, c->open, words * sizeof(uint64_t));
+    c->arena_head = offset + words;
+
+    size_t slot = c->block_first + c->block_count;
+    if (slot >= c->block_capacity) {
+        slot -= c->block_capacity;
+    }
+    cold_block_t* b = &c->blocks[slot];
+    b->offset = offset;
+    b->words = words;
+    b->count = c->open_count;
+    b->min_ts = c->open_min_ts;
+    b->max_ts = c->open_max_ts;
+    c->block_count++;
+    c->sealed_points += c->open_count;
+    c->sealed_words += words;
+
+    /* Reset open block (bit writer requires zeroed words) */
+    memset(c->open, 0, words * sizeof(uint64_t));
+    c->open_bits = 0;
+    c->open_count = 0;
+}
+
+/* Helper: Sealed block i (0 = oldest) */
+static const cold_block_t* block_at(const cold_tier_t* c, size_t i) {
+    size_t slot = c->block_first + i;
+    if (slot >= c->block_capacity) {
+        slot -= c->block_capacity;
+    }
+    return &c->blocks[slot];
+}
+
+/* Helper: Range-filter one encoded block into the output */
+static size_t scan_block(const uint64_t* words, size_t count, int64_t start_ms,
+                         int64_t end_ms, size_t max_points,
+                         int64_t* out_timestamps, double* out_values) {
+    cold_reader_t r;
+    reader_init(&r, words, count);
+    size_t n = 0;
+
+    while (r.remaining > 0 && n < max_points) {
+        int64_t t;
+        double v;
+        reader_next(&r, &t, &v);
+        if (t >= start_ms && t <= end_ms) {
+            out_timestamps[n] = t;
+            out_values[n] = v;
+            n++;
+        }
+    }
+    return n;
+}
+
+/* Helper: Newest 'want' points of one encoded block, newest first */
+static size_t tail_block(const uint64_t* words, size_t count, size_t want,
+                         int64_t* out_timestamps, double* out_values) {
+    if (want > count) {
+        want = count;
+    }
+    cold_reader_t r;
+    reader_init(&r, words, count);
+
+    for (size_t i = 0; i < count; i++) {
+        int64_t t;
+        double v;
+        reader_next(&r, &t, &v);
+        if (i >= count - want) {
+            out_timestamps[count - 1 - i] = t;
+            out_values[count - 1 - i] = v;
+        }
+    }
+    return want;
+}
+
+size_t ag_cold_min_budget(void) {
+    return BLOCK_WORDS * sizeof(uint64_t);
+}
+
+cold_tier_t* ag_cold_create(size_t budget_bytes) {
+    size_t arena_words = budget_bytes / sizeof(uint64_t);
+    if (arena_words < BLOCK_WORDS) {
+        return NULL;
+    }
+
+    cold_tier_t* c = (cold_tier_t*)calloc(1, sizeof(cold_tier_t));
+    if (c == NULL) {
+        return NULL;
+    }
+
+    c->arena_words = arena_words;
+    c->block_capacity = arena_words / MIN_BLOCK_WORDS + 1;
+    c->arena = (uint64_t*)malloc(arena_words * sizeof(uint64_t));
+    c->blocks = (cold_block_t*)malloc(c->block_capacity * sizeof(cold_block_t));
+    c->open = (uint64_t*)calloc(BLOCK_WORDS, sizeof(uint64_t));
+
+    if (c->arena == NULL || c->blocks == NULL || c->open == NULL) {
+        ag_cold_destroy(c);
+        return NULL;
+    }
+    return c;
+}
+
+void ag_cold_destroy(cold_tier_t* cold) {
+    if (cold == NULL) {
+        return;
+    }
+    free(cold->arena);
+    free(cold->blocks);
+    free(cold->open);
+    free(cold);
+}
+
+void ag_cold_push(cold_tier_t* cold, int64_t timestamp_ms, double value) {
+    if (cold->open_count == AG_COLD_BLOCK_POINTS) {
+        seal_open(cold);
+    }
+    encode_point(cold, timestamp_ms, value);
+}
+
+size_t ag_cold_query_range(const cold_tier_t* cold, int64_t start_ms, int64_t end_ms,
+                           size_t max_points, int64_t* out_timestamps, double* out_values) {
+    size_t n = 0;
+
+    for (size_t i = 0; i < cold->block_count && n < max_points; i++) {
+        const cold_block_t* b = block_at(cold, i);
+        if (b->max_ts < start_ms || b->min_ts > end_ms) {
+            continue;
+        }
+        n += scan_block(cold->arena + b->offset, b->count, start_ms, end_ms,
+                        max_points - n, out_timestamps + n, out_values + n);
+    }
+
+    if (cold->open_count > 0 && n < max_points &&
+        cold->open_max_ts >= start_ms && cold->open_min_ts <= end_ms) {
+        n += scan_block(cold->open, cold->open_count, start_ms, end_ms,
+                        max_points - n, out_timestamps + n, out_values + n);
+    }
+    return n;
+}
+
+size_t ag_cold_query_last(const cold_tier_t* cold, size_t max_points,
+                          int64_t* out_timestamps, double* out_values) {
+    size_t n = 0;
+
+    if (cold->open_count > 0 && max_points > 0) {
+        n += tail_block(cold->open, cold->open_count, max_points,
+                        out_timestamps, out_values);
+    }
+
+    for (size_t i = cold->block_count; i > 0 && n < max_points; i--) {
+        const cold_block_t* b = block_at(cold, i - 1);
+        n += tail_block(cold->arena + b->offset, b->count, max_points - n,
+                        out_timestamps + n, out_values + n);
+    }
+    return n;
+}
+
+void ag_cold_stats(const cold_tier_t* cold, ag_timeseries_cold_stats_t* out_stats) {
+    out_stats->points = cold->sealed_points + cold->open_count;
+    out_stats->blocks = cold->block_count;
+    out_stats->bytes = cold->sealed_words * sizeof(uint64_t) + (cold->open_bits + 7) / 8;
+    out_stats->budget_bytes = cold->arena_words * sizeof(uint64_t);
+}
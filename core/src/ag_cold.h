@@ -0,0 +1,50 @@
+/*
+ * ag_cold.h - Internal compressed cold tier
+ *
+ * Purpose: Keeps points evicted from a ring in Gorilla-compressed blocks
+ *          (delta-of-delta timestamps, XOR-encoded doubles) inside a fixed
+ *          byte budget, oldest blocks dropped first.
+ *
+ * Not part of the public API - used by ag_timeseries.c.
+ *
+ * Copyright (c) 2025 AlgorithmicGrid
+ */
+
+#ifndef AG_COLD_H
+#define AG_COLD_H
+
+#include "ag_timeseries.h"
+
+/* Points per sealed block */
+#define AG_COLD_BLOCK_POINTS 1024
+
+typedef struct cold_tier_t cold_tier_t;
+
+/* Smallest budget ag_cold_create() accepts (one worst-case block) */
+size_t ag_cold_min_budget(void);
+
+/* Create tier with 'budget_bytes' of block storage; NULL if too small or OOM */
+cold_tier_t* ag_cold_create(size_t budget_bytes);
+
+/* Free tier (NULL safe) */
+void ag_cold_destroy(cold_tier_t* cold);
+
+/* Append one evicted point (newer than every point already in the tier) */
+void ag_cold_push(cold_tier_t* cold, int64_t timestamp_ms, double value);
+
+/*
+ * Copy points with start_ms <= timestamp <= end_ms, oldest first, up to
+ * max_points. Blocks whose timestamp bounds miss the range are skipped
+ * without decoding. Returns number of points written.
+ */
+size_t ag_cold_query_range(const cold_tier_t* cold, int64_t start_ms, int64_t end_ms,
+                           size_t max_points, int64_t* out_timestamps, double* out_values);
+
+/* Copy the newest max_points points, newest first. Returns number written. */
+size_t ag_cold_query_last(const cold_tier_t* cold, size_t max_points,
+                          int64_t* out_timestamps, double* out_values);
+
+/* Fill occupancy counters */
+void ag_cold_stats(const cold_tier_t* cold, ag_timeseries_cold_stats_t* out_stats);
+
+#endif /* AG_COLD_H */
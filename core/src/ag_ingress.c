@@ -0,0 +1,344 @@
+/*
+ * ag_ingress.c - Registry Ingress Queue Implementation
+ *
+ * Implementation Strategy:
+ *   - Bounded MPSC ring of cells, each with its own sequence word
+ *     (Vyukov-style): a producer claims a ticket by CAS on the tail, writes
+ *     the cell, then publishes it by storing ticket + 1 in the cell's
+ *     sequence; the drainer frees a cell by storing ticket + capacity
+ *   - Producers never touch the head and the drainer never touches the
+ *     tail, and the two live on separate cache lines
+ *   - The drainer moves up to INGRESS_BATCH records into scratch arrays,
+ *     groups them by series with a stable counting scatter when they are
+ *     interleaved (series looked up in a small stamped hash table), and
+ *     appends each group as one ag_timeseries_append_batch()
+ *   - Zero allocations after create()
+ *
+ * Copyright (c) 2025 AlgorithmicGrid
+ */
+
+#include "ag_ingress.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INGRESS_ALIGN   64u     /* Cache line */
+
+/* Records moved off the queue per append round */
+#define INGRESS_BATCH   256
+
+/* Group a round when it has more than one run per this many records */
+#define INGRESS_GROUP_RUN 4
+
+/* Group table slots: power of two, twice the most groups a round can have */
+#define INGRESS_TABLE   (2 * INGRESS_BATCH)
+
+/* One queued record: two per cache line */
+typedef struct {
+    _Atomic uint64_t seq;       /* Ticket + 1 when written, ticket + capacity when free */
+    uint64_t series;            /* Target series ID */
+    int64_t timestamp;
+    double value;
+} ingress_cell_t;
+
+/*
+ * Internal structure - opaque to users
+ *
+ * Producer fields (tail and the read-only ring geometry) share the first
+ * line, the rejected counter has its own, and the drainer's state starts
+ * on a third so producers never share a line with the drainer's writes.
+ */
+struct ag_ingress_t {
+    _Atomic uint64_t tail;      /* Next ticket to claim */
+    ingress_cell_t* cells;
+    uint64_t mask;              /* capacity - 1 */
+    int spsc;                   /* Single producer: plain tail store */
+
+    _Alignas(64) _Atomic uint64_t rejected;
+
+    _Alignas(64) uint64_t head; /* Next ticket to drain */
+    ag_tsdb_t* db;
+    size_t capacity;
+    uint64_t drained;
+    uint64_t batches;
+    uint64_t dropped;
+
+    /* Drain scratch: one round as popped, and grouped by series */
+    uint32_t round;                         /* Stamp of the current grouping */
+    uint32_t stamps[INGRESS_TABLE];         /* Slot in use when == round */
+    uint16_t slots[INGRESS_TABLE];          /* Group index of a slot */
+    uint16_t group_of[INGRESS_BATCH];       /* Group index of each record */
+    size_t group_series[INGRESS_BATCH];     /* Series of each group */
+    size_t group_end[INGRESS_BATCH];        /* Count, then scatter position */
+    size_t series[INGRESS_BATCH];
+    int64_t timestamps[INGRESS_BATCH];
+    double values[INGRESS_BATCH];
+    int64_t sorted_timestamps[INGRESS_BATCH];
+    double sorted_values[INGRESS_BATCH];
+};
+
+ag_ingress_t* ag_ingress_create(ag_tsdb_t* db, size_t capacity, unsigned flags) {
+    /* Validate arguments */
+    if (db == NULL || capacity == 0 || (flags & ~AG_INGRESS_SPSC) != 0) {
+        return NULL;
+    }
+
+    /* Power of two >= 2 so tickets map to cells with a mask */
+    size_t cells = 2;
+    while (cells < capacity) {
+        if (cells > SIZE_MAX / 2 / sizeof(ingress_cell_t)) {
+            return NULL;
+        }
+        cells <<= 1;
+    }
+
+    ag_ingress_t* q = (ag_ingress_t*)aligned_alloc(INGRESS_ALIGN, sizeof(ag_ingress_t));
+    if (q == NULL) {
+        return NULL;
+    }
+    q->cells = (ingress_cell_t*)aligned_alloc(INGRESS_ALIGN, cells * sizeof(ingress_cell_t));
+    if (q->cells == NULL) {
+        free(q);
+        return NULL;
+    }
+
+    /* Cell i is free for ticket i */
+    for (size_t i = 0; i < cells; i++) {
+        atomic_init(&q->cells[i].seq, (uint64_t)i);
+    }
+
+    atomic_init(&q->tail, 0);
+    q->mask = (uint64_t)(cells - 1);
+    q->spsc = (flags & AG_INGRESS_SPSC) != 0;
+    atomic_init(&q->rejected, 0);
+    q->head = 0;
+    q->db = db;
+    q->capacity = cells;
+    q->drained = 0;
+    q->batches = 0;
+    q->dropped = 0;
+    q->round = 0;
+    memset(q->stamps, 0, sizeof(q->stamps));
+    return q;
+}
+
+void ag_ingress_destroy(ag_ingress_t* q) {
+    if (q == NULL) {
+        return;
+    }
+    free(q->cells);
+    free(q);
+}
+
+int ag_ingress_push(ag_ingress_t* q, size_t series, int64_t timestamp_ms, double value) {
+    /* Validate handle */
+    if (q == NULL) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    /* Claim a ticket whose cell the drainer has freed */
+    uint64_t pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    ingress_cell_t* cell;
+    for (;;) {
+        cell = &q->cells[pos & q->mask];
+        uint64_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        int64_t diff = (int64_t)(seq - pos);
+        if (diff == 0) {
+            if (q->spsc) {
+                atomic_store_explicit(&q->tail, pos + 1, memory_order_relaxed);
+                break;
+            }
+            if (atomic_compare_exchange_weak_explicit(&q->tail, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            /* Cell still holds the record from one lap ago: full */
+            atomic_fetch_add_explicit(&q->rejected, 1, memory_order_relaxed);
+            return AG_ERR_FULL;
+        } else {
+            pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+        }
+    }
+
+    cell->series = (uint64_t)series;
+    cell->timestamp = timestamp_ms;
+    cell->value = value;
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+    return AG_OK;
+}
+
+/*
+ * Helper: Move up to 'max' published records into the scratch arrays,
+ * dropping unknown series. Sets *taken to the records freed from the
+ * queue; returns the records kept.
+ */
+static size_t ingress_pop(ag_ingress_t* q, size_t max, size_t* taken) {
+    size_t count = ag_tsdb_count(q->db);
+    size_t kept = 0;
+    size_t n = 0;
+    while (n < max) {
+        ingress_cell_t* cell = &q->cells[q->head & q->mask];
+        if (atomic_load_explicit(&cell->seq, memory_order_acquire) != q->head + 1) {
+            break;  /* Empty, or the next record is still being written */
+        }
+
+        if (cell->series < count) {
+            q->series[kept] = (size_t)cell->series;
+            q->timestamps[kept] = cell->timestamp;
+            q->values[kept] = cell->value;
+            kept++;
+        } else {
+            q->dropped++;
+        }
+        atomic_store_explicit(&cell->seq, q->head + q->capacity, memory_order_release);
+        q->head++;
+        n++;
+    }
+    *taken = n;
+    return kept;
+}
+
+/* Helper: Group index of 'series' in the current round, adding it if new */
+static size_t group_find(ag_ingress_t* q, size_t series, size_t* groups) {
+    size_t i = (size_t)(((uint64_t)series * 0x9E3779B97F4A7C15ull) >> 55) & (INGRESS_TABLE - 1);
+    while (q->stamps[i] == q->round) {
+        size_t g = q->slots[i];
+        if (q->group_series[g] == series) {
+            return g;
+        }
+        i = (i + 1) & (INGRESS_TABLE - 1);
+    }
+
+    size_t g = (*groups)++;
+    q->stamps[i] = q->round;
+    q->slots[i] = (uint16_t)g;
+    q->group_series[g] = series;
+    q->group_end[g] = 0;
+    return g;
+}
+
+/*
+ * Helper: Group a round by series, stable, into the sorted arrays. Groups
+ * are numbered in order of first appearance; a counting scatter keeps
+ * each series' records in queue order. O(n), no sort. Returns the group
+ * count; group g ends at group_end[g] and starts where g - 1 ends.
+ */
+static size_t ingress_group(ag_ingress_t* q, size_t n) {
+    /* New stamp clears the table; rewind the stamps once every 2^32 rounds */
+    if (++q->round == 0) {
+        memset(q->stamps, 0, sizeof(q->stamps));
+        q->round = 1;
+    }
+
+    size_t groups = 0;
+    for (size_t i = 0; i < n; i++) {
+        size_t g = group_find(q, q->series[i], &groups);
+        q->group_of[i] = (uint16_t)g;
+        q->group_end[g]++;
+    }
+
+    /* Counts to start positions */
+    size_t at = 0;
+    for (size_t g = 0; g < groups; g++) {
+        size_t count = q->group_end[g];
+        q->group_end[g] = at;
+        at += count;
+    }
+
+    /* Scatter; each group's position ends where the group does */
+    for (size_t i = 0; i < n; i++) {
+        size_t to = q->group_end[q->group_of[i]]++;
+        q->sorted_timestamps[to] = q->timestamps[i];
+        q->sorted_values[to] = q->values[i];
+    }
+    return groups;
+}
+
+/* Helper: Append one round, one append_batch per series run or group */
+static void ingress_append(ag_ingress_t* q, size_t n) {
+    const size_t* series = q->series;
+    size_t runs = 1;
+    for (size_t i = 1; i < n; i++) {
+        runs += series[i] != series[i - 1];
+    }
+
+    /* Interleaved series: group first so each series gets one batch */
+    if (runs > 1 && runs * INGRESS_GROUP_RUN > n) {
+        size_t groups = ingress_group(q, n);
+        size_t start = 0;
+        for (size_t g = 0; g < groups; g++) {
+            size_t end = q->group_end[g];
+            ag_timeseries_append_batch(ag_tsdb_get(q->db, q->group_series[g]),
+                                       q->sorted_timestamps + start,
+                                       q->sorted_values + start, end - start);
+            start = end;
+        }
+        q->batches += groups;
+        q->drained += n;
+        return;
+    }
+
+    const int64_t* timestamps = q->timestamps;
+    const double* values = q->values;
+    size_t start = 0;
+    for (size_t i = 1; i <= n; i++) {
+        if (i == n || series[i] != series[start]) {
+            ag_timeseries_append_batch(ag_tsdb_get(q->db, series[start]),
+                                       timestamps + start, values + start, i - start);
+            q->batches++;
+            start = i;
+        }
+    }
+    q->drained += n;
+}
+
+int ag_ingress_drain(ag_ingress_t* q, size_t max_records, size_t* out_records) {
+    /* Validate handle */
+    if (q == NULL) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    size_t limit = (max_records == 0 || max_records > q->capacity) ? q->capacity
+                                                                   : max_records;
+    size_t total = 0;
+    while (total < limit) {
+        size_t want = (limit - total < INGRESS_BATCH) ? limit - total : INGRESS_BATCH;
+        size_t taken;
+        size_t kept = ingress_pop(q, want, &taken);
+        if (kept > 0) {
+            ingress_append(q, kept);
+        }
+        total += taken;
+        if (taken < want) {
+            break;
+        }
+    }
+
+    if (out_records != NULL) {
+        *out_records = total;
+    }
+    return AG_OK;
+}
+
+int ag_ingress_stats(const ag_ingress_t* q, ag_ingress_stats_t* out) {
+    /* Validate arguments */
+    if (q == NULL || out == NULL) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    out->drained = q->drained;
+    out->batches = q->batches;
+    out->dropped = q->dropped;
+    out->rejected = atomic_load_explicit(&q->rejected, memory_order_relaxed);
+
+    /* Claimed tickets not yet drained (a claim may be mid-write) */
+    uint64_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    out->depth = (tail > q->head) ? (size_t)(tail - q->head) : 0;
+    return AG_OK;
+}
+
+size_t ag_ingress_capacity(const ag_ingress_t* q) {
+    return q == NULL ? 0 : q->capacity;
+}
@@ -0,0 +1,499 @@
+/*
+ * ag_kernels.c - Vectorized Reduction Kernels
+ *
+ * Implementation Strategy:
+ *   - Scalar kernels compiled for every target (fallback and reference)
+ *   - AVX2 kernels built with per-function target attributes, so the
+ *     library itself needs no -mavx2 and still runs on older CPUs
+ *   - NEON kernels on aarch64, where Advanced SIMD is always available
+ *   - One-time runtime dispatch through a kernel table
+ *
+ * Copyright (c) 2025 AlgorithmicGrid
+ */
+
+#include "ag_kernels.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define AG_HAVE_AVX2 1
+#include <immintrin.h>
+#define AG_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#if defined(__aarch64__)
+#define AG_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+/* Helper: Timestamp inside inclusive range */
+static inline int in_range(int64_t t, int64_t lo, int64_t hi) {
+    return t >= lo && t <= hi;
+}
+
+/* ========================================================================
+ * Scalar kernels
+ * ======================================================================== */
+
+static double scalar_sum(const double* values, size_t n) {
+    double sum = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        sum += values[i];
+    }
+    return sum;
+}
+
+static double scalar_min(const double* values, size_t n) {
+    double min = INFINITY;
+    for (size_t i = 0; i < n; i++) {
+        min = (values[i] < min) ? values[i] : min;
+    }
+    return min;
+}
+
+static double scalar_max(const double* values, size_t n) {
+    double max = -INFINITY;
+    for (size_t i = 0; i < n; i++) {
+        max = (values[i] > max) ? values[i] : max;
+    }
+    return max;
+}
+
+static double scalar_sum_in(const int64_t* timestamps, const double* values, size_t n,
+                            int64_t lo, int64_t hi, size_t* count) {
+    double sum = 0.0;
+    size_t matched = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (in_range(timestamps[i], lo, hi)) {
+            sum += values[i];
+            matched++;
+        }
+    }
+    *count += matched;
+    return sum;
+}
+
+static double scalar_min_in(const int64_t* timestamps, const double* values, size_t n,
+                            int64_t lo, int64_t hi, size_t* count) {
+    double min = INFINITY;
+    size_t matched = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (in_range(timestamps[i], lo, hi)) {
+            min = (values[i] < min) ? values[i] : min;
+            matched++;
+        }
+    }
+    *count += matched;
+    return min;
+}
+
+static double scalar_max_in(const int64_t* timestamps, const double* values, size_t n,
+                            int64_t lo, int64_t hi, size_t* count) {
+    double max = -INFINITY;
+    size_t matched = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (in_range(timestamps[i], lo, hi)) {
+            max = (values[i] > max) ? values[i] : max;
+            matched++;
+        }
+    }
+    *count += matched;
+    return max;
+}
+
+static const ag_kernels_t scalar_kernels = {
+    "scalar",
+    scalar_sum, scalar_min, scalar_max,
+    scalar_sum_in, scalar_min_in, scalar_max_in
+};
+
+/* ========================================================================
+ * AVX2 kernels (x86-64)
+ * ======================================================================== */
+
+#ifdef AG_HAVE_AVX2
+
+/* Helper: Horizontal reductions of 4 lanes */
+AG_TARGET_AVX2 static inline double avx2_hsum(__m256d v) {
+    double lanes[4];
+    _mm256_storeu_pd(lanes, v);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+AG_TARGET_AVX2 static inline double avx2_hmin(__m256d v) {
+    double lanes[4];
+    _mm256_storeu_pd(lanes, v);
+    double a = (lanes[0] < lanes[1]) ? lanes[0] : lanes[1];
+    double b = (lanes[2] < lanes[3]) ? lanes[2] : lanes[3];
+    return (a < b) ? a : b;
+}
+
+AG_TARGET_AVX2 static inline double avx2_hmax(__m256d v) {
+    double lanes[4];
+    _mm256_storeu_pd(lanes, v);
+    double a = (lanes[0] > lanes[1]) ? lanes[0] : lanes[1];
+    double b = (lanes[2] > lanes[3]) ? lanes[2] : lanes[3];
+    return (a > b) ? a : b;
+}
+
+AG_TARGET_AVX2 static inline size_t avx2_hcount(__m256i v) {
+    int64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, v);
+    return (size_t)(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+}
+
+/* Helper: All-ones lanes where timestamp is outside [lo, hi] */
+AG_TARGET_AVX2 static inline __m256i avx2_outside(const int64_t* timestamps,
+                                                  __m256i lo, __m256i hi) {
+    __m256i t = _mm256_loadu_si256((const __m256i*)timestamps);
+    return _mm256_or_si256(_mm256_cmpgt_epi64(lo, t), _mm256_cmpgt_epi64(t, hi));
+}
+
+AG_TARGET_AVX2 static double avx2_sum(const double* values, size_t n) {
+    /* Four accumulators hide add latency */
+    __m256d a0 = _mm256_setzero_pd();
+    __m256d a1 = _mm256_setzero_pd();
+    __m256d a2 = _mm256_setzero_pd();
+    __m256d a3 = _mm256_setzero_pd();
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        a0 = _mm256_add_pd(a0, _mm256_loadu_pd(values + i));
+        a1 = _mm256_add_pd(a1, _mm256_loadu_pd(values + i + 4));
+        a2 = _mm256_add_pd(a2, _mm256_loadu_pd(values + i + 8));
+        a3 = _mm256_add_pd(a3, _mm256_loadu_pd(values + i + 12));
+    }
+    for (; i + 4 <= n; i += 4) {
+        a0 = _mm256_add_pd(a0, _mm256_loadu_pd(values + i));
+    }
+
+    double sum = avx2_hsum(_mm256_add_pd(_mm256_add_pd(a0, a1), _mm256_add_pd(a2, a3)));
+    for (; i < n; i++) {
+        sum += values[i];
+    }
+    return sum;
+}
+
+AG_TARGET_AVX2 static double avx2_min(const double* values, size_t n) {
+    /* min_pd(x, acc) returns acc when x is NaN, so NaN is ignored */
+    __m256d a0 = _mm256_set1_pd(INFINITY);
+    __m256d a1 = a0;
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        a0 = _mm256_min_pd(_mm256_loadu_pd(values + i), a0);
+        a1 = _mm256_min_pd(_mm256_loadu_pd(values + i + 4), a1);
+    }
+    for (; i + 4 <= n; i += 4) {
+        a0 = _mm256_min_pd(_mm256_loadu_pd(values + i), a0);
+    }
+
+    double min = avx2_hmin(_mm256_min_pd(a0, a1));
+    for (; i < n; i++) {
+        min = (values[i] < min) ? values[i] : min;
+    }
+    return min;
+}
+
+AG_TARGET_AVX2 static double avx2_max(const double* values, size_t n) {
+    __m256d a0 = _mm256_set1_pd(-INFINITY);
+    __m256d a1 = a0;
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        a0 = _mm256_max_pd(_mm256_loadu_pd(values + i), a0);
+        a1 = _mm256_max_pd(_mm256_loadu_pd(values + i + 4), a1);
+    }
+    for (; i + 4 <= n; i += 4) {
+        a0 = _mm256_max_pd(_mm256_loadu_pd(values + i), a0);
+    }
+
+    double max = avx2_hmax(_mm256_max_pd(a0, a1));
+    for (; i < n; i++) {
+        max = (values[i] > max) ? values[i] : max;
+    }
+    return max;
+}
+
+AG_TARGET_AVX2 static double avx2_sum_in(const int64_t* timestamps, const double* values,
+                                         size_t n, int64_t lo, int64_t hi, size_t* count) {
+    __m256i lo_v = _mm256_set1_epi64x(lo);
+    __m256i hi_v = _mm256_set1_epi64x(hi);
+    __m256d acc = _mm256_setzero_pd();
+    __m256i excluded = _mm256_setzero_si256();
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m256i out = avx2_outside(timestamps + i, lo_v, hi_v);
+        __m256d x = _mm256_loadu_pd(values + i);
+        acc = _mm256_add_pd(acc, _mm256_andnot_pd(_mm256_castsi256_pd(out), x));
+        excluded = _mm256_sub_epi64(excluded, out);  /* out lanes are -1 */
+    }
+
+    size_t matched = i - avx2_hcount(excluded);
+    double sum = avx2_hsum(acc);
+    for (; i < n; i++) {
+        if (in_range(timestamps[i], lo, hi)) {
+            sum += values[i];
+            matched++;
+        }
+    }
+    *count += matched;
+    return sum;
+}
+
+AG_TARGET_AVX2 static double avx2_min_in(const int64_t* timestamps, const double* values,
+                                         size_t n, int64_t lo, int64_t hi, size_t* count) {
+    __m256i lo_v = _mm256_set1_epi64x(lo);
+    __m256i hi_v = _mm256_set1_epi64x(hi);
+    __m256d inf = _mm256_set1_pd(INFINITY);
+    __m256d acc = inf;
+    __m256i excluded = _mm256_setzero_si256();
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m256i out = avx2_outside(timestamps + i, lo_v, hi_v);
+        __m256d x = _mm256_blendv_pd(_mm256_loadu_pd(values + i), inf,
+                                     _mm256_castsi256_pd(out));
+        acc = _mm256_min_pd(x, acc);
+        excluded = _mm256_sub_epi64(excluded, out);
+    }
+
+    size_t matched = i - avx2_hcount(excluded);
+    double min = avx2_hmin(acc);
+    for (; i < n; i++) {
+        if (in_range(timestamps[i], lo, hi)) {
+            min = (values[i] < min) ? values[i] : min;
+            matched++;
+        }
+    }
+    *count += matched;
+    return min;
+}
+
+AG_TARGET_AVX2 static double avx2_max_in(const int64_t* timestamps, const double* values,
+                                         size_t n, int64_t lo, int64_t hi, size_t* count) {
+    __m256i lo_v = _mm256_set1_epi64x(lo);
+    __m256i hi_v = _mm256_set1_epi64x(hi);
+    __m256d ninf = _mm256_set1_pd(-INFINITY);
+    __m256d acc = ninf;
+    __m256i excluded = _mm256_setzero_si256();
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m256i out = avx2_outside(timestamps + i, lo_v, hi_v);
+        __m256d x = _mm256_blendv_pd(_mm256_loadu_pd(values + i), ninf,
+                                     _mm256_castsi256_pd(out));
+        acc = _mm256_max_pd(x, acc);
+        excluded = _mm256_sub_epi64(excluded, out);
+    }
+
+    size_t matched = i - avx2_hcount(excluded);
+    double max = avx2_hmax(acc);
+    for (; i < n; i++) {
+        if (in_range(timestamps[i], lo, hi)) {
+            max = (values[i] > max) ? values[i] : max;
+            matched++;
+        }
+    }
+    *count += matched;
+    return max;
+}
+
+static const ag_kernels_t avx2_kernels = {
+    "avx2",
+    avx2_sum, avx2_min, avx2_max,
+    avx2_sum_in, avx2_min_in, avx2_max_in
+};
+
+#endif /* AG_HAVE_AVX2 */
+
+/* ========================================================================
+ * NEON kernels (aarch64)
+ * ======================================================================== */
+
+#ifdef AG_HAVE_NEON
+
+/* Helper: All-ones lanes where timestamp is inside [lo, hi] */
+static inline uint64x2_t neon_inside(const int64_t* timestamps, int64x2_t lo, int64x2_t hi) {
+    int64x2_t t = vld1q_s64(timestamps);
+    return vandq_u64(vcgeq_s64(t, lo), vcleq_s64(t, hi));
+}
+
+static double neon_sum(const double* values, size_t n) {
+    float64x2_t a0 = vdupq_n_f64(0.0);
+    float64x2_t a1 = vdupq_n_f64(0.0);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        a0 = vaddq_f64(a0, vld1q_f64(values + i));
+        a1 = vaddq_f64(a1, vld1q_f64(values + i + 2));
+    }
+
+    double sum = vaddvq_f64(vaddq_f64(a0, a1));
+    for (; i < n; i++) {
+        sum += values[i];
+    }
+    return sum;
+}
+
+static double neon_min(const double* values, size_t n) {
+    /* minnm returns the non-NaN operand, so NaN is ignored */
+    float64x2_t acc = vdupq_n_f64(INFINITY);
+    size_t i = 0;
+
+    for (; i + 2 <= n; i += 2) {
+        acc = vminnmq_f64(acc, vld1q_f64(values + i));
+    }
+
+    double min = vminnmvq_f64(acc);
+    for (; i < n; i++) {
+        min = (values[i] < min) ? values[i] : min;
+    }
+    return min;
+}
+
+static double neon_max(const double* values, size_t n) {
+    float64x2_t acc = vdupq_n_f64(-INFINITY);
+    size_t i = 0;
+
+    for (; i + 2 <= n; i += 2) {
+        acc = vmaxnmq_f64(acc, vld1q_f64(values + i));
+    }
+
+    double max = vmaxnmvq_f64(acc);
+    for (; i < n; i++) {
+        max = (values[i] > max) ? values[i] : max;
+    }
+    return max;
+}
+
+static double neon_sum_in(const int64_t* timestamps, const double* values, size_t n,
+                          int64_t lo, int64_t hi, size_t* count) {
+    int64x2_t lo_v = vdupq_n_s64(lo);
+    int64x2_t hi_v = vdupq_n_s64(hi);
+    float64x2_t zero = vdupq_n_f64(0.0);
+    float64x2_t acc = zero;
+    int64x2_t matched_v = vdupq_n_s64(0);
+    size_t i = 0;
+
+    for (; i + 2 <= n; i += 2) {
+        uint64x2_t in = neon_inside(timestamps + i, lo_v, hi_v);
+        acc = vaddq_f64(acc, vbslq_f64(in, vld1q_f64(values + i), zero));
+        matched_v = vsubq_s64(matched_v, vreinterpretq_s64_u64(in));  /* in lanes are -1 */
+    }
+
+    size_t matched = (size_t)vaddvq_s64(matched_v);
+    double sum = vaddvq_f64(acc);
+    for (; i < n; i++) {
+        if (in_range(timestamps[i], lo, hi)) {
+            sum += values[i];
+            matched++;
+        }
+    }
+    *count += matched;
+    return sum;
+}
+
+static double neon_min_in(const int64_t* timestamps, const double* values, size_t n,
+                          int64_t lo, int64_t hi, size_t* count) {
+    int64x2_t lo_v = vdupq_n_s64(lo);
+    int64x2_t hi_v = vdupq_n_s64(hi);
+    float64x2_t inf = vdupq_n_f64(INFINITY);
+    float64x2_t acc = inf;
+    int64x2_t matched_v = vdupq_n_s64(0);
+    size_t i = 0;
+
+    for (; i + 2 <= n; i += 2) {
+        uint64x2_t in = neon_inside(timestamps + i, lo_v, hi_v);
+        acc = vminnmq_f64(acc, vbslq_f64(in, vld1q_f64(values + i), inf));
+        matched_v = vsubq_s64(matched_v, vreinterpretq_s64_u64(in));
+    }
+
+    size_t matched = (size_t)vaddvq_s64(matched_v);
+    double min = vminnmvq_f64(acc);
+    for (; i < n; i++) {
+        if (in_range(timestamps[i], lo, hi)) {
+            min = (values[i] < min) ? values[i] : min;
+            matched++;
+        }
+    }
+    *count += matched;
+    return min;
+}
+
+static double neon_max_in(const int64_t* timestamps, const double* values, size_t n,
+                          int64_t lo, int64_t hi, size_t* count) {
+    int64x2_t lo_v = vdupq_n_s64(lo);
+    int64x2_t hi_v = vdupq_n_s64(hi);
+    float64x2_t ninf = vdupq_n_f64(-INFINITY);
+    float64x2_t acc = ninf;
+    int64x2_t matched_v = vdupq_n_s64(0);
+    size_t i = 0;
+
+    for (; i + 2 <= n; i += 2) {
+        uint64x2_t in = neon_inside(timestamps + i, lo_v, hi_v);
+        acc = vmaxnmq_f64(acc, vbslq_f64(in, vld1q_f64(values + i), ninf));
+        matched_v = vsubq_s64(matched_v, vreinterpretq_s64_u64(in));
+    }
+
+    size_t matched = (size_t)vaddvq_s64(matched_v);
+    double max = vmaxnmvq_f64(acc);
+    for (; i < n; i++) {
+        if (in_range(timestamps[i], lo, hi)) {
+            max = (values[i] > max) ? values[i] : max;
+            matched++;
+        }
+    }
+    *count += matched;
+    return max;
+}
+
+static const ag_kernels_t neon_kernels = {
+    "neon",
+    neon_sum, neon_min, neon_max,
+    neon_sum_in, neon_min_in, neon_max_in
+};
+
+#endif /* AG_HAVE_NEON */
+
+/* ========================================================================
+ * Dispatch
+ * ======================================================================== */
+
+/* Helper: Pick kernels for the running CPU */
+static const ag_kernels_t* resolve_kernels(void) {
+    const char* forced = getenv("AG_CORE_SIMD");
+    if (forced != NULL && strcmp(forced, "scalar") == 0) {
+        return &scalar_kernels;
+    }
+
+#if defined(AG_HAVE_AVX2)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return &avx2_kernels;
+    }
+#elif defined(AG_HAVE_NEON)
+    return &neon_kernels;
+#endif
+
+    return &scalar_kernels;
+}
+
+const ag_kernels_t* ag_kernels_scalar(void) {
+    return &scalar_kernels;
+}
+
+const ag_kernels_t* ag_kernels_get(void) {
+    /* Benign race: concurrent first calls resolve to the same table */
+    static _Atomic(const ag_kernels_t*) resolved = NULL;
+
+    const ag_kernels_t* k = atomic_load_explicit(&resolved, memory_order_acquire);
+    if (k == NULL) {
+        k = resolve_kernels();
+        atomic_store_explicit(&resolved, k, memory_order_release);
+    }
+    return k;
+}
@@ -0,0 +1,54 @@
+/*
+ * ag_kernels.h - Internal vectorized reduction kernels
+ *
+ * Purpose: Sum/min/max reductions over contiguous ring segments, with
+ *          AVX2 (x86-64) and NEON (aarch64) variants selected at runtime.
+ *
+ * Not part of the public API - used by ag_timeseries.c.
+ *
+ * Copyright (c) 2025 AlgorithmicGrid
+ */
+
+#ifndef AG_KERNELS_H
+#define AG_KERNELS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Kernel table.
+ *
+ * Plain kernels reduce all n values. Range kernels ("_in") only include
+ * values whose timestamp lies in [lo, hi] and add the number of matches
+ * to *count.
+ *
+ * Identities: sum 0.0, min +INFINITY, max -INFINITY (returned for n == 0).
+ * NaN values propagate through sum and are ignored by min/max.
+ * Sums may be reassociated, so results can differ from a sequential sum
+ * in the last bits.
+ */
+typedef struct {
+    const char* name;   /* "scalar", "avx2" or "neon" */
+
+    double (*sum)(const double* values, size_t n);
+    double (*min)(const double* values, size_t n);
+    double (*max)(const double* values, size_t n);
+
+    double (*sum_in)(const int64_t* timestamps, const double* values, size_t n,
+                     int64_t lo, int64_t hi, size_t* count);
+    double (*min_in)(const int64_t* timestamps, const double* values, size_t n,
+                     int64_t lo, int64_t hi, size_t* count);
+    double (*max_in)(const int64_t* timestamps, const double* values, size_t n,
+                     int64_t lo, int64_t hi, size_t* count);
+} ag_kernels_t;
+
+/* Portable scalar kernels */
+const ag_kernels_t* ag_kernels_scalar(void);
+
+/*
+ * Best kernels for the running CPU, resolved once on first use.
+ * Setting environment variable AG_CORE_SIMD=scalar forces the fallback.
+ */
+const ag_kernels_t* ag_kernels_get(void);
+
+#endif /* AG_KERNELS_H */
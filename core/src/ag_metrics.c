@@ -0,0 +1,267 @@
+/*
+ * ag_metrics.c - Opt-In Instrumentation
+ *
+ * Implementation Strategy:
+ *   - Compiled in with -DAG_METRICS only; otherwise the hooks in
+ *     ag_timeseries_internal.h expand to nothing and this file only keeps
+ *     the public entry points (get_metrics reports AG_ERR_UNSUPPORTED)
+ *   - Per-series counters live in the handle, process-wide totals in one
+ *     static set; both are relaxed atomics that readers may bump
+ *     concurrently (no locks, no ordering with the ring protocol)
+ *   - Append counts stay writer-local and reach the totals in
+ *     METRICS_FOLD chunks, so appends pay no shared atomic add; query
+ *     counts reach them from a per-thread pending set every
+ *     METRICS_FOLD_QUERIES queries, at thread exit and when the thread
+ *     reads the totals
+ *   - Latency histogram: log-linear buckets, four per power of two, so
+ *     recording is a bit scan and two shifts
+ *
+ * Copyright (c) 2025 AlgorithmicGrid
+ */
+
+#define _POSIX_C_SOURCE 200809L     /* clock_gettime */
+
+#include "ag_timeseries_internal.h"
+#include <string.h>
+#include <time.h>
+
+/* Helper: Lower bound of histogram bucket b (b <= AG_METRICS_BUCKETS) */
+static uint64_t bucket_floor_ns(size_t b) {
+    if (b < 4) {
+        return (uint64_t)b;
+    }
+    size_t exp = b / 4 + 1;
+    return (uint64_t)(4 + b % 4) << (exp - 2);
+}
+
+uint64_t ag_timeseries_histogram_bucket_ns(size_t bucket) {
+    if (bucket > AG_METRICS_BUCKETS) {
+        return UINT64_MAX;
+    }
+    return bucket_floor_ns(bucket);
+}
+
+uint64_t ag_timeseries_histogram_quantile(const ag_timeseries_histogram_t* hist, double q) {
+    if (hist == NULL || hist->count == 0 || !(q >= 0.0 && q <= 1.0)) {
+        return 0;
+    }
+
+    /* Rank of the q-th sample, 1-based */
+    uint64_t rank = (uint64_t)(q * (double)hist->count);
+    if ((double)rank < q * (double)hist->count || rank == 0) {
+        rank++;
+    }
+
+    uint64_t seen = 0;
+    for (size_t b = 0; b < AG_METRICS_BUCKETS; b++) {
+        seen += hist->buckets[b];
+        if (seen >= rank) {
+            uint64_t upper = bucket_floor_ns(b + 1);
+            return (upper < hist->max_ns) ? upper : hist->max_ns;
+        }
+    }
+    return hist->max_ns;
+}
+
+#ifdef AG_METRICS
+
+#include <pthread.h>
+
+/* Queries a thread accumulates before folding them into the global totals */
+#define METRICS_FOLD_QUERIES 64
+
+/* Process-wide totals over every series */
+static metrics_state_t global_metrics;
+
+/*
+ * Per-thread share of the global query counters not yet folded in. Plain
+ * fields: only the owning thread touches them.
+ */
+typedef struct {
+    uint64_t queries;
+    uint64_t points_scanned;
+    uint64_t points_returned;
+    uint64_t retries;
+    uint64_t sum_ns;
+    uint64_t max_ns;
+    uint64_t buckets[AG_METRICS_BUCKETS];
+    int registered;                 /* Thread-exit fold armed */
+} metrics_pending_t;
+
+static _Thread_local metrics_pending_t pending;
+static pthread_key_t pending_key;
+static pthread_once_t pending_once = PTHREAD_ONCE_INIT;
+
+/* Helper: Histogram bucket for a latency in ns */
+static size_t bucket_of(uint64_t ns) {
+    if (ns < 4) {
+        return (size_t)ns;
+    }
+#if defined(__GNUC__) || defined(__clang__)
+    size_t exp = 63 - (size_t)__builtin_clzll(ns);
+#else
+    size_t exp = 0;
+    while ((ns >> exp) > 1) {
+        exp++;
+    }
+#endif
+    size_t b = (exp - 1) * 4 + (size_t)((ns >> (exp - 2)) & 3);
+    return (b < AG_METRICS_BUCKETS) ? b : AG_METRICS_BUCKETS - 1;
+}
+
+/* Helper: Relaxed add */
+static inline void bump(_Atomic uint64_t* counter, uint64_t n) {
+    atomic_fetch_add_explicit(counter, n, memory_order_relaxed);
+}
+
+/* Helper: Raise a running maximum */
+static inline void raise_max(_Atomic uint64_t* max, uint64_t v) {
+    uint64_t cur = atomic_load_explicit(max, memory_order_relaxed);
+    while (v > cur &&
+           !atomic_compare_exchange_weak_explicit(max, &cur, v, memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+    }
+}
+
+/* Helper: Move this thread's pending query counters into the totals */
+static void fold_pending(metrics_pending_t* p) {
+    if (p->queries == 0 && p->retries == 0) {
+        return;
+    }
+
+    bump(&global_metrics.queries, p->queries);
+    bump(&global_metrics.points_scanned, p->points_scanned);
+    bump(&global_metrics.points_returned, p->points_returned);
+    bump(&global_metrics.retries, p->retries);
+    bump(&global_metrics.query_latency.sum_ns, p->sum_ns);
+    raise_max(&global_metrics.query_latency.max_ns, p->max_ns);
+    for (size_t b = 0; b < AG_METRICS_BUCKETS; b++) {
+        if (p->buckets[b] != 0) {
+            bump(&global_metrics.query_latency.buckets[b], p->buckets[b]);
+        }
+    }
+
+    int registered = p->registered;
+    memset(p, 0, sizeof(*p));
+    p->registered = registered;
+}
+
+/* Helper: Thread-exit destructor (the key value is the thread's 'pending') */
+static void fold_at_exit(void* p) {
+    fold_pending((metrics_pending_t*)p);
+}
+
+/* Helper: Create the thread-exit key once per process */
+static void pending_key_init(void) {
+    pthread_key_create(&pending_key, fold_at_exit);
+}
+
+/* Helper: This thread's pending counters, thread-exit fold armed */
+static metrics_pending_t* pending_get(void) {
+    if (!pending.registered) {
+        pthread_once(&pending_once, pending_key_init);
+        pthread_setspecific(pending_key, &pending);
+        pending.registered = 1;
+    }
+    return &pending;
+}
+
+/* Helper: Copy a live counter set into the public layout */
+static void snapshot(const metrics_state_t* m, ag_timeseries_metrics_t* out) {
+    metrics_state_t* src = (metrics_state_t*)m;
+
+    out->appends = atomic_load_explicit(&src->appends, memory_order_relaxed);
+    out->overwrites = atomic_load_explicit(&src->overwrites, memory_order_relaxed);
+    out->queries = atomic_load_explicit(&src->queries, memory_order_relaxed);
+    out->points_scanned = atomic_load_explicit(&src->points_scanned, memory_order_relaxed);
+    out->points_returned = atomic_load_explicit(&src->points_returned, memory_order_relaxed);
+    out->retries = atomic_load_explicit(&src->retries, memory_order_relaxed);
+
+    metrics_hist_t* h = &src->query_latency;
+    out->query_latency.count = out->queries;
+    out->query_latency.sum_ns = atomic_load_explicit(&h->sum_ns, memory_order_relaxed);
+    out->query_latency.max_ns = atomic_load_explicit(&h->max_ns, memory_order_relaxed);
+    for (size_t b = 0; b < AG_METRICS_BUCKETS; b++) {
+        out->query_latency.buckets[b] = atomic_load_explicit(&h->buckets[b],
+                                                             memory_order_relaxed);
+    }
+}
+
+uint64_t ag_metrics_now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000u + (uint64_t)t.tv_nsec;
+}
+
+void ag_metrics_fold(ag_timeseries_t* ts) {
+    metrics_state_t* m = &ts->metrics;
+    uint64_t appends = atomic_load_explicit(&m->appends, memory_order_relaxed);
+    uint64_t overwrites = atomic_load_explicit(&m->overwrites, memory_order_relaxed);
+
+    bump(&global_metrics.appends, appends - m->folded_appends);
+    bump(&global_metrics.overwrites, overwrites - m->folded_overwrites);
+    m->folded_appends = appends;
+    m->folded_overwrites = overwrites;
+}
+
+void ag_metrics_query(const ag_timeseries_t* ts, uint64_t start_ns,
+                      uint64_t scanned, uint64_t returned) {
+    metrics_state_t* m = (metrics_state_t*)&ts->metrics;
+    uint64_t ns = ag_metrics_now() - start_ns;
+    size_t b = bucket_of(ns);
+
+    /* Series: shared with every reader thread */
+    bump(&m->queries, 1);
+    bump(&m->points_scanned, scanned);
+    bump(&m->points_returned, returned);
+    bump(&m->query_latency.sum_ns, ns);
+    bump(&m->query_latency.buckets[b], 1);
+    raise_max(&m->query_latency.max_ns, ns);
+
+    /* Totals: this thread's share, folded in chunks */
+    metrics_pending_t* p = pending_get();
+    p->queries++;
+    p->points_scanned += scanned;
+    p->points_returned += returned;
+    p->sum_ns += ns;
+    p->max_ns = (ns > p->max_ns) ? ns : p->max_ns;
+    p->buckets[b]++;
+    if (p->queries >= METRICS_FOLD_QUERIES) {
+        fold_pending(p);
+    }
+}
+
+void ag_metrics_retry(const ag_timeseries_t* ts) {
+    metrics_state_t* m = (metrics_state_t*)&ts->metrics;
+    bump(&m->retries, 1);
+    pending_get()->retries++;
+}
+
+int ag_timeseries_get_metrics(const ag_timeseries_t* ts, ag_timeseries_metrics_t* out_metrics) {
+    if (out_metrics == NULL) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    if (ts != NULL) {
+        snapshot(&ts->metrics, out_metrics);
+    } else {
+        /* The caller's own queries are always included */
+        fold_pending(&pending);
+        snapshot(&global_metrics, out_metrics);
+    }
+    return AG_OK;
+}
+
+#else /* !AG_METRICS */
+
+int ag_timeseries_get_metrics(const ag_timeseries_t* ts, ag_timeseries_metrics_t* out_metrics) {
+    (void)ts;
+    if (out_metrics == NULL) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    memset(out_metrics, 0, sizeof(*out_metrics));
+    return AG_ERR_UNSUPPORTED;
+}
+
+#endif /* AG_METRICS */
@@ -0,0 +1,320 @@
+/*
+ * ag_mseries.c - Multi-Column Series Implementation
+ *
+ * Implementation Strategy:
+ *   - One mapping: [timestamps][column 0]...[column K-1], each array
+ *     64-byte aligned and contiguous, so column spans are plain arrays
+ *   - An embedded writer handle owns head and counters; K read-only
+ *     column handles point their counters at it, so every ag_timeseries.h
+ *     read path (and its SPMC snapshot protocol) works per column
+ *   - append_row runs the claim/write/publish protocol once per row
+ *   - Multi-column queries search the timestamp column once and copy
+ *     each requested column with the same spans
+ *
+ * Copyright (c) 2025 AlgorithmicGrid
+ */
+
+#define _DEFAULT_SOURCE     /* munmap */
+
+#include "ag_mseries.h"
+#include "ag_timeseries_internal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define MSERIES_ALIGN   64u     /* Cache line */
+
+/*
+ * Internal structure - opaque to users
+ *
+ * 'ring' is the writer's view (timestamps + column 0) and the only handle
+ * whose counters are live; cols[c].ctl points at ring.local.
+ */
+struct ag_mseries_t {
+    ag_timeseries_t ring;       /* Writer state and shared counters */
+    ag_timeseries_t* cols;      /* Read-only handle per column */
+    size_t columns;             /* Number of value columns (K) */
+    size_t column_stride;       /* Doubles between the starts of two columns */
+    unsigned char* block;       /* Mapping base */
+    size_t block_size;          /* Mapping length */
+};
+
+/* Helper: Round up to multiple of 'align' (power of two), 0 on overflow */
+static size_t align_up(size_t n, size_t align) {
+    if (n > SIZE_MAX - (align - 1)) {
+        return 0;
+    }
+    return (n + align - 1) & ~(align - 1);
+}
+
+/* Helper: Check a column selection against the series */
+static int columns_valid(const ag_mseries_t* ms, const size_t* columns, size_t ncols,
+                         double* const* out_columns) {
+    if (columns == NULL || out_columns == NULL || ncols == 0) {
+        return 0;
+    }
+    for (size_t j = 0; j < ncols; j++) {
+        if (columns[j] >= ms->columns || out_columns[j] == NULL) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+ag_mseries_t* ag_mseries_create(size_t capacity, size_t columns, unsigned flags) {
+    /* Validate arguments */
+    if (capacity == 0 || capacity > SIZE_MAX / sizeof(int64_t) || columns == 0) {
+        return NULL;
+    }
+    if (flags & ~AG_MSERIES_SPMC) {
+        return NULL;
+    }
+
+    /* Compute layout, rejecting size_t overflow */
+    size_t array = align_up(capacity * sizeof(int64_t), MSERIES_ALIGN);
+    if (array == 0 || columns > SIZE_MAX / array - 1 ||
+        columns > SIZE_MAX / sizeof(ag_timeseries_t)) {
+        return NULL;
+    }
+    size_t block_size = (columns + 1) * array;
+
+    ag_mseries_t* ms = (ag_mseries_t*)malloc(sizeof(ag_mseries_t));
+    if (ms == NULL) {
+        return NULL;
+    }
+    ms->cols = (ag_timeseries_t*)calloc(columns, sizeof(ag_timeseries_t));
+    ms->block = (unsigned char*)ag_map_pages(&block_size, 0);
+
+    if (ms->cols == NULL || ms->block == NULL) {
+        /* Cleanup on partial allocation failure */
+        if (ms->block != NULL) {
+            munmap(ms->block, block_size);
+        }
+        free(ms->cols);
+        free(ms);
+        return NULL;
+    }
+
+    int spmc = (flags & AG_MSERIES_SPMC) != 0;
+    int64_t* timestamps = (int64_t*)ms->block;
+    ms->columns = columns;
+    ms->column_stride = array / sizeof(double);
+    ms->block_size = block_size;
+
+    /* Writer handle over column 0; never freed on its own */
+    ag_timeseries_init(&ms->ring, capacity, spmc, timestamps,
+                       (double*)(ms->block + array));
+    ms->ring.external = 1;
+
+    for (size_t c = 0; c < columns; c++) {
+        ag_timeseries_t* col = &ms->cols[c];
+        ag_timeseries_init(col, capacity, spmc, timestamps,
+                           (double*)(ms->block + (c + 1) * array));
+        col->ctl = &ms->ring.local;
+        col->external = 1;
+        col->readonly = 1;
+    }
+
+    return ms;
+}
+
+void ag_mseries_destroy(ag_mseries_t* ms) {
+    if (ms == NULL) {
+        return;
+    }
+
+    METRICS_RELEASE(&ms->cols[0]);
+    munmap(ms->block, ms->block_size);
+    free(ms->cols);
+    free(ms);
+}
+
+int ag_mseries_append_row(ag_mseries_t* ms, int64_t timestamp_ms, const double* row) {
+    /* Validate inputs */
+    if (ms == NULL || row == NULL) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    /* Same claim/write/publish protocol as ag_timeseries_append, once per row */
+    ag_timeseries_t* ts = &ms->ring;
+    uint64_t seq = seq_load(&ts->ctl->appended, memory_order_relaxed);
+
+    /* Track ordering against the newest stored row */
+    if (seq > 0) {
+        size_t newest = (ts->head == 0) ? ts->capacity - 1 : ts->head - 1;
+        if (timestamp_ms < ts->timestamps[newest]) {
+            atomic_store_explicit(&ts->ctl->ordered_from, seq, memory_order_relaxed);
+        }
+    }
+
+    /* SPMC: announce the slot before overwriting it */
+    if (ts->spmc) {
+        atomic_store_explicit(&ts->ctl->claimed, seq + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+    }
+
+    /* Write the row across the columns */
+    ts->timestamps[ts->head] = timestamp_ms;
+    double* cell = ts->values + ts->head;
+    for (size_t c = 0; c < ms->columns; c++) {
+        cell[c * ms->column_stride] = row[c];
+    }
+    ts->head = advance_index(ts->head, ts->capacity);
+
+    /* Publish */
+    atomic_store_explicit(&ts->ctl->appended, seq + 1,
+                          ts->spmc ? memory_order_release : memory_order_relaxed);
+    METRICS_APPEND(&ms->cols[0], 1, seq >= ts->capacity);
+    return AG_OK;
+}
+
+const ag_timeseries_t* ag_mseries_column(const ag_mseries_t* ms, size_t column) {
+    if (ms == NULL || column >= ms->columns) {
+        return NULL;
+    }
+    return &ms->cols[column];
+}
+
+size_t ag_mseries_query_last(
+    const ag_mseries_t* ms,
+    const size_t* columns,
+    size_t ncols,
+    size_t max_points,
+    int64_t* out_timestamps,
+    double* const* out_columns
+) {
+    /* Validate inputs */
+    if (ms == NULL || out_timestamps == NULL ||
+        !columns_valid(ms, columns, ncols, out_columns)) {
+        return 0;
+    }
+
+    if (max_points == 0) {
+        return 0;
+    }
+
+    METRICS_QUERY_START(metrics_start);
+    const ag_timeseries_t* ts = &ms->ring;
+    uint64_t guard = 0;
+    for (;;) {
+        ring_window_t w = load_window(ts, guard);
+
+        /* Determine how many rows to return */
+        size_t num_points = (size_t)(w.end - w.begin);
+        if (num_points > max_points) {
+            num_points = max_points;
+        }
+        w.begin = w.end - num_points;
+
+        /* Copy runs newest to oldest, each walked backwards, column by column */
+        size_t offset[2];
+        size_t length[2];
+        size_t runs = window_segments(ts, w, offset, length);
+        size_t count = 0;
+
+        while (runs > 0) {
+            runs--;
+            const int64_t* run = ts->timestamps + offset[runs];
+            for (size_t i = length[runs]; i > 0; i--) {
+                out_timestamps[count + length[runs] - i] = run[i - 1];
+            }
+            for (size_t j = 0; j < ncols; j++) {
+                const double* vals = ms->cols[columns[j]].values + offset[runs];
+                double* out = out_columns[j] + count;
+                for (size_t i = length[runs]; i > 0; i--) {
+                    out[length[runs] - i] = vals[i - 1];
+                }
+            }
+            count += length[runs];
+        }
+
+        if (read_intact(ts, w, w.begin, &guard)) {
+            METRICS_QUERY(&ms->cols[0], metrics_start, num_points, num_points);
+            return num_points;
+        }
+    }
+}
+
+size_t ag_mseries_query_range(
+    const ag_mseries_t* ms,
+    int64_t start_ms,
+    int64_t end_ms,
+    const size_t* columns,
+    size_t ncols,
+    size_t max_points,
+    int64_t* out_timestamps,
+    double* const* out_columns
+) {
+    /* Validate inputs */
+    if (ms == NULL || out_timestamps == NULL ||
+        !columns_valid(ms, columns, ncols, out_columns)) {
+        return 0;
+    }
+
+    if (max_points == 0 || start_ms > end_ms) {
+        return 0;
+    }
+
+    METRICS_QUERY_START(metrics_start);
+    const ag_timeseries_t* ts = &ms->ring;
+    uint64_t guard = 0;
+    for (;;) {
+        ring_window_t w = load_window(ts, guard);
+        size_t count = 0;
+        uint64_t first_seq = w.begin;
+
+        if (window_ordered(ts, w)) {
+            /* Ordered window: search timestamps once, copy every column's slices */
+            ag_timeseries_view_t view;
+            first_seq = ag_timeseries_locate_range(ts, w, start_ms, end_ms, &view);
+
+            for (size_t r = 0; r < view.span_count && count < max_points; r++) {
+                size_t slot = (size_t)(view.spans[r].timestamps - ts->timestamps);
+                size_t n = view.spans[r].length;
+                if (n > max_points - count) {
+                    n = max_points - count;
+                }
+                memcpy(out_timestamps + count, view.spans[r].timestamps,
+                       n * sizeof(int64_t));
+                for (size_t j = 0; j < ncols; j++) {
+                    memcpy(out_columns[j] + count, ms->cols[columns[j]].values + slot,
+                           n * sizeof(double));
+                }
+                count += n;
+            }
+        } else {
+            /* Unordered window: scan each run oldest to newest */
+            size_t offset[2];
+            size_t length[2];
+            size_t runs = window_segments(ts, w, offset, length);
+
+            for (size_t r = 0; r < runs && count < max_points; r++) {
+                for (size_t i = 0; i < length[r] && count < max_points; i++) {
+                    size_t slot = offset[r] + i;
+                    int64_t timestamp = ts->timestamps[slot];
+                    if (timestamp < start_ms || timestamp > end_ms) {
+                        continue;
+                    }
+                    out_timestamps[count] = timestamp;
+                    for (size_t j = 0; j < ncols; j++) {
+                        out_columns[j][count] = ms->cols[columns[j]].values[slot];
+                    }
+                    count++;
+                }
+            }
+        }
+
+        if (read_intact(ts, w, first_seq, &guard)) {
+            METRICS_QUERY(&ms->cols[0], metrics_start,
+                          window_ordered(ts, w) ? count : (size_t)(w.end - w.begin), count);
+            return count;
+        }
+    }
+}
+
+size_t ag_mseries_columns(const ag_mseries_t* ms) {
+    if (ms == NULL) {
+        return 0;
+    }
+    return ms->columns;
+}
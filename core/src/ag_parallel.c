@@ -0,0 +1,324 @@
+/*
+ * ag_parallel.c - Multi-Series Worker Pool
+ *
+ * Implementation Strategy:
+ *   - Fixed set of pthreads created with the pool; between calls they
+ *     sleep on a condition variable, a call bumps a generation counter
+ *   - The calling thread is participant 0, workers are 1..n; every
+ *     participant runs every call, so no job outlives its caller
+ *   - Work-stealing over series chunks: each participant owns a range of
+ *     chunk indices packed in one 64-bit word (lo | hi << 32). The owner
+ *     takes from lo, thieves take from hi, both with CAS, so there are no
+ *     locks on the work path and nothing is queued
+ *   - Chunk results go straight into the caller's matrix (disjoint rows)
+ *   - Zero allocations after create()
+ *
+ * Copyright (c) 2025 AlgorithmicGrid
+ */
+
+#define _POSIX_C_SOURCE 200809L     /* sysconf */
+
+#include "ag_timeseries_internal.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Largest worker count accepted by pool_create */
+#define POOL_MAX_THREADS 1024
+
+/* Below this many series a call runs on the caller alone */
+#define PARALLEL_MIN_SERIES 16
+
+/* Chunks dealt to each participant; more chunks balance better */
+#define CHUNKS_PER_PARTICIPANT 4
+
+/* Chunk index range of one participant, alone on its cache line */
+typedef struct {
+    _Atomic uint64_t range;         /* lo | hi << 32 */
+    char pad[64 - sizeof(uint64_t)];
+} pool_range_t;
+
+/* One aggregate_many call */
+typedef struct {
+    const ag_timeseries_t* const* series;
+    size_t k;
+    int64_t start_ms;
+    int64_t end_ms;
+    const int* aggs;
+    size_t naggs;
+    double* out;
+    size_t chunk;                   /* Series per chunk */
+} pool_job_t;
+
+/* Worker thread argument */
+typedef struct {
+    ag_timeseries_pool_t* pool;
+    size_t id;                      /* Participant index (1..workers) */
+} pool_worker_t;
+
+struct ag_timeseries_pool_t {
+    size_t workers;                 /* Worker threads */
+    pthread_t* threads;
+    pool_worker_t* args;
+    pool_range_t* ranges;           /* workers + 1 chunk ranges */
+
+    pthread_mutex_t run;            /* Serializes calls */
+    pthread_mutex_t lock;           /* Guards the fields below */
+    pthread_cond_t wake;            /* Caller -> workers: new generation */
+    pthread_cond_t done;            /* Workers -> caller: busy hit 0 */
+    const pool_job_t* job;
+    uint64_t generation;
+    size_t busy;                    /* Workers still in the current call */
+    int stop;
+};
+
+/* Helper: Pack a chunk range */
+static inline uint64_t range_pack(uint64_t lo, uint64_t hi) {
+    return lo | (hi << 32);
+}
+
+/* Helper: Owner takes the first chunk of its range, -1 if empty */
+static int64_t range_take(pool_range_t* r) {
+    uint64_t v = atomic_load_explicit(&r->range, memory_order_relaxed);
+    for (;;) {
+        uint64_t lo = v & 0xffffffffu;
+        uint64_t hi = v >> 32;
+        if (lo >= hi) {
+            return -1;
+        }
+        if (atomic_compare_exchange_weak_explicit(&r->range, &v, range_pack(lo + 1, hi),
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+            return (int64_t)lo;
+        }
+    }
+}
+
+/* Helper: Thief takes the last chunk of another range, -1 if empty */
+static int64_t range_steal(pool_range_t* r) {
+    uint64_t v = atomic_load_explicit(&r->range, memory_order_relaxed);
+    for (;;) {
+        uint64_t lo = v & 0xffffffffu;
+        uint64_t hi = v >> 32;
+        if (lo >= hi) {
+            return -1;
+        }
+        if (atomic_compare_exchange_weak_explicit(&r->range, &v, range_pack(lo, hi - 1),
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+            return (int64_t)(hi - 1);
+        }
+    }
+}
+
+/* Helper: Aggregate rows [first, last) of the job */
+static void run_rows(const pool_job_t* job, size_t first, size_t last) {
+    for (size_t i = first; i < last; i++) {
+        double* row = job->out + i * job->naggs;
+        for (size_t j = 0; j < job->naggs; j++) {
+            if (ag_timeseries_aggregate_range(job->series[i], job->start_ms, job->end_ms,
+                                              job->aggs[j], &row[j]) != AG_OK) {
+                row[j] = NAN;   /* AG_ERR_EMPTY: arguments were validated */
+            }
+        }
+    }
+}
+
+/* Helper: Work own chunks, then steal until every range is empty */
+static void participate(ag_timeseries_pool_t* pool, const pool_job_t* job, size_t id) {
+    size_t participants = pool->workers + 1;
+    for (;;) {
+        int64_t c = range_take(&pool->ranges[id]);
+        for (size_t v = 1; c < 0 && v < participants; v++) {
+            c = range_steal(&pool->ranges[(id + v) % participants]);
+        }
+        if (c < 0) {
+            return;
+        }
+
+        size_t first = (size_t)c * job->chunk;
+        size_t last = first + job->chunk;
+        run_rows(job, first, (last < job->k) ? last : job->k);
+    }
+}
+
+/* Helper: Worker thread body */
+static void* worker_main(void* arg) {
+    pool_worker_t* w = (pool_worker_t*)arg;
+    ag_timeseries_pool_t* pool = w->pool;
+    uint64_t seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->stop && pool->generation == seen) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->stop) {
+            break;
+        }
+        seen = pool->generation;
+        const pool_job_t* job = pool->job;
+        pthread_mutex_unlock(&pool->lock);
+
+        participate(pool, job, w->id);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busy == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+/* Helper: Stop and join the first 'started' workers */
+static void pool_stop(ag_timeseries_pool_t* pool, size_t started) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t i = 0; i < started; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+}
+
+/* Helper: Free pool memory and synchronization objects */
+static void pool_free(ag_timeseries_pool_t* pool) {
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_mutex_destroy(&pool->run);
+    free(pool->ranges);
+    free(pool->args);
+    free(pool->threads);
+    free(pool);
+}
+
+ag_timeseries_pool_t* ag_timeseries_pool_create(size_t threads) {
+    if (threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (cpus > 1) ? (size_t)(cpus - 1) : 0;
+    }
+    if (threads > POOL_MAX_THREADS) {
+        return NULL;
+    }
+
+    ag_timeseries_pool_t* pool = (ag_timeseries_pool_t*)calloc(1, sizeof(*pool));
+    if (pool == NULL) {
+        return NULL;
+    }
+    pool->workers = threads;
+    pool->threads = (pthread_t*)calloc(threads + 1, sizeof(pthread_t));
+    pool->args = (pool_worker_t*)calloc(threads + 1, sizeof(pool_worker_t));
+    pool->ranges = (pool_range_t*)aligned_alloc(64, (threads + 1) * sizeof(pool_range_t));
+    pthread_mutex_init(&pool->run, NULL);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    if (pool->threads == NULL || pool->args == NULL || pool->ranges == NULL) {
+        pool_free(pool);
+        return NULL;
+    }
+    for (size_t p = 0; p <= threads; p++) {
+        atomic_init(&pool->ranges[p].range, 0);
+    }
+
+    for (size_t i = 0; i < threads; i++) {
+        pool->args[i].pool = pool;
+        pool->args[i].id = i + 1;
+        if (pthread_create(&pool->threads[i], NULL, worker_main, &pool->args[i]) != 0) {
+            /* Cleanup on partial start */
+            pool_stop(pool, i);
+            pool_free(pool);
+            return NULL;
+        }
+    }
+    return pool;
+}
+
+void ag_timeseries_pool_destroy(ag_timeseries_pool_t* pool) {
+    if (pool == NULL) {
+        return;
+    }
+
+    pool_stop(pool, pool->workers);
+    pool_free(pool);
+}
+
+size_t ag_timeseries_pool_threads(const ag_timeseries_pool_t* pool) {
+    return (pool != NULL) ? pool->workers : 0;
+}
+
+int ag_timeseries_aggregate_many(
+    const ag_timeseries_t* const* series,
+    size_t k,
+    int64_t start_ms,
+    int64_t end_ms,
+    const int* aggs,
+    size_t naggs,
+    double* out_matrix,
+    ag_timeseries_pool_t* pool
+) {
+    /* Validate inputs */
+    if (aggs == NULL || naggs == 0 || (k > 0 && (series == NULL || out_matrix == NULL))) {
+        return AG_ERR_INVALID_ARG;
+    }
+    for (size_t j = 0; j < naggs; j++) {
+        if (aggs[j] < AG_AGG_COUNT || aggs[j] > AG_AGG_MAX) {
+            return AG_ERR_INVALID_ARG;
+        }
+    }
+    for (size_t i = 0; i < k; i++) {
+        if (series[i] == NULL) {
+            return AG_ERR_INVALID_ARG;
+        }
+    }
+
+    pool_job_t job = { series, k, start_ms, end_ms, aggs, naggs, out_matrix, 0 };
+
+    /* Few series or no workers: the wake-up would cost more than it saves */
+    if (pool == NULL || pool->workers == 0 || k < PARALLEL_MIN_SERIES) {
+        run_rows(&job, 0, k);
+        return AG_OK;
+    }
+
+    pthread_mutex_lock(&pool->run);
+
+    /* Deal chunks out evenly: participant p owns [p * n / P, (p + 1) * n / P) */
+    size_t participants = pool->workers + 1;
+    job.chunk = k / (participants * CHUNKS_PER_PARTICIPANT);
+    if (job.chunk == 0) {
+        job.chunk = 1;
+    }
+    size_t nchunks = (k + job.chunk - 1) / job.chunk;
+    for (size_t p = 0; p < participants; p++) {
+        uint64_t lo = (uint64_t)(p * nchunks / participants);
+        uint64_t hi = (uint64_t)((p + 1) * nchunks / participants);
+        atomic_store_explicit(&pool->ranges[p].range, range_pack(lo, hi),
+                              memory_order_relaxed);
+    }
+
+    /* Wake the workers (the mutex publishes the ranges and the job) */
+    pthread_mutex_lock(&pool->lock);
+    pool->job = &job;
+    pool->busy = pool->workers;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    participate(pool, &job, 0);
+
+    /* Wait until no worker can touch the job or the matrix */
+    pthread_mutex_lock(&pool->lock);
+    while (pool->busy > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pool->job = NULL;
+    pthread_mutex_unlock(&pool->lock);
+
+    pthread_mutex_unlock(&pool->run);
+    return AG_OK;
+}
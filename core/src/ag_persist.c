@@ -0,0 +1,227 @@
+/*
+ * ag_persist.c - File-Backed Ring Buffers
+ *
+ * Implementation Strategy:
+ *   - Header page plus both arrays in one MAP_SHARED file mapping
+ *   - The writer mirrors its counters into the header on every append,
+ *     so the file is recoverable even if the process is killed
+ *   - Checksum over counters and arrays computed on sync/close, verified
+ *     on the next open
+ *   - An append interrupted mid-write is detected (claimed != appended)
+ *     and the slots it touched are dropped on recovery
+ *
+ * Copyright (c) 2025 AlgorithmicGrid
+ */
+
+#define _DEFAULT_SOURCE     /* ftruncate, O_CLOEXEC, MAP_SHARED */
+
+#include "ag_timeseries_internal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Helper: Checksum over the immutable header fields */
+static uint64_t header_checksum(const persist_header_t* h) {
+    uint64_t magic;
+    memcpy(&magic, h->magic, sizeof(magic));
+    uint64_t c = checksum_word(0xcbf29ce484222325ull, magic);
+    c = checksum_word(c, ((uint64_t)h->version << 32) | h->header_size);
+    return checksum_word(c, h->capacity);
+}
+
+/* Helper: Checksum over counters and both arrays */
+static uint64_t data_checksum(const persist_header_t* h, size_t capacity,
+                              const int64_t* timestamps, const double* values) {
+    uint64_t c = checksum_word(0xcbf29ce484222325ull,
+                               atomic_load_explicit(&h->claimed, memory_order_relaxed));
+    c = checksum_word(c, atomic_load_explicit(&h->appended, memory_order_relaxed));
+    c = checksum_word(c, atomic_load_explicit(&h->ordered_from, memory_order_relaxed));
+    c = checksum_word(c, atomic_load_explicit(&h->expired, memory_order_relaxed));
+    c = checksum_words(c, timestamps, capacity);
+    return checksum_words(c, values, capacity);
+}
+
+/* Helper: Total file size, 0 on overflow */
+static size_t file_size_for(size_t capacity) {
+    if (capacity == 0 || capacity > (SIZE_MAX - AG_PERSIST_HEADER_SIZE) / 16) {
+        return 0;
+    }
+    return AG_PERSIST_HEADER_SIZE + capacity * (sizeof(int64_t) + sizeof(double));
+}
+
+/* Helper: Reset counters to an empty ring */
+static void header_reset(persist_header_t* h) {
+    atomic_store_explicit(&h->claimed, 0, memory_order_relaxed);
+    atomic_store_explicit(&h->appended, 0, memory_order_relaxed);
+    atomic_store_explicit(&h->ordered_from, 0, memory_order_relaxed);
+    atomic_store_explicit(&h->expired, 0, memory_order_relaxed);
+    atomic_store_explicit(&h->clean, 0, memory_order_relaxed);
+}
+
+/*
+ * Helper: Rebuild a ring whose last append was interrupted.
+ *
+ * Sequences [claimed - capacity, appended) not below 'expired' are intact;
+ * they are re-appended from sequence 0 so the window invariants hold again.
+ */
+static int recover_torn(ag_timeseries_t* ts, uint64_t appended, uint64_t claimed,
+                        uint64_t expired) {
+    uint64_t cap = ts->capacity;
+    uint64_t begin = appended > cap ? appended - cap : 0;
+    if (claimed > cap && claimed - cap > begin) {
+        begin = claimed - cap;
+    }
+    if (expired > begin) {
+        begin = expired;
+    }
+    size_t n = appended > begin ? (size_t)(appended - begin) : 0;
+
+    int64_t* tmp_ts = NULL;
+    double* tmp_vals = NULL;
+    if (n > 0) {
+        tmp_ts = (int64_t*)malloc(n * sizeof(int64_t));
+        tmp_vals = (double*)malloc(n * sizeof(double));
+        if (tmp_ts == NULL || tmp_vals == NULL) {
+            free(tmp_ts);
+            free(tmp_vals);
+            return AG_ERR_NOMEM;
+        }
+        for (size_t i = 0; i < n; i++) {
+            size_t slot = (size_t)((begin + i) % cap);
+            tmp_ts[i] = ts->timestamps[slot];
+            tmp_vals[i] = ts->values[slot];
+        }
+    }
+
+    header_reset(ts->persist);
+    int rc = ag_timeseries_append_batch(ts, tmp_ts, tmp_vals, n);
+
+    free(tmp_ts);
+    free(tmp_vals);
+    return rc;
+}
+
+ag_timeseries_t* ag_timeseries_open_mmap(const char* path, size_t capacity) {
+    /* Validate arguments */
+    size_t size = file_size_for(capacity);
+    if (path == NULL || size == 0) {
+        return NULL;
+    }
+
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    /* New (empty) file: size it; existing file must match exactly */
+    struct stat st;
+    int fresh = 0;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return NULL;
+    }
+    if (st.st_size == 0) {
+        if (ftruncate(fd, (off_t)size) != 0) {
+            close(fd);
+            return NULL;
+        }
+        fresh = 1;
+    } else if ((uint64_t)st.st_size != (uint64_t)size) {
+        close(fd);
+        return NULL;
+    }
+
+    void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);  /* Mapping keeps the file referenced */
+    if (base == MAP_FAILED) {
+        return NULL;
+    }
+
+    persist_header_t* h = (persist_header_t*)base;
+    int64_t* timestamps = (int64_t*)((unsigned char*)base + AG_PERSIST_HEADER_SIZE);
+    double* values = (double*)(timestamps + capacity);
+
+    if (fresh) {
+        /* ftruncate zero-filled everything; write the identity fields */
+        memcpy(h->magic, AG_PERSIST_MAGIC, sizeof(h->magic));
+        h->version = AG_PERSIST_VERSION;
+        h->header_size = AG_PERSIST_HEADER_SIZE;
+        h->capacity = capacity;
+        h->header_checksum = header_checksum(h);
+        header_reset(h);
+    } else if (memcmp(h->magic, AG_PERSIST_MAGIC, sizeof(h->magic)) != 0 ||
+               h->version != AG_PERSIST_VERSION ||
+               h->header_size != AG_PERSIST_HEADER_SIZE ||
+               h->capacity != capacity ||
+               h->header_checksum != header_checksum(h)) {
+        /* Not a ring file of this layout - never overwrite it */
+        munmap(base, size);
+        return NULL;
+    }
+
+    ag_timeseries_t* ts = (ag_timeseries_t*)malloc(sizeof(ag_timeseries_t));
+    if (ts == NULL) {
+        munmap(base, size);
+        return NULL;
+    }
+    ag_timeseries_init(ts, capacity, 0, timestamps, values);
+    ts->persist = h;
+
+    uint64_t claimed = atomic_load_explicit(&h->claimed, memory_order_relaxed);
+    uint64_t appended = atomic_load_explicit(&h->appended, memory_order_relaxed);
+    uint64_t ordered_from = atomic_load_explicit(&h->ordered_from, memory_order_relaxed);
+    uint64_t expired = atomic_load_explicit(&h->expired, memory_order_relaxed);
+
+    /* Corrupt state recovers as an empty ring */
+    int valid = claimed >= appended && ordered_from <= appended && expired <= appended;
+    if (valid && atomic_load_explicit(&h->clean, memory_order_relaxed)) {
+        valid = h->data_checksum == data_checksum(h, capacity, timestamps, values);
+    }
+    if (!valid) {
+        header_reset(h);
+        return ts;
+    }
+
+    if (claimed != appended) {
+        if (recover_torn(ts, appended, claimed, expired) != AG_OK) {
+            munmap(base, size);
+            free(ts);
+            return NULL;
+        }
+        return ts;
+    }
+
+    atomic_init(&ts->ctl->appended, appended);
+    atomic_init(&ts->ctl->claimed, appended);
+    atomic_init(&ts->ctl->ordered_from, ordered_from);
+    atomic_init(&ts->ctl->expired, expired);
+    ts->head = slot_of(ts, appended);
+    return ts;
+}
+
+int ag_timeseries_sync(ag_timeseries_t* ts) {
+    /* Validate handle */
+    if (ts == NULL || ts->persist == NULL) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    persist_header_t* h = ts->persist;
+    h->data_checksum = data_checksum(h, ts->capacity, ts->timestamps, ts->values);
+    atomic_signal_fence(memory_order_seq_cst);
+    atomic_store_explicit(&h->clean, 1, memory_order_relaxed);
+
+    if (msync(h, file_size_for(ts->capacity), MS_SYNC) != 0) {
+        return AG_ERR_IO;
+    }
+    return AG_OK;
+}
+
+void ag_persist_close(ag_timeseries_t* ts) {
+    /* Best effort: the mapping is dropped even if the flush fails */
+    (void)ag_timeseries_sync(ts);
+    munmap(ts->persist, file_size_for(ts->capacity));
+    ts->persist = NULL;
+}
@@ -0,0 +1,138 @@
+/*
+ * ag_reorder.c - Bounded Reorder Buffer
+ *
+ * Implementation Strategy:
+ *   - Staged points kept sorted in a small ring of max_points + 1 slots,
+ *     oldest at 'first'; a push always fits, then pops shrink it back
+ *   - Insertion sort from the back: an in-order point costs one compare,
+ *     a late one shifts only the points newer than it
+ *   - Release watermark: newest timestamp seen minus window_ms
+ *   - Zero allocations after create()
+ *
+ * Copyright (c) 2025 AlgorithmicGrid
+ */
+
+#include "ag_reorder.h"
+#include <stdlib.h>
+
+struct reorder_buf_t {
+    int64_t window_ms;      /* Hold time before a point is released */
+    size_t max_points;      /* Staged points kept before forcing releases */
+    size_t slots;           /* max_points + 1 */
+    size_t first;           /* Slot of the oldest staged point */
+    size_t count;           /* Staged points */
+    int64_t newest_ms;      /* Newest timestamp accepted */
+    int64_t floor_ms;       /* Newest timestamp released; older points are late */
+    uint64_t rejected;      /* Points dropped as too late */
+    uint64_t reordered;     /* Points placed before an already staged point */
+    int64_t* timestamps;    /* Staged timestamps (ring of 'slots') */
+    uint64_t* cells;        /* Staged value bit patterns */
+};
+
+/* Helper: Ring slot of the i-th oldest staged point */
+static inline size_t staged_slot(const reorder_buf_t* rb, size_t i) {
+    size_t s = rb->first + i;
+    return (s >= rb->slots) ? s - rb->slots : s;
+}
+
+/* Helper: a - b > limit without overflow, for a >= b */
+static inline int gap_exceeds(int64_t a, int64_t b, int64_t limit) {
+    return (uint64_t)a - (uint64_t)b > (uint64_t)limit;
+}
+
+/* Helper: a - b >= limit without overflow, for a >= b */
+static inline int gap_reaches(int64_t a, int64_t b, int64_t limit) {
+    return (uint64_t)a - (uint64_t)b >= (uint64_t)limit;
+}
+
+reorder_buf_t* ag_reorder_create(int64_t window_ms, size_t max_points, int64_t floor_ms) {
+    reorder_buf_t* rb = (reorder_buf_t*)calloc(1, sizeof(reorder_buf_t));
+    if (rb == NULL) {
+        return NULL;
+    }
+
+    rb->slots = max_points + 1;
+    rb->timestamps = (int64_t*)malloc(rb->slots * sizeof(int64_t));
+    rb->cells = (uint64_t*)malloc(rb->slots * sizeof(uint64_t));
+    if (rb->timestamps == NULL || rb->cells == NULL) {
+        ag_reorder_destroy(rb);
+        return NULL;
+    }
+
+    rb->window_ms = window_ms;
+    rb->max_points = max_points;
+    rb->newest_ms = floor_ms;
+    rb->floor_ms = floor_ms;
+    return rb;
+}
+
+void ag_reorder_destroy(reorder_buf_t* rb) {
+    if (rb == NULL) {
+        return;
+    }
+    free(rb->timestamps);
+    free(rb->cells);
+    free(rb);
+}
+
+int ag_reorder_push(reorder_buf_t* rb, int64_t timestamp_ms, uint64_t cell) {
+    /* Too late: would land before released points or outside the window */
+    if (timestamp_ms < rb->floor_ms ||
+        (timestamp_ms < rb->newest_ms &&
+         gap_exceeds(rb->newest_ms, timestamp_ms, rb->window_ms))) {
+        rb->rejected++;
+        return AG_ERR_UNORDERED;
+    }
+
+    /* Shift newer points up one slot until the new point fits (stable) */
+    size_t i = rb->count;
+    while (i > 0) {
+        size_t prev = staged_slot(rb, i - 1);
+        if (rb->timestamps[prev] <= timestamp_ms) {
+            break;
+        }
+        size_t cur = staged_slot(rb, i);
+        rb->timestamps[cur] = rb->timestamps[prev];
+        rb->cells[cur] = rb->cells[prev];
+        i--;
+    }
+    if (i < rb->count) {
+        rb->reordered++;
+    }
+
+    size_t slot = staged_slot(rb, i);
+    rb->timestamps[slot] = timestamp_ms;
+    rb->cells[slot] = cell;
+    rb->count++;
+    if (timestamp_ms > rb->newest_ms) {
+        rb->newest_ms = timestamp_ms;
+    }
+    return AG_OK;
+}
+
+int ag_reorder_pop(reorder_buf_t* rb, int force, int64_t* out_timestamp, uint64_t* out_cell) {
+    if (rb->count == 0) {
+        return 0;
+    }
+
+    int64_t t = rb->timestamps[rb->first];
+    if (!force && rb->count <= rb->max_points &&
+        !gap_reaches(rb->newest_ms, t, rb->window_ms)) {
+        return 0;
+    }
+
+    *out_timestamp = t;
+    *out_cell = rb->cells[rb->first];
+    rb->first = (rb->first + 1 == rb->slots) ? 0 : rb->first + 1;
+    rb->count--;
+    rb->floor_ms = t;
+    return 1;
+}
+
+void ag_reorder_stats(const reorder_buf_t* rb, ag_timeseries_reorder_stats_t* out_stats) {
+    out_stats->pending = rb->count;
+    out_stats->rejected = rb->rejected;
+    out_stats->reordered = rb->reordered;
+    out_stats->window_ms = rb->window_ms;
+    out_stats->max_points = rb->max_points;
+}
@@ -0,0 +1,49 @@
+/*
+ * ag_reorder.h - Internal bounded reorder buffer
+ *
+ * Purpose: Holds the newest points of a series in timestamp order for a
+ *          bounded time/point window, so slightly late points can still be
+ *          placed in order before they become visible in the ring.
+ *
+ * Not part of the public API - used by ag_timeseries.c.
+ *
+ * Copyright (c) 2025 AlgorithmicGrid
+ */
+
+#ifndef AG_REORDER_H
+#define AG_REORDER_H
+
+#include "ag_timeseries.h"
+
+typedef struct reorder_buf_t reorder_buf_t;
+
+/*
+ * Create buffer holding up to max_points staged points for window_ms.
+ * 'floor_ms' is the newest timestamp already released (INT64_MIN if none).
+ * NULL on allocation failure.
+ */
+reorder_buf_t* ag_reorder_create(int64_t window_ms, size_t max_points, int64_t floor_ms);
+
+/* Free buffer (NULL safe) */
+void ag_reorder_destroy(reorder_buf_t* rb);
+
+/*
+ * Insertion-sort one point into the staged tail. 'cell' is the value's
+ * 64-bit pattern (a double, or an int64 of an int64 column), moved as is.
+ * Returns AG_OK, or AG_ERR_UNORDERED (point counted and dropped) if it is
+ * older than the last released point or more than window_ms older than
+ * the newest seen.
+ */
+int ag_reorder_push(reorder_buf_t* rb, int64_t timestamp_ms, uint64_t cell);
+
+/*
+ * Release the oldest staged point if it left the window, the buffer holds
+ * more than max_points, or 'force' is set. Returns 1 and fills the outputs
+ * if a point was released, 0 otherwise.
+ */
+int ag_reorder_pop(reorder_buf_t* rb, int force, int64_t* out_timestamp, uint64_t* out_cell);
+
+/* Fill counters */
+void ag_reorder_stats(const reorder_buf_t* rb, ag_timeseries_reorder_stats_t* out_stats);
+
+#endif /* AG_REORDER_H */
@@ -0,0 +1,212 @@
+/*
+ * ag_rollup.c - Multi-Resolution Rollup Chains
+ *
+ * Implementation Strategy:
+ *   - Each level keeps one open bucket accumulator and a ring of closed
+ *     buckets ordered by start time
+ *   - A raw point that falls past level 0's open bucket closes it; the
+ *     closed bucket is stored and merged into level 1's accumulator, which
+ *     may close in turn - O(levels) worst case, O(1) amortized per point
+ *   - Level widths nest (each a multiple of the previous), so a closed
+ *     child bucket always lies inside exactly one parent bucket
+ *   - Points older than level 0's open bucket are late and not rolled up
+ *
+ * Copyright (c) 2025 AlgorithmicGrid
+ */
+
+#include "ag_rollup.h"
+#include "ag_timeseries_internal.h"
+#include <stdlib.h>
+
+/* Open bucket accumulator */
+typedef struct {
+    int64_t start_ms;   /* Bucket start */
+    double last;        /* Newest value */
+    double sum;         /* Sum of values */
+    double min;         /* Smallest value */
+    double max;         /* Largest value */
+    size_t count;       /* Points so far, 0 = no open bucket */
+} rollup_acc_t;
+
+/* One resolution: accumulator plus ring of closed buckets */
+typedef struct {
+    int64_t bucket_ms;              /* Bucket width */
+    size_t capacity;                /* Ring size */
+    size_t head;                    /* Next write slot */
+    uint64_t closed;                /* Buckets ever closed */
+    rollup_acc_t acc;               /* Bucket in progress */
+    ag_timeseries_rollup_t* items;  /* Closed buckets */
+} rollup_level_t;
+
+struct rollup_chain_t {
+    size_t level_count;
+    rollup_level_t levels[AG_ROLLUP_MAX_LEVELS];
+};
+
+/* Helper: Number of closed buckets stored */
+static inline size_t level_size(const rollup_level_t* lv) {
+    return lv->closed < lv->capacity ? (size_t)lv->closed : lv->capacity;
+}
+
+/* Helper: i-th stored bucket, 0 = oldest */
+static inline const ag_timeseries_rollup_t* level_at(const rollup_level_t* lv, size_t i) {
+    size_t slot = (lv->closed < lv->capacity) ? i : lv->head + i;
+    if (slot >= lv->capacity) {
+        slot -= lv->capacity;
+    }
+    return &lv->items[slot];
+}
+
+/* Helper: First stored bucket with start_ms >= key */
+static size_t level_lower_bound(const rollup_level_t* lv, int64_t key) {
+    size_t lo = 0;
+    size_t hi = level_size(lv);
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (level_at(lv, mid)->start_ms < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* Helper: First stored bucket with start_ms > key */
+static size_t level_upper_bound(const rollup_level_t* lv, int64_t key) {
+    size_t lo = 0;
+    size_t hi = level_size(lv);
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (level_at(lv, mid)->start_ms <= key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* Helper: Merge a partial aggregate into an accumulator */
+static inline void acc_merge(rollup_acc_t* acc, double last, double sum,
+                             double min, double max, size_t count) {
+    if (acc->count == 0) {
+        acc->sum = sum;
+        acc->min = min;
+        acc->max = max;
+    } else {
+        acc->sum += sum;
+        acc->min = (min < acc->min) ? min : acc->min;
+        acc->max = (max > acc->max) ? max : acc->max;
+    }
+    acc->last = last;
+    acc->count += count;
+}
+
+/*
+ * Helper: Route a partial aggregate starting at 'start_ms' into level k,
+ * closing the open bucket first if the aggregate lies past it.
+ */
+static void level_feed(rollup_chain_t* chain, size_t k, int64_t start_ms, double last,
+                       double sum, double min, double max, size_t count) {
+    rollup_level_t* lv = &chain->levels[k];
+    int64_t bucket = bucket_floor(start_ms, lv->bucket_ms);
+
+    if (lv->acc.count > 0 && bucket != lv->acc.start_ms) {
+        if (bucket < lv->acc.start_ms) {
+            return;     /* Late point: its bucket already closed */
+        }
+
+        /* Close: store, then propagate to the next coarser level */
+        rollup_acc_t done = lv->acc;
+        ag_timeseries_rollup_t* item = &lv->items[lv->head];
+        item->start_ms = done.start_ms;
+        item->last = done.last;
+        item->mean = done.sum / (double)done.count;
+        item->min = done.min;
+        item->max = done.max;
+        item->count = done.count;
+        lv->head = (lv->head + 1 == lv->capacity) ? 0 : lv->head + 1;
+        lv->closed++;
+        lv->acc.count = 0;
+
+        if (k + 1 < chain->level_count) {
+            level_feed(chain, k + 1, done.start_ms, done.last, done.sum,
+                       done.min, done.max, done.count);
+        }
+    }
+
+    if (lv->acc.count == 0) {
+        lv->acc.start_ms = bucket;
+    }
+    acc_merge(&lv->acc, last, sum, min, max, count);
+}
+
+rollup_chain_t* ag_rollup_create(const ag_rollup_level_t* levels, size_t level_count) {
+    rollup_chain_t* chain = (rollup_chain_t*)calloc(1, sizeof(rollup_chain_t));
+    if (chain == NULL) {
+        return NULL;
+    }
+
+    chain->level_count = level_count;
+    for (size_t k = 0; k < level_count; k++) {
+        rollup_level_t* lv = &chain->levels[k];
+        lv->bucket_ms = levels[k].bucket_ms;
+        lv->capacity = levels[k].capacity;
+        lv->items = (ag_timeseries_rollup_t*)malloc(lv->capacity * sizeof(ag_timeseries_rollup_t));
+        if (lv->items == NULL) {
+            ag_rollup_destroy(chain);
+            return NULL;
+        }
+    }
+    return chain;
+}
+
+void ag_rollup_destroy(rollup_chain_t* chain) {
+    if (chain == NULL) {
+        return;
+    }
+    for (size_t k = 0; k < chain->level_count; k++) {
+        free(chain->levels[k].items);
+    }
+    free(chain);
+}
+
+void ag_rollup_push(rollup_chain_t* chain, int64_t timestamp_ms, double value) {
+    level_feed(chain, 0, timestamp_ms, value, value, value, value, 1);
+}
+
+size_t ag_rollup_levels(const rollup_chain_t* chain) {
+    return chain->level_count;
+}
+
+int64_t ag_rollup_bucket_ms(const rollup_chain_t* chain, size_t k) {
+    return chain->levels[k].bucket_ms;
+}
+
+size_t ag_rollup_count(const rollup_chain_t* chain, size_t k,
+                       int64_t start_ms, int64_t end_ms, int* out_covers) {
+    const rollup_level_t* lv = &chain->levels[k];
+    size_t n = level_size(lv);
+
+    *out_covers = lv->closed <= lv->capacity ||
+                  (n > 0 && level_at(lv, 0)->start_ms <= start_ms);
+
+    size_t lo = level_lower_bound(lv, start_ms);
+    size_t hi = level_upper_bound(lv, end_ms);
+    return hi > lo ? hi - lo : 0;
+}
+
+size_t ag_rollup_copy(const rollup_chain_t* chain, size_t k,
+                      int64_t start_ms, int64_t end_ms, size_t max_points,
+                      ag_timeseries_rollup_t* out_points) {
+    const rollup_level_t* lv = &chain->levels[k];
+    size_t lo = level_lower_bound(lv, start_ms);
+    size_t hi = level_upper_bound(lv, end_ms);
+    size_t n = 0;
+
+    for (size_t i = lo; i < hi && n < max_points; i++) {
+        out_points[n++] = *level_at(lv, i);
+    }
+    return n;
+}
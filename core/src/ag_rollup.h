@@ -0,0 +1,47 @@
+/*
+ * ag_rollup.h - Internal multi-resolution rollup chains
+ *
+ * Purpose: Downsampled child rings (e.g. 1s -> 1m -> 1h) fed bucket by
+ *          bucket as points are appended to the parent series.
+ *
+ * Not part of the public API - used by ag_timeseries.c.
+ *
+ * Copyright (c) 2025 AlgorithmicGrid
+ */
+
+#ifndef AG_ROLLUP_H
+#define AG_ROLLUP_H
+
+#include "ag_timeseries.h"
+
+typedef struct rollup_chain_t rollup_chain_t;
+
+/* Create chain; levels must already be validated. NULL on allocation failure */
+rollup_chain_t* ag_rollup_create(const ag_rollup_level_t* levels, size_t level_count);
+
+/* Free chain (NULL safe) */
+void ag_rollup_destroy(rollup_chain_t* chain);
+
+/* Feed one raw point; closes and propagates buckets it moves past */
+void ag_rollup_push(rollup_chain_t* chain, int64_t timestamp_ms, double value);
+
+/* Number of levels */
+size_t ag_rollup_levels(const rollup_chain_t* chain);
+
+/* Bucket width of level k */
+int64_t ag_rollup_bucket_ms(const rollup_chain_t* chain, size_t k);
+
+/*
+ * Closed buckets of level k with start_ms in [start_ms, end_ms].
+ * *out_covers is set to 1 if the level still holds everything back to
+ * start_ms (its oldest bucket is not after it, or it never evicted).
+ */
+size_t ag_rollup_count(const rollup_chain_t* chain, size_t k,
+                       int64_t start_ms, int64_t end_ms, int* out_covers);
+
+/* Copy up to max_points closed buckets of level k in range, oldest first */
+size_t ag_rollup_copy(const rollup_chain_t* chain, size_t k,
+                      int64_t start_ms, int64_t end_ms, size_t max_points,
+                      ag_timeseries_rollup_t* out_points);
+
+#endif /* AG_ROLLUP_H */
@@ -0,0 +1,216 @@
+/*
+ * ag_shm.c - Shared-Memory Ring Buffers
+ *
+ * Implementation Strategy:
+ *   - Header page plus both arrays in one POSIX shm segment
+ *   - The ring counters live only in the header, so the writer's SPMC
+ *     publish protocol is directly visible to readers in other processes
+ *   - Readers map the segment PROT_READ and reuse every query path
+ *   - The writer marks the segment live after initializing it and closed
+ *     on destroy; a segment whose writer process is gone is replaced
+ *
+ * Copyright (c) 2025 AlgorithmicGrid
+ */
+
+#define _DEFAULT_SOURCE     /* ftruncate, kill, O_CLOEXEC, MAP_SHARED */
+
+#include "ag_timeseries_internal.h"
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Helper: Total segment size, 0 on overflow */
+static size_t segment_size_for(size_t capacity) {
+    if (capacity == 0 || capacity > (SIZE_MAX - AG_SHM_HEADER_SIZE) / 16) {
+        return 0;
+    }
+    return AG_SHM_HEADER_SIZE + capacity * (sizeof(int64_t) + sizeof(double));
+}
+
+/* Helper: Check identity fields of a mapped header */
+static int header_valid(const shm_header_t* h, size_t mapped) {
+    return memcmp(h->magic, AG_SHM_MAGIC, sizeof(h->magic)) == 0 &&
+           h->version == AG_SHM_VERSION &&
+           h->header_size == AG_SHM_HEADER_SIZE &&
+           segment_size_for((size_t)h->capacity) == mapped;
+}
+
+/*
+ * Helper: Whether an existing segment may be replaced: an abandoned
+ * creation (empty or zeroed header), closed, or its writer process is gone.
+ * Segments that are not rings are never touched.
+ */
+static int segment_stale(const char* name) {
+    static const char zeros[8] = { 0 };
+    int fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        return errno == ENOENT;
+    }
+
+    struct stat st;
+    int stale = 0;
+    if (fstat(fd, &st) == 0 && st.st_size == 0) {
+        stale = 1;
+    } else if ((size_t)st.st_size >= sizeof(shm_header_t)) {
+        const shm_header_t* h = (const shm_header_t*)mmap(NULL, sizeof(shm_header_t),
+                                                          PROT_READ, MAP_SHARED, fd, 0);
+        if (h != MAP_FAILED) {
+            uint64_t state = atomic_load_explicit(&h->state, memory_order_acquire);
+            pid_t pid = (pid_t)h->writer_pid;
+            if (memcmp(h->magic, zeros, sizeof(h->magic)) == 0) {
+                stale = 1;
+            } else if (memcmp(h->magic, AG_SHM_MAGIC, sizeof(h->magic)) == 0) {
+                stale = state != AG_SHM_LIVE || pid <= 0 ||
+                        (kill(pid, 0) != 0 && errno == ESRCH);
+            }
+            munmap((void*)h, sizeof(shm_header_t));
+        }
+    }
+    close(fd);
+    return stale;
+}
+
+/* Helper: Wrap a mapped segment in a handle; NULL (mapping kept) on OOM */
+static ag_timeseries_t* shm_handle(shm_header_t* h, size_t size, const char* name,
+                                   int readonly) {
+    ag_timeseries_t* ts = (ag_timeseries_t*)malloc(sizeof(ag_timeseries_t));
+    shm_link_t* link = (shm_link_t*)calloc(1, sizeof(shm_link_t));
+    char* copy = (name != NULL) ? strdup(name) : NULL;
+    if (ts == NULL || link == NULL || (name != NULL && copy == NULL)) {
+        free(ts);
+        free(link);
+        free(copy);
+        return NULL;
+    }
+
+    size_t capacity = (size_t)h->capacity;
+    int64_t* timestamps = (int64_t*)((unsigned char*)h + AG_SHM_HEADER_SIZE);
+    double* values = (double*)(timestamps + capacity);
+
+    ag_timeseries_init(ts, capacity, 1, timestamps, values);
+    ts->ctl = &h->ctl;
+    ts->readonly = readonly;
+    link->header = h;
+    link->size = size;
+    link->name = copy;
+    ts->shm = link;
+    return ts;
+}
+
+ag_timeseries_t* ag_timeseries_create_shm(const char* name, size_t capacity) {
+    /* Validate arguments */
+    size_t size = segment_size_for(capacity);
+    if (name == NULL || size == 0) {
+        return NULL;
+    }
+
+    /* Never take over a segment another live writer owns */
+    if (!segment_stale(name)) {
+        return NULL;
+    }
+    shm_unlink(name);
+
+    /* Fresh segment: readers of a replaced one keep their old mapping */
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (ftruncate(fd, (off_t)size) != 0) {
+        close(fd);
+        shm_unlink(name);
+        return NULL;
+    }
+
+    void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);  /* Mapping keeps the segment referenced */
+    if (base == MAP_FAILED) {
+        shm_unlink(name);
+        return NULL;
+    }
+
+    /* ftruncate zero-filled everything, counters included */
+    shm_header_t* h = (shm_header_t*)base;
+    memcpy(h->magic, AG_SHM_MAGIC, sizeof(h->magic));
+    h->version = AG_SHM_VERSION;
+    h->header_size = AG_SHM_HEADER_SIZE;
+    h->capacity = capacity;
+    h->writer_pid = (uint64_t)getpid();
+
+    ag_timeseries_t* ts = shm_handle(h, size, name, 0);
+    if (ts == NULL) {
+        munmap(base, size);
+        shm_unlink(name);
+        return NULL;
+    }
+
+    /* Publish: readers check state before trusting the identity fields */
+    atomic_store_explicit(&h->state, AG_SHM_LIVE, memory_order_release);
+    return ts;
+}
+
+ag_timeseries_t* ag_timeseries_attach_shm(const char* name) {
+    /* Validate arguments */
+    if (name == NULL) {
+        return NULL;
+    }
+
+    int fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < AG_SHM_HEADER_SIZE) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t size = (size_t)st.st_size;
+    void* base = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        return NULL;
+    }
+
+    /* Only a live segment has settled identity fields */
+    shm_header_t* h = (shm_header_t*)base;
+    if (atomic_load_explicit(&h->state, memory_order_acquire) == AG_SHM_INIT ||
+        !header_valid(h, size)) {
+        munmap(base, size);
+        return NULL;
+    }
+
+    ag_timeseries_t* ts = shm_handle(h, size, NULL, 1);
+    if (ts == NULL) {
+        munmap(base, size);
+    }
+    return ts;
+}
+
+int ag_timeseries_shm_live(const ag_timeseries_t* ts) {
+    if (ts == NULL || ts->shm == NULL) {
+        return 0;
+    }
+    return atomic_load_explicit(&ts->shm->header->state, memory_order_acquire) == AG_SHM_LIVE;
+}
+
+void ag_shm_close(ag_timeseries_t* ts) {
+    shm_link_t* link = ts->shm;
+
+    /* Writer: tell readers, then drop the name so the next writer starts fresh */
+    if (!ts->readonly) {
+        atomic_store_explicit(&link->header->state, AG_SHM_CLOSED, memory_order_release);
+        shm_unlink(link->name);
+    }
+
+    munmap(link->header, link->size);
+    free(link->name);
+    free(link);
+    ts->shm = NULL;
+    ts->ctl = &ts->local;
+}
@@ -0,0 +1,309 @@
+/*
+ * ag_sketch.c - Mergeable Quantile Sketch
+ *
+ * Implementation Strategy:
+ *   - DDSketch: value v > 0 maps to key ceil(log_gamma(v)), gamma =
+ *     (1 + alpha) / (1 - alpha); every value of a key is within alpha of
+ *     the key's representative value
+ *   - log2 is approximated from the double's bits (exponent plus linear
+ *     mantissa), no libm call on update. The approximation is at most
+ *     1 / ln 2 times steeper than log2, so 1 / ln(gamma) keys per unit keep
+ *     each key narrower than a factor gamma
+ *   - Fixed dense key range [key(min_value), key(max_value)] per sign plus
+ *     a zero bin: the key of a value never changes, so counts can be
+ *     subtracted as exactly as they were added (sliding windows), and two
+ *     sketches with the same alpha merge bin by bin
+ *   - Counts are relaxed atomics written by one thread, so readers may
+ *     walk them while the owner updates
+ *   - One allocation at create(), none after
+ *
+ * Copyright (c) 2025 AlgorithmicGrid
+ */
+
+#include "ag_sketch.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+/*
+ * Internal structure - opaque to users
+ *
+ * Bin Layout:
+ *   counts[0 .. bins)         negative values, index = key - key_min
+ *   counts[bins .. 2 * bins)  positive values, index = key - key_min
+ *   zero                      values with |v| < min_value
+ */
+struct ag_timeseries_sketch_t {
+    double accuracy;            /* Relative accuracy alpha */
+    double multiplier;          /* Keys per unit of approximate log2: 1 / ln(gamma) */
+    double min_value;           /* Smallest magnitude given its own key */
+    int64_t key_min;            /* Key of min_value */
+    size_t bins;                /* Keys per sign */
+    _Atomic uint64_t count;     /* Values counted */
+    _Atomic uint64_t zero;      /* Values below min_value in magnitude */
+    _Atomic uint64_t counts[];  /* 2 * bins counts */
+};
+
+/* Helper: log2(v) within one unit, exact at powers of two (v normal, > 0) */
+static inline double approx_log2(double v) {
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    int exponent = (int)((bits >> 52) & 0x7ff) - 1023;
+    bits = (bits & 0x000fffffffffffffull) | 0x3ff0000000000000ull;
+    double mantissa;
+    memcpy(&mantissa, &bits, sizeof(mantissa));
+    return (double)exponent + (mantissa - 1.0);
+}
+
+/* Helper: Inverse of approx_log2 */
+static inline double approx_exp2(double x) {
+    double e = floor(x);
+    return ldexp(1.0 + (x - e), (int)e);
+}
+
+/* Helper: Key of magnitude a >= min_value, before clamping */
+static inline int64_t raw_key(double multiplier, double a) {
+    /* ceil() without a libm call: truncation is already ceil below zero */
+    double x = approx_log2(a) * multiplier;
+    int64_t key = (int64_t)x;
+    return key + ((double)key < x);
+}
+
+/* Helper: Counter of 'value' (NaN excluded) */
+static inline _Atomic uint64_t* sketch_counter(ag_timeseries_sketch_t* sk, double value) {
+    double a = fabs(value);
+    if (a < sk->min_value) {
+        return &sk->zero;
+    }
+
+    /* Infinity and magnitudes above max_value land in the top key */
+    size_t index = sk->bins - 1;
+    if (a <= DBL_MAX) {
+        size_t key = (size_t)(raw_key(sk->multiplier, a) - sk->key_min);
+        if (key < index) {
+            index = key;
+        }
+    }
+    return &sk->counts[(value < 0.0) ? index : sk->bins + index];
+}
+
+/* Helper: Single-writer counter update, readable by other threads */
+static inline void counter_add(_Atomic uint64_t* c, uint64_t delta) {
+    atomic_store_explicit(c, atomic_load_explicit(c, memory_order_relaxed) + delta,
+                          memory_order_relaxed);
+}
+
+/* Helper: Value reported for a key: minimizes the worst relative error */
+static double key_value(const ag_timeseries_sketch_t* sk, int64_t key) {
+    double lo = approx_exp2((double)(key - 1) / sk->multiplier);
+    double hi = approx_exp2((double)key / sk->multiplier);
+    return 2.0 * lo * hi / (lo + hi);
+}
+
+/*
+ * Helper: Counter at ascending position p of the value order: negative
+ * keys from the largest magnitude down, then zero, then positive keys up.
+ * Positions run from 0 to 2 * bins.
+ */
+static inline const _Atomic uint64_t* position_counter(const ag_timeseries_sketch_t* sk,
+                                                       size_t p) {
+    if (p < sk->bins) {
+        return &sk->counts[sk->bins - 1 - p];
+    }
+    if (p == sk->bins) {
+        return &sk->zero;
+    }
+    return &sk->counts[p - 1];
+}
+
+/* Helper: Value reported for position p */
+static double position_value(const ag_timeseries_sketch_t* sk, size_t p) {
+    if (p < sk->bins) {
+        return -key_value(sk, sk->key_min + (int64_t)(sk->bins - 1 - p));
+    }
+    if (p == sk->bins) {
+        return 0.0;
+    }
+    return key_value(sk, sk->key_min + (int64_t)(p - sk->bins - 1));
+}
+
+/* Helper: Keys per unit of approximate log2 for a relative accuracy */
+static inline double accuracy_multiplier(double relative_accuracy) {
+    return 1.0 / log((1.0 + relative_accuracy) / (1.0 - relative_accuracy));
+}
+
+size_t ag_sketch_bins(double relative_accuracy, double min_value, double max_value) {
+    /* Negated compares also reject NaN */
+    if (!(relative_accuracy > 0.0 && relative_accuracy <= 0.5) ||
+        !(min_value >= DBL_MIN && max_value > min_value && max_value <= DBL_MAX)) {
+        return 0;
+    }
+
+    double multiplier = accuracy_multiplier(relative_accuracy);
+    int64_t span = raw_key(multiplier, max_value) - raw_key(multiplier, min_value);
+    return (span < (int64_t)AG_SKETCH_MAX_BINS) ? (size_t)span + 1 : 0;
+}
+
+ag_timeseries_sketch_t* ag_timeseries_sketch_create(double relative_accuracy,
+                                                    double min_value, double max_value) {
+    /* Validate arguments */
+    size_t bins = ag_sketch_bins(relative_accuracy, min_value, max_value);
+    if (bins == 0) {
+        return NULL;
+    }
+    double multiplier = accuracy_multiplier(relative_accuracy);
+
+    ag_timeseries_sketch_t* sk = (ag_timeseries_sketch_t*)calloc(
+        1, sizeof(ag_timeseries_sketch_t) + 2 * bins * sizeof(_Atomic uint64_t));
+    if (sk == NULL) {
+        return NULL;
+    }
+    sk->accuracy = relative_accuracy;
+    sk->multiplier = multiplier;
+    sk->min_value = min_value;
+    sk->key_min = raw_key(multiplier, min_value);
+    sk->bins = bins;
+    atomic_init(&sk->count, 0);
+    atomic_init(&sk->zero, 0);
+    return sk;
+}
+
+void ag_timeseries_sketch_destroy(ag_timeseries_sketch_t* sketch) {
+    free(sketch);
+}
+
+void ag_sketch_insert(ag_timeseries_sketch_t* sketch, double value) {
+    if (isnan(value)) {
+        return;
+    }
+    counter_add(sketch_counter(sketch, value), 1);
+    counter_add(&sketch->count, 1);
+}
+
+void ag_sketch_remove(ag_timeseries_sketch_t* sketch, double value) {
+    if (isnan(value)) {
+        return;
+    }
+    counter_add(sketch_counter(sketch, value), (uint64_t)-1);
+    counter_add(&sketch->count, (uint64_t)-1);
+}
+
+int ag_timeseries_sketch_add(ag_timeseries_sketch_t* sketch, double value) {
+    if (sketch == NULL) {
+        return AG_ERR_INVALID_ARG;
+    }
+    ag_sketch_insert(sketch, value);
+    return AG_OK;
+}
+
+int ag_timeseries_sketch_merge(ag_timeseries_sketch_t* dst, const ag_timeseries_sketch_t* src) {
+    /* Same alpha, same key mapping */
+    if (dst == NULL || src == NULL || dst->accuracy != src->accuracy) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    uint64_t added = atomic_load_explicit(&src->zero, memory_order_relaxed);
+    counter_add(&dst->zero, added);
+
+    for (size_t sign = 0; sign < 2; sign++) {
+        for (size_t i = 0; i < src->bins; i++) {
+            uint64_t c = atomic_load_explicit(&src->counts[sign * src->bins + i],
+                                              memory_order_relaxed);
+            if (c == 0) {
+                continue;
+            }
+
+            /* Re-home the key in dst's range: below it is zero, above it the top */
+            int64_t key = src->key_min + (int64_t)i;
+            if (key < dst->key_min) {
+                counter_add(&dst->zero, c);
+            } else {
+                size_t index = (size_t)(key - dst->key_min);
+                if (index >= dst->bins) {
+                    index = dst->bins - 1;
+                }
+                counter_add(&dst->counts[sign * dst->bins + index], c);
+            }
+            added += c;
+        }
+    }
+    counter_add(&dst->count, added);
+    return AG_OK;
+}
+
+int ag_timeseries_sketch_quantiles(const ag_timeseries_sketch_t* sketch, const double* qs,
+                                   size_t n, double* out_values) {
+    /* Validate arguments */
+    if (sketch == NULL || qs == NULL || out_values == NULL) {
+        return AG_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (!(qs[i] >= 0.0 && qs[i] <= 1.0)) {
+            return AG_ERR_INVALID_ARG;
+        }
+    }
+
+    uint64_t count = atomic_load_explicit(&sketch->count, memory_order_acquire);
+    if (count == 0) {
+        return AG_ERR_EMPTY;
+    }
+
+    /* Walk positions in value order; ascending qs resume where the last stopped */
+    size_t positions = 2 * sketch->bins + 1;
+    size_t p = 0;
+    size_t last = positions;    /* Last non-empty position passed */
+    uint64_t below = 0;         /* Values before position p */
+    double prev_q = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        if (qs[i] < prev_q) {
+            p = 0;
+            last = positions;
+            below = 0;
+        }
+        prev_q = qs[i];
+
+        double rank = qs[i] * (double)(count - 1);
+        while (p < positions) {
+            uint64_t c = atomic_load_explicit(position_counter(sketch, p), memory_order_relaxed);
+            if (c != 0) {
+                if ((double)(below + c) > rank) {
+                    break;
+                }
+                last = p;
+            }
+            below += c;
+            p++;
+        }
+
+        /* Counts shrank under a concurrent writer: report the largest seen */
+        if (p == positions) {
+            if (last == positions) {
+                return AG_ERR_EMPTY;
+            }
+            out_values[i] = position_value(sketch, last);
+        } else {
+            out_values[i] = position_value(sketch, p);
+        }
+    }
+    return AG_OK;
+}
+
+void ag_timeseries_sketch_clear(ag_timeseries_sketch_t* sketch) {
+    if (sketch == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < 2 * sketch->bins; i++) {
+        atomic_store_explicit(&sketch->counts[i], 0, memory_order_relaxed);
+    }
+    atomic_store_explicit(&sketch->zero, 0, memory_order_relaxed);
+    atomic_store_explicit(&sketch->count, 0, memory_order_relaxed);
+}
+
+uint64_t ag_timeseries_sketch_count(const ag_timeseries_sketch_t* sketch) {
+    if (sketch == NULL) {
+        return 0;
+    }
+    return atomic_load_explicit(&sketch->count, memory_order_relaxed);
+}
@@ -0,0 +1,26 @@
+/*
+ * ag_sketch.h - Internal quantile sketch hooks
+ *
+ * Purpose: Lets a series keep its window sketch in step with the ring:
+ *          values are counted on append and subtracted on eviction.
+ *
+ * Not part of the public API - used by ag_timeseries.c.
+ *
+ * Copyright (c) 2025 AlgorithmicGrid
+ */
+
+#ifndef AG_SKETCH_H
+#define AG_SKETCH_H
+
+#include "ag_timeseries.h"
+
+/* Keys per sign for these parameters, 0 if they are out of range */
+size_t ag_sketch_bins(double relative_accuracy, double min_value, double max_value);
+
+/* Count one value (NaN ignored). One writer per sketch. */
+void ag_sketch_insert(ag_timeseries_sketch_t* sketch, double value);
+
+/* Uncount one value counted before (NaN ignored). One writer per sketch. */
+void ag_sketch_remove(ag_timeseries_sketch_t* sketch, double value);
+
+#endif /* AG_SKETCH_H */
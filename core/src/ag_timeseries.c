@@ -2,50 +2,372 @@
  * ag_timeseries.c - Time-Series Ring Buffer Implementation
  *
  * Implementation Strategy:
- *   - Ring buffer with head/tail pointers
+ *   - Ring buffer addressed by a monotonically increasing 64-bit sequence
  *   - Fixed capacity, circular overwrite
+ *   - Power-of-two capacities index with a mask instead of a divide
+ *   - Optional rolling stats (Kahan sums, monotonic-deque min/max) kept O(1)
+ *   - Range aggregation runs SIMD kernels (ag_kernels.c) on ring segments
+ *   - Timestamp ordering tracked on append; range queries binary-search
+ *     the two contiguous ring segments while the window is ordered
+ *   - Split arrays by default; interleaved {timestamp, value} pairs walk
+ *     the same arrays with stride 2
  *   - Zero allocations after create()
  *   - Defensive programming with NULL checks
  *
  * Copyright (c) 2025 AlgorithmicGrid
  */
 
-#include "ag_timeseries.h"
+#include "ag_timeseries_internal.h"
+#include "ag_kernels.h"
+#include "ag_timeseries_inline.h"
+#include "ag_sketch.h"
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <math.h>
+#include <stddef.h>
+
+/* Helper: First index in sorted run (slots 'stride' apart) with timestamp >= key */
+static inline size_t lower_bound_ts(const int64_t* run, size_t n, size_t stride,
+                                    int64_t key) {
+    size_t lo = 0;
+    size_t hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (run[mid * stride] < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* Helper: First index in sorted run (slots 'stride' apart) with timestamp > key */
+static inline size_t upper_bound_ts(const int64_t* run, size_t n, size_t stride,
+                                    int64_t key) {
+    size_t lo = 0;
+    size_t hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (run[mid * stride] <= key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* Helper: Describe window slice [begin, end) as spans, oldest first (split only) */
+static void window_view(const ag_timeseries_t* ts, ring_window_t w,
+                        ag_timeseries_view_t* view) {
+    size_t offset[2];
+    size_t length[2];
+    size_t runs = window_segments(ts, w, offset, length);
+
+    view->span_count = runs;
+    view->length = (size_t)(w.end - w.begin);
+    view->begin_seq = w.begin;
+    view->end_seq = w.end;
+    for (size_t r = 0; r < runs; r++) {
+        view->spans[r].timestamps = ts->timestamps + offset[r];
+        view->spans[r].values = ts->values + offset[r];
+        view->spans[r].length = length[r];
+    }
+}
 
 /*
- * Internal structure - opaque to users
+ * Locate [start_ms, end_ms] in an ordered window as up to two spans.
+ * Matches are contiguous because the window is sorted. Spans of an
+ * interleaved buffer step by ts->stride; typed series get NULL values
+ * (callers read slots from the timestamp pointer). Such spans never leave
+ * the library.
  *
- * Ring Buffer Layout:
- *   [0] [1] [2] ... [capacity-1]
- *    ^               ^
- *    tail           head (next write position)
- *
- * Invariants:
- *   - size <= capacity
- *   - head, tail < capacity
- *   - When size == capacity, buffer is full
- *   - When size == 0, buffer is empty
+ * Returns the sequence from which slots must stay intact for the search
+ * to hold (the first run's nearer bound).
  */
-struct ag_timeseries_t {
-    size_t capacity;        /* Maximum number of points */
-    size_t size;            /* Current number of points */
-    size_t head;            /* Next write position */
-    size_t tail;            /* Oldest data position (only valid when full) */
-    int64_t* timestamps;    /* Timestamp array */
-    double* values;         /* Value array */
-};
+uint64_t ag_timeseries_locate_range(const ag_timeseries_t* ts, ring_window_t w,
+                                    int64_t start_ms, int64_t end_ms,
+                                    ag_timeseries_view_t* view) {
+    size_t offset[2];
+    size_t length[2];
+    size_t runs = window_segments(ts, w, offset, length);
+    uint64_t run_seq = w.begin;
+    uint64_t intact_from = w.begin;
+
+    view->span_count = 0;
+    view->length = 0;
+    view->begin_seq = w.end;
+    view->end_seq = w.end;
 
-/* Helper: Advance index with wraparound */
-static inline size_t advance_index(size_t index, size_t capacity) {
-    return (index + 1) % capacity;
+    for (size_t r = 0; r < runs; r++) {
+        const int64_t* run = ts->timestamps + offset[r] * ts->stride;
+        size_t first = lower_bound_ts(run, length[r], ts->stride, start_ms);
+        size_t last = upper_bound_ts(run, length[r], ts->stride, end_ms);
+        if (r == 0) {
+            intact_from = run_seq + ((first < last) ? first : last);
+        }
+
+        if (first < last) {
+            ag_timeseries_span_t* span = &view->spans[view->span_count];
+            span->timestamps = run + first * ts->stride;
+            span->values = (ts->values != NULL)
+                         ? ts->values + (offset[r] + first) * ts->stride : NULL;
+            span->length = last - first;
+
+            if (view->span_count == 0) {
+                view->begin_seq = run_seq + first;
+            }
+            view->end_seq = run_seq + last;
+            view->length += span->length;
+            view->span_count++;
+        }
+        run_seq += length[r];
+    }
+
+    if (view->span_count == 0) {
+        view->begin_seq = view->end_seq = intact_from;
+    }
+    return intact_from;
 }
 
-ag_timeseries_t* ag_timeseries_create(size_t capacity) {
-    /* Validate capacity */
-    if (capacity == 0) {
+/* Helper: Compensated add */
+static inline void kahan_add(kahan_t* k, double x) {
+    double y = x - k->comp;
+    double t = k->sum + y;
+    k->comp = (t - k->sum) - y;
+    k->sum = t;
+}
+
+/* Helper: Drop deque front entries older than begin */
+static inline void deque_expire(mono_deque_t* dq, size_t capacity, uint64_t begin) {
+    while (dq->count > 0 && dq->seqs[dq->front] < begin) {
+        dq->front = advance_index(dq->front, capacity);
+        dq->count--;
+    }
+}
+
+/*
+ * Helper: Push sequence seq with value v, first dropping back entries it
+ * dominates. 'is_max' selects a max deque (drop smaller) vs min (drop larger).
+ */
+static inline void deque_push(mono_deque_t* dq, const ag_timeseries_t* ts,
+                              uint64_t seq, double v, int is_max) {
+    while (dq->count > 0) {
+        size_t back = dq->front + dq->count - 1;
+        if (back >= ts->capacity) {
+            back -= ts->capacity;
+        }
+        double bv = slot_value(ts, slot_of(ts, dq->seqs[back]));
+        if (is_max ? (bv > v) : (bv < v)) {
+            break;
+        }
+        dq->count--;
+    }
+
+    size_t pos = dq->front + dq->count;
+    if (pos >= ts->capacity) {
+        pos -= ts->capacity;
+    }
+    dq->seqs[pos] = seq;
+    dq->count++;
+}
+
+/* Helper: Begin stats update (SPMC readers retry while version is odd) */
+static inline void stats_write_begin(ag_timeseries_t* ts) {
+    if (ts->spmc) {
+        uint64_t v = atomic_load_explicit(&ts->stats->version, memory_order_relaxed);
+        atomic_store_explicit(&ts->stats->version, v + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+    }
+}
+
+/* Helper: End stats update */
+static inline void stats_write_end(ag_timeseries_t* ts) {
+    if (ts->spmc) {
+        uint64_t v = atomic_load_explicit(&ts->stats->version, memory_order_relaxed);
+        atomic_store_explicit(&ts->stats->version, v + 1, memory_order_release);
+    }
+}
+
+/* Helper: Remove points below new_begin from the stats window */
+static void stats_drop(ag_timeseries_t* ts, uint64_t new_begin) {
+    stats_state_t* st = ts->stats;
+    if (new_begin <= st->begin_seq) {
+        return;
+    }
+
+    if (new_begin >= st->end_seq) {
+        /* Whole window gone: restart sums to shed accumulated error */
+        memset(&st->sum, 0, sizeof(st->sum));
+        memset(&st->sum_sq, 0, sizeof(st->sum_sq));
+        st->min.count = 0;
+        st->max.count = 0;
+        st->begin_seq = new_begin;
+        return;
+    }
+
+    for (uint64_t seq = st->begin_seq; seq < new_begin; seq++) {
+        double d = slot_value(ts, slot_of(ts, seq)) - st->shift;
+        kahan_add(&st->sum, -d);
+        kahan_add(&st->sum_sq, -(d * d));
+    }
+    deque_expire(&st->min, ts->capacity, new_begin);
+    deque_expire(&st->max, ts->capacity, new_begin);
+    st->begin_seq = new_begin;
+}
+
+/*
+ * Helper: Remove points leaving the window before their slots are
+ * overwritten. 'end' is the sequence one past the newest point after the
+ * pending write of 'count' points starting at stats->end_seq.
+ */
+static void stats_evict(ag_timeseries_t* ts, uint64_t end) {
+    stats_drop(ts, (end > ts->capacity) ? end - ts->capacity : 0);
+}
+
+/*
+ * Helper: Shift the sums by the oldest value of the window, recomputing
+ * them. Runs once per capacity of window advance: O(1) amortized.
+ */
+static void stats_rebase(ag_timeseries_t* ts) {
+    stats_state_t* st = ts->stats;
+    st->shift = slot_value(ts, slot_of(ts, st->begin_seq));
+    st->rebase_seq = st->begin_seq + ts->capacity;
+    memset(&st->sum, 0, sizeof(st->sum));
+    memset(&st->sum_sq, 0, sizeof(st->sum_sq));
+    for (uint64_t seq = st->begin_seq; seq < st->end_seq; seq++) {
+        double d = slot_value(ts, slot_of(ts, seq)) - st->shift;
+        kahan_add(&st->sum, d);
+        kahan_add(&st->sum_sq, d * d);
+    }
+}
+
+/* Helper: Add points [first, end) already written to the ring */
+static void stats_push(ag_timeseries_t* ts, uint64_t first, uint64_t end) {
+    stats_state_t* st = ts->stats;
+
+    /* Empty window (sums are zero): shift by its first value */
+    if (st->begin_seq >= st->end_seq && first < end) {
+        st->shift = slot_value(ts, slot_of(ts, first));
+        st->rebase_seq = first + ts->capacity;
+    }
+
+    for (uint64_t seq = first; seq < end; seq++) {
+        double v = slot_value(ts, slot_of(ts, seq));
+        double d = v - st->shift;
+        kahan_add(&st->sum, d);
+        kahan_add(&st->sum_sq, d * d);
+        deque_push(&st->min, ts, seq, v, 0);
+        deque_push(&st->max, ts, seq, v, 1);
+    }
+    st->end_seq = end;
+
+    /* A full capacity advanced since the shift: follow the level */
+    if (st->begin_seq >= st->rebase_seq && st->begin_seq < end) {
+        stats_rebase(ts);
+    }
+}
+
+/* Helper: Uncount points below new_begin from the quantile sketch */
+static void quantile_drop(ag_timeseries_t* ts, uint64_t new_begin) {
+    quantile_state_t* qst = ts->quantiles;
+    uint64_t stop = (new_begin < qst->end_seq) ? new_begin : qst->end_seq;
+    for (uint64_t seq = qst->begin_seq; seq < stop; seq++) {
+        ag_sketch_remove(qst->sketch, slot_value(ts, slot_of(ts, seq)));
+    }
+    if (new_begin > qst->begin_seq) {
+        qst->begin_seq = new_begin;
+    }
+}
+
+/* Helper: Uncount points about to be overwritten (see stats_evict) */
+static void quantile_evict(ag_timeseries_t* ts, uint64_t end) {
+    quantile_drop(ts, (end > ts->capacity) ? end - ts->capacity : 0);
+}
+
+/* Helper: Count points [first, end) already written to the ring */
+static void quantile_push(ag_timeseries_t* ts, uint64_t first, uint64_t end) {
+    quantile_state_t* qst = ts->quantiles;
+    for (uint64_t seq = first; seq < end; seq++) {
+        ag_sketch_insert(qst->sketch, slot_value(ts, slot_of(ts, seq)));
+    }
+    qst->end_seq = end;
+}
+
+void ag_timeseries_init(
+    ag_timeseries_t* ts,
+    size_t capacity,
+    int spmc,
+    int64_t* timestamps,
+    double* values
+) {
+    ts->capacity = capacity;
+    ts->pow2 = (capacity & (capacity - 1)) == 0;
+    ts->mask = ts->pow2 ? capacity - 1 : 0;
+    ts->head = 0;
+    ts->spmc = spmc;
+    ts->external = 0;
+    ts->readonly = 0;
+    ts->ctl = &ts->local;
+    atomic_init(&ts->ctl->appended, 0);
+    atomic_init(&ts->ctl->claimed, 0);
+    atomic_init(&ts->ctl->ordered_from, 0);
+    atomic_init(&ts->ctl->expired, 0);
+    ts->stride = 1;
+    ts->timestamps = timestamps;
+    ts->values = values;
+    ts->cells = values;
+    ts->vtype = AG_VALUE_F64;
+    ts->vsize = sizeof(double);
+    ts->stats = NULL;
+    ts->persist = NULL;
+    ts->cold = NULL;
+    ts->rollups = NULL;
+    ts->reorder = NULL;
+    ts->quantiles = NULL;
+    ts->ttl_ms = 0;
+    ts->shm = NULL;
+    ts->mapped = 0;
+#ifdef AG_METRICS
+    memset(&ts->metrics, 0, sizeof(ts->metrics));
+#endif
+}
+
+/* Cache line size; interleaved blocks are aligned to it */
+#define AG_CACHE_LINE 64
+
+/*
+ * Helper: Allocate an interleaved buffer: one cache-line-aligned block of
+ * {timestamp, value} pairs. The block is untyped storage, so even elements
+ * are accessed only as int64_t and odd ones only as double.
+ */
+static ag_timeseries_t* timeseries_alloc_interleaved(ag_timeseries_t* ts, size_t capacity) {
+    size_t pair = sizeof(int64_t) + sizeof(double);
+    if (capacity > (SIZE_MAX - AG_CACHE_LINE) / pair) {
+        free(ts);
+        return NULL;
+    }
+
+    /* aligned_alloc wants a multiple of the alignment */
+    size_t bytes = (capacity * pair + AG_CACHE_LINE - 1) & ~(size_t)(AG_CACHE_LINE - 1);
+    void* block = aligned_alloc(AG_CACHE_LINE, bytes);
+    if (block == NULL) {
+        free(ts);
+        return NULL;
+    }
+    memset(block, 0, bytes);
+
+    ag_timeseries_init(ts, capacity, 0, (int64_t*)block, (double*)block + 1);
+    ts->stride = 2;
+    return ts;
+}
+
+/* Helper: Allocate and initialize buffer */
+static ag_timeseries_t* timeseries_alloc(size_t capacity, int spmc, int interleaved) {
+    /* Validate capacity (zero, or byte size overflowing size_t) */
+    if (capacity == 0 || capacity > SIZE_MAX / sizeof(int64_t)) {
         return NULL;
     }
 
@@ -55,23 +377,24 @@ ag_timeseries_t* ag_timeseries_create(size_t capacity) {
         return NULL;
     }
 
+    if (interleaved) {
+        return timeseries_alloc_interleaved(ts, capacity);
+    }
+
     /* Allocate data arrays */
-    ts->timestamps = (int64_t*)malloc(capacity * sizeof(int64_t));
-    ts->values = (double*)malloc(capacity * sizeof(double));
+    int64_t* timestamps = (int64_t*)malloc(capacity * sizeof(int64_t));
+    double* values = (double*)malloc(capacity * sizeof(double));
 
-    if (ts->timestamps == NULL || ts->values == NULL) {
+    if (timestamps == NULL || values == NULL) {
         /* Cleanup on partial allocation failure */
-        free(ts->timestamps);
-        free(ts->values);
+        free(timestamps);
+        free(values);
         free(ts);
         return NULL;
     }
 
     /* Initialize state */
-    ts->capacity = capacity;
-    ts->size = 0;
-    ts->head = 0;
-    ts->tail = 0;
+    ag_timeseries_init(ts, capacity, spmc, timestamps, values);
 
     /* Zero-initialize arrays (defensive, not strictly necessary) */
     memset(ts->timestamps, 0, capacity * sizeof(int64_t));
@@ -80,142 +403,2003 @@ ag_timeseries_t* ag_timeseries_create(size_t capacity) {
     return ts;
 }
 
-void ag_timeseries_destroy(ag_timeseries_t* ts) {
+int ag_timeseries_init_external(
+    ag_timeseries_t* ts,
+    size_t capacity,
+    int spmc,
+    int64_t* timestamps,
+    double* values
+) {
+    if (ts == NULL || timestamps == NULL || values == NULL) {
+        return AG_ERR_INVALID_ARG;
+    }
+    if (capacity == 0 || capacity > SIZE_MAX / sizeof(int64_t)) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    ag_timeseries_init(ts, capacity, spmc, timestamps, values);
+    ts->external = 1;
+    return AG_OK;
+}
+
+void ag_timeseries_release(ag_timeseries_t* ts) {
     if (ts == NULL) {
         return;
     }
 
-    /* Free data arrays */
-    free(ts->timestamps);
-    free(ts->values);
+    /* Free rolling stats */
+    if (ts->stats != NULL) {
+        free(ts->stats->min.seqs);
+        free(ts->stats->max.seqs);
+        free(ts->stats);
+        ts->stats = NULL;
+    }
 
-    /* Free handle */
-    free(ts);
+    /* Free quantile sketch */
+    if (ts->quantiles != NULL) {
+        ag_timeseries_sketch_destroy(ts->quantiles->sketch);
+        free(ts->quantiles);
+        ts->quantiles = NULL;
+    }
+
+    /* Pending appends join the global totals */
+    METRICS_RELEASE(ts);
+
+    /* Free cold tier, rollup chain and reorder buffer */
+    ag_reorder_destroy(ts->reorder);
+    ts->reorder = NULL;
+    ag_cold_destroy(ts->cold);
+    ts->cold = NULL;
+    ag_rollup_destroy(ts->rollups);
+    ts->rollups = NULL;
 }
 
-int ag_timeseries_append(ag_timeseries_t* ts, int64_t timestamp_ms, double value) {
-    /* Validate handle */
-    if (ts == NULL) {
-        return AG_ERR_INVALID_ARG;
+ag_timeseries_t* ag_timeseries_create(size_t capacity) {
+    return timeseries_alloc(capacity, 0, 0);
+}
+
+ag_timeseries_t* ag_timeseries_create_spmc(size_t capacity) {
+    return timeseries_alloc(capacity, 1, 0);
+}
+
+ag_timeseries_t* ag_timeseries_create_pow2(size_t capacity) {
+    /* Round up to the next power of two, rejecting overflow */
+    size_t rounded = 1;
+    while (rounded < capacity) {
+        if (rounded > SIZE_MAX / 2) {
+            return NULL;
+        }
+        rounded <<= 1;
     }
+    return timeseries_alloc(capacity == 0 ? 0 : rounded, 0, 0);
+}
 
-    /* Write to current head position */
-    ts->timestamps[ts->head] = timestamp_ms;
-    ts->values[ts->head] = value;
+ag_timeseries_t* ag_timeseries_create_interleaved(size_t capacity) {
+    return timeseries_alloc(capacity, 0, 1);
+}
 
-    /* Advance head */
-    ts->head = advance_index(ts->head, ts->capacity);
+ag_timeseries_t* ag_timeseries_create_typed(size_t capacity, int value_type) {
+    size_t vsize = ag_typed_size(value_type);
 
-    /* Update size and tail */
-    if (ts->size < ts->capacity) {
-        /* Buffer not yet full */
-        ts->size++;
-    } else {
-        /* Buffer full - advance tail (overwrite oldest) */
-        ts->tail = advance_index(ts->tail, ts->capacity);
+    /* Validate value type and capacity */
+    if (vsize == 0 || capacity == 0 || capacity > SIZE_MAX / sizeof(int64_t)) {
+        return NULL;
+    }
+    if (value_type == AG_VALUE_F64) {
+        return timeseries_alloc(capacity, 0, 0);
     }
 
-    return AG_OK;
-}
+    ag_timeseries_t* ts = (ag_timeseries_t*)malloc(sizeof(ag_timeseries_t));
+    int64_t* timestamps = (int64_t*)calloc(capacity, sizeof(int64_t));
+    void* cells = calloc(capacity, vsize);
 
-size_t ag_timeseries_query_last(
-    const ag_timeseries_t* ts,
-    size_t max_points,
-    int64_t* out_timestamps,
-    double* out_values
-) {
-    /* Validate inputs */
-    if (ts == NULL || out_timestamps == NULL || out_values == NULL) {
-        return 0;
+    if (ts == NULL || timestamps == NULL || cells == NULL) {
+        /* Cleanup on partial allocation failure */
+        free(timestamps);
+        free(cells);
+        free(ts);
+        return NULL;
     }
 
-    if (ts->size == 0 || max_points == 0) {
-        return 0;
+    ag_timeseries_init(ts, capacity, 0, timestamps, NULL);
+    ag_typed_attach(ts, value_type, cells);
+    return ts;
+}
+
+void ag_timeseries_destroy(ag_timeseries_t* ts) {
+    /* Registry-owned series are freed with their registry */
+    if (ts == NULL || ts->external) {
+        return;
     }
 
-    /* Determine how many points to return */
-    size_t num_points = (max_points < ts->size) ? max_points : ts->size;
+    /* Free rolling stats */
+    ag_timeseries_release(ts);
 
-    /*
-     * Iterate backwards from newest to oldest
-     * Newest is at (head - 1 + capacity) % capacity
-     */
-    size_t current_idx;
-    if (ts->head == 0) {
-        current_idx = ts->capacity - 1;
+    /* Free data arrays (file-backed, shared and create_ex rings unmap instead) */
+    if (ts->persist != NULL) {
+        ag_persist_close(ts);
+    } else if (ts->shm != NULL) {
+        ag_shm_close(ts);
+    } else if (ts->mapped != 0) {
+        ag_pages_close(ts);
     } else {
-        current_idx = ts->head - 1;
+        /* Interleaved values live inside the timestamp block */
+        free(ts->timestamps);
+        if (ts->stride == 1) {
+            free(ts->cells);
+        }
     }
 
-    for (size_t i = 0; i < num_points; i++) {
-        out_timestamps[i] = ts->timestamps[current_idx];
-        out_values[i] = ts->values[current_idx];
+    /* Free handle */
+    free(ts);
+}
 
-        /* Move to previous element */
-        if (current_idx == 0) {
-            current_idx = ts->capacity - 1;
-        } else {
-            current_idx--;
-        }
+/*
+ * Helper: Hand points about to be evicted by appending 'count' points at
+ * 'seq' to the cold tier, oldest first: stored points, then batch inputs
+ * that never reach the ring.
+ */
+static void cold_evict(ag_timeseries_t* ts, uint64_t seq, const int64_t* timestamps_ms,
+                       const double* values, size_t count) {
+    uint64_t cap = ts->capacity;
+    uint64_t old_begin = ring_begin(ts, seq);   /* Expired points are already cold */
+    uint64_t new_begin = seq + count > cap ? seq + count - cap : 0;
+    uint64_t ring_end = new_begin < seq ? new_begin : seq;
+
+    for (uint64_t s = old_begin; s < ring_end; s++) {
+        size_t slot = slot_of(ts, s);
+        ag_cold_push(ts->cold, slot_time(ts, slot), slot_value(ts, slot));
+    }
+    for (uint64_t s = seq; s < new_begin; s++) {
+        ag_cold_push(ts->cold, timestamps_ms[s - seq], values[s - seq]);
     }
+}
 
-    return num_points;
+/* Helper: Oldest timestamp a TTL keeps at time now_ms (saturating) */
+static inline int64_t ttl_cutoff(int64_t now_ms, int64_t ttl_ms) {
+    return (now_ms < INT64_MIN + ttl_ms) ? INT64_MIN : now_ms - ttl_ms;
 }
 
-size_t ag_timeseries_query_range(
-    const ag_timeseries_t* ts,
-    int64_t start_ms,
-    int64_t end_ms,
-    size_t max_points,
-    int64_t* out_timestamps,
-    double* out_values
-) {
-    /* Validate inputs */
-    if (ts == NULL || out_timestamps == NULL || out_values == NULL) {
+/*
+ * Helper: Advance the tail past points older than 'cutoff', oldest first,
+ * stopping at the first one that is not. Expired points go to the cold
+ * tier (if any) like points lost to overwrite. Returns the number expired.
+ */
+static size_t expire_before(ag_timeseries_t* ts, int64_t cutoff) {
+    uint64_t end = seq_load(&ts->ctl->appended, memory_order_relaxed);
+    uint64_t first = ring_begin(ts, end);
+    uint64_t begin = first;
+
+    while (begin < end) {
+        size_t slot = slot_of(ts, begin);
+        if (slot_time(ts, slot) >= cutoff) {
+            break;
+        }
+        if (ts->cold != NULL) {
+            ag_cold_push(ts->cold, slot_time(ts, slot), slot_value(ts, slot));
+        }
+        begin++;
+    }
+    if (begin == first) {
         return 0;
     }
 
-    if (ts->size == 0 || max_points == 0) {
-        return 0;
+    if (ts->stats != NULL) {
+        stats_write_begin(ts);
+        stats_drop(ts, begin);
+        stats_write_end(ts);
     }
+    if (ts->quantiles != NULL) {
+        quantile_drop(ts, begin);
+    }
+    atomic_store_explicit(&ts->ctl->expired, begin, memory_order_release);
+    if (ts->persist != NULL) {
+        persist_expire(ts, begin);
+    }
+    return (size_t)(begin - first);
+}
 
-    /* Validate range */
-    if (start_ms > end_ms) {
-        return 0;
+/*
+ * Helper: Write one point to the ring (handle already validated). A
+ * non-NULL 'exact' is stored instead of 'value' (int64 columns only).
+ */
+static inline void append_point_exact(ag_timeseries_t* ts, int64_t timestamp_ms,
+                                      double value, const int64_t* exact) {
+    uint64_t seq = seq_load(&ts->ctl->appended, memory_order_relaxed);
+
+    /* Track ordering against the newest stored point */
+    if (seq > 0) {
+        size_t newest = (ts->head == 0) ? ts->capacity - 1 : ts->head - 1;
+        if (timestamp_ms < slot_time(ts, newest)) {
+            atomic_store_explicit(&ts->ctl->ordered_from, seq, memory_order_relaxed);
+        }
     }
 
-    /*
-     * Iterate from oldest to newest, collecting matching points.
-     * Oldest is at tail (when buffer is full) or index 0 (when not full).
-     */
-    size_t start_idx = (ts->size < ts->capacity) ? 0 : ts->tail;
-    size_t count = 0;
+    /* SPMC: announce the slot before overwriting it */
+    if (ts->spmc) {
+        atomic_store_explicit(&ts->ctl->claimed, seq + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+    }
+    if (ts->persist != NULL) {
+        persist_claim(ts, seq + 1);
+    }
+
+    /* Rolling stats: drop the point about to be overwritten */
+    if (ts->stats != NULL) {
+        stats_write_begin(ts);
+        stats_evict(ts, seq + 1);
+    }
+    if (ts->quantiles != NULL) {
+        quantile_evict(ts, seq + 1);
+    }
+
+    /* Cold tier: compress it instead of losing it (unless it expired to cold already) */
+    if (ts->cold != NULL && seq >= ts->capacity && ring_begin(ts, seq) == seq - ts->capacity) {
+        ag_cold_push(ts->cold, slot_time(ts, ts->head), slot_value(ts, ts->head));
+    }
+
+    /* Write to current head position (overwrites oldest when full) */
+    ts->timestamps[ts->head * ts->stride] = timestamp_ms;
+    if (exact != NULL) {
+        ((int64_t*)ts->cells)[ts->head] = *exact;
+    } else {
+        slot_store(ts, ts->head, value);
+    }
+
+    /* Advance head */
+    ts->head = advance_index(ts->head, ts->capacity);
+
+    if (ts->stats != NULL) {
+        stats_push(ts, seq, seq + 1);
+        stats_write_end(ts);
+    }
+    if (ts->quantiles != NULL) {
+        quantile_push(ts, seq, seq + 1);
+    }
+
+    /* Publish */
+    if (ts->spmc) {
+        atomic_store_explicit(&ts->ctl->appended, seq + 1, memory_order_release);
+    } else {
+        atomic_store_explicit(&ts->ctl->appended, seq + 1, memory_order_relaxed);
+    }
+    if (ts->persist != NULL) {
+        persist_publish(ts, seq + 1);
+    }
+    METRICS_APPEND(ts, 1, ring_begin(ts, seq + 1) > ring_begin(ts, seq));
+
+    /* Retention: this point's timestamp is the clock */
+    if (ts->ttl_ms > 0) {
+        expire_before(ts, ttl_cutoff(timestamp_ms, ts->ttl_ms));
+    }
+
+    /* Rollups: may close buckets down the chain */
+    if (ts->rollups != NULL) {
+        ag_rollup_push(ts->rollups, timestamp_ms, value);
+    }
+}
 
-    for (size_t i = 0; i < ts->size && count < max_points; i++) {
-        size_t idx = (start_idx + i) % ts->capacity;
-        int64_t timestamp = ts->timestamps[idx];
+/* Helper: Write one converted point to the ring */
+static inline void append_point(ag_timeseries_t* ts, int64_t timestamp_ms, double value) {
+    append_point_exact(ts, timestamp_ms, value, NULL);
+}
 
-        /* Check if timestamp is in range */
-        if (timestamp >= start_ms && timestamp <= end_ms) {
-            out_timestamps[count] = timestamp;
-            out_values[count] = ts->values[idx];
-            count++;
+/*
+ * Helper: Write every staged point the reorder buffer releases. Cells
+ * hold the int64 itself for int64 columns, the double otherwise.
+ */
+static void reorder_release(ag_timeseries_t* ts, int force) {
+    int64_t t;
+    uint64_t cell;
+    while (ag_reorder_pop(ts->reorder, force, &t, &cell)) {
+        if (ts->vtype == AG_VALUE_I64) {
+            int64_t x = (int64_t)cell;
+            append_point_exact(ts, t, (double)x, &x);
+        } else {
+            double v;
+            memcpy(&v, &cell, sizeof(v));
+            append_point(ts, t, v);
         }
     }
+}
 
-    return count;
+/*
+ * Helper: Stage one point, then write every point that left the window.
+ * A non-NULL 'exact' is staged instead of 'value' (int64 columns only).
+ */
+static int reorder_append(ag_timeseries_t* ts, int64_t timestamp_ms, double value,
+                          const int64_t* exact) {
+    uint64_t cell;
+    if (ts->vtype == AG_VALUE_I64) {
+        cell = (uint64_t)((exact != NULL) ? *exact : to_i64(value));
+    } else {
+        memcpy(&cell, &value, sizeof(cell));
+    }
+    int rc = ag_reorder_push(ts->reorder, timestamp_ms, cell);
+    reorder_release(ts, 0);
+    return rc;
 }
 
-size_t ag_timeseries_size(const ag_timeseries_t* ts) {
-    if (ts == NULL) {
-        return 0;
+int ag_timeseries_append(ag_timeseries_t* ts, int64_t timestamp_ms, double value) {
+    /* Validate handle (shared-memory readers map the ring read-only) */
+    if (ts == NULL || ts->readonly) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    if (ts->reorder != NULL) {
+        return reorder_append(ts, timestamp_ms, value, NULL);
     }
-    return ts->size;
+
+    append_point(ts, timestamp_ms, value);
+    return AG_OK;
 }
 
-size_t ag_timeseries_capacity(const ag_timeseries_t* ts) {
-    if (ts == NULL) {
-        return 0;
+int ag_timeseries_append_i64(ag_timeseries_t* ts, int64_t timestamp_ms, int64_t value) {
+    /* Validate handle (shared-memory readers map the ring read-only) */
+    if (ts == NULL || ts->readonly) {
+        return AG_ERR_INVALID_ARG;
     }
-    return ts->capacity;
+
+    const int64_t* exact = (ts->vtype == AG_VALUE_I64) ? &value : NULL;
+    if (ts->reorder != NULL) {
+        return reorder_append(ts, timestamp_ms, (double)value, exact);
+    }
+
+    append_point_exact(ts, timestamp_ms, (double)value, exact);
+    return AG_OK;
+}
+
+/*
+ * Helper: Write count > 0 points with the append protocol (handle and
+ * inputs already validated, no reorder buffer). Values come either as
+ * doubles or, when 'values' is NULL, as 'native' cells of the column type
+ * (only without cold tier and rollups, which need doubles).
+ */
+static void append_bulk(ag_timeseries_t* ts, const int64_t* timestamps_ms,
+                        const double* values, const void* native, size_t count) {
+    uint64_t seq = seq_load(&ts->ctl->appended, memory_order_relaxed);
+
+    /* Only the newest 'capacity' points survive; skip the rest */
+    size_t skip = (count > ts->capacity) ? count - ts->capacity : 0;
+    size_t kept = count - skip;
+
+    /* Track ordering: find the last kept point older than its predecessor */
+    for (size_t i = count; i > skip; i--) {
+        size_t k = i - 1;
+        int64_t prev;
+        if (k > 0) {
+            prev = timestamps_ms[k - 1];
+        } else if (seq > 0) {
+            prev = slot_time(ts, (ts->head == 0) ? ts->capacity - 1 : ts->head - 1);
+        } else {
+            break;
+        }
+        if (timestamps_ms[k] < prev) {
+            atomic_store_explicit(&ts->ctl->ordered_from, seq + k, memory_order_relaxed);
+            break;
+        }
+    }
+
+    /* SPMC: announce the whole batch before overwriting */
+    if (ts->spmc) {
+        atomic_store_explicit(&ts->ctl->claimed, seq + count, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+    }
+    if (ts->persist != NULL) {
+        persist_claim(ts, seq + count);
+    }
+
+    /* Rolling stats: drop points about to be overwritten */
+    if (ts->stats != NULL) {
+        stats_write_begin(ts);
+        stats_evict(ts, seq + count);
+    }
+    if (ts->quantiles != NULL) {
+        quantile_evict(ts, seq + count);
+    }
+
+    /* Cold tier: compress evicted and skipped points */
+    if (ts->cold != NULL) {
+        cold_evict(ts, seq, timestamps_ms, values, count);
+    }
+
+    /* Write kept points in at most two contiguous copies split at the wrap */
+    size_t start = slot_of(ts, seq + skip);
+    size_t first = ts->capacity - start;
+    if (first > kept) {
+        first = kept;
+    }
+
+    if (ts->stride == 1) {
+        memcpy(ts->timestamps + start, timestamps_ms + skip, first * sizeof(int64_t));
+        if (kept > first) {
+            memcpy(ts->timestamps, timestamps_ms + skip + first,
+                   (kept - first) * sizeof(int64_t));
+        }
+
+        if (native != NULL) {
+            /* Column-type input: byte copies */
+            size_t vsize = ts->vsize;
+            const unsigned char* in = (const unsigned char*)native + skip * vsize;
+            unsigned char* cells = (unsigned char*)ts->cells;
+            memcpy(cells + start * vsize, in, first * vsize);
+            if (kept > first) {
+                memcpy(cells, in + first * vsize, (kept - first) * vsize);
+            }
+        } else if (ts->vtype != AG_VALUE_F64) {
+            /* Typed column, double input: convert */
+            ag_typed_store(ts, start, values + skip, first);
+            if (kept > first) {
+                ag_typed_store(ts, 0, values + skip + first, kept - first);
+            }
+        } else {
+            memcpy(ts->values + start, values + skip, first * sizeof(double));
+            if (kept > first) {
+                memcpy(ts->values, values + skip + first, (kept - first) * sizeof(double));
+            }
+        }
+    } else {
+        size_t slot = start;
+        for (size_t i = skip; i < count; i++) {
+            ts->timestamps[slot * 2] = timestamps_ms[i];
+            ts->values[slot * 2] = values[i];
+            slot = advance_index(slot, ts->capacity);
+        }
+    }
+
+    /* Advance head */
+    ts->head = slot_of(ts, seq + count);
+
+    if (ts->stats != NULL) {
+        stats_push(ts, seq + skip, seq + count);
+        stats_write_end(ts);
+    }
+    if (ts->quantiles != NULL) {
+        quantile_push(ts, seq + skip, seq + count);
+    }
+
+    /* Publish */
+    if (ts->spmc) {
+        atomic_store_explicit(&ts->ctl->appended, seq + count, memory_order_release);
+    } else {
+        atomic_store_explicit(&ts->ctl->appended, seq + count, memory_order_relaxed);
+    }
+    if (ts->persist != NULL) {
+        persist_publish(ts, seq + count);
+    }
+    /* Dropped = stored before + batch - stored after */
+    METRICS_APPEND(ts, count,
+                   (seq - ring_begin(ts, seq)) + count - (seq + count - ring_begin(ts, seq + count)));
+
+    /* Retention: the newest batch point is the clock */
+    if (ts->ttl_ms > 0) {
+        expire_before(ts, ttl_cutoff(timestamps_ms[count - 1], ts->ttl_ms));
+    }
+
+    /* Rollups: every input point, including ones the ring skipped */
+    if (ts->rollups != NULL) {
+        for (size_t i = 0; i < count; i++) {
+            ag_rollup_push(ts->rollups, timestamps_ms[i], values[i]);
+        }
+    }
+}
+
+int ag_timeseries_append_batch(
+    ag_timeseries_t* ts,
+    const int64_t* timestamps_ms,
+    const double* values,
+    size_t count
+) {
+    /* Validate inputs */
+    if (ts == NULL || ts->readonly ||
+        ((timestamps_ms == NULL || values == NULL) && count > 0)) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    if (count == 0) {
+        return AG_OK;
+    }
+
+    /* Reorder buffer: points are released one by one in timestamp order */
+    if (ts->reorder != NULL) {
+        int rc = AG_OK;
+        for (size_t i = 0; i < count; i++) {
+            if (reorder_append(ts, timestamps_ms[i], values[i], NULL) != AG_OK) {
+                rc = AG_ERR_UNORDERED;
+            }
+        }
+        return rc;
+    }
+
+    append_bulk(ts, timestamps_ms, values, NULL, count);
+    return AG_OK;
+}
+
+/* Helper: Value i of a native batch, widened to double */
+static double native_value(const ag_timeseries_t* ts, const void* values, size_t i) {
+    switch (ts->vtype) {
+    case AG_VALUE_F32:
+        return (double)((const float*)values)[i];
+    case AG_VALUE_I64:
+        return (double)((const int64_t*)values)[i];
+    case AG_VALUE_I32:
+        return (double)((const int32_t*)values)[i];
+    default:
+        return ((const double*)values)[i];
+    }
+}
+
+int ag_timeseries_append_batch_native(
+    ag_timeseries_t* ts,
+    const int64_t* timestamps_ms,
+    const void* values,
+    size_t count
+) {
+    /* Validate inputs */
+    if (ts == NULL || ts->readonly ||
+        ((timestamps_ms == NULL || values == NULL) && count > 0)) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    if (ts->vtype == AG_VALUE_F64) {
+        return ag_timeseries_append_batch(ts, timestamps_ms, (const double*)values, count);
+    }
+
+    /* Reorder buffer, cold tier and rollups take doubles: point by point */
+    if (ts->reorder != NULL || ts->cold != NULL || ts->rollups != NULL) {
+        int rc = AG_OK;
+        for (size_t i = 0; i < count; i++) {
+            double v = native_value(ts, values, i);
+            const int64_t* exact = (ts->vtype == AG_VALUE_I64)
+                                   ? (const int64_t*)values + i : NULL;
+            if (ts->reorder != NULL) {
+                if (reorder_append(ts, timestamps_ms[i], v, exact) != AG_OK) {
+                    rc = AG_ERR_UNORDERED;
+                }
+            } else {
+                append_point_exact(ts, timestamps_ms[i], v, exact);
+            }
+        }
+        return rc;
+    }
+
+    if (count > 0) {
+        append_bulk(ts, timestamps_ms, NULL, values, count);
+    }
+    return AG_OK;
+}
+
+size_t ag_timeseries_query_last(
+    const ag_timeseries_t* ts,
+    size_t max_points,
+    int64_t* out_timestamps,
+    double* out_values
+) {
+    /* Validate inputs */
+    if (ts == NULL || out_timestamps == NULL || out_values == NULL) {
+        return 0;
+    }
+
+    if (max_points == 0) {
+        return 0;
+    }
+
+    METRICS_QUERY_START(metrics_start);
+    uint64_t guard = 0;
+    for (;;) {
+        ring_window_t w = load_window(ts, guard);
+
+        /* Determine how many points to return */
+        size_t num_points = (size_t)(w.end - w.begin);
+        if (num_points > max_points) {
+            num_points = max_points;
+        }
+        w.begin = w.end - num_points;
+
+        /* Copy runs newest to oldest, each walked backwards */
+        size_t offset[2];
+        size_t length[2];
+        size_t runs = window_segments(ts, w, offset, length);
+        size_t stride = ts->stride;
+        size_t count = 0;
+
+        while (runs > 0) {
+            runs--;
+            const int64_t* run = ts->timestamps + offset[runs] * stride;
+            if (ts->values == NULL) {
+                /* Typed column: per-type kernel widens the run */
+                for (size_t i = 0; i < length[runs]; i++) {
+                    out_timestamps[count + i] = run[length[runs] - 1 - i];
+                }
+                ag_typed_load(ts, offset[runs], length[runs], out_values + count, 1);
+                count += length[runs];
+                continue;
+            }
+            const double* vals = ts->values + offset[runs] * stride;
+            for (size_t i = length[runs]; i > 0; i--) {
+                out_timestamps[count] = run[(i - 1) * stride];
+                out_values[count] = vals[(i - 1) * stride];
+                count++;
+            }
+        }
+
+        if (read_intact(ts, w, w.begin, &guard)) {
+            /* Cold tier (never SPMC): continue with the newest evicted points */
+            if (ts->cold != NULL && num_points < max_points) {
+                num_points += ag_cold_query_last(ts->cold, max_points - num_points,
+                                                 out_timestamps + num_points,
+                                                 out_values + num_points);
+            }
+            METRICS_QUERY(ts, metrics_start, num_points, num_points);
+            return num_points;
+        }
+    }
+}
+
+size_t ag_timeseries_query_range(
+    const ag_timeseries_t* ts,
+    int64_t start_ms,
+    int64_t end_ms,
+    size_t max_points,
+    int64_t* out_timestamps,
+    double* out_values
+) {
+    /* Validate inputs */
+    if (ts == NULL || out_timestamps == NULL || out_values == NULL) {
+        return 0;
+    }
+
+    if (max_points == 0) {
+        return 0;
+    }
+
+    /* Validate range */
+    if (start_ms > end_ms) {
+        return 0;
+    }
+
+    METRICS_QUERY_START(metrics_start);
+
+    /* Cold tier (never SPMC): compressed points precede the ring */
+    size_t cold = 0;
+    if (ts->cold != NULL) {
+        cold = ag_cold_query_range(ts->cold, start_ms, end_ms, max_points,
+                                   out_timestamps, out_values);
+        if (cold == max_points) {
+            METRICS_QUERY(ts, metrics_start, cold, cold);
+            return cold;
+        }
+        max_points -= cold;
+        out_timestamps += cold;
+        out_values += cold;
+    }
+
+    uint64_t guard = 0;
+    for (;;) {
+        ring_window_t w = load_window(ts, guard);
+        size_t count = 0;
+        uint64_t first_seq = w.begin;
+
+        if (window_ordered(ts, w)) {
+            /*
+             * Ordered window: binary-search each run for [start_ms, end_ms]
+             * and bulk-copy the matching slices.
+             */
+            ag_timeseries_view_t view;
+            first_seq = ag_timeseries_locate_range(ts, w, start_ms, end_ms, &view);
+
+            for (size_t r = 0; r < view.span_count && count < max_points; r++) {
+                size_t n = view.spans[r].length;
+                if (n > max_points - count) {
+                    n = max_points - count;
+                }
+                if (ts->values == NULL) {
+                    memcpy(out_timestamps + count, view.spans[r].timestamps,
+                           n * sizeof(int64_t));
+                    ag_typed_load(ts, (size_t)(view.spans[r].timestamps - ts->timestamps),
+                                  n, out_values + count, 0);
+                } else if (ts->stride == 1) {
+                    memcpy(out_timestamps + count, view.spans[r].timestamps,
+                           n * sizeof(int64_t));
+                    memcpy(out_values + count, view.spans[r].values,
+                           n * sizeof(double));
+                } else {
+                    for (size_t i = 0; i < n; i++) {
+                        out_timestamps[count + i] = view.spans[r].timestamps[i * 2];
+                        out_values[count + i] = view.spans[r].values[i * 2];
+                    }
+                }
+                count += n;
+            }
+        } else {
+            /* Unordered window: scan each run oldest to newest */
+            size_t offset[2];
+            size_t length[2];
+            size_t runs = window_segments(ts, w, offset, length);
+
+            size_t stride = ts->stride;
+
+            for (size_t r = 0; r < runs && count < max_points; r++) {
+                const int64_t* run = ts->timestamps + offset[r] * stride;
+
+                for (size_t i = 0; i < length[r] && count < max_points; i++) {
+                    int64_t timestamp = run[i * stride];
+
+                    /* Check if timestamp is in range */
+                    if (timestamp >= start_ms && timestamp <= end_ms) {
+                        out_timestamps[count] = timestamp;
+                        out_values[count] = slot_value(ts, offset[r] + i);
+                        count++;
+                    }
+                }
+            }
+        }
+
+        if (read_intact(ts, w, first_seq, &guard)) {
+            /* Unordered windows are scanned point by point */
+            METRICS_QUERY(ts, metrics_start,
+                          cold + (window_ordered(ts, w) ? count : (size_t)(w.end - w.begin)),
+                          cold + count);
+            return cold + count;
+        }
+    }
+}
+
+size_t ag_timeseries_query_last_native(
+    const ag_timeseries_t* ts,
+    size_t max_points,
+    int64_t* out_timestamps,
+    void* out_values
+) {
+    /* Validate inputs */
+    if (ts == NULL || out_timestamps == NULL || out_values == NULL) {
+        return 0;
+    }
+
+    if (max_points == 0) {
+        return 0;
+    }
+
+    METRICS_QUERY_START(metrics_start);
+    unsigned char* out = (unsigned char*)out_values;
+    uint64_t guard = 0;
+    for (;;) {
+        ring_window_t w = load_window(ts, guard);
+
+        /* Determine how many points to return */
+        size_t num_points = (size_t)(w.end - w.begin);
+        if (num_points > max_points) {
+            num_points = max_points;
+        }
+        w.begin = w.end - num_points;
+
+        /* Copy runs newest to oldest, each reversed */
+        size_t offset[2];
+        size_t length[2];
+        size_t runs = window_segments(ts, w, offset, length);
+        size_t stride = ts->stride;
+        size_t count = 0;
+
+        while (runs > 0) {
+            runs--;
+            const int64_t* run = ts->timestamps + offset[runs] * stride;
+            for (size_t i = 0; i < length[runs]; i++) {
+                out_timestamps[count + i] = run[(length[runs] - 1 - i) * stride];
+            }
+            ag_typed_copy(ts, offset[runs], length[runs], out + count * ts->vsize, 1);
+            count += length[runs];
+        }
+
+        if (read_intact(ts, w, w.begin, &guard)) {
+            METRICS_QUERY(ts, metrics_start, num_points, num_points);
+            return num_points;
+        }
+    }
+}
+
+size_t ag_timeseries_query_range_native(
+    const ag_timeseries_t* ts,
+    int64_t start_ms,
+    int64_t end_ms,
+    size_t max_points,
+    int64_t* out_timestamps,
+    void* out_values
+) {
+    /* Validate inputs */
+    if (ts == NULL || out_timestamps == NULL || out_values == NULL) {
+        return 0;
+    }
+
+    if (max_points == 0 || start_ms > end_ms) {
+        return 0;
+    }
+
+    METRICS_QUERY_START(metrics_start);
+    unsigned char* out = (unsigned char*)out_values;
+    size_t stride = ts->stride;
+    uint64_t guard = 0;
+    for (;;) {
+        ring_window_t w = load_window(ts, guard);
+        size_t count = 0;
+        uint64_t first_seq = w.begin;
+
+        if (window_ordered(ts, w)) {
+            /* Ordered window: copy the located slices */
+            ag_timeseries_view_t view;
+            first_seq = ag_timeseries_locate_range(ts, w, start_ms, end_ms, &view);
+
+            for (size_t r = 0; r < view.span_count && count < max_points; r++) {
+                const int64_t* run = view.spans[r].timestamps;
+                size_t n = view.spans[r].length;
+                if (n > max_points - count) {
+                    n = max_points - count;
+                }
+                for (size_t i = 0; i < n; i++) {
+                    out_timestamps[count + i] = run[i * stride];
+                }
+                ag_typed_copy(ts, (size_t)(run - ts->timestamps) / stride, n,
+                              out + count * ts->vsize, 0);
+                count += n;
+            }
+        } else {
+            /* Unordered window: scan each run oldest to newest */
+            size_t offset[2];
+            size_t length[2];
+            size_t runs = window_segments(ts, w, offset, length);
+
+            for (size_t r = 0; r < runs && count < max_points; r++) {
+                for (size_t i = 0; i < length[r] && count < max_points; i++) {
+                    size_t slot = offset[r] + i;
+                    int64_t timestamp = slot_time(ts, slot);
+                    if (timestamp >= start_ms && timestamp <= end_ms) {
+                        out_timestamps[count] = timestamp;
+                        ag_typed_copy(ts, slot, 1, out + count * ts->vsize, 0);
+                        count++;
+                    }
+                }
+            }
+        }
+
+        if (read_intact(ts, w, first_seq, &guard)) {
+            METRICS_QUERY(ts, metrics_start,
+                          window_ordered(ts, w) ? count : (size_t)(w.end - w.begin), count);
+            return count;
+        }
+    }
+}
+
+/*
+ * Helper: Number of points with timestamp <= key in an ordered window,
+ * i.e. the window offset just past the as-of match.
+ */
+static size_t window_upper_bound(const ag_timeseries_t* ts, ring_window_t w, int64_t key) {
+    size_t offset[2];
+    size_t length[2];
+    size_t runs = window_segments(ts, w, offset, length);
+    size_t stride = ts->stride;
+
+    if (runs == 0) {
+        return 0;
+    }
+    if (runs == 2 && ts->timestamps[offset[1] * stride] <= key) {
+        return length[0] + upper_bound_ts(ts->timestamps + offset[1] * stride,
+                                          length[1], stride, key);
+    }
+    return upper_bound_ts(ts->timestamps + offset[0] * stride, length[0], stride, key);
+}
+
+int ag_timeseries_asof(
+    const ag_timeseries_t* ts,
+    int64_t timestamp_ms,
+    int64_t* out_timestamp,
+    double* out_value
+) {
+    /* Validate inputs */
+    if (ts == NULL || out_timestamp == NULL || out_value == NULL) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    METRICS_QUERY_START(metrics_start);
+    uint64_t guard = 0;
+    for (;;) {
+        ring_window_t w = load_window(ts, guard);
+        uint64_t first_seq = w.begin;
+        int found = 0;
+        int64_t t = 0;
+        double v = 0.0;
+
+        if (window_ordered(ts, w)) {
+            /* Ordered window: the match sits just before the upper bound */
+            size_t past = window_upper_bound(ts, w, timestamp_ms);
+            if (past > 0) {
+                first_seq = w.begin + past - 1;
+                size_t slot = slot_of(ts, first_seq);
+                t = slot_time(ts, slot);
+                v = slot_value(ts, slot);
+                found = 1;
+            }
+        } else {
+            /* Unordered window: latest of the newest timestamps <= target */
+            for (uint64_t seq = w.begin; seq < w.end; seq++) {
+                size_t slot = slot_of(ts, seq);
+                int64_t cand = slot_time(ts, slot);
+                if (cand <= timestamp_ms && (!found || cand >= t)) {
+                    t = cand;
+                    v = slot_value(ts, slot);
+                    found = 1;
+                }
+            }
+        }
+
+        if (read_intact(ts, w, first_seq, &guard)) {
+            METRICS_QUERY(ts, metrics_start,
+                          window_ordered(ts, w) ? (size_t)found : (size_t)(w.end - w.begin),
+                          (size_t)found);
+            if (!found) {
+                return AG_ERR_EMPTY;
+            }
+            *out_timestamp = t;
+            *out_value = v;
+            return AG_OK;
+        }
+    }
+}
+
+/*
+ * Helper: As-of values of one ordered window for non-decreasing query
+ * timestamps, written 'k' doubles apart. One binary search places the
+ * cursor; afterwards it only moves forward (merge-join).
+ *
+ * Returns the sequence from which slots must stay intact.
+ */
+static uint64_t align_column(const ag_timeseries_t* ts, ring_window_t w,
+                             const int64_t* timestamps, size_t n,
+                             double* out, size_t k) {
+    size_t offset[2] = { 0, 0 };
+    size_t length[2] = { 0, 0 };
+    window_segments(ts, w, offset, length);
+    size_t stride = ts->stride;
+    size_t total = length[0] + length[1];
+
+    size_t past = window_upper_bound(ts, w, timestamps[0]);
+    uint64_t intact_from = w.begin + ((past > 0) ? past - 1 : 0);
+
+    for (size_t i = 0; i < n; i++) {
+        /* Advance over points at or before this query timestamp */
+        while (past < total) {
+            size_t slot = (past < length[0]) ? offset[0] + past
+                                             : offset[1] + (past - length[0]);
+            if (ts->timestamps[slot * stride] > timestamps[i]) {
+                break;
+            }
+            past++;
+        }
+
+        if (past == 0) {
+            out[i * k] = NAN;
+        } else {
+            size_t at = past - 1;
+            size_t slot = (at < length[0]) ? offset[0] + at : offset[1] + (at - length[0]);
+            out[i * k] = slot_value(ts, slot);
+        }
+    }
+    return intact_from;
+}
+
+int ag_timeseries_align(
+    const ag_timeseries_t* const* series,
+    size_t k,
+    const int64_t* timestamps,
+    size_t n,
+    double* out_matrix
+) {
+    /* Validate inputs */
+    if ((k > 0 && series == NULL) || (n > 0 && (timestamps == NULL || out_matrix == NULL))) {
+        return AG_ERR_INVALID_ARG;
+    }
+    for (size_t j = 0; j < k; j++) {
+        if (series[j] == NULL) {
+            return AG_ERR_INVALID_ARG;
+        }
+    }
+    for (size_t i = 1; i < n; i++) {
+        if (timestamps[i] < timestamps[i - 1]) {
+            return AG_ERR_INVALID_ARG;
+        }
+    }
+    if (n == 0) {
+        return AG_OK;
+    }
+
+    /* One pass per series; column j of row i is series j as of timestamps[i] */
+    for (size_t j = 0; j < k; j++) {
+        const ag_timeseries_t* ts = series[j];
+        uint64_t guard = 0;
+        for (;;) {
+            ring_window_t w = load_window(ts, guard);
+            if (!window_ordered(ts, w)) {
+                return AG_ERR_UNORDERED;
+            }
+
+            uint64_t first_seq = align_column(ts, w, timestamps, n, out_matrix + j, k);
+            if (read_intact(ts, w, first_seq, &guard)) {
+                break;
+            }
+        }
+    }
+    return AG_OK;
+}
+
+int ag_timeseries_view_last(
+    const ag_timeseries_t* ts,
+    size_t max_points,
+    ag_timeseries_view_t* out_view
+) {
+    /* Validate inputs (interleaved and typed slots cannot form double spans) */
+    if (ts == NULL || out_view == NULL || ts->stride != 1 || ts->values == NULL) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    METRICS_QUERY_START(metrics_start);
+    ring_window_t w = load_window(ts, 0);
+    if (w.end - w.begin > max_points) {
+        w.begin = w.end - max_points;
+    }
+    window_view(ts, w, out_view);
+    METRICS_QUERY(ts, metrics_start, 0, out_view->length);
+    return AG_OK;
+}
+
+int ag_timeseries_view_range(
+    const ag_timeseries_t* ts,
+    int64_t start_ms,
+    int64_t end_ms,
+    ag_timeseries_view_t* out_view
+) {
+    /* Validate inputs (interleaved and typed slots cannot form double spans) */
+    if (ts == NULL || out_view == NULL || ts->stride != 1 || ts->values == NULL) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    METRICS_QUERY_START(metrics_start);
+    uint64_t guard = 0;
+    for (;;) {
+        ring_window_t w = load_window(ts, guard);
+
+        /* Matches of an unordered window are not contiguous */
+        if (!window_ordered(ts, w)) {
+            return AG_ERR_UNORDERED;
+        }
+
+        if (start_ms > end_ms) {
+            w.begin = w.end;
+            window_view(ts, w, out_view);
+            METRICS_QUERY(ts, metrics_start, 0, 0);
+            return AG_OK;
+        }
+
+        uint64_t first_seq = ag_timeseries_locate_range(ts, w, start_ms, end_ms, out_view);
+        if (read_intact(ts, w, first_seq, &guard)) {
+            METRICS_QUERY(ts, metrics_start, 0, out_view->length);
+            return AG_OK;
+        }
+    }
+}
+
+int ag_timeseries_view_valid(
+    const ag_timeseries_t* ts,
+    const ag_timeseries_view_t* view
+) {
+    if (ts == NULL || view == NULL) {
+        return 0;
+    }
+    return write_horizon(ts) <= view->begin_seq + ts->capacity;
+}
+
+/*
+ * Helper: Accumulate sum/min/max/count of in-range points of an interleaved
+ * run. The SIMD kernels need contiguous values, so this stays scalar.
+ */
+static void reduce_strided(const int64_t* run, const double* vals, size_t n,
+                           int64_t start_ms, int64_t end_ms, double* sum,
+                           double* min, double* max, size_t* count) {
+    for (size_t i = 0; i < n; i++) {
+        int64_t t = run[i * 2];
+        if (t < start_ms || t > end_ms) {
+            continue;
+        }
+        double v = vals[i * 2];
+        *sum += v;
+        *min = (v < *min) ? v : *min;
+        *max = (v > *max) ? v : *max;
+        (*count)++;
+    }
+}
+
+int ag_timeseries_cursor_init(
+    const ag_timeseries_t* ts,
+    int from,
+    ag_ts_cursor_t* out_cursor
+) {
+    /* Validate inputs */
+    if (ts == NULL || out_cursor == NULL ||
+        (from != AG_CURSOR_OLDEST && from != AG_CURSOR_LATEST)) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    ring_window_t w = load_window(ts, 0);
+    out_cursor->next_seq = (from == AG_CURSOR_OLDEST) ? w.begin : w.end;
+    out_cursor->lost = 0;
+    return AG_OK;
+}
+
+int ag_timeseries_cursor_read(
+    const ag_timeseries_t* ts,
+    ag_ts_cursor_t* cursor,
+    size_t max_points,
+    int64_t* out_timestamps,
+    double* out_values,
+    size_t* out_count,
+    uint64_t* out_lost
+) {
+    /* Validate inputs */
+    if (ts == NULL || cursor == NULL || out_timestamps == NULL ||
+        out_values == NULL || out_count == NULL) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    METRICS_QUERY_START(metrics_start);
+    uint64_t guard = 0;
+    for (;;) {
+        ring_window_t w = load_window(ts, guard);
+        if (cursor->next_seq > w.end) {
+            return AG_ERR_INVALID_ARG;  /* Not a cursor of this buffer */
+        }
+
+        /* Unread points still stored: [max(next, begin), end), capped */
+        ring_window_t r;
+        r.begin = (cursor->next_seq > w.begin) ? cursor->next_seq : w.begin;
+        r.end = (w.end - r.begin > max_points) ? r.begin + max_points : w.end;
+
+        size_t offset[2];
+        size_t length[2];
+        size_t runs = window_segments(ts, r, offset, length);
+        size_t stride = ts->stride;
+        size_t count = 0;
+
+        for (size_t k = 0; k < runs; k++) {
+            const int64_t* run = ts->timestamps + offset[k] * stride;
+            if (ts->values == NULL) {
+                memcpy(out_timestamps + count, run, length[k] * sizeof(int64_t));
+                ag_typed_load(ts, offset[k], length[k], out_values + count, 0);
+                count += length[k];
+                continue;
+            }
+            const double* vals = ts->values + offset[k] * stride;
+            for (size_t i = 0; i < length[k]; i++) {
+                out_timestamps[count] = run[i * stride];
+                out_values[count] = vals[i * stride];
+                count++;
+            }
+        }
+
+        if (!read_intact(ts, w, r.begin, &guard)) {
+            continue;
+        }
+
+        uint64_t lost = r.begin - cursor->next_seq;
+        cursor->next_seq = r.end;
+        cursor->lost += lost;
+        *out_count = count;
+        if (out_lost != NULL) {
+            *out_lost = lost;
+        }
+        METRICS_QUERY(ts, metrics_start, count, count);
+        return (lost > 0) ? AG_ERR_LAPPED : AG_OK;
+    }
+}
+
+int ag_timeseries_cursor_view(
+    const ag_timeseries_t* ts,
+    ag_ts_cursor_t* cursor,
+    size_t max_points,
+    ag_timeseries_view_t* out_view,
+    uint64_t* out_lost
+) {
+    /* Validate inputs (interleaved and typed slots cannot form double spans) */
+    if (ts == NULL || cursor == NULL || out_view == NULL ||
+        ts->stride != 1 || ts->values == NULL) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    METRICS_QUERY_START(metrics_start);
+    ring_window_t w = load_window(ts, 0);
+    if (cursor->next_seq > w.end) {
+        return AG_ERR_INVALID_ARG;  /* Not a cursor of this buffer */
+    }
+
+    /* Skip what the ring no longer holds; the rest stays unread */
+    uint64_t lost = 0;
+    if (cursor->next_seq < w.begin) {
+        lost = w.begin - cursor->next_seq;
+        cursor->next_seq = w.begin;
+        cursor->lost += lost;
+    }
+
+    ring_window_t r;
+    r.begin = cursor->next_seq;
+    r.end = (w.end - r.begin > max_points) ? r.begin + max_points : w.end;
+    window_view(ts, r, out_view);
+
+    if (out_lost != NULL) {
+        *out_lost = lost;
+    }
+    METRICS_QUERY(ts, metrics_start, 0, out_view->length);
+    return (lost > 0) ? AG_ERR_LAPPED : AG_OK;
+}
+
+int ag_timeseries_aggregate_range(
+    const ag_timeseries_t* ts,
+    int64_t start_ms,
+    int64_t end_ms,
+    int agg,
+    double* out_value
+) {
+    /* Validate inputs */
+    if (ts == NULL || out_value == NULL || agg < AG_AGG_COUNT || agg > AG_AGG_MAX) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    METRICS_QUERY_START(metrics_start);
+    const ag_kernels_t* k = ag_kernels_get();
+    uint64_t guard = 0;
+    for (;;) {
+        ring_window_t w = load_window(ts, guard);
+        uint64_t first_seq = w.begin;
+        size_t count = 0;
+        double sum = 0.0;
+        double min = INFINITY;
+        double max = -INFINITY;
+
+        if (start_ms > end_ms) {
+            /* Empty range */
+        } else if (ts->values == NULL) {
+            /* Typed column: per-type kernels, same shape as the SIMD paths below */
+            size_t offset[2];
+            size_t length[2];
+            size_t runs;
+            int ordered = window_ordered(ts, w);
+            if (ordered) {
+                ag_timeseries_view_t view;
+                first_seq = ag_timeseries_locate_range(ts, w, start_ms, end_ms, &view);
+                count = view.length;
+                runs = view.span_count;
+                for (size_t r = 0; r < runs; r++) {
+                    offset[r] = (size_t)(view.spans[r].timestamps - ts->timestamps);
+                    length[r] = view.spans[r].length;
+                }
+            } else {
+                runs = window_segments(ts, w, offset, length);
+            }
+            for (size_t r = 0; r < runs; r++) {
+                double m = ordered
+                    ? ag_typed_reduce(ts, offset[r], length[r], agg)
+                    : ag_typed_reduce_in(ts, offset[r], length[r], agg, start_ms, end_ms,
+                                         &count);
+                if (agg == AG_AGG_MIN) {
+                    min = (m < min) ? m : min;
+                } else if (agg == AG_AGG_MAX) {
+                    max = (m > max) ? m : max;
+                } else {
+                    sum += m;
+                }
+            }
+        } else if (ts->stride != 1) {
+            /* Interleaved: scalar reduction, located spans when ordered */
+            size_t n = 0;
+            if (window_ordered(ts, w)) {
+                ag_timeseries_view_t view;
+                first_seq = ag_timeseries_locate_range(ts, w, start_ms, end_ms, &view);
+                for (size_t r = 0; r < view.span_count; r++) {
+                    reduce_strided(view.spans[r].timestamps, view.spans[r].values,
+                                   view.spans[r].length, start_ms, end_ms,
+                                   &sum, &min, &max, &n);
+                }
+            } else {
+                size_t offset[2];
+                size_t length[2];
+                size_t runs = window_segments(ts, w, offset, length);
+                for (size_t r = 0; r < runs; r++) {
+                    reduce_strided(ts->timestamps + offset[r] * 2, ts->values + offset[r] * 2,
+                                   length[r], start_ms, end_ms, &sum, &min, &max, &n);
+                }
+            }
+            count = n;
+        } else if (window_ordered(ts, w)) {
+            /* Ordered window: reduce the located spans directly */
+            ag_timeseries_view_t view;
+            first_seq = ag_timeseries_locate_range(ts, w, start_ms, end_ms, &view);
+            count = view.length;
+
+            for (size_t r = 0; r < view.span_count; r++) {
+                const double* vals = view.spans[r].values;
+                size_t n = view.spans[r].length;
+                if (agg == AG_AGG_SUM || agg == AG_AGG_MEAN) {
+                    sum += k->sum(vals, n);
+                } else if (agg == AG_AGG_MIN) {
+                    double m = k->min(vals, n);
+                    min = (m < min) ? m : min;
+                } else if (agg == AG_AGG_MAX) {
+                    double m = k->max(vals, n);
+                    max = (m > max) ? m : max;
+                }
+            }
+        } else {
+            /* Unordered window: masked reduction over each run */
+            size_t offset[2];
+            size_t length[2];
+            size_t runs = window_segments(ts, w, offset, length);
+
+            for (size_t r = 0; r < runs; r++) {
+                const int64_t* run = ts->timestamps + offset[r];
+                const double* vals = ts->values + offset[r];
+                if (agg == AG_AGG_MIN) {
+                    double m = k->min_in(run, vals, length[r], start_ms, end_ms, &count);
+                    min = (m < min) ? m : min;
+                } else if (agg == AG_AGG_MAX) {
+                    double m = k->max_in(run, vals, length[r], start_ms, end_ms, &count);
+                    max = (m > max) ? m : max;
+                } else {
+                    sum += k->sum_in(run, vals, length[r], start_ms, end_ms, &count);
+                }
+            }
+        }
+
+        if (!read_intact(ts, w, first_seq, &guard)) {
+            continue;
+        }
+        /* Located spans hold only matches; unordered windows are scanned whole */
+        METRICS_QUERY(ts, metrics_start,
+                      (start_ms > end_ms || window_ordered(ts, w))
+                          ? count : (size_t)(w.end - w.begin),
+                      count);
+
+        switch (agg) {
+        case AG_AGG_COUNT:
+            *out_value = (double)count;
+            return AG_OK;
+        case AG_AGG_SUM:
+            *out_value = sum;
+            return AG_OK;
+        case AG_AGG_MEAN:
+            if (count == 0) {
+                return AG_ERR_EMPTY;
+            }
+            *out_value = sum / (double)count;
+            return AG_OK;
+        case AG_AGG_MIN:
+            if (count == 0) {
+                return AG_ERR_EMPTY;
+            }
+            *out_value = min;
+            return AG_OK;
+        default:
+            if (count == 0) {
+                return AG_ERR_EMPTY;
+            }
+            *out_value = max;
+            return AG_OK;
+        }
+    }
+}
+
+int ag_timeseries_query_buckets(
+    const ag_timeseries_t* ts,
+    int64_t start_ms,
+    int64_t end_ms,
+    int64_t bucket_ms,
+    ag_timeseries_bucket_t* out_buckets,
+    size_t max_buckets,
+    size_t* out_count
+) {
+    /* Validate inputs */
+    if (ts == NULL || out_buckets == NULL || out_count == NULL || bucket_ms <= 0) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    METRICS_QUERY_START(metrics_start);
+    uint64_t guard = 0;
+    for (;;) {
+        ring_window_t w = load_window(ts, guard);
+        size_t nb = 0;
+
+        /* Single pass needs points in time order */
+        if (!window_ordered(ts, w)) {
+            return AG_ERR_UNORDERED;
+        }
+
+        ag_timeseries_view_t view;
+        uint64_t first_seq = w.begin;
+        if (start_ms <= end_ms && max_buckets > 0) {
+            first_seq = ag_timeseries_locate_range(ts, w, start_ms, end_ms, &view);
+        } else {
+            view.span_count = 0;
+        }
+
+        ag_timeseries_bucket_t* b = NULL;
+        size_t stride = ts->stride;
+        for (size_t r = 0; r < view.span_count; r++) {
+            const int64_t* run = view.spans[r].timestamps;
+            size_t slot = (size_t)(run - ts->timestamps) / stride;
+
+            for (size_t i = 0; i < view.spans[r].length; i++) {
+                int64_t t = run[i * stride];
+                double v = slot_value(ts, slot + i);
+
+                /* Open a new bucket when t crosses the current one's end */
+                if (b == NULL ||
+                    (uint64_t)t - (uint64_t)b->start_ms >= (uint64_t)bucket_ms) {
+                    if (nb == max_buckets) {
+                        goto done;
+                    }
+                    b = &out_buckets[nb++];
+                    b->start_ms = bucket_floor(t, bucket_ms);
+                    b->open = v;
+                    b->high = v;
+                    b->low = v;
+                    b->close = v;
+                    b->count = 1;
+                    continue;
+                }
+
+                b->high = (v > b->high) ? v : b->high;
+                b->low = (v < b->low) ? v : b->low;
+                b->close = v;
+                b->count++;
+            }
+        }
+
+done:
+        if (read_intact(ts, w, first_seq, &guard)) {
+            *out_count = nb;
+            METRICS_QUERY(ts, metrics_start, (view.span_count > 0) ? view.length : 0,
+                          (view.span_count > 0) ? view.length : 0);
+            return AG_OK;
+        }
+    }
+}
+
+const char* ag_timeseries_simd_name(void) {
+    return ag_kernels_get()->name;
+}
+
+int ag_timeseries_enable_stats(ag_timeseries_t* ts) {
+    /* Readers cannot follow the writer's appends */
+    if (ts == NULL || ts->readonly) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    if (ts->stats != NULL) {
+        return AG_OK;
+    }
+
+    stats_state_t* st = (stats_state_t*)calloc(1, sizeof(stats_state_t));
+    if (st == NULL) {
+        return AG_ERR_NOMEM;
+    }
+    st->min.seqs = (uint64_t*)malloc(ts->capacity * sizeof(uint64_t));
+    st->max.seqs = (uint64_t*)malloc(ts->capacity * sizeof(uint64_t));
+    if (st->min.seqs == NULL || st->max.seqs == NULL) {
+        free(st->min.seqs);
+        free(st->max.seqs);
+        free(st);
+        return AG_ERR_NOMEM;
+    }
+    atomic_init(&st->version, 0);
+
+    /* Seed from points already stored */
+    ts->stats = st;
+    ring_window_t w = load_window(ts, 0);
+    st->begin_seq = w.begin;
+    st->end_seq = w.begin;
+    stats_push(ts, w.begin, w.end);
+
+    return AG_OK;
+}
+
+int ag_timeseries_stats(const ag_timeseries_t* ts, ag_timeseries_stats_t* out_stats) {
+    if (ts == NULL || out_stats == NULL || ts->stats == NULL) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    const stats_state_t* st = ts->stats;
+    for (;;) {
+        uint64_t version = seq_load(&st->version, memory_order_acquire);
+        if (version & 1) {
+            continue;  /* SPMC writer mid-update */
+        }
+
+        size_t count = (size_t)(st->end_seq - st->begin_seq);
+        double sum = st->sum.sum;
+        double sum_sq = st->sum_sq.sum;
+        double shift = st->shift;
+        double min = 0.0;
+        double max = 0.0;
+        if (st->min.count > 0 && st->max.count > 0) {
+            min = slot_value(ts, slot_of(ts, st->min.seqs[st->min.front]));
+            max = slot_value(ts, slot_of(ts, st->max.seqs[st->max.front]));
+        }
+
+        atomic_thread_fence(memory_order_acquire);
+        if (seq_load(&st->version, memory_order_relaxed) != version) {
+            continue;
+        }
+
+        if (count == 0) {
+            return AG_ERR_EMPTY;
+        }
+
+        /* Moments of v - shift first: no cancellation at the price level */
+        double n = (double)count;
+        double mean_d = sum / n;
+        double variance = sum_sq / n - mean_d * mean_d;
+
+        out_stats->count = count;
+        out_stats->sum = shift * n + sum;
+        out_stats->sum_sq = shift * (shift * n + 2.0 * sum) + sum_sq;
+        out_stats->mean = shift + mean_d;
+        out_stats->variance = (variance > 0.0) ? variance : 0.0;
+        out_stats->min = min;
+        out_stats->max = max;
+        return AG_OK;
+    }
+}
+
+int ag_timeseries_enable_quantiles(ag_timeseries_t* ts, double relative_accuracy,
+                                   double min_value, double max_value) {
+    /* Readers cannot follow the writer's appends */
+    if (ts == NULL || ts->readonly) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    if (ts->quantiles != NULL) {
+        return AG_OK;
+    }
+
+    if (ag_sketch_bins(relative_accuracy, min_value, max_value) == 0) {
+        return AG_ERR_INVALID_ARG;
+    }
+    ag_timeseries_sketch_t* sketch = ag_timeseries_sketch_create(relative_accuracy,
+                                                                 min_value, max_value);
+    if (sketch == NULL) {
+        return AG_ERR_NOMEM;
+    }
+    quantile_state_t* qst = (quantile_state_t*)malloc(sizeof(quantile_state_t));
+    if (qst == NULL) {
+        ag_timeseries_sketch_destroy(sketch);
+        return AG_ERR_NOMEM;
+    }
+    qst->sketch = sketch;
+
+    /* Seed from points already stored */
+    ts->quantiles = qst;
+    ring_window_t w = load_window(ts, 0);
+    qst->begin_seq = w.begin;
+    qst->end_seq = w.begin;
+    quantile_push(ts, w.begin, w.end);
+    return AG_OK;
+}
+
+int ag_timeseries_quantiles(const ag_timeseries_t* ts, const double* qs, size_t n,
+                            double* out_values) {
+    if (ts == NULL || ts->quantiles == NULL) {
+        return AG_ERR_INVALID_ARG;
+    }
+    return ag_timeseries_sketch_quantiles(ts->quantiles->sketch, qs, n, out_values);
+}
+
+int ag_timeseries_sketch_merge_series(ag_timeseries_sketch_t* dst, const ag_timeseries_t* ts) {
+    if (ts == NULL || ts->quantiles == NULL) {
+        return AG_ERR_INVALID_ARG;
+    }
+    return ag_timeseries_sketch_merge(dst, ts->quantiles->sketch);
+}
+
+size_t ag_timeseries_size(const ag_timeseries_t* ts) {
+    if (ts == NULL) {
+        return 0;
+    }
+    ring_window_t w = load_window(ts, 0);
+    return (size_t)(w.end - w.begin);
+}
+
+uint64_t ag_timeseries_sequence(const ag_timeseries_t* ts) {
+    if (ts == NULL) {
+        return 0;
+    }
+    return seq_load(&ts->ctl->appended, memory_order_acquire);
+}
+
+/* The inline header's mirror must match the handle field for field */
+#define AG_INLINE_MIRRORS(type, field) \
+    _Static_assert(offsetof(type, field) == offsetof(ag_ts_inline_layout_t, field) && \
+                   sizeof(((type*)0)->field) == sizeof(((ag_ts_inline_layout_t*)0)->field), \
+                   "ag_timeseries_inline.h out of date: " #field)
+AG_INLINE_MIRRORS(struct ag_timeseries_t, capacity);
+AG_INLINE_MIRRORS(struct ag_timeseries_t, mask);
+AG_INLINE_MIRRORS(struct ag_timeseries_t, head);
+AG_INLINE_MIRRORS(struct ag_timeseries_t, pow2);
+AG_INLINE_MIRRORS(struct ag_timeseries_t, spmc);
+AG_INLINE_MIRRORS(struct ag_timeseries_t, readonly);
+AG_INLINE_MIRRORS(struct ag_timeseries_t, ctl);
+AG_INLINE_MIRRORS(struct ag_timeseries_t, stride);
+AG_INLINE_MIRRORS(struct ag_timeseries_t, timestamps);
+AG_INLINE_MIRRORS(struct ag_timeseries_t, values);
+AG_INLINE_MIRRORS(struct ag_timeseries_t, stats);
+AG_INLINE_MIRRORS(struct ag_timeseries_t, persist);
+AG_INLINE_MIRRORS(struct ag_timeseries_t, cold);
+AG_INLINE_MIRRORS(struct ag_timeseries_t, rollups);
+AG_INLINE_MIRRORS(struct ag_timeseries_t, reorder);
+AG_INLINE_MIRRORS(struct ag_timeseries_t, quantiles);
+AG_INLINE_MIRRORS(struct ag_timeseries_t, ttl_ms);
+_Static_assert(offsetof(ring_ctl_t, appended) == offsetof(ag_ts_inline_ctl_t, appended) &&
+               offsetof(ring_ctl_t, claimed) == offsetof(ag_ts_inline_ctl_t, claimed) &&
+               offsetof(ring_ctl_t, ordered_from) == offsetof(ag_ts_inline_ctl_t, ordered_from) &&
+               offsetof(ring_ctl_t, expired) == offsetof(ag_ts_inline_ctl_t, expired),
+               "ag_timeseries_inline.h out of date: ring_ctl_t");
+
+int ag_timeseries_inline_abi(void) {
+    return AG_TIMESERIES_INLINE_ABI;
+}
+
+size_t ag_timeseries_capacity(const ag_timeseries_t* ts) {
+    if (ts == NULL) {
+        return 0;
+    }
+    return ts->capacity;
+}
+
+int ag_timeseries_value_type(const ag_timeseries_t* ts) {
+    if (ts == NULL) {
+        return -1;
+    }
+    return ts->vtype;
+}
+
+int ag_timeseries_enable_rollups(
+    ag_timeseries_t* ts,
+    const ag_rollup_level_t* levels,
+    size_t level_count
+) {
+    /* Rollups are fed outside the SPMC publish protocol */
+    if (ts == NULL || levels == NULL || ts->spmc || ts->readonly || ts->rollups != NULL) {
+        return AG_ERR_INVALID_ARG;
+    }
+    if (level_count == 0 || level_count > AG_ROLLUP_MAX_LEVELS) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    /* Widths must nest so every child bucket lies inside one parent */
+    for (size_t k = 0; k < level_count; k++) {
+        if (levels[k].bucket_ms <= 0 || levels[k].capacity == 0 ||
+            levels[k].capacity > SIZE_MAX / sizeof(ag_timeseries_rollup_t)) {
+            return AG_ERR_INVALID_ARG;
+        }
+        if (k > 0 && (levels[k].bucket_ms <= levels[k - 1].bucket_ms ||
+                      levels[k].bucket_ms % levels[k - 1].bucket_ms != 0)) {
+            return AG_ERR_INVALID_ARG;
+        }
+    }
+
+    ts->rollups = ag_rollup_create(levels, level_count);
+    if (ts->rollups == NULL) {
+        return AG_ERR_NOMEM;
+    }
+    return AG_OK;
+}
+
+/* Helper: Raw points in range as count-1 rollup points, if they fit */
+static int rollup_from_raw(const ag_timeseries_t* ts, int64_t start_ms, int64_t end_ms,
+                           size_t max_points, ag_timeseries_rollup_t* out_points,
+                           size_t* out_count) {
+    ring_window_t w = load_window(ts, 0);
+    if (w.end == w.begin || !window_ordered(ts, w)) {
+        return 0;
+    }
+
+    /* Coverage: nothing evicted yet, or the oldest point is not after start */
+    if (w.begin > 0 && slot_time(ts, slot_of(ts, w.begin)) > start_ms) {
+        return 0;
+    }
+
+    ag_timeseries_view_t view;
+    ag_timeseries_locate_range(ts, w, start_ms, end_ms, &view);
+    if (view.length > max_points) {
+        return 0;
+    }
+
+    size_t n = 0;
+    for (size_t r = 0; r < view.span_count; r++) {
+        size_t slot = (size_t)(view.spans[r].timestamps - ts->timestamps) / ts->stride;
+        for (size_t i = 0; i < view.spans[r].length; i++) {
+            double v = slot_value(ts, slot + i);
+            ag_timeseries_rollup_t* p = &out_points[n++];
+            p->start_ms = view.spans[r].timestamps[i * ts->stride];
+            p->last = v;
+            p->mean = v;
+            p->min = v;
+            p->max = v;
+            p->count = 1;
+        }
+    }
+    *out_count = n;
+    return 1;
+}
+
+int ag_timeseries_query_rollup(
+    const ag_timeseries_t* ts,
+    int64_t start_ms,
+    int64_t end_ms,
+    size_t max_points,
+    ag_timeseries_rollup_t* out_points,
+    size_t* out_count,
+    int64_t* out_bucket_ms
+) {
+    /* Validate inputs */
+    if (ts == NULL || out_points == NULL || out_count == NULL ||
+        ts->rollups == NULL || start_ms > end_ms) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    *out_count = 0;
+    if (out_bucket_ms != NULL) {
+        *out_bucket_ms = 0;
+    }
+
+    /* Finest first: raw ring */
+    if (rollup_from_raw(ts, start_ms, end_ms, max_points, out_points, out_count)) {
+        return AG_OK;
+    }
+
+    /* Then each level; the coarsest answers if nothing fits */
+    size_t levels = ag_rollup_levels(ts->rollups);
+    size_t k = 0;
+    for (; k + 1 < levels; k++) {
+        int covers;
+        size_t n = ag_rollup_count(ts->rollups, k, start_ms, end_ms, &covers);
+        if (covers && n <= max_points) {
+            break;
+        }
+    }
+
+    *out_count = ag_rollup_copy(ts->rollups, k, start_ms, end_ms, max_points, out_points);
+    if (out_bucket_ms != NULL) {
+        *out_bucket_ms = ag_rollup_bucket_ms(ts->rollups, k);
+    }
+    return AG_OK;
+}
+
+int ag_timeseries_enable_cold(ag_timeseries_t* ts, size_t budget_bytes) {
+    /* Cold queries run outside the SPMC snapshot protocol */
+    if (ts == NULL || ts->spmc || ts->readonly) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    if (ts->cold != NULL) {
+        return AG_OK;
+    }
+
+    if (budget_bytes < ag_cold_min_budget()) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    ts->cold = ag_cold_create(budget_bytes);
+    if (ts->cold == NULL) {
+        return AG_ERR_NOMEM;
+    }
+    return AG_OK;
+}
+
+int ag_timeseries_cold_stats(const ag_timeseries_t* ts, ag_timeseries_cold_stats_t* out_stats) {
+    if (ts == NULL || out_stats == NULL || ts->cold == NULL) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    ag_cold_stats(ts->cold, out_stats);
+    return AG_OK;
+}
+
+int ag_timeseries_enable_reorder(ag_timeseries_t* ts, int64_t window_ms, size_t max_points) {
+    /* Validate inputs */
+    if (ts == NULL || ts->readonly || ts->reorder != NULL) {
+        return AG_ERR_INVALID_ARG;
+    }
+    if (window_ms < 0 || max_points == 0 ||
+        max_points >= SIZE_MAX / (sizeof(int64_t) + sizeof(double))) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    /* Points older than the newest stored one would break the order */
+    int64_t floor_ms = INT64_MIN;
+    if (seq_load(&ts->ctl->appended, memory_order_relaxed) > 0) {
+        floor_ms = slot_time(ts, (ts->head == 0) ? ts->capacity - 1 : ts->head - 1);
+    }
+
+    ts->reorder = ag_reorder_create(window_ms, max_points, floor_ms);
+    if (ts->reorder == NULL) {
+        return AG_ERR_NOMEM;
+    }
+    return AG_OK;
+}
+
+int ag_timeseries_flush_reorder(ag_timeseries_t* ts) {
+    if (ts == NULL || ts->reorder == NULL) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    reorder_release(ts, 1);
+    return AG_OK;
+}
+
+int ag_timeseries_reorder_stats(const ag_timeseries_t* ts,
+                                ag_timeseries_reorder_stats_t* out_stats) {
+    if (ts == NULL || out_stats == NULL || ts->reorder == NULL) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    ag_reorder_stats(ts->reorder, out_stats);
+    return AG_OK;
+}
+
+int ag_timeseries_is_monotonic(const ag_timeseries_t* ts) {
+    if (ts == NULL) {
+        return 0;
+    }
+    return window_ordered(ts, load_window(ts, 0));
+}
+
+int ag_timeseries_set_ttl(ag_timeseries_t* ts, int64_t ttl_ms) {
+    /* Validate inputs */
+    if (ts == NULL || ts->readonly || ttl_ms < 0) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    ts->ttl_ms = ttl_ms;
+    return AG_OK;
+}
+
+size_t ag_timeseries_expire(ag_timeseries_t* ts, int64_t now_ms) {
+    if (ts == NULL || ts->readonly || ts->ttl_ms == 0) {
+        return 0;
+    }
+    return expire_before(ts, ttl_cutoff(now_ms, ts->ttl_ms));
+}
+
+/* Helper: Copy ring slots [from, from + n) to slots [to, to + n) of new storage */
+static void resize_copy(const ag_timeseries_t* ts, int64_t* timestamps, void* cells,
+                        size_t from, size_t to, size_t n) {
+    if (ts->stride == 2) {
+        /* Interleaved: pairs move together */
+        memcpy(timestamps + to * 2, ts->timestamps + from * 2, n * 2 * sizeof(int64_t));
+        return;
+    }
+    memcpy(timestamps + to, ts->timestamps + from, n * sizeof(int64_t));
+    memcpy((unsigned char*)cells + to * ts->vsize,
+           (const unsigned char*)ts->cells + from * ts->vsize, n * ts->vsize);
+}
+
+/* Helper: Copy deque entries to 'seqs' from index 0, front first */
+static void resize_deque(mono_deque_t* dq, size_t capacity, uint64_t* seqs) {
+    size_t at = dq->front;
+    for (size_t i = 0; i < dq->count; i++) {
+        seqs[i] = dq->seqs[at];
+        at = advance_index(at, capacity);
+    }
+    free(dq->seqs);
+    dq->seqs = seqs;
+    dq->front = 0;
+}
+
+int ag_timeseries_resize(ag_timeseries_t* ts, size_t new_capacity) {
+    /* Validate inputs: only heap rings this handle owns alone can move */
+    if (ts == NULL || ts->readonly || ts->external || ts->spmc ||
+        ts->persist != NULL || ts->shm != NULL || ts->mapped != 0) {
+        return AG_ERR_INVALID_ARG;
+    }
+    if (new_capacity == 0 || new_capacity > SIZE_MAX / sizeof(int64_t) ||
+        (ts->stride == 2 && new_capacity > (SIZE_MAX - AG_CACHE_LINE) / (2 * sizeof(int64_t)))) {
+        return AG_ERR_INVALID_ARG;
+    }
+    if (new_capacity == ts->capacity) {
+        return AG_OK;
+    }
+
+    /* Allocate everything first, so failure leaves the buffer untouched */
+    int64_t* timestamps;
+    void* cells = NULL;
+    if (ts->stride == 2) {
+        size_t bytes = (new_capacity * 2 * sizeof(int64_t) + AG_CACHE_LINE - 1) &
+                       ~(size_t)(AG_CACHE_LINE - 1);
+        timestamps = (int64_t*)aligned_alloc(AG_CACHE_LINE, bytes);
+        if (timestamps != NULL) {
+            memset(timestamps, 0, bytes);
+        }
+    } else {
+        timestamps = (int64_t*)calloc(new_capacity, sizeof(int64_t));
+        cells = calloc(new_capacity, ts->vsize);
+    }
+    uint64_t* min_seqs = NULL;
+    uint64_t* max_seqs = NULL;
+    if (ts->stats != NULL) {
+        min_seqs = (uint64_t*)malloc(new_capacity * sizeof(uint64_t));
+        max_seqs = (uint64_t*)malloc(new_capacity * sizeof(uint64_t));
+    }
+    if (timestamps == NULL || (ts->stride == 1 && cells == NULL) ||
+        (ts->stats != NULL && (min_seqs == NULL || max_seqs == NULL))) {
+        /* Cleanup on partial allocation failure */
+        free(timestamps);
+        free(cells);
+        free(min_seqs);
+        free(max_seqs);
+        return AG_ERR_NOMEM;
+    }
+
+    /* Shrinking keeps the newest points; the rest leave as if overwritten */
+    uint64_t end = seq_load(&ts->ctl->appended, memory_order_relaxed);
+    uint64_t begin = ring_begin(ts, end);
+    uint64_t keep = (end - begin > new_capacity) ? end - new_capacity : begin;
+    if (ts->cold != NULL) {
+        for (uint64_t seq = begin; seq < keep; seq++) {
+            size_t slot = slot_of(ts, seq);
+            ag_cold_push(ts->cold, slot_time(ts, slot), slot_value(ts, slot));
+        }
+    }
+    if (ts->stats != NULL) {
+        stats_drop(ts, keep);
+        resize_deque(&ts->stats->min, ts->capacity, min_seqs);
+        resize_deque(&ts->stats->max, ts->capacity, max_seqs);
+    }
+    if (ts->quantiles != NULL) {
+        quantile_drop(ts, keep);
+    }
+    METRICS_APPEND(ts, 0, keep - begin);
+
+    /*
+     * Point s stays at slot s % capacity, so sequences keep their meaning
+     * for cursors, stats and ordering. [keep, end) is at most two runs in
+     * either ring, hence at most three copies per column.
+     */
+    for (uint64_t seq = keep; seq < end;) {
+        size_t from = slot_of(ts, seq);
+        size_t to = (size_t)(seq % new_capacity);
+        size_t n = (size_t)(end - seq);
+        if (n > ts->capacity - from) {
+            n = ts->capacity - from;
+        }
+        if (n > new_capacity - to) {
+            n = new_capacity - to;
+        }
+        resize_copy(ts, timestamps, cells, from, to, n);
+        seq += n;
+    }
+
+    /* Install the new storage */
+    free(ts->timestamps);
+    if (ts->stride == 1) {
+        free(ts->cells);
+        ts->cells = cells;
+        ts->values = (ts->vtype == AG_VALUE_F64) ? (double*)cells : NULL;
+    } else {
+        ts->cells = (double*)timestamps + 1;
+        ts->values = (double*)timestamps + 1;
+    }
+    ts->timestamps = timestamps;
+    ts->capacity = new_capacity;
+    ts->pow2 = (new_capacity & (new_capacity - 1)) == 0;
+    ts->mask = ts->pow2 ? new_capacity - 1 : 0;
+    ts->head = slot_of(ts, end);
+
+    /* Growing: sequences below 'keep' were never copied, keep them out of the window */
+    atomic_store_explicit(&ts->ctl->expired, keep, memory_order_relaxed);
+    return AG_OK;
 }
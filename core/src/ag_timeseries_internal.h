@@ -0,0 +1,643 @@
+/*
+ * ag_timeseries_internal.h - Internal Ring Buffer Layout
+ *
+ * Purpose: Shares the ag_timeseries_t definition and the lock-free window
+ *          helpers between the core translation units (series, registry).
+ *
+ * Not part of the public API - layout may change between any two versions.
+ *
+ * Copyright (c) 2025 AlgorithmicGrid
+ */
+
+#ifndef AG_TIMESERIES_INTERNAL_H
+#define AG_TIMESERIES_INTERNAL_H
+
+#include "ag_timeseries.h"
+#include "ag_cold.h"
+#include "ag_rollup.h"
+#include "ag_reorder.h"
+#include <stdatomic.h>
+#include <math.h>
+#include <string.h>
+
+/* Compensated (Kahan) running sum */
+typedef struct {
+    double sum;         /* Running total */
+    double comp;        /* Lost low-order bits */
+} kahan_t;
+
+/*
+ * Monotonic deque of sequence numbers for sliding-window min or max.
+ * Stored as a ring of 'capacity' entries; values are read from the series.
+ */
+typedef struct {
+    uint64_t* seqs;     /* Candidate sequences, front is the extreme */
+    size_t front;       /* Index of front entry */
+    size_t count;       /* Number of entries */
+} mono_deque_t;
+
+/*
+ * Rolling stats state, allocated by ag_timeseries_enable_stats().
+ *
+ * Covers window [begin_seq, end_seq), the ring's window. Sums are of
+ * v - shift, so the variance of a small spread at a large price level
+ * keeps its precision. The shift is re-based to the oldest value (and
+ * the sums recomputed) whenever begin_seq passes rebase_seq, once per
+ * capacity of advance, so it follows a drifting level. In SPMC mode
+ * 'version' is odd while the writer updates, so readers can take a
+ * consistent snapshot (seqlock).
+ */
+typedef struct {
+    kahan_t sum;                /* Sum of (v - shift) in window */
+    kahan_t sum_sq;             /* Sum of (v - shift)^2 in window */
+    double shift;               /* Offset K of the sums, a recent window value */
+    uint64_t rebase_seq;        /* Re-base the shift once begin_seq reaches this */
+    mono_deque_t min;           /* Non-decreasing values, front is min */
+    mono_deque_t max;           /* Non-increasing values, front is max */
+    uint64_t begin_seq;         /* Oldest point included */
+    uint64_t end_seq;           /* One past newest point included */
+    _Atomic uint64_t version;   /* Seqlock version (SPMC only) */
+} stats_state_t;
+
+/*
+ * Window quantile sketch, allocated by ag_timeseries_enable_quantiles().
+ * Counts the values of sequences [begin_seq, end_seq), the ring window;
+ * like the stats window it is trimmed before slots are overwritten.
+ */
+typedef struct {
+    ag_timeseries_sketch_t* sketch; /* Counts (readers walk them lock-free) */
+    uint64_t begin_seq;             /* Oldest point counted */
+    uint64_t end_seq;               /* One past newest point counted */
+} quantile_state_t;
+
+/*
+ * Header page of a file-backed ring (ag_timeseries_open_mmap).
+ *
+ * File Layout:
+ *   [header, AG_PERSIST_HEADER_SIZE bytes][timestamps][values]
+ *
+ * The writer mirrors its counters here around every append: 'claimed'
+ * before touching slots, 'appended' and 'ordered_from' after, and
+ * 'expired' whenever a TTL drops points early. A process
+ * killed mid-append therefore leaves claimed != appended, and recovery
+ * drops the slots it may have overwritten (same rule as SPMC readers).
+ * 'data_checksum' covers counters and arrays, and is only meaningful while
+ * 'clean' is set (by ag_timeseries_sync and destroy).
+ */
+#define AG_PERSIST_MAGIC        "AGTSRING"
+#define AG_PERSIST_VERSION      2u
+#define AG_PERSIST_HEADER_SIZE  4096u
+
+typedef struct {
+    char magic[8];                  /* AG_PERSIST_MAGIC, not NUL-terminated */
+    uint32_t version;               /* AG_PERSIST_VERSION */
+    uint32_t header_size;           /* AG_PERSIST_HEADER_SIZE */
+    uint64_t capacity;              /* Points per array */
+    uint64_t header_checksum;       /* Over the fields above */
+    _Atomic uint64_t claimed;       /* End sequence of the append in progress */
+    _Atomic uint64_t appended;      /* Published number of points */
+    _Atomic uint64_t ordered_from;  /* Sequence of the last out-of-order point */
+    _Atomic uint64_t clean;         /* 1 if data_checksum is current */
+    uint64_t data_checksum;         /* Counters and arrays at last sync */
+    _Atomic uint64_t expired;       /* Points below this sequence expired (TTL) */
+} persist_header_t;
+
+/*
+ * Ring counters (see the protocol below). A handle points at its own copy,
+ * except shared-memory rings, whose writer and readers all use the copy in
+ * the segment header.
+ */
+typedef struct {
+    _Atomic uint64_t appended;      /* Published number of points ever appended */
+    _Atomic uint64_t claimed;       /* Sequence writer may be writing (SPMC only) */
+    _Atomic uint64_t ordered_from;  /* Sequence of the last out-of-order point */
+    _Atomic uint64_t expired;       /* Points below this sequence dropped early (TTL, resize) */
+} ring_ctl_t;
+
+/*
+ * Header page of a shared-memory ring (ag_timeseries_create_shm). Stable
+ * binary layout, documented in ag_timeseries.h for non-C readers.
+ *
+ * Segment Layout:
+ *   [header, AG_SHM_HEADER_SIZE bytes][timestamps][values]
+ *
+ * 'state' is stored last (release) when the writer has initialized the
+ * segment, so a reader that sees AG_SHM_LIVE also sees valid identity
+ * fields. 'ctl' is the ring's only copy of its counters.
+ */
+#define AG_SHM_MAGIC        "AGTSSHM1"
+#define AG_SHM_VERSION      1u
+#define AG_SHM_HEADER_SIZE  4096u
+
+#define AG_SHM_INIT     0u      /* Writer still initializing */
+#define AG_SHM_LIVE     1u      /* Writer attached */
+#define AG_SHM_CLOSED   2u      /* Writer destroyed its handle */
+
+typedef struct {
+    char magic[8];                  /* AG_SHM_MAGIC, not NUL-terminated */
+    uint32_t version;               /* AG_SHM_VERSION */
+    uint32_t header_size;           /* AG_SHM_HEADER_SIZE */
+    uint64_t capacity;              /* Points per array */
+    _Atomic uint64_t state;         /* AG_SHM_INIT / LIVE / CLOSED */
+    uint64_t writer_pid;            /* Process that created the segment */
+    _Alignas(64) ring_ctl_t ctl;    /* Counters, own cache line at offset 64 */
+} shm_header_t;
+
+/* Process-local mapping of a shared-memory ring */
+typedef struct {
+    shm_header_t* header;           /* Start of the mapping */
+    size_t size;                    /* Mapping length */
+    char* name;                     /* Segment name, writer only (unlinked on destroy) */
+} shm_link_t;
+
+#ifdef AG_METRICS
+/* Latency histogram; fields mirror ag_timeseries_histogram_t (count = queries) */
+typedef struct {
+    _Atomic uint64_t sum_ns;
+    _Atomic uint64_t max_ns;
+    _Atomic uint64_t buckets[AG_METRICS_BUCKETS];
+} metrics_hist_t;
+
+/* Appends a series accumulates before folding them into the global totals */
+#define METRICS_FOLD 1024
+
+/*
+ * Instrumentation counters (AG_METRICS builds only); fields mirror
+ * ag_timeseries_metrics_t. 'appends' and 'overwrites' have one writer per
+ * series, the query fields are bumped by every reader thread. The writer
+ * adds its counts to the global totals every METRICS_FOLD appends (a
+ * shared atomic add per point would triple append cost) and on release.
+ */
+typedef struct {
+    _Atomic uint64_t appends;
+    _Atomic uint64_t overwrites;
+    _Atomic uint64_t queries;
+    _Atomic uint64_t points_scanned;
+    _Atomic uint64_t points_returned;
+    _Atomic uint64_t retries;
+    metrics_hist_t query_latency;
+    uint64_t folded_appends;        /* Writer only: part of appends in the totals */
+    uint64_t folded_overwrites;     /* Writer only: part of overwrites in the totals */
+} metrics_state_t;
+#endif
+
+/*
+ * Internal structure - opaque to users
+ *
+ * Ring Buffer Layout:
+ *   [0] [1] [2] ... [capacity-1]
+ *    ^               ^
+ *    oldest         head (next write position)
+ *
+ * Every append is numbered by its sequence (0, 1, 2, ...). 'appended' is
+ * the published count of points ever written; the point with sequence s
+ * lives at slot s % capacity (s & mask for power-of-two capacities), and
+ * the visible window is the last min(appended, capacity) sequences.
+ * 'head' caches the slot of appended for the writer so append never divides.
+ * Since the sequence never wraps, readers can tell exactly how many points
+ * were overwritten between two observations.
+ *
+ * Storage:
+ *   Slot i keeps its timestamp at timestamps[i * stride] and its value at
+ *   values[i * stride]. Split buffers (stride 1) own two arrays; interleaved
+ *   buffers (stride 2) own one 64-byte-aligned block of {timestamp, value}
+ *   pairs, with 'values' pointing one element past 'timestamps'.
+ *   'cells' is the value column in its own type (vtype): equal to 'values'
+ *   for double series; typed series (ag_timeseries_create_typed) keep a
+ *   split array of vsize-byte cells there and set 'values' to NULL.
+ *
+ * Invariants:
+ *   - head == appended % capacity
+ *   - size == appended - max(appended - capacity, expired), clamped at 0
+ *   - claimed == appended except while an SPMC append is in progress
+ *
+ * Ordering:
+ *   When a point is older than its predecessor, 'ordered_from' is set to
+ *   its sequence. The stored window is non-decreasing in time once every
+ *   point before that one has been evicted, i.e. when the oldest stored
+ *   sequence >= ordered_from.
+ *
+ * Expiry:
+ *   The writer raises 'expired' past points older than the TTL, and past
+ *   sequences a resize did not copy (private rings only). Their
+ *   slots stay untouched until overwritten, so a reader holding an older
+ *   'expired' still copies valid points; readers load 'expired' before
+ *   'appended' so the window never inverts.
+ *
+ * SPMC Protocol (seqlock-style, readers never block the writer):
+ *   Writer: claimed = s + 1; release fence; write slot; appended = s + 1 (release)
+ *   Reader: load appended (acquire); copy slots; acquire fence; load claimed.
+ *   Slots of sequences < claimed - capacity may have been overwritten while
+ *   copying, so the copy is kept only if its oldest sequence is above that.
+ */
+struct ag_timeseries_t {
+    size_t capacity;                /* Maximum number of points */
+    size_t mask;                    /* capacity - 1 if power of two, else 0 */
+    size_t head;                    /* Next write position (writer only) */
+    int pow2;                       /* Capacity is a power of two */
+    int spmc;                       /* Single-producer/multi-consumer mode */
+    int external;                   /* Handle and arrays owned by a registry */
+    int readonly;                   /* Shared-memory reader or mseries column: no writes */
+    ring_ctl_t* ctl;                /* Counters: &local, or a shared segment's */
+    size_t stride;                  /* Elements between slots: 1 split, 2 interleaved */
+    int64_t* timestamps;            /* Timestamp array */
+    double* values;                 /* Value array (NULL for typed series) */
+    void* cells;                    /* Value column in its own type */
+    int vtype;                      /* AG_VALUE_* column type */
+    size_t vsize;                   /* Bytes per cell */
+    stats_state_t* stats;           /* Rolling stats, NULL unless enabled */
+    persist_header_t* persist;      /* File header, NULL unless file-backed */
+    cold_tier_t* cold;              /* Compressed evictions, NULL unless enabled */
+    rollup_chain_t* rollups;        /* Downsampled children, NULL unless enabled */
+    reorder_buf_t* reorder;         /* Staged late points, NULL unless enabled */
+    quantile_state_t* quantiles;    /* Window sketch, NULL unless enabled */
+    int64_t ttl_ms;                 /* Max point age kept on append, 0 = no TTL */
+    shm_link_t* shm;                /* Shared segment, NULL unless shared */
+    size_t mapped;                  /* Page mapping length (create_ex), else 0 */
+    ring_ctl_t local;               /* Counters of process-local rings */
+#ifdef AG_METRICS
+    metrics_state_t metrics;        /* Instrumentation (AG_METRICS builds only) */
+#endif
+};
+
+/*
+ * Instrumentation hooks (ag_metrics.c). They expand to nothing unless the
+ * library is built with -DAG_METRICS, so their arguments must not carry
+ * side effects.
+ *
+ *   METRICS_APPEND(ts, points, evicted) - writer handed 'points' to the
+ *                                         ring, 'evicted' left the window
+ *   METRICS_RELEASE(ts)                 - series goes away: fold its
+ *                                         pending appends into the totals
+ *   METRICS_QUERY_START(var)            - declare uint64_t 'var' = now
+ *   METRICS_QUERY(ts, var, scanned, returned)
+ *                                       - one read call finished
+ *   METRICS_RETRY(ts)                   - a lock-free read is repeated
+ */
+#ifdef AG_METRICS
+uint64_t ag_metrics_now(void);
+void ag_metrics_fold(ag_timeseries_t* ts);
+void ag_metrics_query(const ag_timeseries_t* ts, uint64_t start_ns,
+                      uint64_t scanned, uint64_t returned);
+void ag_metrics_retry(const ag_timeseries_t* ts);
+
+/* Helper: Count appended and evicted points (writer thread only) */
+static inline void metrics_append(ag_timeseries_t* ts, uint64_t points, uint64_t evicted) {
+    metrics_state_t* m = &ts->metrics;
+    uint64_t appends = atomic_load_explicit(&m->appends, memory_order_relaxed) + points;
+    atomic_store_explicit(&m->appends, appends, memory_order_relaxed);
+    if (evicted > 0) {
+        uint64_t over = atomic_load_explicit(&m->overwrites, memory_order_relaxed);
+        atomic_store_explicit(&m->overwrites, over + evicted, memory_order_relaxed);
+    }
+    if (appends - m->folded_appends >= METRICS_FOLD) {
+        ag_metrics_fold(ts);
+    }
+}
+
+#define METRICS_APPEND(ts, points, evicted) metrics_append((ts), (points), (evicted))
+#define METRICS_RELEASE(ts) ag_metrics_fold(ts)
+#define METRICS_QUERY_START(var) uint64_t var = ag_metrics_now()
+#define METRICS_QUERY(ts, var, scanned, returned) \
+    ag_metrics_query((ts), (var), (scanned), (returned))
+#define METRICS_RETRY(ts) ag_metrics_retry(ts)
+#else
+#define METRICS_APPEND(ts, points, evicted) ((void)0)
+#define METRICS_RELEASE(ts) ((void)0)
+#define METRICS_QUERY_START(var) ((void)0)
+#define METRICS_QUERY(ts, var, scanned, returned) ((void)0)
+#define METRICS_RETRY(ts) ((void)0)
+#endif
+
+/* Reader snapshot of visible points [begin, end) by sequence number */
+typedef struct {
+    uint64_t begin;     /* Sequence of oldest point to read */
+    uint64_t end;       /* Sequence one past newest published point */
+} ring_window_t;
+
+/* Helper: Advance index with wraparound */
+static inline size_t advance_index(size_t index, size_t capacity) {
+    return (index + 1 == capacity) ? 0 : index + 1;
+}
+
+/* Helper: Ring slot holding sequence number seq */
+static inline size_t slot_of(const ag_timeseries_t* ts, uint64_t seq) {
+    if (ts->pow2) {
+        return (size_t)seq & ts->mask;
+    }
+    return (size_t)(seq % ts->capacity);
+}
+
+/* Helper: Timestamp stored in ring slot 'slot' */
+static inline int64_t slot_time(const ag_timeseries_t* ts, size_t slot) {
+    return ts->timestamps[slot * ts->stride];
+}
+
+/* Helper: Value stored in ring slot 'slot', widened to double */
+static inline double slot_value(const ag_timeseries_t* ts, size_t slot) {
+    /* Double series first: 'values' is loaded anyway, so the test is free */
+    if (ts->values != NULL) {
+        return ts->values[slot * ts->stride];
+    }
+    switch (ts->vtype) {
+    case AG_VALUE_F32:
+        return (double)((const float*)ts->cells)[slot];
+    case AG_VALUE_I64:
+        return (double)((const int64_t*)ts->cells)[slot];
+    default:
+        return (double)((const int32_t*)ts->cells)[slot];
+    }
+}
+
+/*
+ * Helper: Round to the nearest int64_t, saturating; NaN becomes 0.
+ * 9223372036854775808.0 is 2^63, the first double above INT64_MAX.
+ */
+static inline int64_t to_i64(double v) {
+    if (v != v) {
+        return 0;
+    }
+    if (v >= 9223372036854775808.0) {
+        return INT64_MAX;
+    }
+    if (v <= -9223372036854775808.0) {
+        return INT64_MIN;
+    }
+    return (int64_t)llround(v);
+}
+
+/* Helper: Round to the nearest int32_t, saturating; NaN becomes 0 */
+static inline int32_t to_i32(double v) {
+    if (v != v) {
+        return 0;
+    }
+    if (v >= (double)INT32_MAX) {
+        return INT32_MAX;
+    }
+    if (v <= (double)INT32_MIN) {
+        return INT32_MIN;
+    }
+    return (int32_t)lround(v);
+}
+
+/* Helper: Store a double in ring slot 'slot', converted to the column type */
+static inline void slot_store(ag_timeseries_t* ts, size_t slot, double v) {
+    if (ts->values != NULL) {
+        ts->values[slot * ts->stride] = v;
+        return;
+    }
+    switch (ts->vtype) {
+    case AG_VALUE_F32:
+        ((float*)ts->cells)[slot] = (float)v;
+        break;
+    case AG_VALUE_I64:
+        ((int64_t*)ts->cells)[slot] = to_i64(v);
+        break;
+    default:
+        ((int32_t*)ts->cells)[slot] = to_i32(v);
+        break;
+    }
+}
+
+/* Helper: Atomic load through a const handle */
+static inline uint64_t seq_load(const _Atomic uint64_t* seq, memory_order order) {
+    return atomic_load_explicit((_Atomic uint64_t*)seq, order);
+}
+
+/*
+ * Helper: Snapshot the visible window.
+ *
+ * 'guard' trims that many of the oldest points; readers raise it after
+ * being lapped so a retry stays clear of slots the writer is overwriting.
+ */
+static inline ring_window_t load_window(const ag_timeseries_t* ts, uint64_t guard) {
+    ring_window_t w;
+    uint64_t expired = seq_load(&ts->ctl->expired, memory_order_acquire);
+    w.end = seq_load(&ts->ctl->appended, memory_order_acquire);
+    w.begin = (w.end + guard > ts->capacity) ? w.end + guard - ts->capacity : 0;
+    if (w.begin < expired) {
+        w.begin = expired;
+    }
+    if (w.begin > w.end) {
+        w.begin = w.end;
+    }
+    return w;
+}
+
+/* Helper: Oldest stored sequence once 'end' points are appended (writer side) */
+static inline uint64_t ring_begin(const ag_timeseries_t* ts, uint64_t end) {
+    uint64_t begin = (end > ts->capacity) ? end - ts->capacity : 0;
+    uint64_t expired = seq_load(&ts->ctl->expired, memory_order_relaxed);
+    return (begin > expired) ? begin : expired;
+}
+
+/*
+ * Helper: Sequence one past the newest point the writer may have started
+ * writing. Slots of sequences below (horizon - capacity) are overwritten.
+ */
+static inline uint64_t write_horizon(const ag_timeseries_t* ts) {
+    atomic_thread_fence(memory_order_acquire);
+    if (ts->spmc) {
+        return seq_load(&ts->ctl->claimed, memory_order_relaxed);
+    }
+    return seq_load(&ts->ctl->appended, memory_order_relaxed);
+}
+
+/*
+ * Helper: Check that slots from first_seq onward survived the read.
+ *
+ * On failure, grows 'guard' by twice the points the writer claimed during
+ * the attempt (bounded by capacity) and the caller retries.
+ */
+static inline int read_intact(const ag_timeseries_t* ts, ring_window_t w,
+                              uint64_t first_seq, uint64_t* guard) {
+    uint64_t claimed = write_horizon(ts);
+    if (claimed <= first_seq + ts->capacity) {
+        return 1;
+    }
+
+    uint64_t grow = 2 * (claimed - w.end);
+    *guard = (*guard + grow < ts->capacity) ? *guard + grow : ts->capacity;
+    METRICS_RETRY(ts);
+    return 0;
+}
+
+/* Helper: Check whether window timestamps are non-decreasing oldest to newest */
+static inline int window_ordered(const ag_timeseries_t* ts, ring_window_t w) {
+    return w.begin >= seq_load(&ts->ctl->ordered_from, memory_order_relaxed);
+}
+
+/*
+ * Helper: Split window into at most two contiguous runs, oldest first.
+ * Returns number of runs (0, 1 or 2).
+ */
+static inline size_t window_segments(const ag_timeseries_t* ts, ring_window_t w,
+                                     size_t offset[2], size_t length[2]) {
+    size_t n = (size_t)(w.end - w.begin);
+    if (n == 0) {
+        return 0;
+    }
+
+    size_t start = slot_of(ts, w.begin);
+    size_t until_wrap = ts->capacity - start;
+
+    offset[0] = start;
+    if (n <= until_wrap) {
+        length[0] = n;
+        return 1;
+    }
+
+    /* Wrapped: [start, capacity) followed by [0, n - until_wrap) */
+    length[0] = until_wrap;
+    offset[1] = 0;
+    length[1] = n - until_wrap;
+    return 2;
+}
+
+/* Helper: Start of the epoch-aligned bucket containing t (floor division) */
+static inline int64_t bucket_floor(int64_t t, int64_t width) {
+    int64_t r = t % width;
+    if (r < 0) {
+        r += width;
+    }
+    return (t < INT64_MIN + r) ? INT64_MIN : t - r;
+}
+
+/* Helper: Mix one 64-bit word into a running checksum (file and snapshot formats) */
+static inline uint64_t checksum_word(uint64_t h, uint64_t w) {
+    h ^= w;
+    h *= 0x100000001b3ull;
+    return h ^ (h >> 29);
+}
+
+/* Helper: Checksum over an array of n 64-bit words (any alignment) */
+static inline uint64_t checksum_words(uint64_t h, const void* data, size_t n) {
+    const unsigned char* p = (const unsigned char*)data;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t w;
+        memcpy(&w, p + i * sizeof(uint64_t), sizeof(uint64_t));
+        h = checksum_word(h, w);
+    }
+    return h;
+}
+
+/*
+ * Helper: File-backed rings record the sequence range about to be written.
+ * Signal fences only order the compiler: a killed process still leaves all
+ * program-order stores in the shared page cache.
+ */
+static inline void persist_claim(const ag_timeseries_t* ts, uint64_t end) {
+    persist_header_t* h = ts->persist;
+    atomic_store_explicit(&h->clean, 0, memory_order_relaxed);
+    atomic_store_explicit(&h->claimed, end, memory_order_relaxed);
+    atomic_signal_fence(memory_order_seq_cst);
+}
+
+/* Helper: File-backed rings publish the counters after writing slots */
+static inline void persist_publish(const ag_timeseries_t* ts, uint64_t end) {
+    persist_header_t* h = ts->persist;
+    atomic_signal_fence(memory_order_seq_cst);
+    atomic_store_explicit(&h->ordered_from,
+                          seq_load(&ts->ctl->ordered_from, memory_order_relaxed),
+                          memory_order_relaxed);
+    atomic_store_explicit(&h->appended, end, memory_order_relaxed);
+}
+
+/* Helper: File-backed rings record points dropped early (no slots change) */
+static inline void persist_expire(const ag_timeseries_t* ts, uint64_t begin) {
+    persist_header_t* h = ts->persist;
+    atomic_store_explicit(&h->clean, 0, memory_order_relaxed);
+    atomic_signal_fence(memory_order_seq_cst);
+    atomic_store_explicit(&h->expired, begin, memory_order_relaxed);
+}
+
+/* Initialize handle state over already-allocated split arrays (no ownership flags) */
+void ag_timeseries_init(
+    ag_timeseries_t* ts,
+    size_t capacity,
+    int spmc,
+    int64_t* timestamps,
+    double* values
+);
+
+/*
+ * Initialize a series over caller-owned memory (registry arenas).
+ *
+ * timestamps/values must each hold capacity elements. ag_timeseries_destroy
+ * is a no-op for such series; the owner calls ag_timeseries_release instead.
+ * Returns AG_OK or AG_ERR_INVALID_ARG.
+ */
+int ag_timeseries_init_external(
+    ag_timeseries_t* ts,
+    size_t capacity,
+    int spmc,
+    int64_t* timestamps,
+    double* values
+);
+
+/* Free allocations attached to a series (stats, cold tier, rollups, reorder) */
+void ag_timeseries_release(ag_timeseries_t* ts);
+
+/*
+ * Binary-search an ordered window for [start_ms, end_ms] (ag_timeseries.c).
+ * Fills 'view' with up to two spans (stepping by ts->stride; values NULL
+ * for typed series) and returns
+ * the sequence from which slots must stay intact for the result to hold.
+ */
+uint64_t ag_timeseries_locate_range(const ag_timeseries_t* ts, ring_window_t w,
+                                    int64_t start_ms, int64_t end_ms,
+                                    ag_timeseries_view_t* view);
+
+/* Sync and unmap a file-backed ring's mapping (ag_persist.c; handle not freed) */
+void ag_persist_close(ag_timeseries_t* ts);
+
+/*
+ * Unmap a shared-memory ring (ag_shm.c; handle not freed). The writer marks
+ * the segment closed and unlinks its name first.
+ */
+void ag_shm_close(ag_timeseries_t* ts);
+
+/*
+ * Map 'size' bytes of zeroed anonymous memory (ag_alloc.c). With 'huge',
+ * tries MAP_HUGETLB first (growing *size to a huge page multiple), then
+ * falls back to regular pages with transparent huge page advice.
+ * Returns NULL on failure.
+ */
+void* ag_map_pages(size_t* size, int huge);
+
+/* Unmap a create_ex ring's data pages (ag_alloc.c; handle not freed) */
+void ag_pages_close(ag_timeseries_t* ts);
+
+/*
+ * Typed column kernels (ag_typed.c). Each covers n consecutive slots from
+ * 'slot' (no wrap) of any series, double ones included.
+ */
+
+/* Bytes per value of an AG_VALUE_* type, 0 if unknown */
+size_t ag_typed_size(int vtype);
+
+/* Retype an initialized split series: cells of 'vtype' replace 'values' */
+void ag_typed_attach(ag_timeseries_t* ts, int vtype, void* cells);
+
+/* Widen slots to doubles; 'reverse' writes newest first */
+void ag_typed_load(const ag_timeseries_t* ts, size_t slot, size_t n,
+                   double* out, int reverse);
+
+/* Copy slots in the column type; 'reverse' writes newest first */
+void ag_typed_copy(const ag_timeseries_t* ts, size_t slot, size_t n,
+                   void* out, int reverse);
+
+/* Convert doubles into slots */
+void ag_typed_store(ag_timeseries_t* ts, size_t slot, const double* in, size_t n);
+
+/*
+ * Reduce slots for AG_AGG_MIN, AG_AGG_MAX, or else their sum, with the
+ * identities and NaN rules of ag_kernels.h (split series only).
+ */
+double ag_typed_reduce(const ag_timeseries_t* ts, size_t slot, size_t n, int agg);
+
+/* As ag_typed_reduce over slots with timestamp in [lo, hi]; adds matches to *count */
+double ag_typed_reduce_in(const ag_timeseries_t* ts, size_t slot, size_t n, int agg,
+                          int64_t lo, int64_t hi, size_t* count);
+
+#endif /* AG_TIMESERIES_INTERNAL_H */
@@ -0,0 +1,514 @@
+/*
+ * ag_tsdb.c - Multi-Series Registry Implementation
+ *
+ * Implementation Strategy:
+ *   - One anonymous mmap holds every series handle and data array
+ *   - Handles packed at the front, then per-series arrays, all cache-line
+ *     aligned (no false sharing between series, sequential sweeps)
+ *   - Kernel zero-fill replaces the per-series memset
+ *   - Names interned in an open-addressing hash table (FNV-1a, linear probe)
+ *   - Flush pipeline: one ag_ts_cursor_t per series, chunks handed to the
+ *     sink as zero-copy views (ag_timeseries_cursor_view); the flush thread
+ *     sees new series through an atomically published count
+ *
+ * Copyright (c) 2025 AlgorithmicGrid
+ */
+
+#define _DEFAULT_SOURCE     /* munmap, clock_gettime */
+
+#include "ag_tsdb.h"
+#include "ag_timeseries_internal.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#define TSDB_ALIGN      64u                 /* Cache line */
+
+/* Name table slot: id + 1, 0 means empty */
+typedef size_t name_slot_t;
+
+/* Flush position of one series (touched by the flushing thread only) */
+typedef struct {
+    ag_ts_cursor_t cursor;      /* Next point to offer */
+    uint64_t lost;              /* Lost points not yet reported to the sink */
+} flush_cursor_t;
+
+/* Flush counters, readable while the flush thread updates them */
+typedef struct {
+    _Atomic uint64_t flushed;
+    _Atomic uint64_t chunks;
+    _Atomic uint64_t lost;
+    _Atomic uint64_t deferred;
+    _Atomic uint64_t torn;
+    _Atomic uint64_t passes;
+    _Atomic uint64_t backlog;
+} flush_counters_t;
+
+/*
+ * Internal structure - opaque to users
+ *
+ * Arena Layout:
+ *   [handle 0][handle 1]...[handle N-1][ts 0][vals 0][ts 1][vals 1]...
+ *   handle_stride and data_stride are multiples of TSDB_ALIGN.
+ */
+struct ag_tsdb_t {
+    unsigned char* arena;       /* Mapping base */
+    size_t arena_size;          /* Mapping length */
+    size_t max_series;          /* Registry limit */
+    size_t capacity;            /* Points per series */
+    size_t count;               /* Registered series */
+    size_t handle_stride;       /* Bytes per handle slot */
+    size_t array_stride;        /* Bytes per data array */
+    int spmc;                   /* Series created in SPMC mode */
+    char** names;               /* Interned names by ID (NULL = anonymous) */
+    name_slot_t* table;         /* Name hash table */
+    size_t table_mask;          /* Table size - 1 (power of two) */
+    _Atomic size_t published;   /* Series fully set up (count, for other threads) */
+
+    /* Flush pipeline (sink == NULL until ag_tsdb_flush_attach) */
+    ag_tsdb_sink_fn sink;
+    void* sink_ctx;
+    size_t max_chunk;           /* Points per chunk */
+    flush_cursor_t* cursors;    /* max_series cursors */
+    flush_counters_t counters;
+
+    /* Flush thread (valid while flush_running) */
+    pthread_t flush_thread;
+    pthread_mutex_t flush_lock; /* Guards flush_stop */
+    pthread_cond_t flush_wake;  /* Stop request -> sleeping thread */
+    unsigned interval_ms;       /* Idle sleep between passes */
+    int flush_running;
+    int flush_stop;
+};
+
+/* Helper: Round up to multiple of 'align' (power of two), 0 on overflow */
+static size_t align_up(size_t n, size_t align) {
+    if (n > SIZE_MAX - (align - 1)) {
+        return 0;
+    }
+    return (n + align - 1) & ~(align - 1);
+}
+
+/* Helper: FNV-1a string hash */
+static size_t name_hash(const char* name) {
+    uint64_t h = 1469598103934665603ull;
+    for (const unsigned char* p = (const unsigned char*)name; *p != '\0'; p++) {
+        h ^= *p;
+        h *= 1099511628211ull;
+    }
+    return (size_t)h;
+}
+
+/* Helper: Table slot holding 'name', or the empty slot where it belongs */
+static size_t name_probe(const ag_tsdb_t* db, const char* name) {
+    size_t i = name_hash(name) & db->table_mask;
+    while (db->table[i] != 0 && strcmp(db->names[db->table[i] - 1], name) != 0) {
+        i = (i + 1) & db->table_mask;
+    }
+    return i;
+}
+
+/* Helper: Series handle in slot 'id' */
+static ag_timeseries_t* series_at(const ag_tsdb_t* db, size_t id) {
+    return (ag_timeseries_t*)(db->arena + id * db->handle_stride);
+}
+
+ag_tsdb_t* ag_tsdb_create(size_t max_series, size_t capacity, unsigned flags) {
+    /* Validate arguments */
+    if (max_series == 0 || capacity == 0 || capacity > SIZE_MAX / sizeof(int64_t)) {
+        return NULL;
+    }
+    if (flags & ~(AG_TSDB_HUGEPAGES | AG_TSDB_SPMC)) {
+        return NULL;
+    }
+
+    /* Compute layout, rejecting size_t overflow */
+    size_t handle_stride = align_up(sizeof(ag_timeseries_t), TSDB_ALIGN);
+    size_t array_stride = align_up(capacity * sizeof(int64_t), TSDB_ALIGN);
+    if (array_stride == 0) {
+        return NULL;
+    }
+    size_t per_series = 2 * array_stride + handle_stride;
+    if (per_series < array_stride || max_series > SIZE_MAX / per_series) {
+        return NULL;
+    }
+    size_t arena_size = max_series * per_series;
+
+    /* Name table: power of two >= 2 * max_series keeps probes short */
+    size_t table_size = 2;
+    while (table_size < 2 * max_series) {
+        if (table_size > SIZE_MAX / 2 / sizeof(name_slot_t)) {
+            return NULL;
+        }
+        table_size <<= 1;
+    }
+
+    ag_tsdb_t* db = (ag_tsdb_t*)malloc(sizeof(ag_tsdb_t));
+    if (db == NULL) {
+        return NULL;
+    }
+
+    db->names = (char**)calloc(max_series, sizeof(char*));
+    db->table = (name_slot_t*)calloc(table_size, sizeof(name_slot_t));
+    db->arena = (unsigned char*)ag_map_pages(&arena_size, (flags & AG_TSDB_HUGEPAGES) != 0);
+
+    if (db->names == NULL || db->table == NULL || db->arena == NULL) {
+        /* Cleanup on partial allocation failure */
+        if (db->arena != NULL) {
+            munmap(db->arena, arena_size);
+        }
+        free(db->names);
+        free(db->table);
+        free(db);
+        return NULL;
+    }
+
+    db->arena_size = arena_size;
+    db->max_series = max_series;
+    db->capacity = capacity;
+    db->count = 0;
+    db->handle_stride = handle_stride;
+    db->array_stride = array_stride;
+    db->spmc = (flags & AG_TSDB_SPMC) != 0;
+    db->table_mask = table_size - 1;
+    atomic_init(&db->published, 0);
+
+    db->sink = NULL;
+    db->sink_ctx = NULL;
+    db->max_chunk = 0;
+    db->cursors = NULL;
+    atomic_init(&db->counters.flushed, 0);
+    atomic_init(&db->counters.chunks, 0);
+    atomic_init(&db->counters.lost, 0);
+    atomic_init(&db->counters.deferred, 0);
+    atomic_init(&db->counters.torn, 0);
+    atomic_init(&db->counters.passes, 0);
+    atomic_init(&db->counters.backlog, 0);
+    db->interval_ms = 0;
+    db->flush_running = 0;
+    db->flush_stop = 0;
+
+    return db;
+}
+
+void ag_tsdb_destroy(ag_tsdb_t* db) {
+    if (db == NULL) {
+        return;
+    }
+
+    if (db->flush_running) {
+        ag_tsdb_flush_stop(db);
+    }
+    free(db->cursors);
+
+    /* Free per-series attachments (rolling stats) and names */
+    for (size_t id = 0; id < db->count; id++) {
+        ag_timeseries_release(series_at(db, id));
+        free(db->names[id]);
+    }
+
+    munmap(db->arena, db->arena_size);
+    free(db->names);
+    free(db->table);
+    free(db);
+}
+
+int ag_tsdb_add(ag_tsdb_t* db, const char* name, size_t* out_id) {
+    /* Validate handle */
+    if (db == NULL) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    /* Existing name: return its ID */
+    size_t slot = 0;
+    if (name != NULL) {
+        slot = name_probe(db, name);
+        if (db->table[slot] != 0) {
+            if (out_id != NULL) {
+                *out_id = db->table[slot] - 1;
+            }
+            return AG_OK;
+        }
+    }
+
+    if (db->count == db->max_series) {
+        return AG_ERR_FULL;
+    }
+
+    size_t id = db->count;
+
+    /* Intern name before touching the arena so failure leaves no trace */
+    if (name != NULL) {
+        size_t len = strlen(name) + 1;
+        char* copy = (char*)malloc(len);
+        if (copy == NULL) {
+            return AG_ERR_NOMEM;
+        }
+        memcpy(copy, name, len);
+        db->names[id] = copy;
+        db->table[slot] = id + 1;
+    }
+
+    /* Carve series: arrays follow all handles */
+    unsigned char* data = db->arena + db->max_series * db->handle_stride
+                        + id * 2 * db->array_stride;
+    ag_timeseries_init_external(series_at(db, id), db->capacity, db->spmc,
+                                (int64_t*)data,
+                                (double*)(data + db->array_stride));
+
+    db->count = id + 1;
+    atomic_store_explicit(&db->published, id + 1, memory_order_release);
+    if (out_id != NULL) {
+        *out_id = id;
+    }
+    return AG_OK;
+}
+
+int ag_tsdb_find(const ag_tsdb_t* db, const char* name, size_t* out_id) {
+    /* Validate arguments */
+    if (db == NULL || name == NULL || out_id == NULL) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    size_t slot = name_probe(db, name);
+    if (db->table[slot] == 0) {
+        return AG_ERR_EMPTY;
+    }
+
+    *out_id = db->table[slot] - 1;
+    return AG_OK;
+}
+
+ag_timeseries_t* ag_tsdb_get(const ag_tsdb_t* db, size_t id) {
+    if (db == NULL || id >= db->count) {
+        return NULL;
+    }
+    return series_at(db, id);
+}
+
+ag_timeseries_t* ag_tsdb_lookup(const ag_tsdb_t* db, const char* name) {
+    size_t id;
+    if (ag_tsdb_find(db, name, &id) != AG_OK) {
+        return NULL;
+    }
+    return series_at(db, id);
+}
+
+const char* ag_tsdb_name(const ag_tsdb_t* db, size_t id) {
+    if (db == NULL || id >= db->count) {
+        return NULL;
+    }
+    return db->names[id];
+}
+
+size_t ag_tsdb_count(const ag_tsdb_t* db) {
+    return db == NULL ? 0 : db->count;
+}
+
+size_t ag_tsdb_capacity(const ag_tsdb_t* db) {
+    return db == NULL ? 0 : db->capacity;
+}
+
+/* Helper: Add to a flush counter */
+static inline void counter_add(_Atomic uint64_t* counter, uint64_t n) {
+    atomic_fetch_add_explicit(counter, n, memory_order_relaxed);
+}
+
+/*
+ * Helper: Offer one series' unflushed points to the sink, up to the
+ * sequence it had on entry. Returns the points still unflushed.
+ */
+static uint64_t flush_series(ag_tsdb_t* db, size_t id, size_t* delivered) {
+    ag_timeseries_t* ts = series_at(db, id);
+    flush_cursor_t* fc = &db->cursors[id];
+    uint64_t stop = ag_timeseries_sequence(ts);
+
+    while (fc->cursor.next_seq < stop) {
+        ag_tsdb_chunk_t chunk;
+        uint64_t lost = 0;
+        uint64_t limit = stop - fc->cursor.next_seq;
+        size_t max_points = (limit < db->max_chunk) ? (size_t)limit : db->max_chunk;
+        ag_timeseries_cursor_view(ts, &fc->cursor, max_points, &chunk.view, &lost);
+        if (lost > 0) {
+            fc->lost += lost;
+            counter_add(&db->counters.lost, lost);
+        }
+        if (chunk.view.length == 0) {
+            break;
+        }
+
+        /* One contiguous span per chunk: a wrapped tail is the next chunk */
+        if (chunk.view.span_count == 2) {
+            chunk.view.span_count = 1;
+            chunk.view.length = chunk.view.spans[0].length;
+            chunk.view.end_seq = chunk.view.begin_seq + chunk.view.length;
+        }
+
+        chunk.id = id;
+        chunk.name = db->names[id];
+        chunk.ts = ts;
+        chunk.lost = fc->lost;
+        if (db->sink(db->sink_ctx, &chunk) != AG_OK) {
+            counter_add(&db->counters.deferred, 1);
+            break;
+        }
+
+        /* Lapped while the sink read it: offer the survivors again */
+        if (!ag_timeseries_view_valid(ts, &chunk.view)) {
+            counter_add(&db->counters.torn, 1);
+            continue;
+        }
+
+        fc->cursor.next_seq = chunk.view.end_seq;
+        fc->lost = 0;
+        counter_add(&db->counters.flushed, chunk.view.length);
+        counter_add(&db->counters.chunks, 1);
+        *delivered += chunk.view.length;
+    }
+
+    /* Only points still stored can be flushed */
+    uint64_t end = ag_timeseries_sequence(ts);
+    uint64_t backlog = (end > fc->cursor.next_seq) ? end - fc->cursor.next_seq : 0;
+    return (backlog > db->capacity) ? db->capacity : backlog;
+}
+
+/* Helper: One pass over every published series; returns points flushed */
+static size_t flush_pass(ag_tsdb_t* db) {
+    size_t count = atomic_load_explicit(&db->published, memory_order_acquire);
+    size_t delivered = 0;
+    uint64_t backlog = 0;
+    for (size_t id = 0; id < count; id++) {
+        backlog += flush_series(db, id, &delivered);
+    }
+    atomic_store_explicit(&db->counters.backlog, backlog, memory_order_relaxed);
+    counter_add(&db->counters.passes, 1);
+    return delivered;
+}
+
+/* Helper: Flush thread - passes back to back, sleeping when idle */
+static void* flush_main(void* arg) {
+    ag_tsdb_t* db = (ag_tsdb_t*)arg;
+
+    pthread_mutex_lock(&db->flush_lock);
+    while (!db->flush_stop) {
+        pthread_mutex_unlock(&db->flush_lock);
+        size_t delivered = flush_pass(db);
+        pthread_mutex_lock(&db->flush_lock);
+
+        if (delivered == 0 && !db->flush_stop) {
+            struct timespec until;
+            clock_gettime(CLOCK_REALTIME, &until);
+            until.tv_sec += db->interval_ms / 1000u;
+            until.tv_nsec += (long)(db->interval_ms % 1000u) * 1000000L;
+            if (until.tv_nsec >= 1000000000L) {
+                until.tv_sec++;
+                until.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&db->flush_wake, &db->flush_lock, &until);
+        }
+    }
+    pthread_mutex_unlock(&db->flush_lock);
+    return NULL;
+}
+
+int ag_tsdb_flush_attach(ag_tsdb_t* db, ag_tsdb_sink_fn sink, void* ctx,
+                         size_t max_chunk) {
+    /* Validate arguments */
+    if (db == NULL || sink == NULL || db->flush_running) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    /* First attach: cursors at each registered series' oldest point */
+    if (db->cursors == NULL) {
+        flush_cursor_t* cursors = (flush_cursor_t*)calloc(db->max_series,
+                                                          sizeof(flush_cursor_t));
+        if (cursors == NULL) {
+            return AG_ERR_NOMEM;
+        }
+        for (size_t id = 0; id < db->count; id++) {
+            ag_timeseries_cursor_init(series_at(db, id), AG_CURSOR_OLDEST,
+                                      &cursors[id].cursor);
+        }
+        db->cursors = cursors;
+    }
+
+    db->sink = sink;
+    db->sink_ctx = ctx;
+    db->max_chunk = (max_chunk == 0 || max_chunk > db->capacity) ? db->capacity
+                                                                 : max_chunk;
+    return AG_OK;
+}
+
+int ag_tsdb_flush(ag_tsdb_t* db, size_t* out_points) {
+    /* Validate arguments */
+    if (db == NULL || db->sink == NULL || db->flush_running) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    size_t delivered = flush_pass(db);
+    if (out_points != NULL) {
+        *out_points = delivered;
+    }
+    return AG_OK;
+}
+
+int ag_tsdb_flush_start(ag_tsdb_t* db, unsigned interval_ms) {
+    /* Validate arguments: concurrent reads need SPMC series */
+    if (db == NULL || db->sink == NULL || !db->spmc || db->flush_running) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    if (pthread_mutex_init(&db->flush_lock, NULL) != 0) {
+        return AG_ERR_NOMEM;
+    }
+    if (pthread_cond_init(&db->flush_wake, NULL) != 0) {
+        pthread_mutex_destroy(&db->flush_lock);
+        return AG_ERR_NOMEM;
+    }
+
+    db->interval_ms = (interval_ms == 0) ? 1u : interval_ms;
+    db->flush_stop = 0;
+    if (pthread_create(&db->flush_thread, NULL, flush_main, db) != 0) {
+        pthread_cond_destroy(&db->flush_wake);
+        pthread_mutex_destroy(&db->flush_lock);
+        return AG_ERR_NOMEM;
+    }
+    db->flush_running = 1;
+    return AG_OK;
+}
+
+int ag_tsdb_flush_stop(ag_tsdb_t* db) {
+    /* Validate arguments */
+    if (db == NULL || !db->flush_running) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&db->flush_lock);
+    db->flush_stop = 1;
+    pthread_cond_signal(&db->flush_wake);
+    pthread_mutex_unlock(&db->flush_lock);
+
+    pthread_join(db->flush_thread, NULL);
+    pthread_cond_destroy(&db->flush_wake);
+    pthread_mutex_destroy(&db->flush_lock);
+    db->flush_running = 0;
+    return AG_OK;
+}
+
+int ag_tsdb_flush_stats(const ag_tsdb_t* db, ag_tsdb_flush_stats_t* out) {
+    /* Validate arguments */
+    if (db == NULL || out == NULL) {
+        return AG_ERR_INVALID_ARG;
+    }
+
+    out->flushed = atomic_load_explicit(&db->counters.flushed, memory_order_relaxed);
+    out->chunks = atomic_load_explicit(&db->counters.chunks, memory_order_relaxed);
+    out->lost = atomic_load_explicit(&db->counters.lost, memory_order_relaxed);
+    out->deferred = atomic_load_explicit(&db->counters.deferred, memory_order_relaxed);
+    out->torn = atomic_load_explicit(&db->counters.torn, memory_order_relaxed);
+    out->passes = atomic_load_explicit(&db->counters.passes, memory_order_relaxed);
+    out->backlog = atomic_load_explicit(&db->counters.backlog, memory_order_relaxed);
+    return AG_OK;
+}
@@ -0,0 +1,285 @@
+/*
+ * ag_typed.c - Typed Value Column Kernels
+ *
+ * Implementation Strategy:
+ *   - One kernel set per column type, generated from a single macro so
+ *     float, int64_t and int32_t share the loop shapes
+ *   - Loops run over the typed array directly (no per-point type switch);
+ *     the switch happens once per contiguous run
+ *   - Native copies are plain memcpy; conversions widen on load and
+ *     round/saturate on store (see to_i64/to_i32)
+ *   - Reductions mirror ag_kernels.h: plain loops over located spans (one
+ *     aggregate each; sums keep four partial accumulators, reassociating
+ *     like the SIMD kernels) and masked "_in"
+ *     loops for unordered windows; int32_t sums accumulate exactly in
+ *     int64_t, float and int64_t sums in double
+ *
+ * Copyright (c) 2025 AlgorithmicGrid
+ */
+
+#include "ag_timeseries_internal.h"
+#include "ag_kernels.h"
+#include <string.h>
+
+/* Helper: Timestamp inside inclusive range */
+static inline int in_range(int64_t t, int64_t lo, int64_t hi) {
+    return t >= lo && t <= hi;
+}
+
+/* Helper: double -> float (to_i64/to_i32 cover the integer types) */
+static inline float to_f32(double v) {
+    return (float)v;
+}
+
+/* Helper: Min of n values widened to double, +INFINITY identity when n == 0 */
+static inline double widen_min(double m, size_t n) {
+    return (n == 0) ? INFINITY : m;
+}
+
+/* Helper: Max of n values widened to double, -INFINITY identity when n == 0 */
+static inline double widen_max(double m, size_t n) {
+    return (n == 0) ? -INFINITY : m;
+}
+
+/*
+ * Kernel set for one column type.
+ *
+ *   SUFFIX  - Name suffix (f32, i64, i32)
+ *   TYPE    - Cell type
+ *   ACC     - Sum accumulator type
+ *   CONV    - double -> TYPE conversion
+ *   TOP     - Identity of min (largest value; +INFINITY for float, so NaN,
+ *             which never compares smaller, is ignored)
+ *   BOTTOM  - Identity of max
+ */
+#define TYPED_KERNELS(SUFFIX, TYPE, ACC, CONV, TOP, BOTTOM)                         \
+static void load_##SUFFIX(const TYPE* cells, size_t n, double* out, int reverse) {  \
+    if (reverse) {                                                                  \
+        for (size_t i = 0; i < n; i++) {                                            \
+            out[i] = (double)cells[n - 1 - i];                                      \
+        }                                                                           \
+    } else {                                                                        \
+        for (size_t i = 0; i < n; i++) {                                            \
+            out[i] = (double)cells[i];                                              \
+        }                                                                           \
+    }                                                                               \
+}                                                                                   \
+                                                                                    \
+static void copy_rev_##SUFFIX(const TYPE* cells, size_t n, TYPE* out) {             \
+    for (size_t i = 0; i < n; i++) {                                                \
+        out[i] = cells[n - 1 - i];                                                  \
+    }                                                                               \
+}                                                                                   \
+                                                                                    \
+static void store_##SUFFIX(TYPE* cells, const double* in, size_t n) {               \
+    for (size_t i = 0; i < n; i++) {                                                \
+        cells[i] = CONV(in[i]);                                                     \
+    }                                                                               \
+}                                                                                   \
+                                                                                    \
+static ACC sum_##SUFFIX(const TYPE* cells, size_t n) {                              \
+    ACC acc[4] = { 0, 0, 0, 0 };                                                    \
+    size_t i = 0;                                                                   \
+    for (; i + 4 <= n; i += 4) {                                                    \
+        acc[0] += (ACC)cells[i];                                                    \
+        acc[1] += (ACC)cells[i + 1];                                                \
+        acc[2] += (ACC)cells[i + 2];                                                \
+        acc[3] += (ACC)cells[i + 3];                                                \
+    }                                                                               \
+    for (; i < n; i++) {                                                            \
+        acc[0] += (ACC)cells[i];                                                    \
+    }                                                                               \
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);                                   \
+}                                                                                   \
+                                                                                    \
+static TYPE min_##SUFFIX(const TYPE* cells, size_t n) {                             \
+    TYPE m = TOP;                                                                   \
+    for (size_t i = 0; i < n; i++) {                                                \
+        m = (cells[i] < m) ? cells[i] : m;                                          \
+    }                                                                               \
+    return m;                                                                       \
+}                                                                                   \
+                                                                                    \
+static TYPE max_##SUFFIX(const TYPE* cells, size_t n) {                             \
+    TYPE m = BOTTOM;                                                                \
+    for (size_t i = 0; i < n; i++) {                                                \
+        m = (cells[i] > m) ? cells[i] : m;                                          \
+    }                                                                               \
+    return m;                                                                       \
+}                                                                                   \
+                                                                                    \
+static double reduce_in_##SUFFIX(const int64_t* run, const TYPE* cells, size_t n,   \
+                                 int agg, int64_t lo, int64_t hi, size_t* count) {  \
+    ACC acc = 0;                                                                    \
+    TYPE mn = TOP;                                                                  \
+    TYPE mx = BOTTOM;                                                               \
+    size_t matched = 0;                                                             \
+    for (size_t i = 0; i < n; i++) {                                                \
+        if (in_range(run[i], lo, hi)) {                                             \
+            acc += (ACC)cells[i];                                                   \
+            mn = (cells[i] < mn) ? cells[i] : mn;                                   \
+            mx = (cells[i] > mx) ? cells[i] : mx;                                   \
+            matched++;                                                              \
+        }                                                                           \
+    }                                                                               \
+    *count += matched;                                                              \
+    if (agg == AG_AGG_MIN) {                                                        \
+        return widen_min((double)mn, matched);                                      \
+    }                                                                               \
+    if (agg == AG_AGG_MAX) {                                                        \
+        return widen_max((double)mx, matched);                                      \
+    }                                                                               \
+    return (double)acc;                                                             \
+}                                                                                   \
+                                                                                    \
+static double reduce_##SUFFIX(const TYPE* cells, size_t n, int agg) {               \
+    if (agg == AG_AGG_MIN) {                                                        \
+        return widen_min((double)min_##SUFFIX(cells, n), n);                        \
+    }                                                                               \
+    if (agg == AG_AGG_MAX) {                                                        \
+        return widen_max((double)max_##SUFFIX(cells, n), n);                        \
+    }                                                                               \
+    return (double)sum_##SUFFIX(cells, n);                                          \
+}
+
+TYPED_KERNELS(f32, float, double, to_f32, INFINITY, -INFINITY)
+TYPED_KERNELS(i64, int64_t, double, to_i64, INT64_MAX, INT64_MIN)
+TYPED_KERNELS(i32, int32_t, int64_t, to_i32, INT32_MAX, INT32_MIN)
+
+size_t ag_typed_size(int vtype) {
+    switch (vtype) {
+    case AG_VALUE_F64:
+        return sizeof(double);
+    case AG_VALUE_F32:
+        return sizeof(float);
+    case AG_VALUE_I64:
+        return sizeof(int64_t);
+    case AG_VALUE_I32:
+        return sizeof(int32_t);
+    default:
+        return 0;
+    }
+}
+
+void ag_typed_attach(ag_timeseries_t* ts, int vtype, void* cells) {
+    ts->vtype = vtype;
+    ts->vsize = ag_typed_size(vtype);
+    ts->cells = cells;
+    ts->values = (vtype == AG_VALUE_F64) ? (double*)cells : NULL;
+}
+
+void ag_typed_load(const ag_timeseries_t* ts, size_t slot, size_t n,
+                   double* out, int reverse) {
+    switch (ts->vtype) {
+    case AG_VALUE_F32:
+        load_f32((const float*)ts->cells + slot, n, out, reverse);
+        return;
+    case AG_VALUE_I64:
+        load_i64((const int64_t*)ts->cells + slot, n, out, reverse);
+        return;
+    case AG_VALUE_I32:
+        load_i32((const int32_t*)ts->cells + slot, n, out, reverse);
+        return;
+    default:
+        break;
+    }
+
+    /* Double column, split or interleaved */
+    const double* vals = ts->values + slot * ts->stride;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = vals[(reverse ? n - 1 - i : i) * ts->stride];
+    }
+}
+
+void ag_typed_copy(const ag_timeseries_t* ts, size_t slot, size_t n,
+                   void* out, int reverse) {
+    if (ts->stride == 1 && !reverse) {
+        memcpy(out, (const unsigned char*)ts->cells + slot * ts->vsize, n * ts->vsize);
+        return;
+    }
+
+    switch (ts->vtype) {
+    case AG_VALUE_F32:
+        copy_rev_f32((const float*)ts->cells + slot, n, (float*)out);
+        return;
+    case AG_VALUE_I64:
+        copy_rev_i64((const int64_t*)ts->cells + slot, n, (int64_t*)out);
+        return;
+    case AG_VALUE_I32:
+        copy_rev_i32((const int32_t*)ts->cells + slot, n, (int32_t*)out);
+        return;
+    default:
+        ag_typed_load(ts, slot, n, (double*)out, reverse);
+        return;
+    }
+}
+
+void ag_typed_store(ag_timeseries_t* ts, size_t slot, const double* in, size_t n) {
+    switch (ts->vtype) {
+    case AG_VALUE_F32:
+        store_f32((float*)ts->cells + slot, in, n);
+        return;
+    case AG_VALUE_I64:
+        store_i64((int64_t*)ts->cells + slot, in, n);
+        return;
+    case AG_VALUE_I32:
+        store_i32((int32_t*)ts->cells + slot, in, n);
+        return;
+    default:
+        break;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        ts->values[(slot + i) * ts->stride] = in[i];
+    }
+}
+
+double ag_typed_reduce(const ag_timeseries_t* ts, size_t slot, size_t n, int agg) {
+    switch (ts->vtype) {
+    case AG_VALUE_F32:
+        return reduce_f32((const float*)ts->cells + slot, n, agg);
+    case AG_VALUE_I64:
+        return reduce_i64((const int64_t*)ts->cells + slot, n, agg);
+    case AG_VALUE_I32:
+        return reduce_i32((const int32_t*)ts->cells + slot, n, agg);
+    default:
+        break;
+    }
+
+    /* Double column (split): the SIMD kernels */
+    const ag_kernels_t* k = ag_kernels_get();
+    const double* vals = ts->values + slot;
+    if (agg == AG_AGG_MIN) {
+        return k->min(vals, n);
+    }
+    if (agg == AG_AGG_MAX) {
+        return k->max(vals, n);
+    }
+    return k->sum(vals, n);
+}
+
+double ag_typed_reduce_in(const ag_timeseries_t* ts, size_t slot, size_t n, int agg,
+                          int64_t lo, int64_t hi, size_t* count) {
+    const int64_t* run = ts->timestamps + slot;
+
+    switch (ts->vtype) {
+    case AG_VALUE_F32:
+        return reduce_in_f32(run, (const float*)ts->cells + slot, n, agg, lo, hi, count);
+    case AG_VALUE_I64:
+        return reduce_in_i64(run, (const int64_t*)ts->cells + slot, n, agg, lo, hi, count);
+    case AG_VALUE_I32:
+        return reduce_in_i32(run, (const int32_t*)ts->cells + slot, n, agg, lo, hi, count);
+    default:
+        break;
+    }
+
+    const ag_kernels_t* k = ag_kernels_get();
+    const double* vals = ts->values + slot;
+    if (agg == AG_AGG_MIN) {
+        return k->min_in(run, vals, n, lo, hi, count);
+    }
+    if (agg == AG_AGG_MAX) {
+        return k->max_in(run, vals, n, lo, hi, count);
+    }
+    return k->sum_in(run, vals, n, lo, hi, count);
+}
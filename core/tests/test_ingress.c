@@ -0,0 +1,322 @@
+/*
+ * test_ingress.c - Registry Ingress Queue Unit Tests
+ *
+ * Test Coverage:
+ *   - Creation limits, capacity rounding and invalid arguments
+ *   - Drain into series: grouping, per-series order, batch counts
+ *   - Unknown series IDs, full queue rejection, partial drains
+ *   - Concurrent producers (MPSC) and a single SPSC producer while the
+ *     owner drains
+ *
+ * Copyright (c) 2025 AlgorithmicGrid
+ */
+
+#include "ag_ingress.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <pthread.h>
+
+/* Test framework macros */
+#define TEST(name) static void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("Running %s...", #name); \
+    test_##name(); \
+    printf(" PASSED\n"); \
+} while(0)
+
+#define ASSERT(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "\nAssertion failed: %s\n  File: %s\n  Line: %d\n", \
+                #cond, __FILE__, __LINE__); \
+        exit(1); \
+    } \
+} while(0)
+
+#define ASSERT_EQ(a, b) ASSERT((a) == (b))
+#define ASSERT_NE(a, b) ASSERT((a) != (b))
+#define ASSERT_DOUBLE_EQ(a, b) ASSERT(fabs((a) - (b)) < 1e-9)
+
+/* Records pushed by each producer thread in the concurrent tests */
+#define PRODUCER_RECORDS 20000
+
+/* Helper: Check a series holds timestamps first..first+n-1, values -t */
+static void check_series(ag_timeseries_t* ts, int64_t first, size_t n) {
+    int64_t* timestamps = (int64_t*)malloc(n * sizeof(int64_t));
+    double* values = (double*)malloc(n * sizeof(double));
+    ASSERT(timestamps != NULL && values != NULL);
+    ASSERT_EQ(ag_timeseries_size(ts), n);
+    ASSERT_EQ(ag_timeseries_query_range(ts, INT64_MIN, INT64_MAX, n, timestamps, values), n);
+    for (size_t i = 0; i < n; i++) {
+        ASSERT_EQ(timestamps[i], first + (int64_t)i);
+        ASSERT_DOUBLE_EQ(values[i], -(double)timestamps[i]);
+    }
+    free(timestamps);
+    free(values);
+}
+
+/* Test: Create and destroy, invalid arguments */
+TEST(create_destroy) {
+    ag_tsdb_t* db = ag_tsdb_create(4, 64, 0);
+    ASSERT_NE(db, NULL);
+
+    ASSERT_EQ(ag_ingress_create(NULL, 16, 0), NULL);
+    ASSERT_EQ(ag_ingress_create(db, 0, 0), NULL);
+    ASSERT_EQ(ag_ingress_create(db, 16, 0x80), NULL);
+    ASSERT_EQ(ag_ingress_create(db, SIZE_MAX, 0), NULL);
+
+    /* Capacity rounds up to a power of two, at least 2 */
+    ag_ingress_t* q = ag_ingress_create(db, 5, 0);
+    ASSERT_NE(q, NULL);
+    ASSERT_EQ(ag_ingress_capacity(q), 8);
+    ag_ingress_destroy(q);
+    q = ag_ingress_create(db, 1, AG_INGRESS_SPSC);
+    ASSERT_NE(q, NULL);
+    ASSERT_EQ(ag_ingress_capacity(q), 2);
+
+    /* Empty drain */
+    size_t n = 99;
+    ag_ingress_stats_t st;
+    ASSERT_EQ(ag_ingress_drain(q, 0, &n), AG_OK);
+    ASSERT_EQ(n, 0);
+    ASSERT_EQ(ag_ingress_stats(q, &st), AG_OK);
+    ASSERT_EQ(st.drained, 0);
+    ASSERT_EQ(st.depth, 0);
+    ag_ingress_destroy(q);
+
+    /* NULL safety */
+    ag_ingress_destroy(NULL);
+    ASSERT_EQ(ag_ingress_capacity(NULL), 0);
+    ASSERT_EQ(ag_ingress_push(NULL, 0, 0, 0.0), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_ingress_drain(NULL, 0, NULL), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_ingress_stats(NULL, &st), AG_ERR_INVALID_ARG);
+
+    ag_tsdb_destroy(db);
+}
+
+/* Test: Drain groups records by series and keeps each series' order */
+TEST(push_drain) {
+    ag_tsdb_t* db = ag_tsdb_create(4, 256, 0);
+    ASSERT_NE(db, NULL);
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ(ag_tsdb_add(db, NULL, NULL), AG_OK);
+    }
+    ag_ingress_t* q = ag_ingress_create(db, 1024, 0);
+    ASSERT_NE(q, NULL);
+    ag_ingress_stats_t st;
+    size_t n;
+
+    /* Grouped records: one batch per run, no sort */
+    for (int64_t t = 0; t < 10; t++) {
+        ASSERT_EQ(ag_ingress_push(q, 0, t, -(double)t), AG_OK);
+    }
+    for (int64_t t = 0; t < 10; t++) {
+        ASSERT_EQ(ag_ingress_push(q, 1, t, -(double)t), AG_OK);
+    }
+    ASSERT_EQ(ag_ingress_stats(q, &st), AG_OK);
+    ASSERT_EQ(st.depth, 20);
+    ASSERT_EQ(ag_timeseries_size(ag_tsdb_get(db, 0)), 0);   /* Nothing until drained */
+    ASSERT_EQ(ag_ingress_drain(q, 0, &n), AG_OK);
+    ASSERT_EQ(n, 20);
+    ASSERT_EQ(ag_ingress_stats(q, &st), AG_OK);
+    ASSERT_EQ(st.drained, 20);
+    ASSERT_EQ(st.batches, 2);
+    ASSERT_EQ(st.depth, 0);
+    check_series(ag_tsdb_get(db, 0), 0, 10);
+    check_series(ag_tsdb_get(db, 1), 0, 10);
+
+    /* Interleaved records: grouped into one batch per series */
+    for (int64_t t = 10; t < 50; t++) {
+        for (size_t id = 0; id < 3; id++) {
+            ASSERT_EQ(ag_ingress_push(q, id, t, -(double)t), AG_OK);
+        }
+    }
+    ASSERT_EQ(ag_ingress_drain(q, 0, &n), AG_OK);
+    ASSERT_EQ(n, 120);
+    ASSERT_EQ(ag_ingress_stats(q, &st), AG_OK);
+    ASSERT_EQ(st.batches, 5);
+    check_series(ag_tsdb_get(db, 0), 0, 50);
+    check_series(ag_tsdb_get(db, 1), 0, 50);
+    ASSERT_EQ(ag_timeseries_size(ag_tsdb_get(db, 2)), 40);
+    ASSERT(ag_timeseries_is_monotonic(ag_tsdb_get(db, 2)));
+
+    /* Rounds of 256: 600 interleaved records take three, 2 x 3 + 3 batches */
+    for (int64_t t = 50; t < 250; t++) {
+        for (size_t id = 0; id < 3; id++) {
+            ASSERT_EQ(ag_ingress_push(q, id, t, -(double)t), AG_OK);
+        }
+    }
+    ASSERT_EQ(ag_ingress_drain(q, 0, &n), AG_OK);
+    ASSERT_EQ(n, 600);
+    ASSERT_EQ(ag_ingress_stats(q, &st), AG_OK);
+    ASSERT_EQ(st.batches, 14);
+    check_series(ag_tsdb_get(db, 0), 0, 250);
+
+    /* Unknown series IDs are dropped at drain time */
+    ASSERT_EQ(ag_ingress_push(q, 3, 0, 0.0), AG_OK);
+    ASSERT_EQ(ag_ingress_push(q, SIZE_MAX, 0, 0.0), AG_OK);
+    ASSERT_EQ(ag_ingress_push(q, 2, 250, -250.0), AG_OK);
+    ASSERT_EQ(ag_ingress_drain(q, 0, &n), AG_OK);
+    ASSERT_EQ(n, 3);
+    ASSERT_EQ(ag_ingress_stats(q, &st), AG_OK);
+    ASSERT_EQ(st.dropped, 2);
+    ASSERT_EQ(st.drained, 741);
+    check_series(ag_tsdb_get(db, 2), 10, 241);
+
+    ag_ingress_destroy(q);
+    ag_tsdb_destroy(db);
+}
+
+/* Test: Full queue rejects pushes; partial drains free cells */
+TEST(full_queue) {
+    ag_tsdb_t* db = ag_tsdb_create(1, 64, 0);
+    ASSERT_EQ(ag_tsdb_add(db, "a", NULL), AG_OK);
+    ag_ingress_t* q = ag_ingress_create(db, 8, 0);
+    ag_ingress_stats_t st;
+    size_t n;
+
+    for (int64_t t = 0; t < 8; t++) {
+        ASSERT_EQ(ag_ingress_push(q, 0, t, -(double)t), AG_OK);
+    }
+    ASSERT_EQ(ag_ingress_push(q, 0, 8, -8.0), AG_ERR_FULL);
+    ASSERT_EQ(ag_ingress_push(q, 0, 8, -8.0), AG_ERR_FULL);
+    ASSERT_EQ(ag_ingress_stats(q, &st), AG_OK);
+    ASSERT_EQ(st.rejected, 2);
+    ASSERT_EQ(st.depth, 8);
+
+    ASSERT_EQ(ag_ingress_drain(q, 3, &n), AG_OK);
+    ASSERT_EQ(n, 3);
+    check_series(ag_tsdb_get(db, 0), 0, 3);
+    for (int64_t t = 8; t < 11; t++) {
+        ASSERT_EQ(ag_ingress_push(q, 0, t, -(double)t), AG_OK);
+    }
+    ASSERT_EQ(ag_ingress_push(q, 0, 11, -11.0), AG_ERR_FULL);
+
+    /* Several laps of the 8 cells */
+    ASSERT_EQ(ag_ingress_drain(q, 0, &n), AG_OK);
+    ASSERT_EQ(n, 8);
+    for (int64_t t = 11; t < 51; t++) {
+        ASSERT_EQ(ag_ingress_push(q, 0, t, -(double)t), AG_OK);
+        if (t % 5 == 0) {
+            ASSERT_EQ(ag_ingress_drain(q, 0, NULL), AG_OK);
+        }
+    }
+    ASSERT_EQ(ag_ingress_drain(q, 0, NULL), AG_OK);
+    check_series(ag_tsdb_get(db, 0), 0, 51);
+    ASSERT_EQ(ag_ingress_stats(q, &st), AG_OK);
+    ASSERT_EQ(st.rejected, 3);
+    ASSERT_EQ(st.drained, 51);
+    ASSERT_EQ(st.depth, 0);
+
+    ag_ingress_destroy(q);
+    ag_tsdb_destroy(db);
+}
+
+/* Producer thread argument */
+typedef struct {
+    ag_ingress_t* q;
+    size_t series;              /* Own series */
+    size_t shared;              /* Series every producer also feeds, or SIZE_MAX */
+} producer_t;
+
+/* Helper: Push PRODUCER_RECORDS points, retrying while the queue is full */
+static void* producer_main(void* arg) {
+    producer_t* p = (producer_t*)arg;
+    for (int64_t t = 0; t < PRODUCER_RECORDS; t++) {
+        while (ag_ingress_push(p->q, p->series, t, -(double)t) != AG_OK) {
+        }
+        if (p->shared != SIZE_MAX) {
+            while (ag_ingress_push(p->q, p->shared, t, 1.0) != AG_OK) {
+            }
+        }
+    }
+    return NULL;
+}
+
+/* Helper: Drain until 'records' have been taken off the queue */
+static void drain_all(ag_ingress_t* q, uint64_t records) {
+    uint64_t taken = 0;
+    while (taken < records) {
+        size_t n = 0;
+        ASSERT_EQ(ag_ingress_drain(q, 0, &n), AG_OK);
+        taken += n;
+    }
+}
+
+/* Test: Concurrent producers while the owner drains */
+TEST(mpsc_producers) {
+    ag_tsdb_t* db = ag_tsdb_create(4, 4 * PRODUCER_RECORDS, 0);
+    for (int i = 0; i < 4; i++) {
+        ASSERT_EQ(ag_tsdb_add(db, NULL, NULL), AG_OK);
+    }
+    ag_ingress_t* q = ag_ingress_create(db, 1024, 0);
+    ASSERT_NE(q, NULL);
+
+    pthread_t threads[3];
+    producer_t producers[3];
+    for (size_t i = 0; i < 3; i++) {
+        producers[i].q = q;
+        producers[i].series = i;
+        producers[i].shared = 3;
+        ASSERT_EQ(pthread_create(&threads[i], NULL, producer_main, &producers[i]), 0);
+    }
+    drain_all(q, 6 * (uint64_t)PRODUCER_RECORDS);
+    for (size_t i = 0; i < 3; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    /* Each producer's series arrives complete and in push order */
+    for (size_t i = 0; i < 3; i++) {
+        check_series(ag_tsdb_get(db, i), 0, PRODUCER_RECORDS);
+    }
+    double sum = 0.0;
+    ag_timeseries_t* shared = ag_tsdb_get(db, 3);
+    ASSERT_EQ(ag_timeseries_size(shared), 3 * PRODUCER_RECORDS);
+    ASSERT_EQ(ag_timeseries_aggregate_range(shared, INT64_MIN, INT64_MAX, AG_AGG_SUM, &sum),
+              AG_OK);
+    ASSERT_DOUBLE_EQ(sum, 3.0 * PRODUCER_RECORDS);
+
+    ag_ingress_stats_t st;
+    ASSERT_EQ(ag_ingress_stats(q, &st), AG_OK);
+    ASSERT_EQ(st.drained, 6 * (uint64_t)PRODUCER_RECORDS);
+    ASSERT_EQ(st.dropped, 0);
+    ASSERT_EQ(st.depth, 0);
+    ASSERT(st.batches <= st.drained);
+
+    ag_ingress_destroy(q);
+    ag_tsdb_destroy(db);
+}
+
+/* Test: Single producer without the CAS */
+TEST(spsc_producer) {
+    ag_tsdb_t* db = ag_tsdb_create(1, PRODUCER_RECORDS, 0);
+    ASSERT_EQ(ag_tsdb_add(db, NULL, NULL), AG_OK);
+    ag_ingress_t* q = ag_ingress_create(db, 64, AG_INGRESS_SPSC);
+    ASSERT_NE(q, NULL);
+
+    pthread_t thread;
+    producer_t producer = { q, 0, SIZE_MAX };
+    ASSERT_EQ(pthread_create(&thread, NULL, producer_main, &producer), 0);
+    drain_all(q, PRODUCER_RECORDS);
+    pthread_join(thread, NULL);
+
+    check_series(ag_tsdb_get(db, 0), 0, PRODUCER_RECORDS);
+    ag_ingress_destroy(q);
+    ag_tsdb_destroy(db);
+}
+
+/* Main test runner */
+int main(void) {
+    printf("=== ag_ingress Unit Tests ===\n\n");
+
+    RUN_TEST(create_destroy);
+    RUN_TEST(push_drain);
+    RUN_TEST(full_queue);
+    RUN_TEST(mpsc_producers);
+    RUN_TEST(spsc_producer);
+
+    printf("\n=== All tests passed! ===\n");
+    return 0;
+}
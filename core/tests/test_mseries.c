@@ -0,0 +1,240 @@
+/*
+ * test_mseries.c - Multi-Column Series Unit Tests
+ *
+ * Test Coverage:
+ *   - Creation limits and invalid arguments
+ *   - Row append, wraparound, multi-column last/range queries
+ *   - Column handles: shared timestamps, views, aggregates, write rejection
+ *   - Unordered rows (scan fallback)
+ *   - SPMC: concurrent readers never see a torn row
+ *
+ * Copyright (c) 2025 AlgorithmicGrid
+ */
+
+#include "ag_mseries.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <pthread.h>
+
+/* Test framework macros */
+#define TEST(name) static void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("Running %s...", #name); \
+    test_##name(); \
+    printf(" PASSED\n"); \
+} while(0)
+
+#define ASSERT(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "\nAssertion failed: %s\n  File: %s\n  Line: %d\n", \
+                #cond, __FILE__, __LINE__); \
+        exit(1); \
+    } \
+} while(0)
+
+#define ASSERT_EQ(a, b) ASSERT((a) == (b))
+#define ASSERT_NE(a, b) ASSERT((a) != (b))
+#define ASSERT_DOUBLE_EQ(a, b) ASSERT(fabs((a) - (b)) < 1e-9)
+
+/* Helper: Row i of the test feed: {i, 10i, 100i} */
+static void feed_row(ag_mseries_t* ms, int64_t i) {
+    double row[3] = { (double)i, 10.0 * (double)i, 100.0 * (double)i };
+    ASSERT_EQ(ag_mseries_append_row(ms, i * 10, row), AG_OK);
+}
+
+/* Test: Create and destroy, invalid arguments */
+TEST(create_destroy) {
+    ASSERT_EQ(ag_mseries_create(0, 3, 0), NULL);
+    ASSERT_EQ(ag_mseries_create(16, 0, 0), NULL);
+    ASSERT_EQ(ag_mseries_create(16, 3, 0x80u), NULL);
+    ASSERT_EQ(ag_mseries_create(SIZE_MAX, 3, 0), NULL);
+    ASSERT_EQ(ag_mseries_create(1024, SIZE_MAX / 8, 0), NULL);
+
+    ag_mseries_t* ms = ag_mseries_create(16, 3, 0);
+    ASSERT_NE(ms, NULL);
+    ASSERT_EQ(ag_mseries_columns(ms), 3);
+    ASSERT_EQ(ag_mseries_columns(NULL), 0);
+    ASSERT_NE(ag_mseries_column(ms, 2), NULL);
+    ASSERT_EQ(ag_mseries_column(ms, 3), NULL);
+    ASSERT_EQ(ag_mseries_column(NULL, 0), NULL);
+    ASSERT_EQ(ag_timeseries_capacity(ag_mseries_column(ms, 0)), 16);
+    ASSERT_EQ(ag_timeseries_size(ag_mseries_column(ms, 0)), 0);
+    ASSERT_EQ(ag_mseries_append_row(NULL, 0, NULL), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_mseries_append_row(ms, 0, NULL), AG_ERR_INVALID_ARG);
+
+    ag_mseries_destroy(ms);
+    ag_mseries_destroy(NULL);
+}
+
+/* Test: Wrapped rows, multi-column last and range queries */
+TEST(rows_and_queries) {
+    ag_mseries_t* ms = ag_mseries_create(8, 3, 0);
+    for (int64_t i = 0; i < 12; i++) {
+        feed_row(ms, i);
+    }
+
+    /* Stored rows 4..11, wrapped */
+    int64_t timestamps[8];
+    double a[8];
+    double b[8];
+    double* out[2] = { a, b };
+    const size_t pick[2] = { 2, 0 };
+
+    ASSERT_EQ(ag_mseries_query_last(ms, pick, 2, 5, timestamps, out), 5);
+    ASSERT_EQ(timestamps[0], 110);
+    ASSERT_EQ(timestamps[4], 70);
+    ASSERT_DOUBLE_EQ(a[0], 1100.0);
+    ASSERT_DOUBLE_EQ(b[0], 11.0);
+    ASSERT_DOUBLE_EQ(a[4], 700.0);
+    ASSERT_DOUBLE_EQ(b[4], 7.0);
+
+    ASSERT_EQ(ag_mseries_query_range(ms, 55, 95, pick, 2, 8, timestamps, out), 4);
+    ASSERT_EQ(timestamps[0], 60);
+    ASSERT_EQ(timestamps[3], 90);
+    ASSERT_DOUBLE_EQ(a[3], 900.0);
+    ASSERT_DOUBLE_EQ(b[3], 9.0);
+    ASSERT_EQ(ag_mseries_query_range(ms, 0, 1000, pick, 2, 3, timestamps, out), 3);
+    ASSERT_EQ(timestamps[0], 40);
+
+    /* Invalid selections */
+    const size_t bad[1] = { 3 };
+    ASSERT_EQ(ag_mseries_query_last(ms, bad, 1, 8, timestamps, out), 0);
+    ASSERT_EQ(ag_mseries_query_last(ms, pick, 0, 8, timestamps, out), 0);
+    ASSERT_EQ(ag_mseries_query_range(ms, 10, 0, pick, 2, 8, timestamps, out), 0);
+    ASSERT_EQ(ag_mseries_query_range(NULL, 0, 10, pick, 2, 8, timestamps, out), 0);
+
+    ag_mseries_destroy(ms);
+}
+
+/* Test: Column handles reuse the series read API, reject writes */
+TEST(column_handles) {
+    ag_mseries_t* ms = ag_mseries_create(8, 3, 0);
+    for (int64_t i = 0; i < 12; i++) {
+        feed_row(ms, i);
+    }
+    const ag_timeseries_t* mid = ag_mseries_column(ms, 1);
+    const ag_timeseries_t* first = ag_mseries_column(ms, 0);
+
+    ASSERT_EQ(ag_timeseries_size(mid), 8);
+    ASSERT_EQ(ag_timeseries_sequence(mid), 12);
+    ASSERT_EQ(ag_timeseries_is_monotonic(mid), 1);
+
+    /* Spans share the timestamp array and point into the column */
+    ag_timeseries_view_t v1;
+    ag_timeseries_view_t v0;
+    ASSERT_EQ(ag_timeseries_view_range(mid, 50, 100, &v1), AG_OK);
+    ASSERT_EQ(ag_timeseries_view_range(first, 50, 100, &v0), AG_OK);
+    ASSERT_EQ(v1.length, 6);
+    ASSERT_EQ(v1.spans[0].timestamps, v0.spans[0].timestamps);
+    for (size_t r = 0; r < v1.span_count; r++) {
+        for (size_t i = 0; i < v1.spans[r].length; i++) {
+            ASSERT_DOUBLE_EQ(v1.spans[r].values[i], 10.0 * v0.spans[r].values[i]);
+        }
+    }
+
+    double sum = 0.0;
+    ASSERT_EQ(ag_timeseries_aggregate_range(mid, 0, 1000, AG_AGG_SUM, &sum), AG_OK);
+    ASSERT_DOUBLE_EQ(sum, 10.0 * (4 + 5 + 6 + 7 + 8 + 9 + 10 + 11));
+
+    int64_t t = 0;
+    double v = 0.0;
+    ASSERT_EQ(ag_timeseries_asof(mid, 75, &t, &v), AG_OK);
+    ASSERT_EQ(t, 70);
+    ASSERT_DOUBLE_EQ(v, 70.0);
+
+    /* Column handles are read-only and owned by the series */
+    ag_timeseries_t* writable = (ag_timeseries_t*)mid;
+    ASSERT_EQ(ag_timeseries_append(writable, 200, 1.0), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_enable_stats(writable), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_enable_cold(writable, 1 << 20), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_enable_reorder(writable, 10, 10), AG_ERR_INVALID_ARG);
+    ag_timeseries_destroy(writable);
+    ASSERT_EQ(ag_timeseries_size(mid), 8);
+
+    ag_mseries_destroy(ms);
+}
+
+/* Test: Late rows fall back to the scan path */
+TEST(unordered_rows) {
+    ag_mseries_t* ms = ag_mseries_create(16, 3, 0);
+    for (int64_t i = 0; i < 6; i++) {
+        feed_row(ms, i);
+    }
+    feed_row(ms, 2);    /* Late row at t=20 */
+    ASSERT_EQ(ag_timeseries_is_monotonic(ag_mseries_column(ms, 2)), 0);
+
+    int64_t timestamps[16];
+    double c[16];
+    double* out[1] = { c };
+    const size_t pick[1] = { 2 };
+    ASSERT_EQ(ag_mseries_query_range(ms, 15, 35, pick, 1, 16, timestamps, out), 3);
+    ASSERT_EQ(timestamps[0], 20);
+    ASSERT_EQ(timestamps[1], 30);
+    ASSERT_EQ(timestamps[2], 20);
+    ASSERT_DOUBLE_EQ(c[2], 200.0);
+
+    ag_mseries_destroy(ms);
+}
+
+/* SPMC: rows are {t, 2t, 3t}; a torn row would break the ratios */
+#define SPMC_ROWS 200000
+
+static void* spmc_row_reader(void* arg) {
+    const ag_mseries_t* ms = (const ag_mseries_t*)arg;
+    const size_t pick[3] = { 0, 1, 2 };
+    int64_t timestamps[64];
+    double a[64];
+    double b[64];
+    double c[64];
+    double* out[3] = { a, b, c };
+    int64_t last = -1;
+
+    while (last < SPMC_ROWS - 1) {
+        size_t n = ag_mseries_query_last(ms, pick, 3, 64, timestamps, out);
+        for (size_t i = 0; i < n; i++) {
+            double t = (double)timestamps[i];
+            ASSERT(a[i] == t && b[i] == 2.0 * t && c[i] == 3.0 * t);
+            ASSERT(i == 0 || timestamps[i] == timestamps[i - 1] - 1);
+        }
+        if (n > 0) {
+            last = timestamps[0];
+        }
+    }
+    return NULL;
+}
+
+/* Test: Concurrent readers see whole rows */
+TEST(spmc_rows) {
+    ag_mseries_t* ms = ag_mseries_create(1024, 3, AG_MSERIES_SPMC);
+    pthread_t readers[2];
+    for (int r = 0; r < 2; r++) {
+        ASSERT_EQ(pthread_create(&readers[r], NULL, spmc_row_reader, ms), 0);
+    }
+
+    for (int64_t i = 0; i < SPMC_ROWS; i++) {
+        double row[3] = { (double)i, 2.0 * (double)i, 3.0 * (double)i };
+        ag_mseries_append_row(ms, i, row);
+    }
+
+    for (int r = 0; r < 2; r++) {
+        pthread_join(readers[r], NULL);
+    }
+    ag_mseries_destroy(ms);
+}
+
+/* Main test runner */
+int main(void) {
+    printf("=== ag_mseries Unit Tests ===\n\n");
+
+    RUN_TEST(create_destroy);
+    RUN_TEST(rows_and_queries);
+    RUN_TEST(column_handles);
+    RUN_TEST(unordered_rows);
+    RUN_TEST(spmc_rows);
+
+    printf("\n=== All tests passed! ===\n");
+    return 0;
+}
@@ -2,24 +2,46 @@
  * test_timeseries.c - Comprehensive Unit Tests
  *
  * Test Coverage:
- *   - Creation and destruction
+ *   - Creation and destruction (including create_ex placement options)
  *   - Append operations (normal and boundary cases)
  *   - Ring buffer wraparound
  *   - Query last N points
  *   - Query range
+ *   - As-of lookup and multi-series alignment
+ *   - Parallel multi-series aggregation: pool sizes, stealing, concurrent callers
  *   - Size and capacity queries
  *   - NULL pointer handling
  *   - Edge cases (empty buffer, full buffer, etc.)
+ *   - SPMC concurrent writer/readers
+ *   - SIMD kernels against the scalar reference
+ *   - File-backed rings: reopen, crash recovery, corruption
+ *   - Compressed cold tier: lossless round trip, ratio, budget eviction
+ *   - Rollup chains: bucket aggregates, propagation, query routing
+ *   - Reorder buffer: sorted release, late rejection, depth bounds
+ *   - Shared-memory rings: attach, read-only readers, cross-process cursor
+ *   - Typed value columns: parity with double series, conversion, native I/O
+ *   - Instrumentation: counters, histogram buckets and quantiles
+ *   - Header-only inline fast path: parity with the library, fallbacks
+ *   - Quantile sketches: accuracy bound, exact window tracking, merging
  *
  * Copyright (c) 2025 AlgorithmicGrid
  */
 
+#define _DEFAULT_SOURCE     /* mkstemp, pwrite */
+
 #include "ag_timeseries.h"
+#include "../src/ag_kernels.h"
+#include "../src/ag_timeseries_internal.h"
+#include "ag_timeseries_inline.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 #include <math.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
 
 /* Test framework macros */
 #define TEST(name) static void test_##name(void)
@@ -443,6 +465,3008 @@ TEST(query_zero_max_points) {
     ag_timeseries_destroy(ts);
 }
 
+/* Test: Monotonic tracking and recovery after out-of-order point is evicted */
+TEST(monotonic_tracking) {
+    ag_timeseries_t* ts = ag_timeseries_create(3);
+    ASSERT_NE(ts, NULL);
+    ASSERT_EQ(ag_timeseries_is_monotonic(ts), 1);
+    ASSERT_EQ(ag_timeseries_is_monotonic(NULL), 0);
+
+    ag_timeseries_append(ts, 1000, 1.0);
+    ag_timeseries_append(ts, 2000, 2.0);
+    ag_timeseries_append(ts, 2000, 2.5);  /* Equal timestamps stay ordered */
+    ASSERT_EQ(ag_timeseries_is_monotonic(ts), 1);
+
+    ag_timeseries_append(ts, 1500, 3.0);  /* Buffer: 2000, 2000, 1500 */
+    ASSERT_EQ(ag_timeseries_is_monotonic(ts), 0);
+
+    ag_timeseries_append(ts, 3000, 4.0);  /* Buffer: 2000, 1500, 3000 */
+    ASSERT_EQ(ag_timeseries_is_monotonic(ts), 0);
+
+    ag_timeseries_append(ts, 4000, 5.0);  /* Buffer: 1500, 3000, 4000 */
+    ASSERT_EQ(ag_timeseries_is_monotonic(ts), 1);
+
+    ag_timeseries_destroy(ts);
+}
+
+/* Test: Range query on unordered window still scans correctly */
+TEST(query_range_unordered) {
+    ag_timeseries_t* ts = ag_timeseries_create(5);
+    ASSERT_NE(ts, NULL);
+
+    ag_timeseries_append(ts, 3000, 3.0);
+    ag_timeseries_append(ts, 1000, 1.0);
+    ag_timeseries_append(ts, 5000, 5.0);
+    ag_timeseries_append(ts, 2000, 2.0);
+
+    int64_t timestamps[5];
+    double values[5];
+    size_t count = ag_timeseries_query_range(ts, 1500, 3500, 5, timestamps, values);
+
+    ASSERT_EQ(count, 2);
+    ASSERT_EQ(timestamps[0], 3000);  /* Insertion order preserved */
+    ASSERT_EQ(timestamps[1], 2000);
+    ASSERT_DOUBLE_EQ(values[1], 2.0);
+
+    ag_timeseries_destroy(ts);
+}
+
+/* Test: Binary-search range query across wrap point with duplicates */
+TEST(query_range_monotonic_wrap) {
+    ag_timeseries_t* ts = ag_timeseries_create(8);
+    ASSERT_NE(ts, NULL);
+
+    /* 13 points, two per timestamp: 0,0,100,100,...; wraps once */
+    for (int i = 0; i < 13; i++) {
+        ag_timeseries_append(ts, (i / 2) * 100, i * 1.0);
+    }
+    /* Stored (oldest first): 200, 300,300, 400,400, 500,500, 600 */
+    ASSERT_EQ(ag_timeseries_is_monotonic(ts), 1);
+
+    int64_t timestamps[8];
+    double values[8];
+    size_t count = ag_timeseries_query_range(ts, 300, 500, 8, timestamps, values);
+    ASSERT_EQ(count, 6);
+    ASSERT_EQ(timestamps[0], 300);
+    ASSERT_DOUBLE_EQ(values[0], 6.0);
+    ASSERT_EQ(timestamps[5], 500);
+    ASSERT_DOUBLE_EQ(values[5], 11.0);
+
+    /* Range entirely before, after, and spanning everything */
+    ASSERT_EQ(ag_timeseries_query_range(ts, 0, 150, 8, timestamps, values), 0);
+    ASSERT_EQ(ag_timeseries_query_range(ts, 601, 900, 8, timestamps, values), 0);
+    ASSERT_EQ(ag_timeseries_query_range(ts, -100, 1000, 8, timestamps, values), 8);
+    ASSERT_EQ(timestamps[0], 200);
+    ASSERT_EQ(timestamps[7], 600);
+
+    /* max_points truncation returns the oldest matches */
+    count = ag_timeseries_query_range(ts, 400, 600, 3, timestamps, values);
+    ASSERT_EQ(count, 3);
+    ASSERT_EQ(timestamps[0], 400);
+    ASSERT_EQ(timestamps[2], 500);
+    ASSERT_DOUBLE_EQ(values[2], 10.0);
+
+    ag_timeseries_destroy(ts);
+}
+
+/* Test: SPMC buffer behaves like a regular buffer single-threaded */
+TEST(spmc_single_thread) {
+    ag_timeseries_t* ts = ag_timeseries_create_spmc(3);
+    ASSERT_NE(ts, NULL);
+    ASSERT_EQ(ag_timeseries_create_spmc(0), NULL);
+
+    for (int i = 1; i <= 5; i++) {
+        ASSERT_EQ(ag_timeseries_append(ts, i * 1000, i * 1.0), AG_OK);
+    }
+    ASSERT_EQ(ag_timeseries_size(ts), 3);
+
+    int64_t timestamps[3];
+    double values[3];
+    size_t count = ag_timeseries_query_last(ts, 3, timestamps, values);
+    ASSERT_EQ(count, 3);
+    ASSERT_EQ(timestamps[0], 5000);
+    ASSERT_EQ(timestamps[2], 3000);
+
+    count = ag_timeseries_query_range(ts, 0, 10000, 3, timestamps, values);
+    ASSERT_EQ(count, 3);
+    ASSERT_EQ(timestamps[0], 3000);
+    ASSERT_DOUBLE_EQ(values[2], 5.0);
+
+    ag_timeseries_destroy(ts);
+}
+
+#define SPMC_CAPACITY 64
+#define SPMC_POINTS 200000
+
+typedef struct {
+    ag_timeseries_t* ts;
+    int failed;
+} spmc_reader_t;
+
+static void* spmc_reader(void* arg) {
+    spmc_reader_t* reader = (spmc_reader_t*)arg;
+    int64_t timestamps[SPMC_CAPACITY];
+    double values[SPMC_CAPACITY];
+    int64_t newest = -1;
+
+    while (newest < SPMC_POINTS - 1) {
+        /* Newest first, consecutive timestamps, value == timestamp / 2 */
+        size_t count = ag_timeseries_query_last(reader->ts, SPMC_CAPACITY,
+                                                timestamps, values);
+        for (size_t i = 0; i < count; i++) {
+            if (values[i] != timestamps[i] * 0.5 ||
+                (i > 0 && timestamps[i] != timestamps[i - 1] - 1)) {
+                reader->failed = 1;
+                return NULL;
+            }
+        }
+        if (count > 0) {
+            newest = timestamps[0];
+        }
+
+        /* Stats snapshot must describe one consecutive window */
+        ag_timeseries_stats_t st;
+        if (ag_timeseries_stats(reader->ts, &st) == AG_OK &&
+            (st.sum != st.count * (st.min + st.max) / 2.0 ||
+             st.max - st.min != (st.count - 1) * 0.5)) {
+            reader->failed = 1;
+            return NULL;
+        }
+
+        /* Range over the whole window must be contiguous and oldest first */
+        count = ag_timeseries_query_range(reader->ts, 0, newest, SPMC_CAPACITY,
+                                          timestamps, values);
+        for (size_t i = 0; i < count; i++) {
+            if (values[i] != timestamps[i] * 0.5 ||
+                (i > 0 && timestamps[i] != timestamps[i - 1] + 1)) {
+                reader->failed = 1;
+                return NULL;
+            }
+        }
+    }
+    return NULL;
+}
+
+/* Test: SPMC readers see consistent snapshots while writer wraps */
+TEST(spmc_concurrent_readers) {
+    ag_timeseries_t* ts = ag_timeseries_create_spmc(SPMC_CAPACITY);
+    ASSERT_NE(ts, NULL);
+    ASSERT_EQ(ag_timeseries_enable_stats(ts), AG_OK);
+
+    spmc_reader_t readers[2] = {{ts, 0}, {ts, 0}};
+    pthread_t threads[2];
+    for (int i = 0; i < 2; i++) {
+        ASSERT_EQ(pthread_create(&threads[i], NULL, spmc_reader, &readers[i]), 0);
+    }
+
+    for (int64_t i = 0; i < SPMC_POINTS; i++) {
+        ag_timeseries_append(ts, i, i * 0.5);
+    }
+
+    for (int i = 0; i < 2; i++) {
+        pthread_join(threads[i], NULL);
+        ASSERT_EQ(readers[i].failed, 0);
+    }
+    ASSERT_EQ(ag_timeseries_size(ts), SPMC_CAPACITY);
+
+    ag_timeseries_destroy(ts);
+}
+
+/*
+ * Cursor reader: every point arrives exactly once, in order, or is counted
+ * as lost; delivered + lost must add up to everything appended.
+ */
+static void* spmc_cursor_reader(void* arg) {
+    spmc_reader_t* reader = (spmc_reader_t*)arg;
+    int64_t timestamps[16];
+    double values[16];
+    ag_ts_cursor_t cursor;
+    uint64_t delivered = 0;
+
+    /* The writer may already be running: replay starts at the oldest stored */
+    if (ag_timeseries_cursor_init(reader->ts, AG_CURSOR_OLDEST, &cursor) != AG_OK) {
+        reader->failed = 1;
+        return NULL;
+    }
+    uint64_t start = cursor.next_seq;
+    int64_t expect = (int64_t)start;
+    while (expect < SPMC_POINTS) {
+        size_t count = 0;
+        uint64_t lost = 0;
+        int rc = ag_timeseries_cursor_read(reader->ts, &cursor, 16, timestamps,
+                                           values, &count, &lost);
+        if ((rc == AG_OK) != (lost == 0) || (rc != AG_OK && rc != AG_ERR_LAPPED)) {
+            reader->failed = 1;
+            return NULL;
+        }
+        expect += (int64_t)lost;
+        for (size_t i = 0; i < count; i++, expect++) {
+            if (timestamps[i] != expect || values[i] != expect * 0.5) {
+                reader->failed = 1;
+                return NULL;
+            }
+        }
+        delivered += count;
+    }
+    if (start + delivered + cursor.lost != SPMC_POINTS || cursor.next_seq != SPMC_POINTS) {
+        reader->failed = 1;
+    }
+    return NULL;
+}
+
+/* Test: SPMC cursor readers stream every point once or report it lost */
+TEST(spmc_cursor_readers) {
+    ag_timeseries_t* ts = ag_timeseries_create_spmc(SPMC_CAPACITY);
+    ASSERT_NE(ts, NULL);
+
+    spmc_reader_t readers[2] = {{ts, 0}, {ts, 0}};
+    pthread_t threads[2];
+    for (int i = 0; i < 2; i++) {
+        ASSERT_EQ(pthread_create(&threads[i], NULL, spmc_cursor_reader, &readers[i]), 0);
+    }
+
+    for (int64_t i = 0; i < SPMC_POINTS; i++) {
+        ag_timeseries_append(ts, i, i * 0.5);
+    }
+
+    for (int i = 0; i < 2; i++) {
+        pthread_join(threads[i], NULL);
+        ASSERT_EQ(readers[i].failed, 0);
+    }
+
+    ag_timeseries_destroy(ts);
+}
+
+/* Test: Batch append matches per-point appends across the wrap point */
+TEST(append_batch_wraparound) {
+    ag_timeseries_t* batch = ag_timeseries_create(7);
+    ag_timeseries_t* single = ag_timeseries_create(7);
+    ASSERT_NE(batch, NULL);
+    ASSERT_NE(single, NULL);
+
+    int64_t in_ts[5];
+    double in_vals[5];
+    for (int round = 0; round < 4; round++) {
+        for (int i = 0; i < 5; i++) {
+            in_ts[i] = (round * 5 + i) * 100;
+            in_vals[i] = round * 5 + i;
+            ag_timeseries_append(single, in_ts[i], in_vals[i]);
+        }
+        ASSERT_EQ(ag_timeseries_append_batch(batch, in_ts, in_vals, 5), AG_OK);
+    }
+    ASSERT_EQ(ag_timeseries_size(batch), 7);
+
+    int64_t ts_a[7], ts_b[7];
+    double vals_a[7], vals_b[7];
+    ASSERT_EQ(ag_timeseries_query_last(batch, 7, ts_a, vals_a), 7);
+    ASSERT_EQ(ag_timeseries_query_last(single, 7, ts_b, vals_b), 7);
+    for (int i = 0; i < 7; i++) {
+        ASSERT_EQ(ts_a[i], ts_b[i]);
+        ASSERT_DOUBLE_EQ(vals_a[i], vals_b[i]);
+    }
+    ASSERT_EQ(ts_a[0], 1900);
+    ASSERT_EQ(ts_a[6], 1300);
+
+    /* Appends after a batch continue from the right position */
+    ag_timeseries_append(batch, 2000, 20.0);
+    ASSERT_EQ(ag_timeseries_query_last(batch, 2, ts_a, vals_a), 2);
+    ASSERT_EQ(ts_a[0], 2000);
+    ASSERT_EQ(ts_a[1], 1900);
+
+    ag_timeseries_destroy(batch);
+    ag_timeseries_destroy(single);
+}
+
+/* Test: Batch larger than capacity keeps only the newest points */
+TEST(append_batch_exceeds_capacity) {
+    ag_timeseries_t* ts = ag_timeseries_create(4);
+    ASSERT_NE(ts, NULL);
+
+    ag_timeseries_append(ts, 1, 1.0);
+
+    int64_t in_ts[10];
+    double in_vals[10];
+    for (int i = 0; i < 10; i++) {
+        in_ts[i] = 100 + i;
+        in_vals[i] = i * 2.0;
+    }
+    ASSERT_EQ(ag_timeseries_append_batch(ts, in_ts, in_vals, 10), AG_OK);
+    ASSERT_EQ(ag_timeseries_size(ts), 4);
+
+    int64_t timestamps[4];
+    double values[4];
+    ASSERT_EQ(ag_timeseries_query_range(ts, 0, 1000, 4, timestamps, values), 4);
+    ASSERT_EQ(timestamps[0], 106);
+    ASSERT_DOUBLE_EQ(values[0], 12.0);
+    ASSERT_EQ(timestamps[3], 109);
+    ASSERT_DOUBLE_EQ(values[3], 18.0);
+
+    ag_timeseries_destroy(ts);
+}
+
+/* Test: Batch append argument validation and ordering tracking */
+TEST(append_batch_args_and_ordering) {
+    int64_t in_ts[3] = {3000, 1000, 2000};
+    double in_vals[3] = {3.0, 1.0, 2.0};
+
+    ASSERT_EQ(ag_timeseries_append_batch(NULL, in_ts, in_vals, 3), AG_ERR_INVALID_ARG);
+
+    ag_timeseries_t* ts = ag_timeseries_create(4);
+    ASSERT_NE(ts, NULL);
+    ASSERT_EQ(ag_timeseries_append_batch(ts, NULL, in_vals, 3), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_append_batch(ts, NULL, NULL, 0), AG_OK);
+    ASSERT_EQ(ag_timeseries_size(ts), 0);
+
+    ASSERT_EQ(ag_timeseries_append_batch(ts, in_ts, in_vals, 3), AG_OK);
+    ASSERT_EQ(ag_timeseries_is_monotonic(ts), 0);
+
+    /* Late point relative to the stored newest is detected too */
+    ag_timeseries_t* ts2 = ag_timeseries_create(4);
+    ASSERT_NE(ts2, NULL);
+    ag_timeseries_append(ts2, 5000, 5.0);
+    int64_t late_ts[2] = {4000, 6000};
+    ASSERT_EQ(ag_timeseries_append_batch(ts2, late_ts, in_vals, 2), AG_OK);
+    ASSERT_EQ(ag_timeseries_is_monotonic(ts2), 0);
+
+    /* Ordered batch evicting the late point restores monotonic */
+    int64_t ordered_ts[3] = {7000, 8000, 9000};
+    ASSERT_EQ(ag_timeseries_append_batch(ts2, ordered_ts, in_vals, 3), AG_OK);
+    ASSERT_EQ(ag_timeseries_is_monotonic(ts2), 1);
+
+    ag_timeseries_destroy(ts);
+    ag_timeseries_destroy(ts2);
+}
+
+/* Test: Power-of-two creation rounds up and wraps with mask indexing */
+TEST(create_pow2) {
+    ASSERT_EQ(ag_timeseries_create_pow2(0), NULL);
+    ASSERT_EQ(ag_timeseries_create_pow2(SIZE_MAX), NULL);
+
+    ag_timeseries_t* ts = ag_timeseries_create_pow2(5);
+    ASSERT_NE(ts, NULL);
+    ASSERT_EQ(ag_timeseries_capacity(ts), 8);
+
+    ag_timeseries_t* exact = ag_timeseries_create_pow2(16);
+    ASSERT_NE(exact, NULL);
+    ASSERT_EQ(ag_timeseries_capacity(exact), 16);
+    ag_timeseries_destroy(exact);
+
+    for (int i = 0; i < 21; i++) {
+        ag_timeseries_append(ts, i * 10, i * 1.0);
+    }
+    ASSERT_EQ(ag_timeseries_size(ts), 8);
+
+    int64_t timestamps[8];
+    double values[8];
+    ASSERT_EQ(ag_timeseries_query_last(ts, 8, timestamps, values), 8);
+    ASSERT_EQ(timestamps[0], 200);
+    ASSERT_EQ(timestamps[7], 130);
+
+    ASSERT_EQ(ag_timeseries_query_range(ts, 155, 185, 8, timestamps, values), 3);
+    ASSERT_EQ(timestamps[0], 160);
+    ASSERT_DOUBLE_EQ(values[2], 18.0);
+
+    ag_timeseries_destroy(ts);
+}
+
+/* Test: create_ex placement options keep ring behavior unchanged */
+TEST(create_ex_options) {
+    ag_timeseries_options_t opt = { 0, 0, AG_VALUE_F64 };
+    ASSERT_EQ(ag_timeseries_create_ex(0, NULL), NULL);
+    opt.flags = 0x80u;
+    ASSERT_EQ(ag_timeseries_create_ex(16, &opt), NULL);
+    opt.flags = AG_CREATE_NUMA;
+    opt.numa_node = -1;
+    ASSERT_EQ(ag_timeseries_create_ex(16, &opt), NULL);
+    opt.numa_node = AG_CREATE_MAX_NUMA_NODES;
+    ASSERT_EQ(ag_timeseries_create_ex(16, &opt), NULL);
+
+    const unsigned variants[] = {
+        0,
+        AG_CREATE_LAZY,
+        AG_CREATE_HUGEPAGES | AG_CREATE_MLOCK,
+        AG_CREATE_INTERLEAVED | AG_CREATE_LAZY,
+        AG_CREATE_SPMC | AG_CREATE_HUGEPAGES,
+        AG_CREATE_NUMA,
+    };
+    for (size_t k = 0; k < sizeof(variants) / sizeof(variants[0]); k++) {
+        opt.flags = variants[k];
+        opt.numa_node = 0;
+        ag_timeseries_t* ts = ag_timeseries_create_ex(100, (k == 0) ? NULL : &opt);
+        if (ts == NULL && (variants[k] & AG_CREATE_NUMA)) {
+            continue;  /* Kernel without NUMA policy support */
+        }
+        ASSERT_NE(ts, NULL);
+        ASSERT_EQ(ag_timeseries_capacity(ts), 100);
+
+        /* Fresh pages read as zero without a memset */
+        ASSERT_EQ(ts->timestamps[0], 0);
+        ASSERT_EQ(ts->timestamps[99 * ts->stride], 0);
+        ASSERT_EQ(ts->stride, (variants[k] & AG_CREATE_INTERLEAVED) ? 2u : 1u);
+        ASSERT_EQ(ts->spmc, (variants[k] & AG_CREATE_SPMC) != 0);
+
+        for (int64_t i = 0; i < 250; i++) {
+            ASSERT_EQ(ag_timeseries_append(ts, i, (double)i), AG_OK);
+        }
+        int64_t timestamps[100];
+        double values[100];
+        ASSERT_EQ(ag_timeseries_query_last(ts, 100, timestamps, values), 100);
+        ASSERT_EQ(timestamps[0], 249);
+        ASSERT_EQ(timestamps[99], 150);
+        ASSERT_EQ(ag_timeseries_query_range(ts, 200, 209, 100, timestamps, values), 10);
+        ASSERT_DOUBLE_EQ(values[9], 209.0);
+        ag_timeseries_destroy(ts);
+    }
+}
+
+/* Test: Append sequence counts every point, including overwritten ones */
+TEST(sequence_counter) {
+    ASSERT_EQ(ag_timeseries_sequence(NULL), 0);
+
+    ag_timeseries_t* ts = ag_timeseries_create(4);
+    ASSERT_NE(ts, NULL);
+    ASSERT_EQ(ag_timeseries_sequence(ts), 0);
+
+    for (int i = 0; i < 10; i++) {
+        ag_timeseries_append(ts, i, i * 1.0);
+    }
+    ASSERT_EQ(ag_timeseries_sequence(ts), 10);
+
+    int64_t in_ts[3] = {10, 11, 12};
+    double in_vals[3] = {10.0, 11.0, 12.0};
+    ag_timeseries_append_batch(ts, in_ts, in_vals, 3);
+    ASSERT_EQ(ag_timeseries_sequence(ts), 13);
+    ASSERT_EQ(ag_timeseries_size(ts), 4);
+
+    ag_timeseries_destroy(ts);
+}
+
+/* Helper: Sum view values and flatten timestamps, oldest first */
+static double view_sum(const ag_timeseries_view_t* view, int64_t* out_ts) {
+    double sum = 0.0;
+    size_t n = 0;
+    for (size_t s = 0; s < view->span_count; s++) {
+        for (size_t i = 0; i < view->spans[s].length; i++) {
+            sum += view->spans[s].values[i];
+            out_ts[n++] = view->spans[s].timestamps[i];
+        }
+    }
+    return sum;
+}
+
+/* Test: View last N points in place across the wrap point */
+TEST(view_last) {
+    ag_timeseries_view_t view;
+    ASSERT_EQ(ag_timeseries_view_last(NULL, 5, &view), AG_ERR_INVALID_ARG);
+
+    ag_timeseries_t* ts = ag_timeseries_create(5);
+    ASSERT_NE(ts, NULL);
+    ASSERT_EQ(ag_timeseries_view_last(ts, 5, NULL), AG_ERR_INVALID_ARG);
+
+    ASSERT_EQ(ag_timeseries_view_last(ts, 5, &view), AG_OK);
+    ASSERT_EQ(view.length, 0);
+    ASSERT_EQ(view.span_count, 0);
+
+    for (int i = 0; i < 7; i++) {
+        ag_timeseries_append(ts, i * 100, i * 1.0);
+    }
+
+    /* Stored slots: [500, 600, 200, 300, 400] - last 4 wrap once */
+    ASSERT_EQ(ag_timeseries_view_last(ts, 4, &view), AG_OK);
+    ASSERT_EQ(view.length, 4);
+    ASSERT_EQ(view.span_count, 2);
+    ASSERT_EQ(view.begin_seq, 3);
+    ASSERT_EQ(view.end_seq, 7);
+
+    int64_t timestamps[5];
+    ASSERT_DOUBLE_EQ(view_sum(&view, timestamps), 3.0 + 4.0 + 5.0 + 6.0);
+    ASSERT_EQ(timestamps[0], 300);
+    ASSERT_EQ(timestamps[3], 600);
+    ASSERT_EQ(ag_timeseries_view_valid(ts, &view), 1);
+
+    /* One more append overwrites 200 only; the view survives */
+    ag_timeseries_append(ts, 700, 7.0);
+    ASSERT_EQ(ag_timeseries_view_valid(ts, &view), 1);
+
+    /* Next append overwrites 300 - the view's oldest point */
+    ag_timeseries_append(ts, 800, 8.0);
+    ASSERT_EQ(ag_timeseries_view_valid(ts, &view), 0);
+    ASSERT_EQ(ag_timeseries_view_valid(NULL, &view), 0);
+
+    ag_timeseries_destroy(ts);
+}
+
+/* Test: View time range in place, including unordered rejection */
+TEST(view_range) {
+    ag_timeseries_t* ts = ag_timeseries_create(6);
+    ASSERT_NE(ts, NULL);
+
+    for (int i = 0; i < 9; i++) {
+        ag_timeseries_append(ts, i * 100, i * 1.0);
+    }
+
+    /* Stored oldest first: 300..800, wrapping after 500 */
+    ag_timeseries_view_t view;
+    int64_t timestamps[6];
+    ASSERT_EQ(ag_timeseries_view_range(ts, 350, 750, &view), AG_OK);
+    ASSERT_EQ(view.length, 4);
+    ASSERT_EQ(view.begin_seq, 4);
+    ASSERT_EQ(view.end_seq, 8);
+    ASSERT_DOUBLE_EQ(view_sum(&view, timestamps), 4.0 + 5.0 + 6.0 + 7.0);
+    ASSERT_EQ(timestamps[0], 400);
+    ASSERT_EQ(timestamps[3], 700);
+
+    ASSERT_EQ(ag_timeseries_view_range(ts, 900, 1000, &view), AG_OK);
+    ASSERT_EQ(view.length, 0);
+    ASSERT_EQ(ag_timeseries_view_range(ts, 700, 100, &view), AG_OK);
+    ASSERT_EQ(view.length, 0);
+
+    ag_timeseries_append(ts, 50, 0.5);
+    ASSERT_EQ(ag_timeseries_view_range(ts, 0, 1000, &view), AG_ERR_UNORDERED);
+
+    ag_timeseries_destroy(ts);
+}
+
+/* Helper: Check maintained stats against a brute-force pass over query_last */
+static void check_stats(ag_timeseries_t* ts) {
+    size_t n = ag_timeseries_size(ts);
+    int64_t* timestamps = malloc(n * sizeof(int64_t));
+    double* values = malloc(n * sizeof(double));
+    ASSERT(timestamps != NULL && values != NULL);
+    ASSERT_EQ(ag_timeseries_query_last(ts, n, timestamps, values), n);
+
+    double sum = 0.0, sum_sq = 0.0, min = values[0], max = values[0];
+    for (size_t i = 0; i < n; i++) {
+        sum += values[i];
+        sum_sq += values[i] * values[i];
+        min = (values[i] < min) ? values[i] : min;
+        max = (values[i] > max) ? values[i] : max;
+    }
+
+    ag_timeseries_stats_t st;
+    ASSERT_EQ(ag_timeseries_stats(ts, &st), AG_OK);
+    ASSERT_EQ(st.count, n);
+    ASSERT(fabs(st.sum - sum) < 1e-6);
+    ASSERT(fabs(st.sum_sq - sum_sq) < 1e-6);
+    ASSERT(fabs(st.mean - sum / n) < 1e-9);
+    ASSERT_DOUBLE_EQ(st.min, min);
+    ASSERT_DOUBLE_EQ(st.max, max);
+    ASSERT(st.variance >= 0.0);
+
+    free(timestamps);
+    free(values);
+}
+
+/* Test: Rolling stats track a wrapping window, single and batch appends */
+TEST(rolling_stats) {
+    ag_timeseries_stats_t st;
+    ASSERT_EQ(ag_timeseries_enable_stats(NULL), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_stats(NULL, &st), AG_ERR_INVALID_ARG);
+
+    ag_timeseries_t* ts = ag_timeseries_create(16);
+    ASSERT_NE(ts, NULL);
+    ASSERT_EQ(ag_timeseries_stats(ts, &st), AG_ERR_INVALID_ARG);  /* Not enabled */
+
+    /* Seed with points before enabling */
+    for (int i = 0; i < 5; i++) {
+        ag_timeseries_append(ts, i, (double)((i * 7) % 11));
+    }
+    ASSERT_EQ(ag_timeseries_enable_stats(ts), AG_OK);
+    ASSERT_EQ(ag_timeseries_enable_stats(ts), AG_OK);
+    check_stats(ts);
+
+    /* Pseudo-random walk, several wraps */
+    unsigned int x = 12345;
+    for (int i = 5; i < 200; i++) {
+        x = x * 1103515245u + 12345u;
+        ag_timeseries_append(ts, i, (double)((x >> 16) % 1000) / 10.0 - 50.0);
+        check_stats(ts);
+    }
+
+    /* Batches smaller than, and larger than, capacity */
+    int64_t in_ts[40];
+    double in_vals[40];
+    for (int i = 0; i < 40; i++) {
+        in_ts[i] = 200 + i;
+        in_vals[i] = (i % 2) ? i * 1.5 : -i * 0.5;
+    }
+    ag_timeseries_append_batch(ts, in_ts, in_vals, 7);
+    check_stats(ts);
+    ag_timeseries_append_batch(ts, in_ts, in_vals, 40);
+    check_stats(ts);
+    ASSERT_EQ(ag_timeseries_stats(ts, &st), AG_OK);
+    ASSERT_DOUBLE_EQ(st.max, 39 * 1.5);
+
+    ag_timeseries_destroy(ts);
+}
+
+/* Test: Rolling stats on empty and capacity-one SPMC buffers */
+TEST(rolling_stats_edge_cases) {
+    ag_timeseries_t* ts = ag_timeseries_create_spmc(1);
+    ASSERT_NE(ts, NULL);
+    ASSERT_EQ(ag_timeseries_enable_stats(ts), AG_OK);
+
+    ag_timeseries_stats_t st;
+    ASSERT_EQ(ag_timeseries_stats(ts, &st), AG_ERR_EMPTY);
+
+    ag_timeseries_append(ts, 1, 3.0);
+    ag_timeseries_append(ts, 2, -4.0);
+    ASSERT_EQ(ag_timeseries_stats(ts, &st), AG_OK);
+    ASSERT_EQ(st.count, 1);
+    ASSERT_DOUBLE_EQ(st.sum, -4.0);
+    ASSERT_DOUBLE_EQ(st.min, -4.0);
+    ASSERT_DOUBLE_EQ(st.max, -4.0);
+    ASSERT_DOUBLE_EQ(st.variance, 0.0);
+
+    ag_timeseries_destroy(ts);
+}
+
+/* Test: Variance of a small spread at a large price level */
+TEST(rolling_stats_large_offset) {
+    ag_timeseries_t* ts = ag_timeseries_create(1000);
+    ASSERT_NE(ts, NULL);
+    ASSERT_EQ(ag_timeseries_enable_stats(ts), AG_OK);
+
+    /* Window of 1e8 + {0, 1}: variance 0.25; several wraps of eviction */
+    ag_timeseries_stats_t st;
+    for (int64_t i = 0; i < 3500; i++) {
+        ag_timeseries_append(ts, i, 1e8 + (double)(i % 2));
+    }
+    ASSERT_EQ(ag_timeseries_stats(ts, &st), AG_OK);
+    ASSERT_EQ(st.count, 1000);
+    ASSERT(fabs(st.variance - 0.25) < 1e-9);
+    ASSERT(fabs(st.mean - (1e8 + 0.5)) < 1e-6);
+    ASSERT(fabs(st.sum - 1000 * (1e8 + 0.5)) < 1e-3);
+
+    /* Tick-sized spread at BTC level, restarting from an emptied window */
+    int64_t in_ts[1000];
+    double in_vals[1000];
+    for (int i = 0; i < 1000; i++) {
+        in_ts[i] = 4000 + i;
+        in_vals[i] = 50000.0 + 0.01 * (double)(i % 2);
+    }
+    ASSERT_EQ(ag_timeseries_append_batch(ts, in_ts, in_vals, 1000), AG_OK);
+    ASSERT_EQ(ag_timeseries_stats(ts, &st), AG_OK);
+    ASSERT(fabs(st.variance - 2.5e-5) < 2.5e-5 * 1e-6);
+    ASSERT(fabs(st.sum_sq - 1000 * 50000.005 * 50000.005 - 1000 * 2.5e-5) < 1.0);
+    ag_timeseries_destroy(ts);
+
+    /* A streaming window never empties: the shift follows the level */
+    ts = ag_timeseries_create(1000);
+    ASSERT_EQ(ag_timeseries_enable_stats(ts), AG_OK);
+    ag_timeseries_append(ts, 0, 0.0);
+    for (int64_t i = 0; i < 5000; i++) {
+        ag_timeseries_append(ts, 1 + i, 1e8 + (double)(i % 2));
+    }
+    ASSERT_EQ(ag_timeseries_stats(ts, &st), AG_OK);
+    ASSERT(fabs(st.variance - 0.25) < 1e-9);
+    ASSERT(fabs(st.mean - (1e8 + 0.5)) < 1e-6);
+
+    ag_timeseries_destroy(ts);
+
+    /* Level moving 20000 -> 60000, then a 0.01 spread */
+    ts = ag_timeseries_create(1000);
+    ASSERT_EQ(ag_timeseries_enable_stats(ts), AG_OK);
+    for (int64_t i = 0; i < 1000; i++) {
+        ag_timeseries_append(ts, i, 20000.0 + 40.0 * (double)i);
+    }
+    for (int64_t i = 0; i < 5000; i++) {
+        ag_timeseries_append(ts, 1000 + i, 60000.0 + 0.01 * (double)(i % 2));
+    }
+    ASSERT_EQ(ag_timeseries_stats(ts, &st), AG_OK);
+    ASSERT(fabs(st.variance - 2.5e-5) < 2.5e-5 * 1e-6);
+    ASSERT(fabs(st.mean - 60000.005) < 1e-9);
+    ag_timeseries_destroy(ts);
+}
+
+/* Helper: Brute-force aggregate via query_range */
+static int brute_aggregate(ag_timeseries_t* ts, int64_t lo, int64_t hi, int agg,
+                           double* out) {
+    size_t cap = ag_timeseries_capacity(ts);
+    int64_t* timestamps = malloc(cap * sizeof(int64_t));
+    double* values = malloc(cap * sizeof(double));
+    ASSERT(timestamps != NULL && values != NULL);
+    size_t n = ag_timeseries_query_range(ts, lo, hi, cap, timestamps, values);
+
+    double sum = 0.0, min = INFINITY, max = -INFINITY;
+    for (size_t i = 0; i < n; i++) {
+        sum += values[i];
+        min = (values[i] < min) ? values[i] : min;
+        max = (values[i] > max) ? values[i] : max;
+    }
+    free(timestamps);
+    free(values);
+
+    switch (agg) {
+    case AG_AGG_COUNT: *out = (double)n; return AG_OK;
+    case AG_AGG_SUM: *out = sum; return AG_OK;
+    case AG_AGG_MEAN: *out = n ? sum / n : 0.0; return n ? AG_OK : AG_ERR_EMPTY;
+    case AG_AGG_MIN: *out = min; return n ? AG_OK : AG_ERR_EMPTY;
+    default: *out = max; return n ? AG_OK : AG_ERR_EMPTY;
+    }
+}
+
+/* Helper: Compare aggregate_range with brute force for all aggregates */
+static void check_aggregates(ag_timeseries_t* ts, int64_t lo, int64_t hi) {
+    for (int agg = AG_AGG_COUNT; agg <= AG_AGG_MAX; agg++) {
+        double expected = 0.0, actual = 0.0;
+        int rc_expected = brute_aggregate(ts, lo, hi, agg, &expected);
+        int rc = ag_timeseries_aggregate_range(ts, lo, hi, agg, &actual);
+        ASSERT_EQ(rc, rc_expected);
+        if (rc == AG_OK) {
+            ASSERT(fabs(actual - expected) < 1e-6);
+        }
+    }
+}
+
+/* Test: Range aggregation on ordered and unordered wrapped windows */
+TEST(aggregate_range) {
+    double out;
+    ASSERT_EQ(ag_timeseries_aggregate_range(NULL, 0, 1, AG_AGG_SUM, &out), AG_ERR_INVALID_ARG);
+
+    ag_timeseries_t* ts = ag_timeseries_create(101);
+    ASSERT_NE(ts, NULL);
+    ASSERT_EQ(ag_timeseries_aggregate_range(ts, 0, 1, AG_AGG_SUM, NULL), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_aggregate_range(ts, 0, 1, 99, &out), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_aggregate_range(ts, 0, 1, AG_AGG_MIN, &out), AG_ERR_EMPTY);
+    ASSERT_EQ(ag_timeseries_aggregate_range(ts, 0, 1, AG_AGG_COUNT, &out), AG_OK);
+    ASSERT_DOUBLE_EQ(out, 0.0);
+
+    /* Ordered, wrapped: 250 points into capacity 101 */
+    for (int i = 0; i < 250; i++) {
+        ag_timeseries_append(ts, i * 10, sin(i * 0.1) * 100.0);
+    }
+    ASSERT_EQ(ag_timeseries_is_monotonic(ts), 1);
+    check_aggregates(ts, 1500, 2200);
+    check_aggregates(ts, 1493, 1517);
+    check_aggregates(ts, INT64_MIN, INT64_MAX);
+    check_aggregates(ts, 0, 100);
+    check_aggregates(ts, 2000, 1000);
+
+    ASSERT_EQ(ag_timeseries_aggregate_range(ts, 1500, 1540, AG_AGG_COUNT, &out), AG_OK);
+    ASSERT_DOUBLE_EQ(out, 5.0);
+
+    /* Unordered window: masked kernels */
+    for (int i = 0; i < 60; i++) {
+        ag_timeseries_append(ts, (i * 37) % 1000 + 2000, cos(i * 0.3) * 50.0);
+    }
+    ASSERT_EQ(ag_timeseries_is_monotonic(ts), 0);
+    check_aggregates(ts, 2100, 2700);
+    check_aggregates(ts, INT64_MIN, INT64_MAX);
+    check_aggregates(ts, 2003, 2003);
+    check_aggregates(ts, 5000, 6000);
+
+    ag_timeseries_destroy(ts);
+}
+
+/* Test: Dispatched SIMD kernels match scalar kernels, including tails and NaN */
+TEST(simd_kernels_match_scalar) {
+    const ag_kernels_t* ref = ag_kernels_scalar();
+    const ag_kernels_t* simd = ag_kernels_get();
+    ASSERT_NE(simd, NULL);
+    ASSERT(strcmp(ag_timeseries_simd_name(), simd->name) == 0);
+
+    int64_t timestamps[67];
+    double values[67];
+    for (int i = 0; i < 67; i++) {
+        timestamps[i] = (i * 13) % 67;
+        values[i] = (i % 5 == 0) ? -i * 1.25 : i * 0.75;
+    }
+    values[33] = NAN;  /* Ignored by min/max */
+
+    for (size_t n = 0; n <= 67; n++) {
+        size_t c_ref = 0, c_simd = 0;
+        /* Exact equality: min/max do not round, and infinities are identities */
+        ASSERT(simd->min(values, n) == ref->min(values, n));
+        ASSERT(simd->max(values, n) == ref->max(values, n));
+        ASSERT(simd->min_in(timestamps, values, n, 10, 40, &c_simd) ==
+               ref->min_in(timestamps, values, n, 10, 40, &c_ref));
+        ASSERT_EQ(c_simd, c_ref);
+        ASSERT(simd->max_in(timestamps, values, n, 10, 40, &c_simd) ==
+               ref->max_in(timestamps, values, n, 10, 40, &c_ref));
+        ASSERT_EQ(c_simd, c_ref);
+        if (n <= 33) {
+            ASSERT_DOUBLE_EQ(simd->sum(values, n), ref->sum(values, n));
+        } else {
+            ASSERT(isnan(simd->sum(values, n)));
+        }
+    }
+
+    /* Masked sum excludes out-of-range NaN */
+    size_t c_ref = 0, c_simd = 0;
+    double s_ref = ref->sum_in(timestamps, values, 67, 0, 20, &c_ref);
+    double s_simd = simd->sum_in(timestamps, values, 67, 0, 20, &c_simd);
+    ASSERT_EQ(timestamps[33], 27);
+    ASSERT_EQ(c_simd, c_ref);
+    ASSERT_DOUBLE_EQ(s_simd, s_ref);
+}
+
+/* Test: OHLC bucketing with epoch alignment, wrap and truncation */
+TEST(query_buckets) {
+    ag_timeseries_bucket_t buckets[8];
+    size_t n = 99;
+    ASSERT_EQ(ag_timeseries_query_buckets(NULL, 0, 1, 10, buckets, 8, &n), AG_ERR_INVALID_ARG);
+
+    ag_timeseries_t* ts = ag_timeseries_create(10);
+    ASSERT_NE(ts, NULL);
+    ASSERT_EQ(ag_timeseries_query_buckets(ts, 0, 1, 0, buckets, 8, &n), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_query_buckets(ts, 0, 1, 10, buckets, 8, NULL), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_query_buckets(ts, 0, 1000, 10, buckets, 8, &n), AG_OK);
+    ASSERT_EQ(n, 0);
+
+    /* 13 points every 250ms from -1000; buffer keeps last 10 (-250 .. 2000) */
+    double vals[13] = {1, 2, 3, 9, 4, 5, 1, 6, 7, 2, 8, 3, 5};
+    for (int i = 0; i < 13; i++) {
+        ag_timeseries_append(ts, -1000 + i * 250, vals[i]);
+    }
+
+    ASSERT_EQ(ag_timeseries_query_buckets(ts, INT64_MIN, INT64_MAX, 1000, buckets, 8, &n), AG_OK);
+    ASSERT_EQ(n, 4);
+
+    /* [-1000, 0): only -250 survives */
+    ASSERT_EQ(buckets[0].start_ms, -1000);
+    ASSERT_EQ(buckets[0].count, 1);
+    ASSERT_DOUBLE_EQ(buckets[0].open, 9.0);
+
+    /* [0, 1000): 0, 250, 500, 750 -> 4, 5, 1, 6 */
+    ASSERT_EQ(buckets[1].start_ms, 0);
+    ASSERT_EQ(buckets[1].count, 4);
+    ASSERT_DOUBLE_EQ(buckets[1].open, 4.0);
+    ASSERT_DOUBLE_EQ(buckets[1].high, 6.0);
+    ASSERT_DOUBLE_EQ(buckets[1].low, 1.0);
+    ASSERT_DOUBLE_EQ(buckets[1].close, 6.0);
+
+    /* [1000, 2000): 7, 2, 8, 3 */
+    ASSERT_EQ(buckets[2].start_ms, 1000);
+    ASSERT_DOUBLE_EQ(buckets[2].high, 8.0);
+    ASSERT_DOUBLE_EQ(buckets[2].low, 2.0);
+    ASSERT_DOUBLE_EQ(buckets[2].close, 3.0);
+    ASSERT_EQ(buckets[3].start_ms, 2000);
+    ASSERT_EQ(buckets[3].count, 1);
+
+    /* Range clips edge buckets; max_buckets truncates */
+    ASSERT_EQ(ag_timeseries_query_buckets(ts, 500, 1250, 1000, buckets, 1, &n), AG_OK);
+    ASSERT_EQ(n, 1);
+    ASSERT_EQ(buckets[0].start_ms, 0);
+    ASSERT_EQ(buckets[0].count, 2);
+    ASSERT_DOUBLE_EQ(buckets[0].open, 1.0);
+
+    /* Sparse data skips empty buckets */
+    ASSERT_EQ(ag_timeseries_query_buckets(ts, -250, 2000, 100, buckets, 8, &n), AG_OK);
+    ASSERT_EQ(n, 8);
+    ASSERT_EQ(buckets[1].start_ms, 0);
+    ASSERT_EQ(buckets[2].start_ms, 200);
+
+    ag_timeseries_append(ts, 0, 1.0);
+    ASSERT_EQ(ag_timeseries_query_buckets(ts, 0, 1000, 10, buckets, 8, &n), AG_ERR_UNORDERED);
+
+    ag_timeseries_destroy(ts);
+}
+
+/* Helper: Create an empty temporary file, path written to buf */
+static void temp_path(char* buf, size_t size) {
+    snprintf(buf, size, "/tmp/ag_ts_test_XXXXXX");
+    int fd = mkstemp(buf);
+    ASSERT(fd >= 0);
+    close(fd);
+}
+
+/* Test: File-backed ring survives close and reopen */
+TEST(mmap_reopen) {
+    char path[64];
+    temp_path(path, sizeof(path));
+
+    ag_timeseries_t* ts = ag_timeseries_open_mmap(path, 64);
+    ASSERT_NE(ts, NULL);
+    ASSERT_EQ(ag_timeseries_size(ts), 0);
+    for (int64_t i = 0; i < 150; i++) {
+        ASSERT_EQ(ag_timeseries_append(ts, i * 10, (double)i), AG_OK);
+    }
+    ASSERT_EQ(ag_timeseries_sync(ts), AG_OK);
+    ASSERT_EQ(ag_timeseries_append(ts, 1500, 150.0), AG_OK);
+    ag_timeseries_destroy(ts);
+
+    ts = ag_timeseries_open_mmap(path, 64);
+    ASSERT_NE(ts, NULL);
+    ASSERT_EQ(ag_timeseries_size(ts), 64);
+    ASSERT_EQ(ag_timeseries_sequence(ts), 151);
+    ASSERT_EQ(ag_timeseries_is_monotonic(ts), 1);
+
+    int64_t timestamps[64];
+    double values[64];
+    ASSERT_EQ(ag_timeseries_query_last(ts, 64, timestamps, values), 64);
+    for (size_t i = 0; i < 64; i++) {
+        ASSERT_EQ(timestamps[i], (int64_t)(150 - i) * 10);
+        ASSERT_DOUBLE_EQ(values[i], (double)(150 - i));
+    }
+
+    /* Appends continue from the restored head */
+    ASSERT_EQ(ag_timeseries_append(ts, 1510, 151.0), AG_OK);
+    ASSERT_EQ(ag_timeseries_query_last(ts, 2, timestamps, values), 2);
+    ASSERT_EQ(timestamps[0], 1510);
+    ASSERT_EQ(timestamps[1], 1500);
+    ag_timeseries_destroy(ts);
+
+    /* Capacity mismatch and non-ring files are rejected, not overwritten */
+    ASSERT_EQ(ag_timeseries_open_mmap(path, 32), NULL);
+    int fd = open(path, O_WRONLY);
+    ASSERT(fd >= 0);
+    ASSERT_EQ(pwrite(fd, "NOTARING", 8, 0), 8);
+    close(fd);
+    ASSERT_EQ(ag_timeseries_open_mmap(path, 64), NULL);
+
+    ASSERT_EQ(ag_timeseries_open_mmap(NULL, 64), NULL);
+    ASSERT_EQ(ag_timeseries_open_mmap(path, 0), NULL);
+    ASSERT_EQ(ag_timeseries_sync(NULL), AG_ERR_INVALID_ARG);
+    ag_timeseries_t* heap = ag_timeseries_create(4);
+    ASSERT_EQ(ag_timeseries_sync(heap), AG_ERR_INVALID_ARG);
+    ag_timeseries_destroy(heap);
+
+    unlink(path);
+}
+
+/* Test: Recovery after a crash between appends, inside an append, and corruption */
+TEST(mmap_recovery) {
+    char path[64];
+    temp_path(path, sizeof(path));
+
+    /* Killed between appends: a second mapping sees the dirty state as-is */
+    ag_timeseries_t* writer = ag_timeseries_open_mmap(path, 16);
+    ASSERT_NE(writer, NULL);
+    for (int64_t i = 0; i < 40; i++) {
+        ASSERT_EQ(ag_timeseries_append(writer, i, (double)i), AG_OK);
+    }
+    ag_timeseries_t* ts = ag_timeseries_open_mmap(path, 16);
+    ASSERT_NE(ts, NULL);
+    ASSERT_EQ(ag_timeseries_sequence(ts), 40);
+    ASSERT_EQ(ag_timeseries_size(ts), 16);
+    ag_timeseries_destroy(ts);
+
+    /* Killed inside an append: the slot being overwritten is dropped */
+    atomic_store(&writer->persist->claimed, 41);
+    atomic_store(&writer->persist->clean, 0);
+    ts = ag_timeseries_open_mmap(path, 16);
+    ASSERT_NE(ts, NULL);
+    ASSERT_EQ(ag_timeseries_size(ts), 15);
+    ASSERT_EQ(ag_timeseries_sequence(ts), 15);
+    int64_t timestamps[16];
+    double values[16];
+    ASSERT_EQ(ag_timeseries_query_last(ts, 16, timestamps, values), 15);
+    ASSERT_EQ(timestamps[0], 39);
+    ASSERT_EQ(timestamps[14], 25);
+    ag_timeseries_destroy(ts);
+    ag_timeseries_destroy(writer);
+
+    /* Clean file with corrupted data recovers empty */
+    int fd = open(path, O_WRONLY);
+    ASSERT(fd >= 0);
+    int64_t junk = 12345;
+    ASSERT_EQ(pwrite(fd, &junk, sizeof(junk), AG_PERSIST_HEADER_SIZE), (ssize_t)sizeof(junk));
+    close(fd);
+    ts = ag_timeseries_open_mmap(path, 16);
+    ASSERT_NE(ts, NULL);
+    ASSERT_EQ(ag_timeseries_size(ts), 0);
+    ASSERT_EQ(ag_timeseries_append(ts, 1, 1.0), AG_OK);
+    ag_timeseries_destroy(ts);
+
+    unlink(path);
+}
+
+/* Test: TTL expiry survives a reopen, clean or torn */
+TEST(mmap_ttl_reopen) {
+    char path[64];
+    temp_path(path, sizeof(path));
+
+    ag_timeseries_t* ts = ag_timeseries_open_mmap(path, 16);
+    ASSERT_NE(ts, NULL);
+    ASSERT_EQ(ag_timeseries_set_ttl(ts, 100), AG_OK);
+    for (int64_t i = 0; i < 11; i++) {
+        ASSERT_EQ(ag_timeseries_append(ts, i * 50, (double)i), AG_OK);
+    }
+    ASSERT_EQ(ag_timeseries_size(ts), 3);
+    ag_timeseries_destroy(ts);
+
+    /* Clean reopen: the TTL is gone, the expired points stay gone */
+    ts = ag_timeseries_open_mmap(path, 16);
+    ASSERT_NE(ts, NULL);
+    ASSERT_EQ(ag_timeseries_size(ts), 3);
+    ASSERT_EQ(ag_timeseries_sequence(ts), 11);
+    int64_t timestamps[16];
+    double values[16];
+    ASSERT_EQ(ag_timeseries_query_range(ts, 0, 1000, 16, timestamps, values), 3);
+    ASSERT_EQ(timestamps[0], 400);
+    ASSERT_EQ(timestamps[2], 500);
+
+    /* On-demand expiry is recorded too; a second mapping sees it dirty */
+    ASSERT_EQ(ag_timeseries_set_ttl(ts, 100), AG_OK);
+    ASSERT_EQ(ag_timeseries_expire(ts, 560), 2);
+    ag_timeseries_t* other = ag_timeseries_open_mmap(path, 16);
+    ASSERT_NE(other, NULL);
+    ASSERT_EQ(ag_timeseries_size(other), 1);
+    ag_timeseries_destroy(other);
+
+    /* Killed inside an append: survivors are still limited by expiry */
+    atomic_store(&ts->persist->claimed, 12);
+    atomic_store(&ts->persist->clean, 0);
+    other = ag_timeseries_open_mmap(path, 16);
+    ASSERT_NE(other, NULL);
+    ASSERT_EQ(ag_timeseries_size(other), 1);
+    ASSERT_EQ(ag_timeseries_query_last(other, 16, timestamps, values), 1);
+    ASSERT_EQ(timestamps[0], 500);
+    ag_timeseries_destroy(other);
+    ag_timeseries_destroy(ts);
+
+    /* Expiry beyond the published points is corruption: recovers empty */
+    ts = ag_timeseries_open_mmap(path, 16);
+    ASSERT_NE(ts, NULL);
+    atomic_store(&ts->persist->expired, 100);
+    atomic_store(&ts->persist->clean, 0);
+    other = ag_timeseries_open_mmap(path, 16);
+    ASSERT_NE(other, NULL);
+    ASSERT_EQ(ag_timeseries_size(other), 0);
+    ag_timeseries_destroy(other);
+    ag_timeseries_destroy(ts);
+
+    unlink(path);
+}
+
+/* Test: Cold tier is lossless across block boundaries and awkward values */
+TEST(cold_tier_roundtrip) {
+    const size_t capacity = 100;
+    const size_t total = 5000;
+    ag_timeseries_t* ts = ag_timeseries_create(capacity);
+    ASSERT_EQ(ag_timeseries_enable_cold(ts, 1 << 20), AG_OK);
+    ASSERT_EQ(ag_timeseries_enable_cold(ts, 1 << 20), AG_OK);
+
+    int64_t* ref_ts = (int64_t*)malloc(total * sizeof(int64_t));
+    double* ref_vals = (double*)malloc(total * sizeof(double));
+    uint64_t rng = 12345;
+    int64_t t = -1000000;
+    for (size_t i = 0; i < total; i++) {
+        rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+        /* Regular ticks with jitter, big jumps, and a backwards step */
+        if (i % 997 == 0) {
+            t += (int64_t)(rng >> 20);
+        } else if (i % 501 == 0) {
+            t -= 5000;
+        } else {
+            t += 100 + (int64_t)((rng >> 60) & 3);
+        }
+        ref_ts[i] = t;
+        switch (i % 7) {
+        case 0: ref_vals[i] = 100.0; break;
+        case 1: ref_vals[i] = 100.25; break;
+        case 2: ref_vals[i] = -(double)(rng >> 11) * 1e-3; break;
+        case 3: ref_vals[i] = NAN; break;
+        case 4: ref_vals[i] = (i % 14 == 4) ? INFINITY : -0.0; break;
+        default: ref_vals[i] = (double)i; break;
+        }
+    }
+
+    /* Mix single and batch appends, including a batch larger than the ring */
+    size_t i = 0;
+    while (i < total) {
+        size_t n = (i % 3 == 0) ? 1 : (i % 3 == 1 ? 37 : 250);
+        if (n > total - i) {
+            n = total - i;
+        }
+        if (n == 1) {
+            ASSERT_EQ(ag_timeseries_append(ts, ref_ts[i], ref_vals[i]), AG_OK);
+        } else {
+            ASSERT_EQ(ag_timeseries_append_batch(ts, ref_ts + i, ref_vals + i, n), AG_OK);
+        }
+        i += n;
+    }
+
+    ag_timeseries_cold_stats_t cs;
+    ASSERT_EQ(ag_timeseries_cold_stats(ts, &cs), AG_OK);
+    ASSERT_EQ(cs.points, total - capacity);
+    ASSERT_EQ(cs.blocks, (total - capacity) / 1024);
+
+    /* Full history, newest first, then oldest first over a wide range */
+    int64_t* out_ts = (int64_t*)malloc(total * sizeof(int64_t));
+    double* out_vals = (double*)malloc(total * sizeof(double));
+    ASSERT_EQ(ag_timeseries_query_last(ts, total + 10, out_ts, out_vals), total);
+    for (size_t k = 0; k < total; k++) {
+        size_t r = total - 1 - k;
+        ASSERT_EQ(out_ts[k], ref_ts[r]);
+        ASSERT(memcmp(&out_vals[k], &ref_vals[r], sizeof(double)) == 0);
+    }
+
+    ASSERT_EQ(ag_timeseries_query_range(ts, INT64_MIN, INT64_MAX, total, out_ts, out_vals), total);
+    for (size_t k = 0; k < total; k++) {
+        ASSERT_EQ(out_ts[k], ref_ts[k]);
+        ASSERT(memcmp(&out_vals[k], &ref_vals[k], sizeof(double)) == 0);
+    }
+
+    /* Narrow range inside the cold tier, and max_points spanning both tiers */
+    int64_t lo = ref_ts[2000];
+    int64_t hi = ref_ts[2050];
+    size_t expected = 0;
+    for (size_t k = 0; k < total; k++) {
+        if (ref_ts[k] >= lo && ref_ts[k] <= hi) {
+            expected++;
+        }
+    }
+    ASSERT_EQ(ag_timeseries_query_range(ts, lo, hi, total, out_ts, out_vals), expected);
+    ASSERT_EQ(ag_timeseries_query_range(ts, INT64_MIN, INT64_MAX, total - 50, out_ts, out_vals),
+              total - 50);
+    ASSERT_EQ(out_ts[total - 51], ref_ts[total - 51]);
+
+    free(ref_ts);
+    free(ref_vals);
+    free(out_ts);
+    free(out_vals);
+    ag_timeseries_destroy(ts);
+}
+
+/* Test: Regular ticks compress 10x+, budget drops oldest blocks, invalid args */
+TEST(cold_tier_budget) {
+    ag_timeseries_t* ts = ag_timeseries_create(512);
+    ASSERT_EQ(ag_timeseries_enable_cold(ts, 64 * 1024), AG_OK);
+
+    /* 100 ms ticks, price moving in cent steps */
+    const size_t total = 200000;
+    for (size_t i = 0; i < total; i++) {
+        double price = 100.0 + (double)((i / 7) % 50) * 0.01;
+        ASSERT_EQ(ag_timeseries_append(ts, 1700000000000 + (int64_t)i * 100, price), AG_OK);
+    }
+
+    ag_timeseries_cold_stats_t cs;
+    ASSERT_EQ(ag_timeseries_cold_stats(ts, &cs), AG_OK);
+    ASSERT(cs.bytes <= cs.budget_bytes);
+    ASSERT(cs.points * 16 >= cs.bytes * 10);
+    ASSERT(cs.points < total - 512);
+
+    /* Retained history is a contiguous suffix ending at the ring */
+    size_t held = cs.points + 512;
+    int64_t* out_ts = (int64_t*)malloc(held * sizeof(int64_t));
+    double* out_vals = (double*)malloc(held * sizeof(double));
+    ASSERT_EQ(ag_timeseries_query_last(ts, total, out_ts, out_vals), held);
+    for (size_t k = 0; k < held; k++) {
+        size_t i = total - 1 - k;
+        ASSERT_EQ(out_ts[k], 1700000000000 + (int64_t)i * 100);
+        ASSERT_DOUBLE_EQ(out_vals[k], 100.0 + (double)((i / 7) % 50) * 0.01);
+    }
+    free(out_ts);
+    free(out_vals);
+    ag_timeseries_destroy(ts);
+
+    /* Invalid arguments */
+    ASSERT_EQ(ag_timeseries_enable_cold(NULL, 1 << 20), AG_ERR_INVALID_ARG);
+    ts = ag_timeseries_create(16);
+    ASSERT_EQ(ag_timeseries_enable_cold(ts, 1024), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_cold_stats(ts, &cs), AG_ERR_INVALID_ARG);
+    ag_timeseries_destroy(ts);
+    ts = ag_timeseries_create_spmc(16);
+    ASSERT_EQ(ag_timeseries_enable_cold(ts, 1 << 20), AG_ERR_INVALID_ARG);
+    ag_timeseries_destroy(ts);
+}
+
+/* Test: Rollup chain aggregates, propagation and routing */
+TEST(rollup_chain) {
+    const ag_rollup_level_t levels[3] = {
+        { 1000, 100 },      /* 1 s, last 100 s */
+        { 60000, 50 },      /* 1 m, last 50 min */
+        { 3600000, 10 },    /* 1 h, last 10 h */
+    };
+    ag_timeseries_t* ts = ag_timeseries_create(1000);
+    ASSERT_EQ(ag_timeseries_enable_rollups(ts, levels, 3), AG_OK);
+    ASSERT_EQ(ag_timeseries_enable_rollups(ts, levels, 3), AG_ERR_INVALID_ARG);
+
+    /* 100 ms ticks for 2.5 hours, value = tick index; half via batches */
+    const int64_t ticks = 90000;
+    int64_t batch_ts[50];
+    double batch_vals[50];
+    for (int64_t i = 0; i < ticks;) {
+        if ((i / 5000) % 2 == 0) {
+            ASSERT_EQ(ag_timeseries_append(ts, i * 100, (double)i), AG_OK);
+            i++;
+        } else {
+            for (int64_t k = 0; k < 50; k++) {
+                batch_ts[k] = (i + k) * 100;
+                batch_vals[k] = (double)(i + k);
+            }
+            ASSERT_EQ(ag_timeseries_append_batch(ts, batch_ts, batch_vals, 50), AG_OK);
+            i += 50;
+        }
+    }
+
+    /* Late point: stays raw, not rolled up */
+    ASSERT_EQ(ag_timeseries_append(ts, 0, -1.0), AG_OK);
+
+    ag_timeseries_rollup_t out[100];
+    size_t count = 0;
+    int64_t res = -1;
+
+    /* The late point made the raw ring unordered, so this routes to 1 s */
+    ASSERT_EQ(ag_timeseries_query_rollup(ts, 8998000, 8998900, 100, out, &count, &res), AG_OK);
+    ASSERT_EQ(res, 1000);
+    ASSERT_EQ(count, 1);
+    ASSERT_EQ(out[0].start_ms, 8998000);
+    ASSERT_EQ(out[0].count, 10);
+    ASSERT_DOUBLE_EQ(out[0].mean, 89984.5);
+    ASSERT_DOUBLE_EQ(out[0].min, 89980.0);
+    ASSERT_DOUBLE_EQ(out[0].max, 89989.0);
+    ASSERT_DOUBLE_EQ(out[0].last, 89989.0);
+
+    /* Fresh series to check the raw route */
+    ag_timeseries_t* raw = ag_timeseries_create(1000);
+    ASSERT_EQ(ag_timeseries_enable_rollups(raw, levels, 1), AG_OK);
+    for (int64_t i = 0; i < 3000; i++) {
+        ag_timeseries_append(raw, i * 100, (double)i);
+    }
+    ASSERT_EQ(ag_timeseries_query_rollup(raw, 290000, 299900, 100, out, &count, &res), AG_OK);
+    ASSERT_EQ(res, 0);
+    ASSERT_EQ(count, 100);
+    ASSERT_EQ(out[0].start_ms, 290000);
+    ASSERT_EQ(out[0].count, 1);
+    /* Over budget for raw -> 1 s buckets */
+    ASSERT_EQ(ag_timeseries_query_rollup(raw, 200000, 299900, 100, out, &count, &res), AG_OK);
+    ASSERT_EQ(res, 1000);
+    ASSERT_EQ(count, 99);   /* Bucket 299000 is still open */
+    ag_timeseries_destroy(raw);
+
+    /* 10 minutes: raw and 1 s levels no longer reach back -> 1 m buckets */
+    ASSERT_EQ(ag_timeseries_query_rollup(ts, 7800000, 8399999, 100, out, &count, &res), AG_OK);
+    ASSERT_EQ(res, 60000);
+    ASSERT_EQ(count, 10);
+    for (size_t i = 0; i < count; i++) {
+        int64_t first = 78000 + (int64_t)i * 600;
+        ASSERT_EQ(out[i].start_ms, 7800000 + (int64_t)i * 60000);
+        ASSERT_EQ(out[i].count, 600);
+        ASSERT_DOUBLE_EQ(out[i].min, (double)first);
+        ASSERT_DOUBLE_EQ(out[i].max, (double)(first + 599));
+        ASSERT_DOUBLE_EQ(out[i].mean, (double)first + 299.5);
+    }
+
+    /* Whole history: only the hourly level reaches back */
+    ASSERT_EQ(ag_timeseries_query_rollup(ts, 0, INT64_MAX, 100, out, &count, &res), AG_OK);
+    ASSERT_EQ(res, 3600000);
+    ASSERT_EQ(count, 2);
+    ASSERT_EQ(out[1].start_ms, 3600000);
+    ASSERT_EQ(out[1].count, 36000);
+    ASSERT_DOUBLE_EQ(out[1].last, 71999.0);
+
+    /* Budget too small everywhere -> coarsest, first max_points */
+    ASSERT_EQ(ag_timeseries_query_rollup(ts, 0, INT64_MAX, 1, out, &count, &res), AG_OK);
+    ASSERT_EQ(res, 3600000);
+    ASSERT_EQ(count, 1);
+    ASSERT_EQ(out[0].start_ms, 0);
+
+    /* Invalid arguments */
+    ASSERT_EQ(ag_timeseries_query_rollup(ts, 10, 0, 100, out, &count, NULL), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_query_rollup(ts, 0, 10, 100, NULL, &count, NULL), AG_ERR_INVALID_ARG);
+    ag_timeseries_destroy(ts);
+
+    ts = ag_timeseries_create(16);
+    ASSERT_EQ(ag_timeseries_query_rollup(ts, 0, 10, 100, out, &count, NULL), AG_ERR_INVALID_ARG);
+    const ag_rollup_level_t not_nested[2] = { { 1000, 10 }, { 1500, 10 } };
+    ASSERT_EQ(ag_timeseries_enable_rollups(ts, not_nested, 2), AG_ERR_INVALID_ARG);
+    const ag_rollup_level_t zero_cap[1] = { { 1000, 0 } };
+    ASSERT_EQ(ag_timeseries_enable_rollups(ts, zero_cap, 1), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_enable_rollups(ts, levels, 0), AG_ERR_INVALID_ARG);
+    ag_timeseries_destroy(ts);
+    ts = ag_timeseries_create_spmc(16);
+    ASSERT_EQ(ag_timeseries_enable_rollups(ts, levels, 3), AG_ERR_INVALID_ARG);
+    ag_timeseries_destroy(ts);
+}
+
+TEST(interleaved_layout) {
+    ag_timeseries_t* split = ag_timeseries_create(100);
+    ag_timeseries_t* pairs = ag_timeseries_create_interleaved(100);
+    ASSERT_NE(pairs, NULL);
+    ASSERT_EQ(ag_timeseries_create_interleaved(0), NULL);
+    ASSERT_EQ((uintptr_t)pairs->timestamps % 64, 0);
+    ASSERT_EQ(ag_timeseries_capacity(pairs), 100);
+    ASSERT_EQ(ag_timeseries_enable_stats(split), AG_OK);
+    ASSERT_EQ(ag_timeseries_enable_stats(pairs), AG_OK);
+
+    /* Same wrapped history into both: singles, then batches across the wrap */
+    int64_t batch_ts[70];
+    double batch_vals[70];
+    for (int64_t i = 0; i < 130; i++) {
+        double v = (double)((i * 37) % 101);
+        ASSERT_EQ(ag_timeseries_append(split, i * 10, v), AG_OK);
+        ASSERT_EQ(ag_timeseries_append(pairs, i * 10, v), AG_OK);
+    }
+    for (int64_t i = 0; i < 70; i++) {
+        batch_ts[i] = (130 + i) * 10;
+        batch_vals[i] = (double)(i % 13) - 6.0;
+    }
+    ASSERT_EQ(ag_timeseries_append_batch(split, batch_ts, batch_vals, 70), AG_OK);
+    ASSERT_EQ(ag_timeseries_append_batch(pairs, batch_ts, batch_vals, 70), AG_OK);
+
+    int64_t ts_a[100];
+    int64_t ts_b[100];
+    double vals_a[100];
+    double vals_b[100];
+    for (int pass = 0; pass < 2; pass++) {
+        ASSERT_EQ(ag_timeseries_is_monotonic(pairs), ag_timeseries_is_monotonic(split));
+
+        size_t n = ag_timeseries_query_last(split, 100, ts_a, vals_a);
+        ASSERT_EQ(ag_timeseries_query_last(pairs, 100, ts_b, vals_b), n);
+        ASSERT_EQ(n, 100);
+        for (size_t i = 0; i < n; i++) {
+            ASSERT_EQ(ts_b[i], ts_a[i]);
+            ASSERT_DOUBLE_EQ(vals_b[i], vals_a[i]);
+        }
+
+        n = ag_timeseries_query_range(split, 1205, 1795, 100, ts_a, vals_a);
+        ASSERT_EQ(ag_timeseries_query_range(pairs, 1205, 1795, 100, ts_b, vals_b), n);
+        ASSERT(n > 0);
+        for (size_t i = 0; i < n; i++) {
+            ASSERT_EQ(ts_b[i], ts_a[i]);
+            ASSERT_DOUBLE_EQ(vals_b[i], vals_a[i]);
+        }
+
+        for (int agg = AG_AGG_COUNT; agg <= AG_AGG_MAX; agg++) {
+            double a = 0.0;
+            double b = 0.0;
+            ASSERT_EQ(ag_timeseries_aggregate_range(split, 1100, 1990, agg, &a), AG_OK);
+            ASSERT_EQ(ag_timeseries_aggregate_range(pairs, 1100, 1990, agg, &b), AG_OK);
+            ASSERT_DOUBLE_EQ(b, a);
+        }
+
+        ag_timeseries_stats_t sa;
+        ag_timeseries_stats_t sb;
+        ASSERT_EQ(ag_timeseries_stats(split, &sa), AG_OK);
+        ASSERT_EQ(ag_timeseries_stats(pairs, &sb), AG_OK);
+        ASSERT_DOUBLE_EQ(sb.sum, sa.sum);
+        ASSERT_DOUBLE_EQ(sb.min, sa.min);
+        ASSERT_DOUBLE_EQ(sb.max, sa.max);
+
+        if (pass == 0) {
+            ag_timeseries_bucket_t ba[10];
+            ag_timeseries_bucket_t bb[10];
+            size_t na = 0;
+            size_t nb = 0;
+            ASSERT_EQ(ag_timeseries_query_buckets(split, 1000, 1999, 100, ba, 10, &na), AG_OK);
+            ASSERT_EQ(ag_timeseries_query_buckets(pairs, 1000, 1999, 100, bb, 10, &nb), AG_OK);
+            ASSERT_EQ(nb, na);
+            ASSERT_EQ(na, 10);
+            for (size_t i = 0; i < na; i++) {
+                ASSERT_EQ(bb[i].start_ms, ba[i].start_ms);
+                ASSERT_DOUBLE_EQ(bb[i].open, ba[i].open);
+                ASSERT_DOUBLE_EQ(bb[i].close, ba[i].close);
+                ASSERT_DOUBLE_EQ(bb[i].low, ba[i].low);
+                ASSERT_EQ(bb[i].count, ba[i].count);
+            }
+
+            /* Second pass compares the unordered scan paths */
+            ASSERT_EQ(ag_timeseries_append(split, 1500, 99.0), AG_OK);
+            ASSERT_EQ(ag_timeseries_append(pairs, 1500, 99.0), AG_OK);
+        }
+    }
+    ASSERT_EQ(ag_timeseries_is_monotonic(pairs), 0);
+
+    /* Spans must be contiguous arrays */
+    ag_timeseries_view_t view;
+    ASSERT_EQ(ag_timeseries_view_last(pairs, 10, &view), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_view_range(pairs, 0, 10, &view), AG_ERR_INVALID_ARG);
+
+    ag_timeseries_destroy(split);
+    ag_timeseries_destroy(pairs);
+}
+
+/* Test: Typed columns answer like a double series when values fit exactly */
+TEST(typed_columns) {
+    const int types[3] = { AG_VALUE_F32, AG_VALUE_I64, AG_VALUE_I32 };
+    ASSERT_EQ(ag_timeseries_create_typed(100, 7), NULL);
+    ASSERT_EQ(ag_timeseries_create_typed(0, AG_VALUE_I32), NULL);
+    ASSERT_EQ(ag_timeseries_value_type(NULL), -1);
+
+    for (int k = 0; k < 3; k++) {
+        ag_timeseries_t* ref = ag_timeseries_create(100);
+        ag_timeseries_t* typed = ag_timeseries_create_typed(100, types[k]);
+        ASSERT_NE(typed, NULL);
+        ASSERT_EQ(ag_timeseries_value_type(typed), types[k]);
+        ASSERT_EQ(ag_timeseries_value_type(ref), AG_VALUE_F64);
+        ASSERT_EQ(ag_timeseries_enable_stats(ref), AG_OK);
+        ASSERT_EQ(ag_timeseries_enable_stats(typed), AG_OK);
+
+        /* Same wrapped history into both: singles, then a batch across the wrap */
+        int64_t batch_ts[70];
+        double batch_vals[70];
+        for (int64_t i = 0; i < 130; i++) {
+            double v = (double)((i * 37) % 101) - 50.0;
+            ASSERT_EQ(ag_timeseries_append(ref, i * 10, v), AG_OK);
+            ASSERT_EQ(ag_timeseries_append(typed, i * 10, v), AG_OK);
+        }
+        for (int64_t i = 0; i < 70; i++) {
+            batch_ts[i] = (130 + i) * 10;
+            batch_vals[i] = (double)(i % 13) - 6.0;
+        }
+        ASSERT_EQ(ag_timeseries_append_batch(ref, batch_ts, batch_vals, 70), AG_OK);
+        ASSERT_EQ(ag_timeseries_append_batch(typed, batch_ts, batch_vals, 70), AG_OK);
+
+        int64_t ts_a[100];
+        int64_t ts_b[100];
+        double vals_a[100];
+        double vals_b[100];
+        for (int pass = 0; pass < 2; pass++) {
+            size_t n = ag_timeseries_query_last(ref, 100, ts_a, vals_a);
+            ASSERT_EQ(ag_timeseries_query_last(typed, 100, ts_b, vals_b), n);
+            ASSERT_EQ(n, 100);
+            for (size_t i = 0; i < n; i++) {
+                ASSERT_EQ(ts_b[i], ts_a[i]);
+                ASSERT_DOUBLE_EQ(vals_b[i], vals_a[i]);
+            }
+
+            n = ag_timeseries_query_range(ref, 1205, 1795, 100, ts_a, vals_a);
+            ASSERT_EQ(ag_timeseries_query_range(typed, 1205, 1795, 100, ts_b, vals_b), n);
+            ASSERT(n > 0);
+            for (size_t i = 0; i < n; i++) {
+                ASSERT_EQ(ts_b[i], ts_a[i]);
+                ASSERT_DOUBLE_EQ(vals_b[i], vals_a[i]);
+            }
+
+            for (int agg = AG_AGG_COUNT; agg <= AG_AGG_MAX; agg++) {
+                double a = 0.0;
+                double b = 0.0;
+                ASSERT_EQ(ag_timeseries_aggregate_range(ref, 1100, 1990, agg, &a), AG_OK);
+                ASSERT_EQ(ag_timeseries_aggregate_range(typed, 1100, 1990, agg, &b), AG_OK);
+                ASSERT_DOUBLE_EQ(b, a);
+            }
+
+            ag_timeseries_stats_t sa;
+            ag_timeseries_stats_t sb;
+            ASSERT_EQ(ag_timeseries_stats(ref, &sa), AG_OK);
+            ASSERT_EQ(ag_timeseries_stats(typed, &sb), AG_OK);
+            ASSERT_DOUBLE_EQ(sb.sum, sa.sum);
+            ASSERT_DOUBLE_EQ(sb.min, sa.min);
+            ASSERT_DOUBLE_EQ(sb.max, sa.max);
+
+            int64_t t = 0;
+            double v = 0.0;
+            ASSERT_EQ(ag_timeseries_asof(typed, 1615, &t, &v), AG_OK);
+            ASSERT_EQ(ag_timeseries_query_range(ref, t, t, 1, ts_a, vals_a), 1);
+            ASSERT_DOUBLE_EQ(v, vals_a[0]);
+
+            ag_ts_cursor_t cursor;
+            size_t got = 0;
+            ASSERT_EQ(ag_timeseries_cursor_init(typed, AG_CURSOR_OLDEST, &cursor), AG_OK);
+            ASSERT_EQ(ag_timeseries_cursor_read(typed, &cursor, 100, ts_b, vals_b,
+                                                &got, NULL), AG_OK);
+            ASSERT_EQ(got, 100);
+            ASSERT_EQ(ag_timeseries_query_last(ref, 1, ts_a, vals_a), 1);
+            ASSERT_EQ(ts_b[99], ts_a[0]);
+            ASSERT_DOUBLE_EQ(vals_b[99], vals_a[0]);
+
+            if (pass == 0) {
+                ag_timeseries_bucket_t ba[10];
+                ag_timeseries_bucket_t bb[10];
+                size_t na = 0;
+                size_t nb = 0;
+                ASSERT_EQ(ag_timeseries_query_buckets(ref, 1000, 1999, 100, ba, 10, &na), AG_OK);
+                ASSERT_EQ(ag_timeseries_query_buckets(typed, 1000, 1999, 100, bb, 10, &nb), AG_OK);
+                ASSERT_EQ(nb, na);
+                for (size_t i = 0; i < na; i++) {
+                    ASSERT_DOUBLE_EQ(bb[i].open, ba[i].open);
+                    ASSERT_DOUBLE_EQ(bb[i].high, ba[i].high);
+                    ASSERT_DOUBLE_EQ(bb[i].low, ba[i].low);
+                    ASSERT_DOUBLE_EQ(bb[i].close, ba[i].close);
+                }
+
+                /* Second pass compares the unordered scan paths */
+                ASSERT_EQ(ag_timeseries_append(ref, 1500, 99.0), AG_OK);
+                ASSERT_EQ(ag_timeseries_append(typed, 1500, 99.0), AG_OK);
+            }
+        }
+
+        /* Spans are double arrays */
+        ag_timeseries_view_t view;
+        ASSERT_EQ(ag_timeseries_view_last(typed, 10, &view), AG_ERR_INVALID_ARG);
+        ASSERT_EQ(ag_timeseries_view_range(typed, 0, 10, &view), AG_ERR_INVALID_ARG);
+
+        ag_timeseries_destroy(ref);
+        ag_timeseries_destroy(typed);
+    }
+}
+
+/* Test: Conversion rules, exact int64 appends and native batches/queries */
+TEST(typed_native) {
+    /* Integers round to nearest, saturate, store NaN as 0 */
+    ag_timeseries_t* i32 = ag_timeseries_create_typed(8, AG_VALUE_I32);
+    ag_timeseries_append(i32, 1, 2.5);
+    ag_timeseries_append(i32, 2, -2.4);
+    ag_timeseries_append(i32, 3, 1e12);
+    ag_timeseries_append(i32, 4, -1e12);
+    ag_timeseries_append(i32, 5, NAN);
+    int64_t timestamps[8];
+    double vals[8];
+    ASSERT_EQ(ag_timeseries_query_range(i32, 0, 10, 8, timestamps, vals), 5);
+    ASSERT_DOUBLE_EQ(vals[0], 3.0);
+    ASSERT_DOUBLE_EQ(vals[1], -2.0);
+    ASSERT_DOUBLE_EQ(vals[2], (double)INT32_MAX);
+    ASSERT_DOUBLE_EQ(vals[3], (double)INT32_MIN);
+    ASSERT_DOUBLE_EQ(vals[4], 0.0);
+
+    /* Native batch across the wrap, native last/range queries */
+    int32_t in[12];
+    int64_t in_ts[12];
+    for (int i = 0; i < 12; i++) {
+        in[i] = 1000 * i + 7;
+        in_ts[i] = 100 + i;
+    }
+    ASSERT_EQ(ag_timeseries_append_batch_native(i32, in_ts, in, 6), AG_OK);
+    ASSERT_EQ(ag_timeseries_append_batch_native(i32, in_ts + 6, in + 6, 6), AG_OK);
+    ASSERT_EQ(ag_timeseries_append_batch_native(i32, NULL, in, 1), AG_ERR_INVALID_ARG);
+    int32_t out[8];
+    ASSERT_EQ(ag_timeseries_query_last_native(i32, 8, timestamps, out), 8);
+    ASSERT_EQ(timestamps[0], 111);
+    ASSERT_EQ(out[0], 11007);
+    ASSERT_EQ(out[7], 4007);
+    ASSERT_EQ(ag_timeseries_query_range_native(i32, 105, 109, 8, timestamps, out), 5);
+    ASSERT_EQ(timestamps[0], 105);
+    ASSERT_EQ(out[0], 5007);
+    ASSERT_EQ(out[4], 9007);
+    ASSERT_EQ(ag_timeseries_query_range_native(i32, 109, 105, 8, timestamps, out), 0);
+    ag_timeseries_destroy(i32);
+
+    /* int64 beyond 2^53 survives append_i64 and native paths, not doubles */
+    ag_timeseries_t* i64 = ag_timeseries_create_typed(4, AG_VALUE_I64);
+    const int64_t big = (INT64_C(1) << 60) + 1;
+    ASSERT_EQ(ag_timeseries_append_i64(i64, 1, big), AG_OK);
+    ASSERT_EQ(ag_timeseries_append(i64, 2, 1e300), AG_OK);
+    int64_t wide[4];
+    ASSERT_EQ(ag_timeseries_query_range_native(i64, 0, 10, 4, timestamps, wide), 2);
+    ASSERT_EQ(wide[0], big);
+    ASSERT_EQ(wide[1], INT64_MAX);
+    int64_t batch[3] = { big, big + 1, big + 2 };
+    int64_t batch_ts[3] = { 3, 4, 5 };
+    ASSERT_EQ(ag_timeseries_append_batch_native(i64, batch_ts, batch, 3), AG_OK);
+    ASSERT_EQ(ag_timeseries_query_last_native(i64, 4, timestamps, wide), 4);
+    ASSERT_EQ(wide[0], big + 2);
+    ASSERT_EQ(wide[2], big);
+    ASSERT_EQ(wide[3], INT64_MAX);
+    ag_timeseries_destroy(i64);
+
+    /* The reorder buffer stages int64 values exactly, late points included */
+    i64 = ag_timeseries_create_typed(8, AG_VALUE_I64);
+    ASSERT_EQ(ag_timeseries_enable_reorder(i64, 100, 8), AG_OK);
+    const int64_t edge = (INT64_C(1) << 53) + 1;
+    ASSERT_EQ(ag_timeseries_append_i64(i64, 20, edge), AG_OK);
+    ASSERT_EQ(ag_timeseries_append_i64(i64, 10, -edge), AG_OK);
+    ASSERT_EQ(ag_timeseries_append_batch_native(i64, batch_ts, batch, 1), AG_OK);
+    ASSERT_EQ(ag_timeseries_append(i64, 30, 2.5), AG_OK);
+    ASSERT_EQ(ag_timeseries_flush_reorder(i64), AG_OK);
+    ASSERT_EQ(ag_timeseries_query_range_native(i64, 0, 100, 4, timestamps, wide), 4);
+    ASSERT_EQ(timestamps[0], 3);
+    ASSERT_EQ(wide[0], big);
+    ASSERT_EQ(wide[1], -edge);
+    ASSERT_EQ(wide[2], edge);
+    ASSERT_EQ(wide[3], 3);
+
+    /* Integers that are NaN bit patterns as doubles stay exact */
+    const int64_t nan_bits = (int64_t)UINT64_C(0xfff0000000000001);
+    ASSERT_EQ(ag_timeseries_append_i64(i64, 50, -1), AG_OK);
+    ASSERT_EQ(ag_timeseries_append_i64(i64, 40, nan_bits), AG_OK);
+    ASSERT_EQ(ag_timeseries_flush_reorder(i64), AG_OK);
+    ASSERT_EQ(ag_timeseries_query_last_native(i64, 2, timestamps, wide), 2);
+    ASSERT_EQ(timestamps[0], 50);
+    ASSERT_EQ(wide[0], -1);
+    ASSERT_EQ(wide[1], nan_bits);
+    ag_timeseries_destroy(i64);
+
+    /* float series through create_ex; reorder falls back to point appends */
+    ag_timeseries_options_t opt = { AG_CREATE_LAZY, 0, AG_VALUE_F32 };
+    ag_timeseries_t* f32 = ag_timeseries_create_ex(16, &opt);
+    ASSERT_NE(f32, NULL);
+    ASSERT_EQ(ag_timeseries_value_type(f32), AG_VALUE_F32);
+    ASSERT_EQ(ag_timeseries_enable_reorder(f32, 100, 4), AG_OK);
+    float fin[3] = { 0.5f, 1.5f, 2.5f };
+    int64_t fin_ts[3] = { 30, 10, 20 };
+    ASSERT_EQ(ag_timeseries_append_batch_native(f32, fin_ts, fin, 3), AG_OK);
+    ASSERT_EQ(ag_timeseries_flush_reorder(f32), AG_OK);
+    float fout[3];
+    ASSERT_EQ(ag_timeseries_query_range_native(f32, 0, 100, 3, timestamps, fout), 3);
+    ASSERT_EQ(timestamps[0], 10);
+    ASSERT(fout[0] == 1.5f && fout[1] == 2.5f && fout[2] == 0.5f);
+    ag_timeseries_destroy(f32);
+
+    /* Interleaved pairs are double only; double series take native doubles */
+    opt.flags = AG_CREATE_INTERLEAVED;
+    ASSERT_EQ(ag_timeseries_create_ex(16, &opt), NULL);
+    opt.value_type = 9;
+    opt.flags = 0;
+    ASSERT_EQ(ag_timeseries_create_ex(16, &opt), NULL);
+    ag_timeseries_t* f64 = ag_timeseries_create_typed(4, AG_VALUE_F64);
+    double din[2] = { 1.25, 2.5 };
+    ASSERT_EQ(ag_timeseries_append_batch_native(f64, fin_ts, din, 2), AG_OK);
+    double dout[2];
+    ASSERT_EQ(ag_timeseries_query_last_native(f64, 2, timestamps, dout), 2);
+    ASSERT_DOUBLE_EQ(dout[0], 2.5);
+    ag_timeseries_destroy(f64);
+}
+
+/* Test: Histogram bucket bounds and quantile estimates (any build) */
+TEST(metrics_histogram) {
+    /* Exact below 4 ns, then four buckets per power of two */
+    ASSERT_EQ(ag_timeseries_histogram_bucket_ns(0), 0);
+    ASSERT_EQ(ag_timeseries_histogram_bucket_ns(3), 3);
+    ASSERT_EQ(ag_timeseries_histogram_bucket_ns(4), 4);
+    ASSERT_EQ(ag_timeseries_histogram_bucket_ns(5), 5);
+    ASSERT_EQ(ag_timeseries_histogram_bucket_ns(8), 8);
+    ASSERT_EQ(ag_timeseries_histogram_bucket_ns(9), 10);
+    ASSERT_EQ(ag_timeseries_histogram_bucket_ns(AG_METRICS_BUCKETS), (uint64_t)1 << 33);
+    ASSERT_EQ(ag_timeseries_histogram_bucket_ns(AG_METRICS_BUCKETS + 1), UINT64_MAX);
+    for (size_t b = 1; b <= AG_METRICS_BUCKETS; b++) {
+        ASSERT(ag_timeseries_histogram_bucket_ns(b) > ag_timeseries_histogram_bucket_ns(b - 1));
+    }
+
+    /* 90 samples at 4 ns, 10 at 8-9 ns */
+    ag_timeseries_histogram_t hist;
+    memset(&hist, 0, sizeof(hist));
+    hist.buckets[4] = 90;
+    hist.buckets[8] = 10;
+    hist.count = 100;
+    hist.max_ns = 9;
+    ASSERT_EQ(ag_timeseries_histogram_quantile(&hist, 0.0), 5);
+    ASSERT_EQ(ag_timeseries_histogram_quantile(&hist, 0.5), 5);
+    ASSERT_EQ(ag_timeseries_histogram_quantile(&hist, 0.9), 5);
+    ASSERT_EQ(ag_timeseries_histogram_quantile(&hist, 0.99), 9);   /* Capped by max */
+    ASSERT_EQ(ag_timeseries_histogram_quantile(&hist, 1.5), 0);
+    ASSERT_EQ(ag_timeseries_histogram_quantile(NULL, 0.5), 0);
+    hist.count = 0;
+    ASSERT_EQ(ag_timeseries_histogram_quantile(&hist, 0.5), 0);
+}
+
+/* Test: Per-series and global instrumentation counters */
+TEST(metrics_counters) {
+    ag_timeseries_metrics_t m;
+    ASSERT_EQ(ag_timeseries_get_metrics(NULL, NULL), AG_ERR_INVALID_ARG);
+
+#ifdef AG_METRICS
+    ag_timeseries_metrics_t before;
+    ASSERT_EQ(ag_timeseries_get_metrics(NULL, &before), AG_OK);
+
+    ag_timeseries_t* ts = ag_timeseries_create(8);
+    ASSERT_NE(ts, NULL);
+    ASSERT_EQ(ag_timeseries_get_metrics(ts, &m), AG_OK);
+    ASSERT_EQ(m.appends, 0);
+    ASSERT_EQ(m.queries, 0);
+
+    /* 10 single appends into 8 slots, then a 20-point batch */
+    int64_t timestamps[20];
+    double values[20];
+    for (int64_t i = 0; i < 10; i++) {
+        ASSERT_EQ(ag_timeseries_append(ts, i, (double)i), AG_OK);
+    }
+    for (int i = 0; i < 20; i++) {
+        timestamps[i] = 10 + i;
+        values[i] = (double)i;
+    }
+    ASSERT_EQ(ag_timeseries_append_batch(ts, timestamps, values, 20), AG_OK);
+    ASSERT_EQ(ag_timeseries_get_metrics(ts, &m), AG_OK);
+    ASSERT_EQ(m.appends, 30);
+    ASSERT_EQ(m.overwrites, 22);
+
+    /* Ordered queries scan only what they return */
+    ASSERT_EQ(ag_timeseries_query_last(ts, 4, timestamps, values), 4);
+    ASSERT_EQ(ag_timeseries_query_range(ts, 25, 26, 20, timestamps, values), 2);
+    ASSERT_EQ(ag_timeseries_get_metrics(ts, &m), AG_OK);
+    ASSERT_EQ(m.queries, 2);
+    ASSERT_EQ(m.points_scanned, 6);
+    ASSERT_EQ(m.points_returned, 6);
+
+    /* An unordered window is scanned whole */
+    ASSERT_EQ(ag_timeseries_append(ts, 0, 0.0), AG_OK);
+    ASSERT_EQ(ag_timeseries_query_range(ts, 25, 26, 20, timestamps, values), 2);
+    double sum = 0.0;
+    ASSERT_EQ(ag_timeseries_aggregate_range(ts, 25, 26, AG_AGG_SUM, &sum), AG_OK);
+    ASSERT_EQ(ag_timeseries_get_metrics(ts, &m), AG_OK);
+    ASSERT_EQ(m.queries, 4);
+    ASSERT_EQ(m.points_scanned, 6 + 8 + 8);
+    ASSERT_EQ(m.points_returned, 6 + 2 + 2);
+    ASSERT_EQ(m.retries, 0);
+
+    /* One latency sample per query */
+    ASSERT_EQ(m.query_latency.count, m.queries);
+    uint64_t total = 0;
+    for (size_t b = 0; b < AG_METRICS_BUCKETS; b++) {
+        total += m.query_latency.buckets[b];
+    }
+    ASSERT_EQ(total, m.queries);
+    ASSERT(m.query_latency.sum_ns >= m.query_latency.max_ns);
+    ASSERT(ag_timeseries_histogram_quantile(&m.query_latency, 0.5) <= m.query_latency.max_ns);
+
+    /* Global totals: queries right away, appends folded in on destroy */
+    ASSERT_EQ(ag_timeseries_get_metrics(NULL, &m), AG_OK);
+    ASSERT_EQ(m.queries - before.queries, 4);
+    ag_timeseries_destroy(ts);
+    ASSERT_EQ(ag_timeseries_get_metrics(NULL, &m), AG_OK);
+    ASSERT_EQ(m.appends - before.appends, 31);
+    ASSERT_EQ(m.overwrites - before.overwrites, 23);
+#else
+    /* Not compiled in: zeroed output */
+    memset(&m, 0xff, sizeof(m));
+    ASSERT_EQ(ag_timeseries_get_metrics(NULL, &m), AG_ERR_UNSUPPORTED);
+    ASSERT_EQ(m.appends, 0);
+    ASSERT_EQ(m.query_latency.count, 0);
+#endif
+}
+
+TEST(cursor_read) {
+    ag_timeseries_t* ts = ag_timeseries_create(10);
+    ag_ts_cursor_t oldest;
+    ag_ts_cursor_t latest;
+    int64_t timestamps[10];
+    double values[10];
+    size_t count = 99;
+    uint64_t lost = 99;
+
+    ASSERT_EQ(ag_timeseries_cursor_init(NULL, AG_CURSOR_OLDEST, &oldest), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_cursor_init(ts, 2, &oldest), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_cursor_read(ts, NULL, 10, timestamps, values, &count, NULL),
+              AG_ERR_INVALID_ARG);
+
+    for (int64_t i = 0; i < 4; i++) {
+        ag_timeseries_append(ts, i, (double)i);
+    }
+    ASSERT_EQ(ag_timeseries_cursor_init(ts, AG_CURSOR_OLDEST, &oldest), AG_OK);
+    ASSERT_EQ(ag_timeseries_cursor_init(ts, AG_CURSOR_LATEST, &latest), AG_OK);
+
+    /* Replay drains in chunks, then nothing until the next append */
+    ASSERT_EQ(ag_timeseries_cursor_read(ts, &oldest, 3, timestamps, values, &count, &lost), AG_OK);
+    ASSERT_EQ(count, 3);
+    ASSERT_EQ(lost, 0);
+    ASSERT_EQ(timestamps[0], 0);
+    ASSERT_EQ(timestamps[2], 2);
+    ASSERT_EQ(ag_timeseries_cursor_read(ts, &oldest, 3, timestamps, values, &count, NULL), AG_OK);
+    ASSERT_EQ(count, 1);
+    ASSERT_EQ(timestamps[0], 3);
+    ASSERT_EQ(ag_timeseries_cursor_read(ts, &oldest, 3, timestamps, values, &count, NULL), AG_OK);
+    ASSERT_EQ(count, 0);
+    ASSERT_EQ(ag_timeseries_cursor_read(ts, &latest, 10, timestamps, values, &count, NULL), AG_OK);
+    ASSERT_EQ(count, 0);
+
+    ag_timeseries_append(ts, 4, 4.0);
+    ASSERT_EQ(ag_timeseries_cursor_read(ts, &latest, 10, timestamps, values, &count, NULL), AG_OK);
+    ASSERT_EQ(count, 1);
+    ASSERT_EQ(timestamps[0], 4);
+    ASSERT_DOUBLE_EQ(values[0], 4.0);
+
+    /* 25 more points lap a 10-slot ring: 16 of the 26 unread are lost */
+    for (int64_t i = 5; i < 30; i++) {
+        ag_timeseries_append(ts, i, (double)i);
+    }
+    ASSERT_EQ(ag_timeseries_cursor_read(ts, &oldest, 4, timestamps, values, &count, &lost),
+              AG_ERR_LAPPED);
+    ASSERT_EQ(lost, 16);
+    ASSERT_EQ(oldest.lost, 16);
+    ASSERT_EQ(count, 4);
+    ASSERT_EQ(timestamps[0], 20);
+    ASSERT_EQ(timestamps[3], 23);
+    ASSERT_EQ(ag_timeseries_cursor_read(ts, &oldest, 10, timestamps, values, &count, &lost), AG_OK);
+    ASSERT_EQ(lost, 0);
+    ASSERT_EQ(count, 6);
+    ASSERT_EQ(timestamps[5], 29);
+
+    /* A cursor ahead of the buffer belongs to another one */
+    ag_timeseries_t* other = ag_timeseries_create_interleaved(10);
+    ASSERT_EQ(ag_timeseries_cursor_read(other, &oldest, 10, timestamps, values, &count, NULL),
+              AG_ERR_INVALID_ARG);
+    ag_timeseries_append(other, 7, 7.0);
+    ASSERT_EQ(ag_timeseries_cursor_init(other, AG_CURSOR_OLDEST, &latest), AG_OK);
+    ASSERT_EQ(ag_timeseries_cursor_read(other, &latest, 10, timestamps, values, &count, NULL), AG_OK);
+    ASSERT_EQ(count, 1);
+    ASSERT_EQ(timestamps[0], 7);
+
+    /* Zero-copy view: skips lost points, then holds until consumed */
+    ag_timeseries_view_t view;
+    ag_ts_cursor_t viewer = { 20, 0 };
+    for (int64_t i = 30; i < 35; i++) {
+        ag_timeseries_append(ts, i, (double)i);     /* 25..34 stored, wraps at 30 */
+    }
+    ASSERT_EQ(ag_timeseries_cursor_view(ts, &viewer, 8, &view, &lost), AG_ERR_LAPPED);
+    ASSERT_EQ(lost, 5);
+    ASSERT_EQ(viewer.lost, 5);
+    ASSERT_EQ(view.begin_seq, 25);
+    ASSERT_EQ(view.length, 8);
+    ASSERT_EQ(view.span_count, 2);
+    ASSERT_EQ(view.spans[0].length, 5);
+    ASSERT_EQ(view.spans[0].timestamps[0], 25);
+    ASSERT_EQ(view.spans[1].timestamps[0], 30);
+    ASSERT_EQ(ag_timeseries_cursor_view(ts, &viewer, 8, &view, &lost), AG_OK);
+    ASSERT_EQ(lost, 0);
+    ASSERT_EQ(view.begin_seq, 25);
+    viewer.next_seq = view.end_seq;
+    ASSERT_EQ(ag_timeseries_cursor_view(ts, &viewer, 8, &view, NULL), AG_OK);
+    ASSERT_EQ(view.length, 2);
+    ASSERT_EQ(view.spans[0].timestamps[0], 33);
+    ASSERT_DOUBLE_EQ(view.spans[0].values[1], 34.0);
+    ASSERT_EQ(ag_timeseries_cursor_view(other, &latest, 8, &view, NULL), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_cursor_view(ts, NULL, 8, &view, NULL), AG_ERR_INVALID_ARG);
+
+    ag_timeseries_destroy(ts);
+    ag_timeseries_destroy(other);
+}
+
+TEST(asof_align) {
+    ag_timeseries_t* ts = ag_timeseries_create(8);
+    int64_t t = 0;
+    double v = 0.0;
+
+    ASSERT_EQ(ag_timeseries_asof(NULL, 0, &t, &v), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_asof(ts, 0, NULL, &v), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_asof(ts, 0, &t, &v), AG_ERR_EMPTY);
+
+    /* 12 points into 8 slots: stored 40..110, wrapped */
+    for (int64_t i = 0; i < 12; i++) {
+        ag_timeseries_append(ts, i * 10, (double)i);
+    }
+    ASSERT_EQ(ag_timeseries_asof(ts, 39, &t, &v), AG_ERR_EMPTY);
+    ASSERT_EQ(ag_timeseries_asof(ts, 40, &t, &v), AG_OK);
+    ASSERT_EQ(t, 40);
+    ASSERT_DOUBLE_EQ(v, 4.0);
+    ASSERT_EQ(ag_timeseries_asof(ts, 79, &t, &v), AG_OK);
+    ASSERT_EQ(t, 70);
+    ASSERT_EQ(ag_timeseries_asof(ts, 85, &t, &v), AG_OK);
+    ASSERT_EQ(t, 80);
+    ASSERT_EQ(ag_timeseries_asof(ts, INT64_MAX, &t, &v), AG_OK);
+    ASSERT_EQ(t, 110);
+
+    /* Equal timestamps: the latest append wins */
+    ag_timeseries_append(ts, 110, 99.0);
+    ASSERT_EQ(ag_timeseries_asof(ts, 110, &t, &v), AG_OK);
+    ASSERT_DOUBLE_EQ(v, 99.0);
+
+    /* Align a sparse series and a dense one on query timestamps */
+    ag_timeseries_t* dense = ag_timeseries_create_interleaved(64);
+    for (int64_t i = 0; i < 100; i++) {
+        ag_timeseries_append(dense, i * 3, (double)(i * 3));
+    }
+    const ag_timeseries_t* series[2] = { ts, dense };
+    int64_t query[6] = { 0, 50, 50, 151, 200, 1000 };
+    double matrix[12];
+    ASSERT_EQ(ag_timeseries_align(series, 2, query, 6, matrix), AG_OK);
+    for (size_t i = 0; i < 6; i++) {
+        for (size_t j = 0; j < 2; j++) {
+            double cell = matrix[i * 2 + j];
+            if (ag_timeseries_asof(series[j], query[i], &t, &v) == AG_OK) {
+                ASSERT_DOUBLE_EQ(cell, v);
+            } else {
+                ASSERT(isnan(cell));
+            }
+        }
+    }
+    ASSERT(isnan(matrix[0]));
+    ASSERT(isnan(matrix[3]));       /* dense starts at 108 */
+    ASSERT_DOUBLE_EQ(matrix[6], 99.0);
+    ASSERT_DOUBLE_EQ(matrix[7], 150.0);
+    ASSERT_DOUBLE_EQ(matrix[11], 297.0);
+
+    int64_t backwards[2] = { 10, 5 };
+    ASSERT_EQ(ag_timeseries_align(series, 2, backwards, 2, matrix), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_align(NULL, 2, query, 6, matrix), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_align(series, 2, query, 0, NULL), AG_OK);
+
+    /* Unordered window: as-of scans, align refuses */
+    ag_timeseries_append(ts, 75, -1.0);
+    ASSERT_EQ(ag_timeseries_asof(ts, 78, &t, &v), AG_OK);
+    ASSERT_EQ(t, 75);
+    ASSERT_DOUBLE_EQ(v, -1.0);
+    ASSERT_EQ(ag_timeseries_asof(ts, 105, &t, &v), AG_OK);
+    ASSERT_EQ(t, 100);
+    ASSERT_EQ(ag_timeseries_asof(ts, 59, &t, &v), AG_ERR_EMPTY);
+    ASSERT_EQ(ag_timeseries_align(series, 2, query, 6, matrix), AG_ERR_UNORDERED);
+
+    ag_timeseries_destroy(ts);
+    ag_timeseries_destroy(dense);
+}
+
+/* Shared state for concurrent aggregate_many callers */
+typedef struct {
+    ag_timeseries_pool_t* pool;
+    const ag_timeseries_t* const* series;
+    size_t k;
+    const double* expect;
+    int ok;
+} many_caller_t;
+
+/* Helper: Repeated aggregate_many calls checked against 'expect' */
+static void* many_caller(void* arg) {
+    many_caller_t* c = (many_caller_t*)arg;
+    const int aggs[] = { AG_AGG_COUNT, AG_AGG_SUM };
+    double* out = (double*)malloc(c->k * 2 * sizeof(double));
+    c->ok = (out != NULL);
+    for (int round = 0; round < 50 && c->ok; round++) {
+        c->ok = ag_timeseries_aggregate_many(c->series, c->k, 0, INT64_MAX, aggs, 2, out,
+                                             c->pool) == AG_OK &&
+                memcmp(out, c->expect, c->k * 2 * sizeof(double)) == 0;
+    }
+    free(out);
+    return NULL;
+}
+
+/* Test: Parallel multi-series aggregation matches per-series calls */
+TEST(aggregate_many) {
+    enum { K = 200, NAGGS = 5 };
+    const int aggs[NAGGS] = { AG_AGG_COUNT, AG_AGG_SUM, AG_AGG_MEAN, AG_AGG_MIN, AG_AGG_MAX };
+    ag_timeseries_t* series[K];
+    static double expect[K * NAGGS];
+    static double out[K * NAGGS];
+
+    /* Uneven sizes (long series bunched at the front), empty and unordered ones */
+    for (size_t i = 0; i < K; i++) {
+        size_t n = (i < 8) ? 20000 : (i * 37) % 500;
+        series[i] = ag_timeseries_create(4096);
+        ASSERT_NE(series[i], NULL);
+        for (size_t t = 0; t < n; t++) {
+            int64_t ts = (i % 10 == 3 && t % 7 == 0) ? (int64_t)t - 5 : (int64_t)t;
+            ag_timeseries_append(series[i], ts, (double)((t * 31 + i) % 1000) - 500.0);
+        }
+    }
+    const ag_timeseries_t* const* view = (const ag_timeseries_t* const*)series;
+
+    for (size_t i = 0; i < K; i++) {
+        for (size_t j = 0; j < NAGGS; j++) {
+            double* e = &expect[i * NAGGS + j];
+            if (ag_timeseries_aggregate_range(series[i], 100, 15000, aggs[j], e) != AG_OK) {
+                *e = NAN;
+            }
+        }
+    }
+
+    /* Caller only, then pools of several sizes, many rounds */
+    ASSERT_EQ(ag_timeseries_aggregate_many(view, K, 100, 15000, aggs, NAGGS, out, NULL),
+              AG_OK);
+    ASSERT_EQ(memcmp(out, expect, sizeof(out)), 0);
+
+    ag_timeseries_pool_t* pool = NULL;
+    const size_t threads[] = { 1, 3, 7 };
+    for (size_t p = 0; p < 3; p++) {
+        pool = ag_timeseries_pool_create(threads[p]);
+        ASSERT_NE(pool, NULL);
+        ASSERT_EQ(ag_timeseries_pool_threads(pool), threads[p]);
+        for (int round = 0; round < 20; round++) {
+            memset(out, 0, sizeof(out));
+            ASSERT_EQ(ag_timeseries_aggregate_many(view, K, 100, 15000, aggs, NAGGS, out,
+                                                   pool), AG_OK);
+            ASSERT_EQ(memcmp(out, expect, sizeof(out)), 0);   /* Bitwise, NaN included */
+        }
+
+        /* Fewer series than participants */
+        ASSERT_EQ(ag_timeseries_aggregate_many(view + 190, 10, 100, 15000, aggs, NAGGS, out,
+                                               pool), AG_OK);
+        ASSERT_EQ(memcmp(out, expect + 190 * NAGGS, 10 * NAGGS * sizeof(double)), 0);
+        if (p < 2) {
+            ag_timeseries_pool_destroy(pool);
+        }
+    }
+
+    /* Concurrent callers share the pool */
+    static double expect2[K * 2];
+    for (size_t i = 0; i < K; i++) {
+        ag_timeseries_aggregate_range(series[i], 0, INT64_MAX, AG_AGG_COUNT, &expect2[i * 2]);
+        ag_timeseries_aggregate_range(series[i], 0, INT64_MAX, AG_AGG_SUM, &expect2[i * 2 + 1]);
+    }
+    many_caller_t callers[3];
+    pthread_t tids[3];
+    for (int c = 0; c < 3; c++) {
+        callers[c] = (many_caller_t){ pool, view, K, expect2, 0 };
+        ASSERT_EQ(pthread_create(&tids[c], NULL, many_caller, &callers[c]), 0);
+    }
+    for (int c = 0; c < 3; c++) {
+        pthread_join(tids[c], NULL);
+        ASSERT(callers[c].ok);
+    }
+
+    /* Invalid arguments */
+    const int bad[] = { AG_AGG_SUM, 99 };
+    ASSERT_EQ(ag_timeseries_aggregate_many(view, K, 0, 1, bad, 2, out, pool),
+              AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_aggregate_many(view, K, 0, 1, aggs, 0, out, pool),
+              AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_aggregate_many(view, K, 0, 1, NULL, 1, out, pool),
+              AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_aggregate_many(view, K, 0, 1, aggs, 1, NULL, pool),
+              AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_aggregate_many(NULL, 0, 0, 1, aggs, 1, NULL, pool), AG_OK);
+    ag_timeseries_t* saved = series[5];
+    series[5] = NULL;
+    ASSERT_EQ(ag_timeseries_aggregate_many(view, K, 0, 1, aggs, 1, out, pool),
+              AG_ERR_INVALID_ARG);
+    series[5] = saved;
+
+    ASSERT_EQ(ag_timeseries_pool_create(100000), NULL);
+    ASSERT_EQ(ag_timeseries_pool_threads(NULL), 0);
+    ag_timeseries_pool_destroy(NULL);
+    ag_timeseries_pool_destroy(pool);
+
+    /* Auto-sized pool (one worker per extra CPU, possibly none) */
+    pool = ag_timeseries_pool_create(0);
+    ASSERT_NE(pool, NULL);
+    ASSERT_EQ(ag_timeseries_aggregate_many(view, K, 100, 15000, aggs, NAGGS, out, pool),
+              AG_OK);
+    ASSERT_EQ(memcmp(out, expect, sizeof(out)), 0);
+    ag_timeseries_pool_destroy(pool);
+
+    for (size_t i = 0; i < K; i++) {
+        ag_timeseries_destroy(series[i]);
+    }
+}
+
+/* Helper: Expect b to hold the same points as a, bitwise */
+static void check_same_points(const ag_timeseries_t* a, const ag_timeseries_t* b) {
+    size_t n = ag_timeseries_size(a);
+    int64_t* ta = (int64_t*)malloc((n + 1) * sizeof(int64_t));
+    int64_t* tb = (int64_t*)malloc((n + 1) * sizeof(int64_t));
+    double* va = (double*)malloc((n + 1) * sizeof(double));
+    double* vb = (double*)malloc((n + 1) * sizeof(double));
+    ASSERT_EQ(ag_timeseries_size(b), n);
+    ASSERT_EQ(ag_timeseries_query_last(a, n + 1, ta, va), n);
+    ASSERT_EQ(ag_timeseries_query_last(b, n + 1, tb, vb), n);
+    ASSERT(memcmp(ta, tb, n * sizeof(int64_t)) == 0);
+    ASSERT(memcmp(va, vb, n * sizeof(double)) == 0);
+    ASSERT_EQ(ag_timeseries_is_monotonic(b), ag_timeseries_is_monotonic(a));
+    free(ta);
+    free(tb);
+    free(va);
+    free(vb);
+}
+
+/* Test: Snapshots round-trip every layout, raw and delta, and reject damage */
+TEST(serialize_roundtrip) {
+    ag_timeseries_t* all[4] = {
+        ag_timeseries_create(1000),
+        ag_timeseries_create_interleaved(1000),
+        ag_timeseries_create_typed(1000, AG_VALUE_I32),
+        ag_timeseries_create_typed(1000, AG_VALUE_F32),
+    };
+    size_t cap = 64 + 10 * 1000 + 8 * 1000 + 16;
+    unsigned char* buf = (unsigned char*)malloc(cap + 8);
+
+    for (int k = 0; k < 4; k++) {
+        ag_timeseries_t* ts = all[k];
+        size_t len;
+
+        /* Empty buffer */
+        ASSERT_EQ(ag_timeseries_serialize(ts, buf, cap, 0, &len), AG_OK);
+        ASSERT_EQ(len, 64);
+        ag_timeseries_t* copy = ag_timeseries_deserialize(buf, len, 0);
+        ASSERT_NE(copy, NULL);
+        ASSERT_EQ(ag_timeseries_size(copy), 0);
+        ASSERT_EQ(ag_timeseries_capacity(copy), 1000);
+        ag_timeseries_destroy(copy);
+
+        /* Wrapped window with jitter, a late point, extremes and NaN */
+        for (int64_t i = 0; i < 1500; i++) {
+            int64_t t = 1700000000000 + i * 100 + (i * 7919) % 13;
+            double v = (double)(i % 50);
+            if (i == 1200) {
+                t = INT64_MIN;
+            } else if (i == 1201) {
+                t = INT64_MAX;
+            } else if (i == 1300) {
+                t = 5;                  /* Late */
+            } else if (i == 1400) {
+                v = NAN;
+            }
+            ASSERT_EQ(ag_timeseries_append(ts, t, v), AG_OK);
+        }
+        ASSERT_EQ(ag_timeseries_is_monotonic(ts), 0);
+
+        for (unsigned flags = 0; flags <= AG_SERIAL_DELTA; flags += AG_SERIAL_DELTA) {
+            /* Sizing call, then a too-small buffer */
+            size_t need;
+            ASSERT_EQ(ag_timeseries_serialize(ts, NULL, 0, flags, &need), AG_ERR_FULL);
+            ASSERT(need > 64);
+            ASSERT_EQ(ag_timeseries_serialize(ts, buf, need - 1, flags, &len), AG_ERR_FULL);
+            ASSERT_EQ(len, need);
+            ASSERT_EQ(ag_timeseries_serialize(ts, buf, need, flags, &len), AG_OK);
+            ASSERT(len <= need);
+            if (flags & AG_SERIAL_DELTA) {
+                ASSERT(len < 64 + 1000 * 4 + 1000 * 8);     /* Mostly 1-2 byte deltas */
+            } else {
+                ASSERT_EQ(len, need);
+            }
+
+            copy = ag_timeseries_deserialize(buf, len, 0);
+            ASSERT_NE(copy, NULL);
+            ASSERT_EQ(ag_timeseries_value_type(copy), ag_timeseries_value_type(ts));
+            check_same_points(ts, copy);
+            ag_timeseries_destroy(copy);
+
+            /* Unaligned source: copying path */
+            memmove(buf + 1, buf, len);
+            copy = ag_timeseries_deserialize(buf + 1, len, 0);
+            ASSERT_NE(copy, NULL);
+            check_same_points(ts, copy);
+            ag_timeseries_destroy(copy);
+            memmove(buf, buf + 1, len);
+
+            /* Smaller capacity keeps the newest points */
+            copy = ag_timeseries_deserialize(buf, len, 10);
+            ASSERT_NE(copy, NULL);
+            ASSERT_EQ(ag_timeseries_size(copy), 10);
+            int64_t t1[1];
+            double v1[1];
+            int64_t t2[1];
+            double v2[1];
+            ag_timeseries_query_last(ts, 1, t1, v1);
+            ag_timeseries_query_last(copy, 1, t2, v2);
+            ASSERT_EQ(t1[0], t2[0]);
+            ag_timeseries_destroy(copy);
+
+            /* Damage: truncation, a flipped payload bit, bad magic, type mismatch */
+            ASSERT_EQ(ag_timeseries_deserialize(buf, len - 1, 0), NULL);
+            ASSERT_EQ(ag_timeseries_deserialize(buf, 63, 0), NULL);
+            buf[len / 2] ^= 0x10;
+            ASSERT_EQ(ag_timeseries_deserialize(buf, len, 0), NULL);
+            buf[len / 2] ^= 0x10;
+            buf[0] ^= 1;
+            ASSERT_EQ(ag_timeseries_deserialize(buf, len, 0), NULL);
+            buf[0] ^= 1;
+            ag_timeseries_t* other = ag_timeseries_create_typed(10, AG_VALUE_I64);
+            ASSERT_EQ(ag_timeseries_load(other, buf, len), AG_ERR_INVALID_ARG);
+            ASSERT_EQ(ag_timeseries_size(other), 0);
+            ag_timeseries_destroy(other);
+        }
+    }
+
+    /* Load appends: stats see the points, an existing tail stays */
+    ag_timeseries_t* src = all[0];
+    size_t len;
+    ASSERT_EQ(ag_timeseries_serialize(src, buf, cap, AG_SERIAL_DELTA, &len), AG_OK);
+    ag_timeseries_t* dst = ag_timeseries_create(2000);
+    ASSERT_EQ(ag_timeseries_enable_stats(dst), AG_OK);
+    ASSERT_EQ(ag_timeseries_append(dst, 1, 1.0), AG_OK);
+    ASSERT_EQ(ag_timeseries_load(dst, buf, len), AG_OK);
+    ASSERT_EQ(ag_timeseries_size(dst), 1001);
+    ag_timeseries_stats_t st;
+    ASSERT_EQ(ag_timeseries_stats(dst, &st), AG_OK);
+    ASSERT_EQ(st.count, 1001);
+
+    /* Arguments */
+    ASSERT_EQ(ag_timeseries_serialize(NULL, buf, cap, 0, &len), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_serialize(src, buf, cap, 0, NULL), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_serialize(src, NULL, 10, 0, &len), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_serialize(src, buf, cap, 0x80, &len), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_load(NULL, buf, len), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_load(dst, NULL, len), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_deserialize(NULL, 100, 0), NULL);
+
+    ag_timeseries_destroy(dst);
+    for (int k = 0; k < 4; k++) {
+        ag_timeseries_destroy(all[k]);
+    }
+    free(buf);
+}
+
+/* Helper: Check ts stores exactly timestamps first, first + 2, ..., last, value = timestamp / 2 */
+static void check_resized(ag_timeseries_t* ts, int64_t first, int64_t last) {
+    size_t n = (size_t)((last - first) / 2 + 1);
+    int64_t* out_ts = (int64_t*)malloc(n * sizeof(int64_t));
+    double* out_vals = (double*)malloc(n * sizeof(double));
+    ASSERT_EQ(ag_timeseries_size(ts), n);
+    ASSERT_EQ(ag_timeseries_query_last(ts, n + 5, out_ts, out_vals), n);
+    for (size_t i = 0; i < n; i++) {
+        ASSERT_EQ(out_ts[i], last - 2 * (int64_t)i);
+        ASSERT_DOUBLE_EQ(out_vals[i], (double)(last - 2 * (int64_t)i) / 2);
+    }
+    ASSERT_EQ(ag_timeseries_query_range(ts, first, last, n, out_ts, out_vals), n);
+    ASSERT_EQ(out_ts[0], first);
+    free(out_ts);
+    free(out_vals);
+}
+
+/* Test: Resize grows and shrinks every heap layout, keeping the newest points */
+TEST(resize) {
+    ASSERT_EQ(ag_timeseries_resize(NULL, 10), AG_ERR_INVALID_ARG);
+    ag_timeseries_t* spmc = ag_timeseries_create_spmc(10);
+    ASSERT_EQ(ag_timeseries_resize(spmc, 20), AG_ERR_INVALID_ARG);
+    ag_timeseries_destroy(spmc);
+
+    ag_timeseries_t* all[4] = {
+        ag_timeseries_create(100),
+        ag_timeseries_create_pow2(64),
+        ag_timeseries_create_interleaved(100),
+        ag_timeseries_create_typed(100, AG_VALUE_I64),
+    };
+    for (int k = 0; k < 4; k++) {
+        ag_timeseries_t* ts = all[k];
+        size_t cap = ag_timeseries_capacity(ts);
+        ASSERT_EQ(ag_timeseries_resize(ts, 0), AG_ERR_INVALID_ARG);
+        ASSERT_EQ(ag_timeseries_resize(ts, SIZE_MAX), AG_ERR_INVALID_ARG);
+        ASSERT_EQ(ag_timeseries_resize(ts, cap), AG_OK);
+
+        /* Empty resize, then a wrapped window */
+        ASSERT_EQ(ag_timeseries_resize(ts, 50), AG_OK);
+        ASSERT_EQ(ag_timeseries_size(ts), 0);
+        ASSERT_EQ(ag_timeseries_resize(ts, cap), AG_OK);
+        ASSERT_EQ(ag_timeseries_enable_stats(ts), AG_OK);
+        int64_t t = 0;
+        for (; t < 250; t += 2) {
+            ASSERT_EQ(ag_timeseries_append(ts, t, (double)t / 2), AG_OK);
+        }
+        ag_ts_cursor_t cur;
+        ASSERT_EQ(ag_timeseries_cursor_init(ts, AG_CURSOR_OLDEST, &cur), AG_OK);
+
+        /* Grow: every point stays, the room fills before anything wraps */
+        ASSERT_EQ(ag_timeseries_resize(ts, 333), AG_OK);
+        ASSERT_EQ(ag_timeseries_capacity(ts), 333);
+        ASSERT_EQ(ag_timeseries_is_monotonic(ts), 1);
+        check_resized(ts, 250 - 2 * (int64_t)cap, 248);
+        for (; t < 1000; t += 2) {
+            ASSERT_EQ(ag_timeseries_append(ts, t, (double)t / 2), AG_OK);
+        }
+        check_resized(ts, 1000 - 2 * 333, 998);
+
+        /* Stats follow the resized window */
+        ag_timeseries_stats_t st;
+        ASSERT_EQ(ag_timeseries_stats(ts, &st), AG_OK);
+        ASSERT_EQ(st.count, 333);
+        ASSERT_DOUBLE_EQ(st.min, (double)(1000 - 2 * 333) / 2);
+        ASSERT_DOUBLE_EQ(st.max, 499.0);
+
+        /* Shrink to a size that wraps differently: the newest 37 stay */
+        ASSERT_EQ(ag_timeseries_resize(ts, 37), AG_OK);
+        check_resized(ts, 1000 - 2 * 37, 998);
+        ASSERT_EQ(ag_timeseries_stats(ts, &st), AG_OK);
+        ASSERT_EQ(st.count, 37);
+        ASSERT_DOUBLE_EQ(st.min, (double)(1000 - 2 * 37) / 2);
+        ASSERT_DOUBLE_EQ(st.sum, 37.0 * 481.0);   /* 463 .. 499 */
+        for (; t < 1100; t += 2) {
+            ASSERT_EQ(ag_timeseries_append(ts, t, (double)t / 2), AG_OK);
+        }
+        check_resized(ts, 1100 - 2 * 37, 1098);
+        ASSERT_EQ(ag_timeseries_stats(ts, &st), AG_OK);
+        ASSERT_DOUBLE_EQ(st.max, 549.0);
+
+        /* Cursor: same sequences, the shrink shows up as lost points */
+        int64_t out_ts[1000];
+        double out_vals[1000];
+        size_t got;
+        uint64_t lost;
+        ASSERT_EQ(ag_timeseries_cursor_read(ts, &cur, 1000, out_ts, out_vals, &got, &lost),
+                  AG_ERR_LAPPED);
+        ASSERT_EQ(got, 37);
+        ASSERT_EQ(lost, 513 - (125 - cap));
+        ag_timeseries_destroy(ts);
+    }
+
+    /* Shrink hands the dropped points to the cold tier; order tracking survives */
+    ag_timeseries_t* ts = ag_timeseries_create(100);
+    ASSERT_EQ(ag_timeseries_enable_cold(ts, 1 << 20), AG_OK);
+    for (int64_t t = 0; t < 150; t++) {
+        ASSERT_EQ(ag_timeseries_append(ts, (t == 120) ? 0 : t, 1.0), AG_OK);
+    }
+    ASSERT_EQ(ag_timeseries_is_monotonic(ts), 0);
+    ASSERT_EQ(ag_timeseries_resize(ts, 30), AG_OK);
+    ASSERT_EQ(ag_timeseries_size(ts), 30);
+    ASSERT_EQ(ag_timeseries_is_monotonic(ts), 1);
+    ag_timeseries_cold_stats_t cs;
+    ASSERT_EQ(ag_timeseries_cold_stats(ts, &cs), AG_OK);
+    ASSERT_EQ(cs.points, 120);
+    int64_t hist_ts[150];
+    double hist_vals[150];
+    ASSERT_EQ(ag_timeseries_query_last(ts, 150, hist_ts, hist_vals), 150);
+    ASSERT_EQ(hist_ts[0], 149);
+    ASSERT_EQ(hist_ts[28], 121);
+    ASSERT_EQ(hist_ts[29], 0);      /* The late point, oldest kept */
+    ASSERT_EQ(hist_ts[30], 119);    /* Newest cold point */
+    ASSERT_EQ(hist_ts[149], 0);
+    ag_timeseries_destroy(ts);
+}
+
+/* Test: TTL expiry on append and on demand, with stats, cold tier, cursors, shm */
+TEST(ttl_expiry) {
+    ag_timeseries_t* ts = ag_timeseries_create(100);
+    ASSERT_EQ(ag_timeseries_set_ttl(NULL, 10), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_set_ttl(ts, -1), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_expire(NULL, 0), 0);
+    ASSERT_EQ(ag_timeseries_expire(ts, 1000), 0);   /* No TTL */
+    ASSERT_EQ(ag_timeseries_enable_stats(ts), AG_OK);
+    ASSERT_EQ(ag_timeseries_set_ttl(ts, 10), AG_OK);
+
+    ag_ts_cursor_t cur;
+    ASSERT_EQ(ag_timeseries_cursor_init(ts, AG_CURSOR_OLDEST, &cur), AG_OK);
+
+    /* Data time is the clock: keep [t - 10, t] */
+    for (int64_t t = 0; t < 50; t++) {
+        ASSERT_EQ(ag_timeseries_append(ts, t, (double)t), AG_OK);
+    }
+    ASSERT_EQ(ag_timeseries_size(ts), 11);
+    ASSERT_EQ(ag_timeseries_sequence(ts), 50);
+
+    int64_t timestamps[100];
+    double values[100];
+    ASSERT_EQ(ag_timeseries_query_range(ts, 0, 100, 100, timestamps, values), 11);
+    ASSERT_EQ(timestamps[0], 39);
+
+    ag_timeseries_stats_t st;
+    ASSERT_EQ(ag_timeseries_stats(ts, &st), AG_OK);
+    ASSERT_EQ(st.count, 11);
+    ASSERT_DOUBLE_EQ(st.mean, 44.0);
+    ASSERT_DOUBLE_EQ(st.min, 39.0);
+
+    /* Cursor: expired unread points are lost */
+    size_t got;
+    uint64_t lost;
+    ASSERT_EQ(ag_timeseries_cursor_read(ts, &cur, 100, timestamps, values, &got, &lost),
+              AG_ERR_LAPPED);
+    ASSERT_EQ(lost, 39);
+    ASSERT_EQ(got, 11);
+
+    /* Batch: its newest point is the clock */
+    int64_t bt[3] = { 52, 55, 58 };
+    double bv[3] = { 52.0, 55.0, 58.0 };
+    ASSERT_EQ(ag_timeseries_append_batch(ts, bt, bv, 3), AG_OK);
+    ASSERT_EQ(ag_timeseries_size(ts), 5);       /* 48, 49, 52, 55, 58 */
+
+    /* Quiet feed: expire against a wall clock */
+    ASSERT_EQ(ag_timeseries_expire(ts, 60), 2);
+    ASSERT_EQ(ag_timeseries_expire(ts, 60), 0);
+    ASSERT_EQ(ag_timeseries_expire(ts, 0), 0);      /* Clock behind the data */
+    ASSERT_EQ(ag_timeseries_expire(ts, INT64_MIN), 0);
+    ASSERT_EQ(ag_timeseries_stats(ts, &st), AG_OK);
+    ASSERT_EQ(st.count, 3);
+    ASSERT_DOUBLE_EQ(st.sum, 165.0);
+    ASSERT_DOUBLE_EQ(st.min, 52.0);
+    ASSERT_DOUBLE_EQ(st.max, 58.0);
+
+    /* Everything expired: empty, then refills */
+    ASSERT_EQ(ag_timeseries_expire(ts, 1000), 3);
+    ASSERT_EQ(ag_timeseries_size(ts), 0);
+    ASSERT_EQ(ag_timeseries_stats(ts, &st), AG_ERR_EMPTY);
+    ASSERT_EQ(ag_timeseries_query_last(ts, 10, timestamps, values), 0);
+    for (int64_t t = 1000; t < 1300; t++) {
+        ASSERT_EQ(ag_timeseries_append(ts, t, 1.0), AG_OK);
+    }
+    ASSERT_EQ(ag_timeseries_size(ts), 11);
+    ASSERT_EQ(ag_timeseries_stats(ts, &st), AG_OK);
+    ASSERT_EQ(st.count, 11);
+    ASSERT_DOUBLE_EQ(st.sum, 11.0);
+
+    /* TTL wider than the ring: capacity still bounds it */
+    ASSERT_EQ(ag_timeseries_set_ttl(ts, 1000000), AG_OK);
+    for (int64_t t = 2000; t < 2300; t++) {
+        ASSERT_EQ(ag_timeseries_append(ts, t, 2.0), AG_OK);
+    }
+    ASSERT_EQ(ag_timeseries_size(ts), 100);
+    ASSERT_EQ(ag_timeseries_set_ttl(ts, 0), AG_OK);
+    ASSERT_EQ(ag_timeseries_expire(ts, INT64_MAX), 0);
+    ag_timeseries_destroy(ts);
+
+    /* A late point blocks expiry until it expires; then the order is back */
+    ts = ag_timeseries_create(100);
+    ASSERT_EQ(ag_timeseries_set_ttl(ts, 10), AG_OK);
+    ASSERT_EQ(ag_timeseries_append(ts, 100, 0.0), AG_OK);
+    ASSERT_EQ(ag_timeseries_append(ts, 95, 0.0), AG_OK);
+    ASSERT_EQ(ag_timeseries_append(ts, 101, 0.0), AG_OK);
+    ASSERT_EQ(ag_timeseries_is_monotonic(ts), 0);
+    ASSERT_EQ(ag_timeseries_append(ts, 109, 0.0), AG_OK);   /* Cutoff 99 */
+    ASSERT_EQ(ag_timeseries_size(ts), 4);
+    ASSERT_EQ(ag_timeseries_append(ts, 111, 0.0), AG_OK);   /* Cutoff 101 */
+    ASSERT_EQ(ag_timeseries_size(ts), 3);
+    ASSERT_EQ(ag_timeseries_is_monotonic(ts), 1);
+    ag_timeseries_destroy(ts);
+
+    /* Cold tier: expired and overwritten points each arrive once */
+    ts = ag_timeseries_create(100);
+    ASSERT_EQ(ag_timeseries_enable_cold(ts, 1 << 20), AG_OK);
+    ASSERT_EQ(ag_timeseries_set_ttl(ts, 150), AG_OK);
+    for (int64_t t = 0; t < 1000; t++) {
+        ASSERT_EQ(ag_timeseries_append(ts, t, (double)t), AG_OK);
+        if (t % 200 == 0) {
+            ASSERT_EQ(ag_timeseries_set_ttl(ts, (t % 400 == 0) ? 50 : 150), AG_OK);
+        }
+    }
+    int64_t bt2[250];
+    double bv2[250];
+    for (int i = 0; i < 250; i++) {
+        bt2[i] = 1000 + i;
+        bv2[i] = 1000.0 + i;
+    }
+    ASSERT_EQ(ag_timeseries_append_batch(ts, bt2, bv2, 250), AG_OK);
+    ASSERT_EQ(ag_timeseries_expire(ts, 1280), 31);
+    ag_timeseries_cold_stats_t cs;
+    ASSERT_EQ(ag_timeseries_cold_stats(ts, &cs), AG_OK);
+    ASSERT_EQ(cs.points + ag_timeseries_size(ts), 1250);
+
+    int64_t* all_ts = (int64_t*)malloc(1250 * sizeof(int64_t));
+    double* all_vals = (double*)malloc(1250 * sizeof(double));
+    ASSERT_EQ(ag_timeseries_query_range(ts, 0, 2000, 1250, all_ts, all_vals), 1250);
+    for (int64_t i = 0; i < 1250; i++) {
+        ASSERT_EQ(all_ts[i], i);
+        ASSERT_DOUBLE_EQ(all_vals[i], (double)i);
+    }
+    free(all_ts);
+    free(all_vals);
+    ag_timeseries_destroy(ts);
+
+    /* Read-only handles cannot expire */
+    char name[64];
+    snprintf(name, sizeof(name), "/ag_test_ttl_%d", (int)getpid());
+    ag_timeseries_t* writer = ag_timeseries_create_shm(name, 64);
+    ASSERT_NE(writer, NULL);
+    ag_timeseries_t* reader = ag_timeseries_attach_shm(name);
+    ASSERT_NE(reader, NULL);
+    ASSERT_EQ(ag_timeseries_set_ttl(reader, 10), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_expire(reader, 100), 0);
+
+    /* Shared-memory readers see the writer's expiry */
+    ASSERT_EQ(ag_timeseries_set_ttl(writer, 5), AG_OK);
+    for (int64_t t = 0; t < 20; t++) {
+        ASSERT_EQ(ag_timeseries_append(writer, t, (double)t), AG_OK);
+    }
+    ASSERT_EQ(ag_timeseries_size(reader), 6);
+    ASSERT_EQ(ag_timeseries_query_range(reader, 0, 100, 64, timestamps, values), 6);
+    ASSERT_EQ(timestamps[0], 14);
+    ASSERT_EQ(ag_timeseries_expire(writer, 22), 3);
+    ASSERT_EQ(ag_timeseries_size(reader), 3);
+    ag_timeseries_destroy(reader);
+    ag_timeseries_destroy(writer);
+}
+
+TEST(reorder_buffer) {
+    ag_timeseries_t* ts = ag_timeseries_create(1000);
+    ASSERT_EQ(ag_timeseries_enable_reorder(ts, -1, 10), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_enable_reorder(ts, 100, 0), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_flush_reorder(ts), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_append(ts, 5, 5.0), AG_OK);
+    ASSERT_EQ(ag_timeseries_enable_reorder(ts, 100, 1000), AG_OK);
+    ASSERT_EQ(ag_timeseries_enable_reorder(ts, 100, 1000), AG_ERR_INVALID_ARG);
+
+    /* Jittered feed: pairs swapped, every point within 100 ms of the newest */
+    for (int64_t i = 1; i <= 200; i++) {
+        int64_t t = (i % 2 == 0) ? (i - 1) * 10 : (i + 1) * 10;
+        ASSERT_EQ(ag_timeseries_append(ts, t, (double)t), AG_OK);
+    }
+    ASSERT_EQ(ag_timeseries_is_monotonic(ts), 1);
+
+    ag_timeseries_reorder_stats_t st;
+    ASSERT_EQ(ag_timeseries_reorder_stats(ts, &st), AG_OK);
+    ASSERT_EQ(st.reordered, 100);
+    ASSERT_EQ(st.rejected, 0);
+    ASSERT_EQ(st.window_ms, 100);
+
+    /* Newest seen is 2000: points within the last 100 ms are still staged */
+    ASSERT_EQ(st.pending, 10);
+    ASSERT_EQ(ag_timeseries_size(ts), 191);
+
+    /* Older than the window, or than what was already released: dropped */
+    ASSERT_EQ(ag_timeseries_append(ts, 1850, 0.0), AG_ERR_UNORDERED);
+    ASSERT_EQ(ag_timeseries_append(ts, 1, 0.0), AG_ERR_UNORDERED);
+    ASSERT_EQ(ag_timeseries_append(ts, 1905, 1905.0), AG_OK);
+    int64_t late_ts[3] = { 2010, 1000, 1999 };
+    double late_vals[3] = { 2010.0, 0.0, 1999.0 };
+    ASSERT_EQ(ag_timeseries_append_batch(ts, late_ts, late_vals, 3), AG_ERR_UNORDERED);
+    ASSERT_EQ(ag_timeseries_reorder_stats(ts, &st), AG_OK);
+    ASSERT_EQ(st.rejected, 3);
+
+    /* Flush: everything visible, in order, no duplicates or drops */
+    ASSERT_EQ(ag_timeseries_flush_reorder(ts), AG_OK);
+    ASSERT_EQ(ag_timeseries_reorder_stats(ts, &st), AG_OK);
+    ASSERT_EQ(st.pending, 0);
+    ASSERT_EQ(ag_timeseries_size(ts), 204);
+    ASSERT_EQ(ag_timeseries_is_monotonic(ts), 1);
+
+    int64_t timestamps[204];
+    double values[204];
+    ASSERT_EQ(ag_timeseries_query_range(ts, 0, 3000, 204, timestamps, values), 204);
+    ASSERT_EQ(timestamps[0], 5);
+    ASSERT_EQ(timestamps[1], 10);
+    for (size_t i = 2; i < 204; i++) {
+        ASSERT(timestamps[i] >= timestamps[i - 1]);
+        ASSERT_DOUBLE_EQ(values[i], (double)timestamps[i]);
+    }
+    ASSERT_EQ(timestamps[203], 2010);
+    ASSERT_EQ(ag_timeseries_append(ts, 2005, 0.0), AG_ERR_UNORDERED);
+    ag_timeseries_destroy(ts);
+
+    /* Depth in points only: 3 staged, the oldest released when a 4th arrives */
+    ts = ag_timeseries_create(16);
+    ASSERT_EQ(ag_timeseries_enable_reorder(ts, INT64_MAX, 3), AG_OK);
+    const int64_t feed[6] = { 50, 10, 40, 30, 5, 60 };
+    for (int i = 0; i < 6; i++) {
+        int rc = ag_timeseries_append(ts, feed[i], (double)feed[i]);
+        ASSERT_EQ(rc, (feed[i] == 5) ? AG_ERR_UNORDERED : AG_OK);
+    }
+    ASSERT_EQ(ag_timeseries_size(ts), 2);
+    ASSERT_EQ(ag_timeseries_query_last(ts, 2, timestamps, values), 2);
+    ASSERT_EQ(timestamps[0], 30);
+    ASSERT_EQ(timestamps[1], 10);
+    ag_timeseries_destroy(ts);
+}
+
+/* Child process: stream the parent's shared ring with a cursor */
+static int shm_child(const char* name, int64_t points) {
+    ag_timeseries_t* ts = NULL;
+    while ((ts = ag_timeseries_attach_shm(name)) == NULL) {
+        usleep(1000);
+    }
+
+    ag_ts_cursor_t cursor;
+    ag_timeseries_cursor_init(ts, AG_CURSOR_OLDEST, &cursor);
+    int64_t expect = (int64_t)cursor.next_seq;
+    int64_t timestamps[32];
+    double values[32];
+    while (expect < points) {
+        size_t count = 0;
+        uint64_t lost = 0;
+        int rc = ag_timeseries_cursor_read(ts, &cursor, 32, timestamps, values, &count, &lost);
+        if (rc != AG_OK && rc != AG_ERR_LAPPED) {
+            return 1;
+        }
+        expect += (int64_t)lost;
+        for (size_t i = 0; i < count; i++, expect++) {
+            if (timestamps[i] != expect || values[i] != expect * 2.0) {
+                return 2;
+            }
+        }
+        if (count == 0 && lost == 0) {
+            if (!ag_timeseries_shm_live(ts)) {
+                break;
+            }
+            sched_yield();
+        }
+    }
+    int rc = (expect == points) ? 0 : 3;
+    ag_timeseries_destroy(ts);
+    return rc;
+}
+
+TEST(shm_ring) {
+    char name[64];
+    snprintf(name, sizeof(name), "/ag_test_shm_%d", (int)getpid());
+
+    ASSERT_EQ(ag_timeseries_attach_shm(name), NULL);
+    ag_timeseries_t* writer = ag_timeseries_create_shm(name, 64);
+    ASSERT_NE(writer, NULL);
+    ASSERT_EQ(ag_timeseries_shm_live(writer), 1);
+
+    /* A live writer owns the name */
+    ASSERT_EQ(ag_timeseries_create_shm(name, 64), NULL);
+
+    for (int64_t i = 0; i < 100; i++) {
+        ASSERT_EQ(ag_timeseries_append(writer, i, i * 2.0), AG_OK);
+    }
+
+    /* Reader in this process: separate read-only mapping, same points */
+    ag_timeseries_t* reader = ag_timeseries_attach_shm(name);
+    ASSERT_NE(reader, NULL);
+    ASSERT_EQ(ag_timeseries_capacity(reader), 64);
+    ASSERT_EQ(ag_timeseries_sequence(reader), 100);
+    ASSERT_EQ(ag_timeseries_is_monotonic(reader), 1);
+
+    int64_t timestamps[64];
+    double values[64];
+    ASSERT_EQ(ag_timeseries_query_last(reader, 3, timestamps, values), 3);
+    ASSERT_EQ(timestamps[0], 99);
+    ASSERT_DOUBLE_EQ(values[2], 194.0);
+
+    ag_timeseries_view_t view;
+    ASSERT_EQ(ag_timeseries_view_range(reader, 40, 49, &view), AG_OK);
+    ASSERT_EQ(view.length, 10);
+
+    ag_ts_cursor_t cursor;
+    size_t count = 0;
+    ASSERT_EQ(ag_timeseries_cursor_init(reader, AG_CURSOR_LATEST, &cursor), AG_OK);
+    ASSERT_EQ(ag_timeseries_append(writer, 100, 200.0), AG_OK);
+    ASSERT_EQ(ag_timeseries_cursor_read(reader, &cursor, 64, timestamps, values, &count, NULL),
+              AG_OK);
+    ASSERT_EQ(count, 1);
+    ASSERT_EQ(timestamps[0], 100);
+
+    /* Readers cannot write */
+    ASSERT_EQ(ag_timeseries_append(reader, 101, 0.0), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_append_batch(reader, timestamps, values, 1), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_enable_stats(reader), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_enable_cold(reader, 1u << 20), AG_ERR_INVALID_ARG);
+
+    /* Destroying the writer closes and unlinks; the reader keeps its data */
+    ag_timeseries_destroy(writer);
+    ASSERT_EQ(ag_timeseries_shm_live(reader), 0);
+    ASSERT_EQ(ag_timeseries_sequence(reader), 101);
+    ASSERT_EQ(ag_timeseries_attach_shm(name), NULL);
+    ag_timeseries_destroy(reader);
+
+    /* Another process streams every point once or counts it lost */
+    const int64_t points = 200000;
+    writer = ag_timeseries_create_shm(name, 256);
+    ASSERT_NE(writer, NULL);
+    pid_t pid = fork();
+    ASSERT(pid >= 0);
+    if (pid == 0) {
+        _exit(shm_child(name, points));
+    }
+    for (int64_t i = 0; i < points; i++) {
+        ag_timeseries_append(writer, i, i * 2.0);
+        if (i % 4096 == 0) {
+            sched_yield();
+        }
+    }
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    ASSERT(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+    ag_timeseries_destroy(writer);
+    ASSERT_EQ(ag_timeseries_shm_live(NULL), 0);
+}
+
+/* Helper: Append through the inline path to one ring and the library to another */
+static void inline_twin_check(ag_timeseries_t* fast, ag_timeseries_t* ref) {
+    for (int64_t i = 0; i < 300; i++) {
+        int64_t t = (i % 37 == 5) ? i - 3 : i;   /* A few out-of-order points */
+        ASSERT_EQ(ag_timeseries_append_inline(fast, t, i * 0.5), AG_OK);
+        ASSERT_EQ(ag_timeseries_append(ref, t, i * 0.5), AG_OK);
+
+        int64_t t_fast;
+        double v_fast;
+        ASSERT_EQ(ag_timeseries_last_inline(fast, &t_fast, &v_fast), AG_OK);
+        ASSERT_EQ(t_fast, t);
+        ASSERT_DOUBLE_EQ(v_fast, i * 0.5);
+        ASSERT_EQ(ag_timeseries_size_inline(fast), ag_timeseries_size(ref));
+        ASSERT_EQ(ag_timeseries_sequence_inline(fast), ag_timeseries_sequence(ref));
+        ASSERT_EQ(ag_timeseries_is_monotonic(fast), ag_timeseries_is_monotonic(ref));
+    }
+
+    int64_t ta[64], tb[64];
+    double va[64], vb[64];
+    size_t n = ag_timeseries_query_last(fast, 64, ta, va);
+    ASSERT_EQ(n, ag_timeseries_query_last(ref, 64, tb, vb));
+    ASSERT_EQ(memcmp(ta, tb, n * sizeof(int64_t)), 0);
+    ASSERT_EQ(memcmp(va, vb, n * sizeof(double)), 0);
+    ag_timeseries_destroy(fast);
+    ag_timeseries_destroy(ref);
+}
+
+typedef struct {
+    ag_timeseries_t* ts;
+    _Atomic int done;
+    int torn;
+} inline_reader_ctx_t;
+
+/* Helper: Check every newest point read while the writer runs */
+static void* inline_reader(void* arg) {
+    inline_reader_ctx_t* ctx = (inline_reader_ctx_t*)arg;
+    while (!atomic_load(&ctx->done)) {
+        int64_t t;
+        double v;
+        if (ag_timeseries_last_inline(ctx->ts, &t, &v) == AG_OK && v != (double)t * 2.0) {
+            ctx->torn++;
+        }
+    }
+    return NULL;
+}
+
+/* Test: Inline fast path matches the library and falls back when it must */
+TEST(inline_fast_path) {
+    ASSERT_EQ(ag_timeseries_inline_abi(), AG_TIMESERIES_INLINE_ABI);
+
+    /* Validation is compiled in for this (non-NDEBUG) build */
+    int64_t t;
+    double v;
+    ASSERT_EQ(ag_timeseries_append_inline(NULL, 0, 0.0), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_last_inline(NULL, &t, &v), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_size_inline(NULL), 0);
+    ASSERT_EQ(ag_timeseries_sequence_inline(NULL), 0);
+
+    ag_timeseries_t* ts = ag_timeseries_create(10);
+    ASSERT_EQ(ag_timeseries_last_inline(ts, &t, &v), AG_ERR_EMPTY);
+    ag_timeseries_destroy(ts);
+
+    /* Split, power-of-two, interleaved and SPMC rings */
+    inline_twin_check(ag_timeseries_create(100), ag_timeseries_create(100));
+    inline_twin_check(ag_timeseries_create(64), ag_timeseries_create(64));
+    inline_twin_check(ag_timeseries_create_interleaved(50), ag_timeseries_create_interleaved(50));
+    inline_twin_check(ag_timeseries_create_spmc(32), ag_timeseries_create_spmc(32));
+
+    /* Attachments take the library path: stats, TTL, reorder */
+    ag_timeseries_t* fast = ag_timeseries_create(100);
+    ag_timeseries_t* ref = ag_timeseries_create(100);
+    ASSERT_EQ(ag_timeseries_enable_stats(fast), AG_OK);
+    ASSERT_EQ(ag_timeseries_enable_stats(ref), AG_OK);
+    ASSERT_EQ(ag_timeseries_set_ttl(fast, 10), AG_OK);
+    ASSERT_EQ(ag_timeseries_set_ttl(ref, 10), AG_OK);
+    inline_twin_check(fast, ref);
+
+    fast = ag_timeseries_create(100);
+    ASSERT_EQ(ag_timeseries_set_ttl(fast, 10), AG_OK);
+    for (int64_t i = 0; i < 50; i++) {
+        ASSERT_EQ(ag_timeseries_append_inline(fast, i, (double)i), AG_OK);
+    }
+    ASSERT_EQ(ag_timeseries_size_inline(fast), 11);
+    ag_timeseries_destroy(fast);
+
+    ag_timeseries_stats_t st;
+    fast = ag_timeseries_create(100);
+    ASSERT_EQ(ag_timeseries_enable_stats(fast), AG_OK);
+    for (int64_t i = 0; i < 10; i++) {
+        ASSERT_EQ(ag_timeseries_append_inline(fast, i, (double)i), AG_OK);
+    }
+    ASSERT_EQ(ag_timeseries_stats(fast, &st), AG_OK);
+    ASSERT_EQ(st.count, 10);
+    ASSERT_DOUBLE_EQ(st.sum, 45.0);
+    ag_timeseries_destroy(fast);
+
+    /* Typed columns convert through the library */
+    ts = ag_timeseries_create_typed(16, AG_VALUE_I32);
+    ASSERT_NE(ts, NULL);
+    ASSERT_EQ(ag_timeseries_append_inline(ts, 7, 42.0), AG_OK);
+    ASSERT_EQ(ag_timeseries_last_inline(ts, &t, &v), AG_OK);
+    ASSERT_EQ(t, 7);
+    ASSERT_DOUBLE_EQ(v, 42.0);
+    ASSERT_EQ(ag_timeseries_size_inline(ts), 1);
+    ag_timeseries_destroy(ts);
+
+    /* Read-only handles refuse writes */
+    char name[64];
+    snprintf(name, sizeof(name), "/ag_test_inline_%d", (int)getpid());
+    ag_timeseries_t* writer = ag_timeseries_create_shm(name, 16);
+    ASSERT_NE(writer, NULL);
+    ag_timeseries_t* reader = ag_timeseries_attach_shm(name);
+    ASSERT_NE(reader, NULL);
+    ASSERT_EQ(ag_timeseries_append_inline(writer, 1, 2.0), AG_OK);
+    ASSERT_EQ(ag_timeseries_append_inline(reader, 2, 3.0), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_last_inline(reader, &t, &v), AG_OK);
+    ASSERT_EQ(t, 1);
+    ag_timeseries_destroy(reader);
+    ag_timeseries_destroy(writer);
+
+    /* SPMC: a concurrent reader never sees a torn newest point */
+    inline_reader_ctx_t ctx = { ag_timeseries_create_spmc(8), 0, 0 };
+    pthread_t thread;
+    ASSERT_EQ(pthread_create(&thread, NULL, inline_reader, &ctx), 0);
+    for (int64_t i = 0; i < 200000; i++) {
+        ag_timeseries_append_inline(ctx.ts, i, (double)i * 2.0);
+    }
+    atomic_store(&ctx.done, 1);
+    pthread_join(thread, NULL);
+    ASSERT_EQ(ctx.torn, 0);
+    ag_timeseries_destroy(ctx.ts);
+}
+
+/* Sketch parameters shared by the quantile tests */
+#define QS_ACCURACY 0.01
+#define QS_MIN 1e-3
+#define QS_MAX 1e6
+
+/* Helper: The series' sketch answers exactly like one rebuilt from its window */
+static void quantile_check_window(const ag_timeseries_t* ts) {
+    static const double qs[] = { 0.0, 0.01, 0.25, 0.5, 0.9, 0.95, 0.99, 1.0 };
+    size_t n = ag_timeseries_size(ts);
+    int64_t* timestamps = (int64_t*)malloc((n + 1) * sizeof(int64_t));
+    double* values = (double*)malloc((n + 1) * sizeof(double));
+    ASSERT_EQ(ag_timeseries_query_last(ts, n, timestamps, values), n);
+
+    ag_timeseries_sketch_t* ref = ag_timeseries_sketch_create(QS_ACCURACY, QS_MIN, QS_MAX);
+    ASSERT_NE(ref, NULL);
+    for (size_t i = 0; i < n; i++) {
+        ASSERT_EQ(ag_timeseries_sketch_add(ref, values[i]), AG_OK);
+    }
+
+    /* Same counts bin by bin: merging the series into an empty sketch gives ref */
+    ag_timeseries_sketch_t* merged = ag_timeseries_sketch_create(QS_ACCURACY, QS_MIN, QS_MAX);
+    ASSERT_EQ(ag_timeseries_sketch_merge_series(merged, ts), AG_OK);
+    ASSERT_EQ(ag_timeseries_sketch_count(merged), ag_timeseries_sketch_count(ref));
+
+    double got[8], want[8];
+    int rc = ag_timeseries_quantiles(ts, qs, 8, got);
+    ASSERT_EQ(rc, ag_timeseries_sketch_quantiles(ref, qs, 8, want));
+    if (rc == AG_OK) {
+        ASSERT_EQ(memcmp(got, want, sizeof(got)), 0);
+    }
+
+    ag_timeseries_sketch_destroy(merged);
+    ag_timeseries_sketch_destroy(ref);
+    free(timestamps);
+    free(values);
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/* Helper: Query window quantiles while the writer appends values in [1, 2) */
+static void* quantile_reader(void* arg) {
+    inline_reader_ctx_t* ctx = (inline_reader_ctx_t*)arg;
+    static const double qs[] = { 0.0, 0.5, 0.99, 1.0 };
+    while (!atomic_load(&ctx->done)) {
+        double out[4];
+        if (ag_timeseries_quantiles(ctx->ts, qs, 4, out) != AG_OK) {
+            continue;
+        }
+        for (size_t i = 0; i < 4; i++) {
+            if (!(out[i] >= 1.0 * (1.0 - QS_ACCURACY) && out[i] <= 2.0 * (1.0 + QS_ACCURACY))) {
+                ctx->torn++;
+            }
+        }
+    }
+    return NULL;
+}
+
+/* Test: Quantile sketch accuracy, window tracking and merging */
+TEST(quantile_sketch) {
+    /* Parameter validation */
+    ASSERT_EQ(ag_timeseries_sketch_create(0.0, 1.0, 2.0), NULL);
+    ASSERT_EQ(ag_timeseries_sketch_create(0.6, 1.0, 2.0), NULL);
+    ASSERT_EQ(ag_timeseries_sketch_create(NAN, 1.0, 2.0), NULL);
+    ASSERT_EQ(ag_timeseries_sketch_create(0.01, 0.0, 2.0), NULL);
+    ASSERT_EQ(ag_timeseries_sketch_create(0.01, 2.0, 2.0), NULL);
+    ASSERT_EQ(ag_timeseries_sketch_create(0.01, 1.0, INFINITY), NULL);
+    ASSERT_EQ(ag_timeseries_sketch_create(1e-9, 1e-300, 1e300), NULL);  /* Too many bins */
+    ASSERT_EQ(ag_timeseries_sketch_add(NULL, 1.0), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_sketch_count(NULL), 0);
+    ag_timeseries_sketch_destroy(NULL);
+    ag_timeseries_sketch_clear(NULL);
+
+    ag_timeseries_t* ts = ag_timeseries_create(1000);
+    double q = 0.5;
+    double out;
+    ASSERT_EQ(ag_timeseries_quantiles(ts, &q, 1, &out), AG_ERR_INVALID_ARG);  /* Not enabled */
+    ASSERT_EQ(ag_timeseries_enable_quantiles(NULL, QS_ACCURACY, QS_MIN, QS_MAX),
+              AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_enable_quantiles(ts, 0.01, 1.0, 0.5), AG_ERR_INVALID_ARG);
+
+    /* Standalone accuracy: every quantile within alpha of the exact rank */
+    ag_timeseries_sketch_t* sk = ag_timeseries_sketch_create(QS_ACCURACY, QS_MIN, QS_MAX);
+    ASSERT_NE(sk, NULL);
+    ASSERT_EQ(ag_timeseries_sketch_quantiles(sk, &q, 1, &out), AG_ERR_EMPTY);
+    enum { N = 20000 };
+    double* sorted = (double*)malloc(N * sizeof(double));
+    uint64_t seed = 88172645463325252ull;
+    for (size_t i = 0; i < N; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        double u = (double)(seed >> 11) / 9007199254740992.0;
+        double v = exp(u * 18.0 - 6.0);                 /* 2.5e-3 .. 1.6e5 */
+        sorted[i] = (i % 5 == 0) ? -v : v;
+        ASSERT_EQ(ag_timeseries_sketch_add(sk, sorted[i]), AG_OK);
+    }
+    ASSERT_EQ(ag_timeseries_sketch_add(sk, NAN), AG_OK);    /* Ignored */
+    ASSERT_EQ(ag_timeseries_sketch_count(sk), N);
+    qsort(sorted, N, sizeof(double), compare_doubles);
+
+    double qs[] = { 0.0, 0.001, 0.1, 0.2, 0.25, 0.5, 0.75, 0.9, 0.95, 0.99, 0.999, 1.0 };
+    double got[12];
+    ASSERT_EQ(ag_timeseries_sketch_quantiles(sk, qs, 12, got), AG_OK);
+    for (size_t i = 0; i < 12; i++) {
+        double exact = sorted[(size_t)(qs[i] * (N - 1))];
+        ASSERT(fabs(got[i] - exact) <= QS_ACCURACY * fabs(exact) * (1.0 + 1e-9));
+    }
+
+    /* Descending quantiles restart the walk */
+    double desc[] = { 0.99, 0.5, 0.01 };
+    double got_desc[3];
+    ASSERT_EQ(ag_timeseries_sketch_quantiles(sk, desc, 3, got_desc), AG_OK);
+    ASSERT_EQ(got_desc[0], got[9]);
+    ASSERT_EQ(got_desc[1], got[5]);
+    ASSERT(got_desc[2] < got_desc[1]);
+    double bad = 1.5;
+    ASSERT_EQ(ag_timeseries_sketch_quantiles(sk, &bad, 1, &out), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_sketch_quantiles(sk, NULL, 1, &out), AG_ERR_INVALID_ARG);
+    free(sorted);
+
+    /* Zero bin and clamped top bin */
+    ag_timeseries_sketch_clear(sk);
+    ASSERT_EQ(ag_timeseries_sketch_count(sk), 0);
+    ag_timeseries_sketch_add(sk, 1e-9);
+    ag_timeseries_sketch_add(sk, INFINITY);
+    ag_timeseries_sketch_add(sk, -1e9);
+    double ends[] = { 0.0, 0.5, 1.0 };
+    double got_ends[3];
+    ASSERT_EQ(ag_timeseries_sketch_quantiles(sk, ends, 3, got_ends), AG_OK);
+    ASSERT(fabs(got_ends[0] + QS_MAX) <= QS_ACCURACY * QS_MAX);
+    ASSERT_EQ(got_ends[1], 0.0);
+    ASSERT(fabs(got_ends[2] - QS_MAX) <= QS_ACCURACY * QS_MAX);
+
+    /* Seeded from stored points, then tracks the window through overwrites */
+    for (int64_t t = 0; t < 300; t++) {
+        ASSERT_EQ(ag_timeseries_append(ts, t, 1.0 + (double)(t % 97)), AG_OK);
+    }
+    ASSERT_EQ(ag_timeseries_enable_quantiles(ts, QS_ACCURACY, QS_MIN, QS_MAX), AG_OK);
+    ASSERT_EQ(ag_timeseries_enable_quantiles(ts, 0.5, 1.0, 2.0), AG_OK);  /* Kept */
+    quantile_check_window(ts);
+    for (int64_t t = 300; t < 5000; t++) {
+        double v = (t % 11 == 0) ? NAN : (t % 7 == 0) ? -(double)(t % 1000) : (double)(t % 1000);
+        ASSERT_EQ(ag_timeseries_append(ts, t, v), AG_OK);
+        if (t % 613 == 0) {
+            quantile_check_window(ts);
+        }
+    }
+    quantile_check_window(ts);
+
+    /* Batches: partial overwrite and more than the whole ring */
+    int64_t bt[2500];
+    double bv[2500];
+    for (size_t i = 0; i < 2500; i++) {
+        bt[i] = 5000 + (int64_t)i;
+        bv[i] = 0.5 + (double)(i % 313);
+    }
+    ASSERT_EQ(ag_timeseries_append_batch(ts, bt, bv, 400), AG_OK);
+    quantile_check_window(ts);
+    ASSERT_EQ(ag_timeseries_append_batch(ts, bt, bv, 2500), AG_OK);
+    quantile_check_window(ts);
+
+    /* Resize shrink drops the oldest points; growth keeps the window */
+    ASSERT_EQ(ag_timeseries_resize(ts, 600), AG_OK);
+    quantile_check_window(ts);
+    ASSERT_EQ(ag_timeseries_resize(ts, 2000), AG_OK);
+    quantile_check_window(ts);
+
+    /* TTL expiry subtracts expired points */
+    ASSERT_EQ(ag_timeseries_set_ttl(ts, 100), AG_OK);
+    ASSERT_EQ(ag_timeseries_append(ts, 10000, 42.0), AG_OK);
+    ASSERT_EQ(ag_timeseries_size(ts), 1);
+    quantile_check_window(ts);
+    ASSERT_EQ(ag_timeseries_quantiles(ts, &q, 1, &out), AG_OK);
+    ASSERT(fabs(out - 42.0) <= QS_ACCURACY * 42.0);
+    ASSERT_EQ(ag_timeseries_append(ts, 20000, NAN), AG_OK);
+    ASSERT_EQ(ag_timeseries_quantiles(ts, &q, 1, &out), AG_ERR_EMPTY);
+
+    /* Portfolio view: merged series sketches equal one sketch of both windows */
+    ag_timeseries_t* a = ag_timeseries_create_interleaved(64);
+    ag_timeseries_t* b = ag_timeseries_create_typed(100, AG_VALUE_I32);
+    ASSERT_EQ(ag_timeseries_enable_quantiles(a, QS_ACCURACY, QS_MIN, QS_MAX), AG_OK);
+    ASSERT_EQ(ag_timeseries_enable_quantiles(b, QS_ACCURACY, QS_MIN, QS_MAX), AG_OK);
+    ag_timeseries_sketch_clear(sk);
+    for (int64_t t = 0; t < 200; t++) {
+        ag_timeseries_append_inline(a, t, 0.25 * (double)t);   /* Falls back: sketch attached */
+        ag_timeseries_append(b, t, (double)(t * 3));
+    }
+    for (int64_t t = 200 - 64; t < 200; t++) {
+        ag_timeseries_sketch_add(sk, 0.25 * (double)t);
+    }
+    for (int64_t t = 100; t < 200; t++) {
+        ag_timeseries_sketch_add(sk, (double)(t * 3));
+    }
+    quantile_check_window(a);
+    quantile_check_window(b);
+
+    ag_timeseries_sketch_t* book = ag_timeseries_sketch_create(QS_ACCURACY, QS_MIN, QS_MAX);
+    ASSERT_EQ(ag_timeseries_sketch_merge_series(book, a), AG_OK);
+    ASSERT_EQ(ag_timeseries_sketch_merge_series(book, b), AG_OK);
+    ASSERT_EQ(ag_timeseries_sketch_count(book), 164);
+    double got_book[12], got_all[12];
+    ASSERT_EQ(ag_timeseries_sketch_quantiles(book, qs, 12, got_book), AG_OK);
+    ASSERT_EQ(ag_timeseries_sketch_quantiles(sk, qs, 12, got_all), AG_OK);
+    ASSERT_EQ(memcmp(got_book, got_all, sizeof(got_book)), 0);
+
+    /* Merging needs one accuracy; a narrower range clamps */
+    ag_timeseries_sketch_t* coarse = ag_timeseries_sketch_create(0.02, QS_MIN, QS_MAX);
+    ag_timeseries_sketch_t* narrow = ag_timeseries_sketch_create(QS_ACCURACY, 40.0, 100.0);
+    ASSERT_EQ(ag_timeseries_sketch_merge(coarse, book), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_sketch_merge(NULL, book), AG_ERR_INVALID_ARG);
+    ag_timeseries_t* plain = ag_timeseries_create(4);
+    ASSERT_EQ(ag_timeseries_sketch_merge_series(book, plain), AG_ERR_INVALID_ARG);
+    ASSERT_EQ(ag_timeseries_sketch_merge_series(book, NULL), AG_ERR_INVALID_ARG);
+    ag_timeseries_destroy(plain);
+    ASSERT_EQ(ag_timeseries_sketch_merge(narrow, book), AG_OK);
+    ASSERT_EQ(ag_timeseries_sketch_count(narrow), 164);
+    ASSERT_EQ(ag_timeseries_sketch_quantiles(narrow, ends, 3, got_ends), AG_OK);
+    ASSERT_EQ(got_ends[0], 0.0);                                /* 34 is below 40 */
+    ASSERT(fabs(got_ends[2] - 100.0) <= QS_ACCURACY * 100.0);   /* 597 clamps */
+
+    /* SPMC: readers query while the writer counts and evicts */
+    inline_reader_ctx_t ctx = { ag_timeseries_create_spmc(256), 0, 0 };
+    ASSERT_EQ(ag_timeseries_enable_quantiles(ctx.ts, QS_ACCURACY, QS_MIN, QS_MAX), AG_OK);
+    pthread_t thread;
+    ASSERT_EQ(pthread_create(&thread, NULL, quantile_reader, &ctx), 0);
+    for (int64_t i = 0; i < 200000; i++) {
+        ag_timeseries_append(ctx.ts, i, 1.0 + (double)(i % 1000) / 1000.0);
+    }
+    atomic_store(&ctx.done, 1);
+    pthread_join(thread, NULL);
+    ASSERT_EQ(ctx.torn, 0);
+    quantile_check_window(ctx.ts);
+    ag_timeseries_destroy(ctx.ts);
+
+    ag_timeseries_sketch_destroy(narrow);
+    ag_timeseries_sketch_destroy(coarse);
+    ag_timeseries_sketch_destroy(book);
+    ag_timeseries_sketch_destroy(sk);
+    ag_timeseries_destroy(a);
+    ag_timeseries_destroy(b);
+    ag_timeseries_destroy(ts);
+}
+
 /* Main test runner */
 int main(void) {
     printf("=== ag_timeseries Unit Tests ===\n\n");
@@ -472,6 +3496,47 @@ int main(void) {
     RUN_TEST(capacity_one);
     RUN_TEST(negative_timestamps);
     RUN_TEST(query_zero_max_points);
+    RUN_TEST(monotonic_tracking);
+    RUN_TEST(query_range_unordered);
+    RUN_TEST(query_range_monotonic_wrap);
+    RUN_TEST(append_batch_wraparound);
+    RUN_TEST(append_batch_exceeds_capacity);
+    RUN_TEST(append_batch_args_and_ordering);
+    RUN_TEST(create_pow2);
+    RUN_TEST(create_ex_options);
+    RUN_TEST(sequence_counter);
+    RUN_TEST(view_last);
+    RUN_TEST(view_range);
+    RUN_TEST(rolling_stats);
+    RUN_TEST(rolling_stats_edge_cases);
+    RUN_TEST(rolling_stats_large_offset);
+    RUN_TEST(aggregate_range);
+    RUN_TEST(simd_kernels_match_scalar);
+    RUN_TEST(query_buckets);
+    RUN_TEST(cold_tier_roundtrip);
+    RUN_TEST(cold_tier_budget);
+    RUN_TEST(rollup_chain);
+    RUN_TEST(interleaved_layout);
+    RUN_TEST(typed_columns);
+    RUN_TEST(typed_native);
+    RUN_TEST(metrics_histogram);
+    RUN_TEST(metrics_counters);
+    RUN_TEST(cursor_read);
+    RUN_TEST(asof_align);
+    RUN_TEST(aggregate_many);
+    RUN_TEST(ttl_expiry);
+    RUN_TEST(resize);
+    RUN_TEST(serialize_roundtrip);
+    RUN_TEST(reorder_buffer);
+    RUN_TEST(inline_fast_path);
+    RUN_TEST(quantile_sketch);
+    RUN_TEST(shm_ring);
+    RUN_TEST(mmap_reopen);
+    RUN_TEST(mmap_recovery);
+    RUN_TEST(mmap_ttl_reopen);
+    RUN_TEST(spmc_single_thread);
+    RUN_TEST(spmc_concurrent_readers);
+    RUN_TEST(spmc_cursor_readers);
 
     printf("\n=== All tests passed! ===\n");
     return 0;